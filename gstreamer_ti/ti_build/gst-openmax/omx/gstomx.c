@@ -55,6 +55,7 @@
 #include "gstomx_camera.h"
 #include "gstperf.h"
 #include "gstomx_scaler.h"
+#include "gstomx_mcscaler.h"
 #include "gstomx_noisefilter.h"
 #include "gstomx_base_ctrl.h"
 
@@ -109,53 +110,82 @@ static TableItem element_table[] =
 //    { "omx_volume",         "libomxil-bellagio.so.0",   "OMX.st.volume.component",      NULL,                   GST_RANK_NONE,      gst_omx_volume_get_type },
     { "gstperf",         "libOMX_Core.so",   NULL,      NULL,                   GST_RANK_PRIMARY,      gst_perf_get_type },
     { "omx_scaler",         "libOMX_Core.so",   "OMX.TI.VPSSM3.VFPC.INDTXSCWB",     "",                   GST_RANK_PRIMARY,      gst_omx_scaler_get_type },
+    { "omx_mcscaler",         "libOMX_Core.so",   "OMX.TI.VPSSM3.VFPC.INDTXSCWB",     "",                   GST_RANK_NONE,      gst_omx_mcscaler_get_type },
     { "omx_noisefilter",         "libOMX_Core.so",   "OMX.TI.VPSSM3.VFPC.NF",     "",                   GST_RANK_PRIMARY,      gst_omx_noisefilter_get_type },
     { "omx_ctrl",         "libOMX_Core.so",   "OMX.TI.VPSSM3.CTRL.DC",     "",                   GST_RANK_PRIMARY,      gst_omx_base_ctrl_get_type },
 //    { "omx_camera",         "libOMX_Core.so",           "OMX.TI.DUCATI1.VIDEO.CAMERA",  NULL,                   GST_RANK_PRIMARY,   gst_omx_camera_get_type },
     { NULL, NULL, NULL, NULL, 0, NULL },
 };
 
+/* elements for the unit tests only, registered when the test harness sets
+ * CHECK_ENV (see tests/Makefile.am) */
+#define CHECK_ENV "GST_OMX_CHECK"
+
+static TableItem check_element_table[] =
+{
+    { "omx_dummy",          "libomxil-foo.so",          "OMX.check.dummy",              NULL,                   GST_RANK_NONE,      gst_omx_dummy_get_type },
+    { NULL, NULL, NULL, NULL, 0, NULL },
+};
+
 static gboolean
-plugin_init (GstPlugin *plugin)
+register_elements (GstPlugin *plugin, TableItem *table)
 {
     GQuark library_name_quark;
     GQuark component_name_quark;
     GQuark component_role_quark;
-    GST_DEBUG_CATEGORY_INIT (gstomx_debug, "omx", 0, "gst-openmax");
-    GST_DEBUG_CATEGORY_INIT (gstomx_util_debug, "omx_util", 0, "gst-openmax utility");
-    GST_DEBUG_CATEGORY_INIT (gstomx_ppm, "omx_ppm", 0,
-                             "gst-openmax performance");
+    guint i;
 
     library_name_quark = g_quark_from_static_string ("library-name");
     component_name_quark = g_quark_from_static_string ("component-name");
     component_role_quark = g_quark_from_static_string ("component-role");
 
-    g_omx_init ();
-
+    for (i = 0; table[i].name; i++)
     {
-        guint i;
-        for (i = 0; element_table[i].name; i++)
+        TableItem *element;
+        GType type;
+
+        element = &table[i];
+        type = element->get_type ();
+        g_type_set_qdata (type, library_name_quark, (gpointer) element->library_name);
+        g_type_set_qdata (type, component_name_quark, (gpointer) element->component_name);
+        g_type_set_qdata (type, component_role_quark, (gpointer) element->component_role);
+
+        if (!gst_element_register (plugin, element->name, element->rank, type))
         {
-            TableItem *element;
-            GType type;
-
-            element = &element_table[i];
-            type = element->get_type ();
-            g_type_set_qdata (type, library_name_quark, (gpointer) element->library_name);
-            g_type_set_qdata (type, component_name_quark, (gpointer) element->component_name);
-            g_type_set_qdata (type, component_role_quark, (gpointer) element->component_role);
-
-            if (!gst_element_register (plugin, element->name, element->rank, type))
-            {
-                g_warning ("failed registering '%s'", element->name);
-                return FALSE;
-            }
+            g_warning ("failed registering '%s'", element->name);
+            return FALSE;
         }
     }
 
     return TRUE;
 }
 
+static gboolean
+plugin_init (GstPlugin *plugin)
+{
+    static const gchar *check_env[] = { CHECK_ENV, NULL };
+
+    GST_DEBUG_CATEGORY_INIT (gstomx_debug, "omx", 0, "gst-openmax");
+    GST_DEBUG_CATEGORY_INIT (gstomx_util_debug, "omx_util", 0, "gst-openmax utility");
+    GST_DEBUG_CATEGORY_INIT (gstomx_ppm, "omx_ppm", 0,
+                             "gst-openmax performance");
+
+    g_omx_init ();
+
+    /* rescan the plugin when the variable changes, so the test-only
+     * elements never stay in a registry once the harness is gone */
+    gst_plugin_add_dependency (plugin, check_env, NULL, NULL,
+                               GST_PLUGIN_DEPENDENCY_FLAG_NONE);
+
+    if (!register_elements (plugin, element_table))
+        return FALSE;
+
+    if (g_getenv (CHECK_ENV) && !register_elements (plugin, check_element_table))
+        return FALSE;
+
+    return TRUE;
+}
+
 GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
                    GST_VERSION_MINOR,
                    "omx",
@@ -23,6 +23,9 @@
 #include "gstomx.h"
 #include "gstomx_interface.h"
 #include "gstomx_buffertransport.h"
+#include "gstomx_pool.h"
+
+#include "cpu_load.h"
 
 enum
 {
@@ -33,6 +36,16 @@ enum
     ARG_USE_TIMESTAMPS,
     ARG_NUM_INPUT_BUFFERS,
     ARG_NUM_OUTPUT_BUFFERS,
+    ARG_PORT_STATS,
+    ARG_STATS_INTERVAL,
+    ARG_INPUT_THREAD_ID,
+    ARG_OUTPUT_THREAD_ID,
+    ARG_COMMAND_TIMEOUT,
+    ARG_COMMAND_STATS,
+    ARG_USE_POOL,
+    ARG_POOL_SIZE,
+    ARG_POOL_TIMEOUT,
+    ARG_POOL_STATS,
 };
 
 static void init_interfaces (GType type);
@@ -41,7 +54,10 @@ GSTOMX_BOILERPLATE_FULL (GstOmxBaseFilter, gst_omx_base_filter, GstElement, GST_
 
 static GstFlowReturn push_buffer (GstOmxBaseFilter *self, GstBuffer *buf);
 static GstFlowReturn pad_chain (GstPad *pad, GstBuffer *buf);
+static GstFlowReturn pad_chain_list (GstPad *pad, GstBufferList *list);
+static GstFlowReturn pad_chain_list_each (GstPad *pad, GstBufferList *list);
 static gboolean pad_event (GstPad *pad, GstEvent *event);
+static GstStructure *get_port_stats (GstOmxBaseFilter *self);
 
 
 static void
@@ -88,43 +104,51 @@ setup_ports (GstOmxBaseFilter *self)
             self->in_port->share_buffer, self->out_port->share_buffer);
 }
 
-static void
-setup_input_buffer (GstOmxBaseFilter *self, GstBuffer *buf)
+/**
+ * Pick the buffer mode of input port @in_port from the first buffer that
+ * will be sent to it: buffers of an upstream OMX port are shared, anything
+ * else is copied into buffers the component allocates.
+ */
+void
+gst_omx_base_filter_setup_input_port (GstOmxBaseFilter *self,
+                                      GOmxPort *in_port,
+                                      GstBuffer *buf)
 {
     if (GST_IS_OMXBUFFERTRANSPORT (buf))
     {
         OMX_PARAM_PORTDEFINITIONTYPE param;
-        GOmxPort *port, *in_port;
+        GOmxPort *port;
         gint i;
 
         /* retrieve incoming buffer port information */
         port = GST_GET_OMXPORT (buf);
 
         /* configure input buffer size to match with upstream buffer */
-        G_OMX_PORT_GET_DEFINITION (self->in_port, &param);
+        G_OMX_PORT_GET_DEFINITION (in_port, &param);
         param.nBufferSize =  GST_BUFFER_SIZE (buf);
         param.nBufferCountActual = port->num_buffers;
-        G_OMX_PORT_SET_DEFINITION (self->in_port, &param);
+        G_OMX_PORT_SET_DEFINITION (in_port, &param);
 
         /* allocate resource to save the incoming buffer port pBuffer pointer in
          * OmxBufferInfo structure.
          */
-        in_port =  self->in_port;
         in_port->share_buffer_info = malloc (sizeof(OmxBufferInfo));
-        in_port->share_buffer_info->pBuffer = malloc (sizeof(int) * port->num_buffers);
+        in_port->share_buffer_info->port = port;
+        in_port->share_buffer_info->num_buffers = port->num_buffers;
+        in_port->share_buffer_info->pBuffer = malloc (sizeof(OMX_U8 *) * port->num_buffers);
         for (i=0; i < port->num_buffers; i++) {
             in_port->share_buffer_info->pBuffer[i] = port->buffers[i]->pBuffer;
         }
 
         /* disable omx_allocate alloc flag, so that we can fall back to shared method */
-        self->in_port->omx_allocate = FALSE;
-        self->in_port->always_copy = FALSE;
+        in_port->omx_allocate = FALSE;
+        in_port->always_copy = FALSE;
     }
     else
     {
         /* ask openmax to allocate input buffer */
-        self->in_port->omx_allocate = TRUE;
-        self->in_port->always_copy = TRUE;
+        in_port->omx_allocate = TRUE;
+        in_port->always_copy = TRUE;
     }
 }
 
@@ -178,6 +202,8 @@ change_state (GstElement *element,
                 self->ready = FALSE;
             }
             g_mutex_unlock (self->ready_lock);
+            g_atomic_int_set (&self->input_tid, 0);
+            g_atomic_int_set (&self->output_tid, 0);
             if (core->omx_state != OMX_StateLoaded &&
                 core->omx_state != OMX_StateInvalid)
             {
@@ -267,6 +293,36 @@ set_property (GObject *obj,
                 G_OMX_PORT_SET_DEFINITION (port, &param);
             }
             break;
+        case ARG_STATS_INTERVAL:
+            self->stats_interval = g_value_get_uint (value);
+            if (self->stats_interval)
+            {
+                g_omx_port_enable_stats (self->in_port);
+                g_omx_port_enable_stats (self->out_port);
+            }
+            break;
+        case ARG_COMMAND_TIMEOUT:
+            self->gomx->command_timeout = g_value_get_uint (value);
+            break;
+        case ARG_USE_POOL:
+            self->gomx->use_pool = g_value_get_boolean (value);
+            break;
+        case ARG_POOL_SIZE:
+            {
+                guint timeout;
+
+                g_omx_pool_get_limits (NULL, &timeout);
+                g_omx_pool_set_limits (g_value_get_uint (value), timeout);
+            }
+            break;
+        case ARG_POOL_TIMEOUT:
+            {
+                guint size;
+
+                g_omx_pool_get_limits (&size, NULL);
+                g_omx_pool_set_limits (size, g_value_get_uint (value));
+            }
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -309,6 +365,58 @@ get_property (GObject *obj,
                 g_value_set_uint (value, param.nBufferCountActual);
             }
             break;
+        case ARG_PORT_STATS:
+            g_value_take_boxed (value, get_port_stats (self));
+            break;
+        case ARG_STATS_INTERVAL:
+            g_value_set_uint (value, self->stats_interval);
+            break;
+        case ARG_INPUT_THREAD_ID:
+            g_value_set_int (value, g_atomic_int_get (&self->input_tid));
+            break;
+        case ARG_OUTPUT_THREAD_ID:
+            g_value_set_int (value, g_atomic_int_get (&self->output_tid));
+            break;
+        case ARG_COMMAND_TIMEOUT:
+            g_value_set_uint (value, self->gomx->command_timeout);
+            break;
+        case ARG_COMMAND_STATS:
+            {
+                GstStructure *structure;
+
+                structure = gst_structure_new ("omx-command-stats", NULL);
+                g_omx_core_get_stats (self->gomx, structure);
+                g_value_take_boxed (value, structure);
+            }
+            break;
+        case ARG_USE_POOL:
+            g_value_set_boolean (value, self->gomx->use_pool);
+            break;
+        case ARG_POOL_SIZE:
+            {
+                guint size;
+
+                g_omx_pool_get_limits (&size, NULL);
+                g_value_set_uint (value, size);
+            }
+            break;
+        case ARG_POOL_TIMEOUT:
+            {
+                guint timeout;
+
+                g_omx_pool_get_limits (NULL, &timeout);
+                g_value_set_uint (value, timeout);
+            }
+            break;
+        case ARG_POOL_STATS:
+            {
+                GstStructure *structure;
+
+                structure = gst_structure_new ("omx-pool-stats", NULL);
+                g_omx_pool_get_stats (structure);
+                g_value_take_boxed (value, structure);
+            }
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -375,6 +483,56 @@ type_class_init (gpointer g_class,
                                          g_param_spec_uint ("output-buffers", "Output buffers",
                                                             "The number of OMX output buffers",
                                                             1, 10, 4, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_PORT_STATS,
+                                         g_param_spec_boxed ("port-stats", "Port statistics",
+                                                             "Component residency and queue depth histograms of the OMX ports, collected from the first read or once stats-interval is set",
+                                                             GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_STATS_INTERVAL,
+                                         g_param_spec_uint ("stats-interval", "Statistics interval",
+                                                            "Post port-stats as an element message every this many msec (0 = never)",
+                                                            0, G_MAXUINT, 0, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_INPUT_THREAD_ID,
+                                         g_param_spec_int ("input-thread-id", "Input thread id",
+                                                           "Kernel id of the thread feeding the input port (0 = none yet)",
+                                                           0, G_MAXINT, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_OUTPUT_THREAD_ID,
+                                         g_param_spec_int ("output-thread-id", "Output thread id",
+                                                           "Kernel id of the thread pushing output buffers (0 = none yet)",
+                                                           0, G_MAXINT, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_COMMAND_TIMEOUT,
+                                         g_param_spec_uint ("command-timeout", "Command timeout",
+                                                            "Msec to wait for a state change or port command to complete",
+                                                            1, G_MAXINT / 1000, G_OMX_CORE_DEFAULT_COMMAND_TIMEOUT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_COMMAND_STATS,
+                                         g_param_spec_boxed ("command-stats", "Command statistics",
+                                                             "Completion time histograms of state changes and port commands",
+                                                             GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_USE_POOL,
+                                         g_param_spec_boolean ("use-pool", "Use the component pool",
+                                                               "Adopt an idle component from the process-wide pool on NULL->READY and park it there on READY->NULL",
+                                                               FALSE, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_POOL_SIZE,
+                                         g_param_spec_uint ("pool-size", "Pool size",
+                                                            "Idle components the process-wide pool keeps at most (0 = disabled)",
+                                                            0, G_MAXINT, G_OMX_POOL_DEFAULT_SIZE, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_POOL_TIMEOUT,
+                                         g_param_spec_uint ("pool-timeout", "Pool timeout",
+                                                            "Msec an idle component stays in the process-wide pool (0 = until evicted by pool-size)",
+                                                            0, G_MAXINT / 1000, G_OMX_POOL_DEFAULT_TIMEOUT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_POOL_STATS,
+                                         g_param_spec_boxed ("pool-stats", "Pool statistics",
+                                                             "Idle components and hits, misses and evictions of the process-wide pool",
+                                                             GST_TYPE_STRUCTURE, G_PARAM_READABLE));
     }
 }
 
@@ -396,6 +554,39 @@ push_buffer (GstOmxBaseFilter *self,
     return ret;
 }
 
+static GstStructure *
+get_port_stats (GstOmxBaseFilter *self)
+{
+    GstStructure *structure;
+
+    /* collection starts with the first read, see g_omx_port_enable_stats() */
+    g_omx_port_enable_stats (self->in_port);
+    g_omx_port_enable_stats (self->out_port);
+
+    structure = gst_structure_new ("omx-port-stats", NULL);
+
+    g_omx_port_get_stats (self->in_port, structure, "in");
+    g_omx_port_get_stats (self->out_port, structure, "out");
+
+    return structure;
+}
+
+static void
+post_port_stats (GstOmxBaseFilter *self)
+{
+    GstClockTime now;
+
+    now = gst_util_get_timestamp ();
+
+    if (now - self->last_stats < self->stats_interval * GST_MSECOND)
+        return;
+
+    self->last_stats = now;
+
+    gst_element_post_message (GST_ELEMENT (self),
+            gst_message_new_element (GST_OBJECT (self), get_port_stats (self)));
+}
+
 static void
 output_loop (gpointer data)
 {
@@ -422,6 +613,8 @@ output_loop (gpointer data)
 
     out_port = self->out_port;
 
+    g_atomic_int_set (&self->output_tid, cpu_load_get_tid ());
+
     if (G_LIKELY (out_port->enabled))
     {
         gpointer obj = g_omx_port_recv (out_port);
@@ -458,6 +651,9 @@ output_loop (gpointer data)
                 GstBuffer *buf = GST_BUFFER (obj);
                 ret = bclass->push_buffer (self, buf);
                 GST_DEBUG_OBJECT (self, "ret=%s", gst_flow_get_name (ret));
+
+                if (self->stats_interval)
+                    post_port_stats (self);
             }
         }
         else if (GST_IS_EVENT (obj))
@@ -492,22 +688,25 @@ leave:
     gst_object_unref (self);
 }
 
+/* send @bufs to the component, starting it for the first one, and drop
+ * them; @bufs is not freed
+ */
 static GstFlowReturn
-pad_chain (GstPad *pad,
-           GstBuffer *buf)
+send_buffers (GstOmxBaseFilter *self,
+              GstBuffer **bufs,
+              guint n_bufs)
 {
     GOmxCore *gomx;
     GOmxPort *in_port;
-    GstOmxBaseFilter *self;
     GstFlowReturn ret = GST_FLOW_OK;
-
-    self = GST_OMX_BASE_FILTER (GST_OBJECT_PARENT (pad));
-
-    PRINT_BUFFER (self, buf);
+    guint i;
 
     gomx = self->gomx;
 
-    GST_LOG_OBJECT (self, "begin: size=%u, state=%d", GST_BUFFER_SIZE (buf), gomx->omx_state);
+    g_atomic_int_set (&self->input_tid, cpu_load_get_tid ());
+
+    GST_LOG_OBJECT (self, "begin: buffers=%u, size=%u, state=%d", n_bufs,
+            GST_BUFFER_SIZE (bufs[0]), gomx->omx_state);
 
     if (G_UNLIKELY (gomx->omx_state == OMX_StateLoaded))
     {
@@ -521,7 +720,7 @@ pad_chain (GstPad *pad,
             self->omx_setup (self);
         }
 
-        setup_input_buffer (self, buf);
+        gst_omx_base_filter_setup_input_port (self, self->in_port, bufs[0]);
 
         setup_ports (self);
 
@@ -542,7 +741,9 @@ pad_chain (GstPad *pad,
     in_port = self->in_port;
 
     if (G_LIKELY (in_port->enabled))
-    {        
+    {
+        gint sent;
+
         if (G_UNLIKELY (gomx->omx_state == OMX_StateIdle))
         {
             GST_INFO_OBJECT (self, "omx: play");
@@ -565,37 +766,27 @@ pad_chain (GstPad *pad,
             GST_ERROR_OBJECT (self, "Whoa! very wrong");
         }
 
-        while (TRUE)
+        if (self->last_pad_push_return != GST_FLOW_OK ||
+            !(gomx->omx_state == OMX_StateExecuting ||
+              gomx->omx_state == OMX_StatePause))
         {
-            gint sent;
-
-            if (self->last_pad_push_return != GST_FLOW_OK ||
-                !(gomx->omx_state == OMX_StateExecuting ||
-                  gomx->omx_state == OMX_StatePause))
-            {
-                GST_DEBUG_OBJECT (self, "last_pad_push_return=%d", self->last_pad_push_return);
-                goto out_flushing;
-            }
+            GST_DEBUG_OBJECT (self, "last_pad_push_return=%d", self->last_pad_push_return);
+            goto out_flushing;
+        }
 
-            sent = g_omx_port_send (in_port, buf);
+        /* buffers larger than an input header are spread over several */
+        sent = g_omx_port_send_batch (in_port, bufs, n_bufs);
 
-            if (G_UNLIKELY (sent < 0))
-            {
-                ret = GST_FLOW_WRONG_STATE;
-                goto out_flushing;
-            }
-            else if (sent < GST_BUFFER_SIZE (buf))
-            {
-                GstBuffer *subbuf = gst_buffer_create_sub (buf, sent,
-                        GST_BUFFER_SIZE (buf) - sent);
-                gst_buffer_unref (buf);
-                buf = subbuf;
-            }
-            else
-            {
-                gst_buffer_unref (buf);
-                break;
-            }
+        if (G_UNLIKELY (sent == G_OMX_PORT_SEND_MISROUTED))
+        {
+            GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                    ("input buffer does not belong to the negotiated buffer pool"));
+            ret = GST_FLOW_ERROR;
+        }
+        else if (G_UNLIKELY (sent < 0))
+        {
+            ret = GST_FLOW_WRONG_STATE;
+            goto out_flushing;
         }
     }
     else
@@ -606,6 +797,9 @@ pad_chain (GstPad *pad,
 
 leave:
 
+    for (i = 0; i < n_bufs; i++)
+        gst_buffer_unref (bufs[i]);
+
     GST_LOG_OBJECT (self, "end");
 
     return ret;
@@ -631,12 +825,96 @@ out_flushing:
             ret = GST_FLOW_ERROR;
         }
 
-        gst_buffer_unref (buf);
-
         goto leave;
     }
 }
 
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxBaseFilter *self;
+
+    self = GST_OMX_BASE_FILTER (GST_OBJECT_PARENT (pad));
+
+    PRINT_BUFFER (self, buf);
+
+    return send_buffers (self, &buf, 1);
+}
+
+/* every group of @list is one input buffer, all sent in one batch */
+static GstFlowReturn
+pad_chain_list (GstPad *pad,
+                GstBufferList *list)
+{
+    GstOmxBaseFilter *self;
+    GstBufferListIterator *it;
+    GPtrArray *bufs;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    self = GST_OMX_BASE_FILTER (GST_OBJECT_PARENT (pad));
+
+    bufs = g_ptr_array_new ();
+
+    it = gst_buffer_list_iterate (list);
+    while (gst_buffer_list_iterator_next_group (it))
+    {
+        GstBuffer *buf;
+
+        /* a group of one buffer is the common case, don't copy it */
+        if (gst_buffer_list_iterator_n_buffers (it) == 1)
+            buf = gst_buffer_ref (gst_buffer_list_iterator_next (it));
+        else
+            buf = gst_buffer_list_iterator_merge_group (it);
+
+        if (buf)
+        {
+            PRINT_BUFFER (self, buf);
+            g_ptr_array_add (bufs, buf);
+        }
+    }
+    gst_buffer_list_iterator_free (it);
+    gst_buffer_list_unref (list);
+
+    if (bufs->len)
+        ret = send_buffers (self, (GstBuffer **) bufs->pdata, bufs->len);
+
+    g_ptr_array_free (bufs, TRUE);
+
+    return ret;
+}
+
+/* for a subclass with its own pad_chain: every group of @list is one input
+ * buffer, handed to that pad_chain in turn until one fails */
+static GstFlowReturn
+pad_chain_list_each (GstPad *pad,
+                     GstBufferList *list)
+{
+    GstOmxBaseFilterClass *bclass;
+    GstBufferListIterator *it;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    bclass = GST_OMX_BASE_FILTER_GET_CLASS (GST_OBJECT_PARENT (pad));
+
+    it = gst_buffer_list_iterate (list);
+    while (ret == GST_FLOW_OK && gst_buffer_list_iterator_next_group (it))
+    {
+        GstBuffer *buf;
+
+        if (gst_buffer_list_iterator_n_buffers (it) == 1)
+            buf = gst_buffer_ref (gst_buffer_list_iterator_next (it));
+        else
+            buf = gst_buffer_list_iterator_merge_group (it);
+
+        if (buf)
+            ret = bclass->pad_chain (pad, buf);
+    }
+    gst_buffer_list_iterator_free (it);
+    gst_buffer_list_unref (list);
+
+    return ret;
+}
+
 static gboolean
 pad_event (GstPad *pad,
            GstEvent *event)
@@ -843,6 +1121,12 @@ type_instance_init (GTypeInstance *instance,
         gst_pad_new_from_template (gst_element_class_get_pad_template (element_class, "sink"), "sink");
 
     gst_pad_set_chain_function (self->sinkpad, bclass->pad_chain);
+
+    /* a subclass that handles buffers itself gets lists one by one */
+    if (bclass->pad_chain == pad_chain)
+        gst_pad_set_chain_list_function (self->sinkpad, pad_chain_list);
+    else
+        gst_pad_set_chain_list_function (self->sinkpad, pad_chain_list_each);
     gst_pad_set_event_function (self->sinkpad, bclass->pad_event);
 
     self->srcpad =
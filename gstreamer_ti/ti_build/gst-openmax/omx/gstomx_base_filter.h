@@ -59,6 +59,12 @@ struct GstOmxBaseFilter
     GstFlowReturn last_pad_push_return;
     GstBuffer *codec_data;
     GstClockTime duration;
+
+    guint stats_interval;           /**< msec between port-stats messages, 0 for none */
+    GstClockTime last_stats;
+
+    volatile gint input_tid;        /**< thread last seen in pad_chain */
+    volatile gint output_tid;       /**< thread running output_loop */
 };
 
 struct GstOmxBaseFilterClass
@@ -71,6 +77,7 @@ struct GstOmxBaseFilterClass
 };
 
 GType gst_omx_base_filter_get_type (void);
+void gst_omx_base_filter_setup_input_port (GstOmxBaseFilter *self, GOmxPort *in_port, GstBuffer *buf);
 
 G_END_DECLS
 
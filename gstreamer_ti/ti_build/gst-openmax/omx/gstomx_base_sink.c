@@ -37,6 +37,8 @@ enum
     ARG_COMPONENT_ROLE,
     ARG_COMPONENT_NAME,
     ARG_LIBRARY_NAME,
+    ARG_PORT_STATS,
+    ARG_STATS_INTERVAL,
 };
 
 static void init_interfaces (GType type);
@@ -78,7 +80,9 @@ setup_input_buffer (GstOmxBaseSink *self, GstBuffer *buf)
          */
         in_port =  self->in_port;
         in_port->share_buffer_info = malloc (sizeof(OmxBufferInfo));
-        in_port->share_buffer_info->pBuffer = malloc (sizeof(int) * port->num_buffers);
+        in_port->share_buffer_info->port = port;
+        in_port->share_buffer_info->num_buffers = port->num_buffers;
+        in_port->share_buffer_info->pBuffer = malloc (sizeof(OMX_U8 *) * port->num_buffers);
         for (i=0; i < port->num_buffers; i++) {
             in_port->share_buffer_info->pBuffer[i] = port->buffers[i]->pBuffer;
         }
@@ -185,6 +189,37 @@ finalize (GObject *obj)
     G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
+static GstStructure *
+get_port_stats (GstOmxBaseSink *self)
+{
+    GstStructure *structure;
+
+    /* collection starts with the first read, see g_omx_port_enable_stats() */
+    g_omx_port_enable_stats (self->in_port);
+
+    structure = gst_structure_new ("omx-port-stats", NULL);
+
+    g_omx_port_get_stats (self->in_port, structure, "in");
+
+    return structure;
+}
+
+static void
+post_port_stats (GstOmxBaseSink *self)
+{
+    GstClockTime now;
+
+    now = gst_util_get_timestamp ();
+
+    if (now - self->last_stats < self->stats_interval * GST_MSECOND)
+        return;
+
+    self->last_stats = now;
+
+    gst_element_post_message (GST_ELEMENT (self),
+            gst_message_new_element (GST_OBJECT (self), get_port_stats (self)));
+}
+
 static GstFlowReturn
 render (GstBaseSink *gst_base,
         GstBuffer *buf)
@@ -218,7 +253,14 @@ render (GstBaseSink *gst_base,
         {
             gint sent = g_omx_port_send (in_port, buf);
 
-            if (G_UNLIKELY (sent < 0))
+            if (G_UNLIKELY (sent == G_OMX_PORT_SEND_MISROUTED))
+            {
+                GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                        ("input buffer %p does not belong to the negotiated buffer pool", buf));
+                ret = GST_FLOW_ERROR;
+                break;
+            }
+            else if (G_UNLIKELY (sent < 0))
             {
                 ret = GST_FLOW_UNEXPECTED;
                 break;
@@ -242,6 +284,9 @@ render (GstBaseSink *gst_base,
         ret = GST_FLOW_UNEXPECTED;
     }
 
+    if (self->stats_interval)
+        post_port_stats (self);
+
     GST_LOG_OBJECT (self, "end");
 
     return ret;
@@ -324,7 +369,7 @@ buffer_alloc(GstBaseSink *base, guint64 offset, guint size, GstCaps *caps,
             g_omx_port_push_buffer (self->in_port, self->in_port->buffers[i]);
     }
 
-    omx_buffer = async_queue_pop (self->in_port->queue);
+    omx_buffer = async_ring_pop (self->in_port->queue);
     omx_buffer->nFilledLen = size;
     *buf = gst_omxbuffertransport_new (self->in_port, omx_buffer);
 
@@ -356,6 +401,13 @@ set_property (GObject *obj,
             g_free (self->omx_library);
             self->omx_library = g_value_dup_string (value);
             break;
+        case ARG_STATS_INTERVAL:
+            self->stats_interval = g_value_get_uint (value);
+            if (self->stats_interval)
+            {
+                g_omx_port_enable_stats (self->in_port);
+            }
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -383,6 +435,12 @@ get_property (GObject *obj,
         case ARG_LIBRARY_NAME:
             g_value_set_string (value, self->omx_library);
             break;
+        case ARG_PORT_STATS:
+            g_value_take_boxed (value, get_port_stats (self));
+            break;
+        case ARG_STATS_INTERVAL:
+            g_value_set_uint (value, self->stats_interval);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -434,6 +492,16 @@ type_class_init (gpointer g_class,
                                          g_param_spec_string ("library-name", "Library name",
                                                               "Name of the OpenMAX IL implementation library to use",
                                                               NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_PORT_STATS,
+                                         g_param_spec_boxed ("port-stats", "Port statistics",
+                                                             "Component residency and queue depth histograms of the OMX port, collected from the first read or once stats-interval is set",
+                                                             GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_STATS_INTERVAL,
+                                         g_param_spec_uint ("stats-interval", "Statistics interval",
+                                                            "Post port-stats as an element message every this many msec (0 = never)",
+                                                            0, G_MAXUINT, 0, G_PARAM_READWRITE));
     }
 }
 
@@ -55,6 +55,9 @@ struct GstOmxBaseSink
     gboolean initialized;
     gboolean port_initialized;
     GstOmxSinkCb omx_setup;
+
+    guint stats_interval;           /**< msec between port-stats messages, 0 for none */
+    GstClockTime last_stats;
 };
 
 struct GstOmxBaseSinkClass
@@ -31,8 +31,16 @@ enum
 {
     ARG_0,
     ARG_PORT_INDEX,
+    ARG_MIN_OUTPUT_BUFFERS,
+    ARG_MAX_OUTPUT_BUFFERS,
+    ARG_PEAK_OUTPUT_BUFFERS,
+    ARG_LAZY_CROP,
 };
 
+#define DEFAULT_MIN_OUTPUT_BUFFERS 2
+#define DEFAULT_MAX_OUTPUT_BUFFERS 16
+#define DEFAULT_LAZY_CROP FALSE
+
 GSTOMX_BOILERPLATE (GstOmxBaseVfpc, gst_omx_base_vfpc, GstOmxBaseFilter, GST_OMX_BASE_FILTER_TYPE);
 
 static GstFlowReturn push_buffer (GstOmxBaseFilter *self, GstBuffer *buf);
@@ -52,7 +60,9 @@ pad_event (GstPad *pad, GstEvent *event)
     {
         case GST_EVENT_CROP:
         {
-            gst_event_parse_crop (event, &self->top, &self->left, NULL, NULL);
+            gst_event_parse_crop (event, &self->top, &self->left,
+                    &self->crop_width, &self->crop_height);
+            gst_event_unref (event);
             return TRUE;
         }
         default:
@@ -62,6 +72,125 @@ pad_event (GstPad *pad, GstEvent *event)
     }
 }
 
+/**
+ * Caps for passing the input through unchanged, but described as the
+ * crop region: same format, the crop size and the input rowstride.  The
+ * position of the region goes downstream in a crop event, the way the
+ * decoders report their padding.
+ */
+static GstCaps *
+create_crop_caps (GstOmxBaseVfpc *self)
+{
+    GstOmxBaseFilter *omx_base;
+    GstStructure *structure;
+    GstCaps *caps;
+    gint width, height;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    if (!GST_PAD_CAPS (omx_base->sinkpad))
+        return NULL;
+
+    width = self->crop_width > 0 ? self->crop_width : self->in_width;
+    height = self->crop_height > 0 ? self->crop_height : self->in_height;
+
+    if (width > self->in_width || height > self->in_height)
+        return NULL;
+
+    caps = gst_caps_copy (GST_PAD_CAPS (omx_base->sinkpad));
+    structure = gst_caps_get_structure (caps, 0);
+    gst_structure_set_name (structure, "video/x-raw-yuv-strided");
+    gst_structure_set (structure,
+            "width", G_TYPE_INT, width,
+            "height", G_TYPE_INT, height,
+            "rowstride", G_TYPE_INT, self->in_stride,
+            NULL);
+
+    return caps;
+}
+
+/**
+ * A crop needs no pass through the component when downstream prefers the
+ * input format at the crop size.  "Prefers" is the first structure it
+ * offers that we can produce, so elements that would otherwise convert
+ * still do so for peers that take anything.
+ */
+static gboolean
+setup_in_place (GstOmxBaseVfpc *self)
+{
+    GstOmxBaseFilter *omx_base;
+    GstCaps *caps, *peer_caps, *allowed;
+    gboolean ret = FALSE;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    caps = create_crop_caps (self);
+    if (!caps)
+        return FALSE;
+
+    peer_caps = gst_pad_peer_get_caps (omx_base->srcpad);
+    if (peer_caps)
+    {
+        allowed = gst_caps_intersect (peer_caps,
+                gst_pad_get_pad_template_caps (omx_base->srcpad));
+
+        if (!gst_caps_is_empty (allowed))
+        {
+            GstCaps *first;
+
+            first = gst_caps_copy_nth (allowed, 0);
+            ret = gst_caps_can_intersect (first, caps);
+            gst_caps_unref (first);
+        }
+
+        gst_caps_unref (allowed);
+        gst_caps_unref (peer_caps);
+    }
+
+    if (ret)
+        ret = gst_pad_set_caps (omx_base->srcpad, caps);
+
+    if (ret)
+        GST_INFO_OBJECT (self, "cropping in place to %" GST_PTR_FORMAT, caps);
+
+    gst_caps_unref (caps);
+
+    return ret;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad, GstBuffer *buf)
+{
+    GstOmxBaseVfpc *self;
+    GstOmxBaseFilter *omx_base;
+
+    self = GST_OMX_BASE_VFPC (GST_OBJECT_PARENT (pad));
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    /* decide before the component is set up, and stick to it after */
+    if (G_UNLIKELY (!self->crop_checked))
+    {
+        self->in_place = self->lazy_crop && !omx_base->ready &&
+            setup_in_place (self);
+        self->crop_checked = TRUE;
+    }
+
+    if (!self->in_place)
+        return parent_class->pad_chain (pad, buf);
+
+    if (self->left || self->top)
+    {
+        gst_pad_push_event (omx_base->srcpad,
+                gst_event_new_crop (self->top, self->left,
+                        self->out_width, self->out_height));
+    }
+
+    buf = gst_buffer_make_metadata_writable (buf);
+    gst_buffer_set_caps (buf, GST_PAD_CAPS (omx_base->srcpad));
+
+    return push_buffer (omx_base, buf);
+}
+
 static void
 gstomx_vfpc_set_port_index (GObject *obj, int index)
 {
@@ -180,6 +309,9 @@ sink_setcaps (GstPad *pad,
         }
     }
 
+    /* new input, look at cropping in place again */
+    self->crop_checked = FALSE;
+
     if (self->sink_setcaps)
         self->sink_setcaps (pad, caps);
 
@@ -223,6 +355,82 @@ src_setcaps (GstPad *pad, GstCaps *caps)
     return TRUE;
 }
 
+/**
+ * Pick nBufferCountActual for an output port feeding @srcpad: what the
+ * component needs (@min_count) plus one being pushed plus what downstream
+ * holds on to.  Downstream is asked with a buffers query and a latency
+ * query, the latter counted in frames of @duration; if neither is answered
+ * @fallback is used instead.  The result is kept within the
+ * min-output-buffers and max-output-buffers properties, but never below
+ * @min_count.
+ */
+OMX_U32
+gst_omx_base_vfpc_get_output_buffer_count (GstOmxBaseVfpc *self,
+                                           GstPad *srcpad,
+                                           GstClockTime duration,
+                                           OMX_U32 min_count,
+                                           OMX_U32 fallback)
+{
+    GstQuery *query;
+    GstCaps *caps;
+    guint downstream = 0;
+    gboolean answered = FALSE;
+    OMX_U32 count;
+
+    caps = gst_pad_get_negotiated_caps (srcpad);
+    if (caps)
+    {
+        gint buffers = 0;
+
+        query = gst_query_new_buffers (caps);
+        if (gst_pad_peer_query (srcpad, query))
+        {
+            gst_query_parse_buffers_count (query, &buffers);
+            if (buffers > 0)
+            {
+                downstream = buffers;
+                answered = TRUE;
+            }
+        }
+        gst_query_unref (query);
+        gst_caps_unref (caps);
+    }
+
+    query = gst_query_new_latency ();
+    if (gst_pad_peer_query (srcpad, query))
+    {
+        gboolean live;
+        GstClockTime min_latency, max_latency;
+
+        gst_query_parse_latency (query, &live, &min_latency, &max_latency);
+
+        if (GST_CLOCK_TIME_IS_VALID (duration) && duration > 0 &&
+            GST_CLOCK_TIME_IS_VALID (min_latency))
+        {
+            /* frames queued before the first one is rendered, plus that one */
+            guint frames = (min_latency + duration - 1) / duration + 1;
+
+            downstream = MAX (downstream, frames);
+            answered = TRUE;
+        }
+    }
+    gst_query_unref (query);
+
+    if (answered)
+        count = min_count + 1 + downstream;
+    else
+        count = fallback;
+
+    count = CLAMP (count, self->min_output_buffers, self->max_output_buffers);
+    count = MAX (count, min_count);
+
+    GST_INFO_OBJECT (self, "%s: %lu output buffers (component needs %lu, "
+            "downstream %s %u)", GST_PAD_NAME (srcpad), count, min_count,
+            answered ? "holds" : "did not say,", downstream);
+
+    return count;
+}
+
 static void
 set_property (GObject *obj,
               guint prop_id,
@@ -242,6 +450,15 @@ set_property (GObject *obj,
             if (!self->port_configured) 
                 gstomx_vfpc_set_port_index (obj, self->port_index);
             break;
+        case ARG_MIN_OUTPUT_BUFFERS:
+            self->min_output_buffers = g_value_get_uint (value);
+            break;
+        case ARG_MAX_OUTPUT_BUFFERS:
+            self->max_output_buffers = g_value_get_uint (value);
+            break;
+        case ARG_LAZY_CROP:
+            self->lazy_crop = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -255,7 +472,9 @@ get_property (GObject *obj,
               GParamSpec *pspec)
 {
     GstOmxBaseVfpc *self;
+    GstOmxBaseFilter *omx_base;
 
+    omx_base = GST_OMX_BASE_FILTER (obj);
     self = GST_OMX_BASE_VFPC (obj);
 
     switch (prop_id)
@@ -263,6 +482,19 @@ get_property (GObject *obj,
         case ARG_PORT_INDEX:
             g_value_set_uint (value, self->port_index);
             break;
+        case ARG_MIN_OUTPUT_BUFFERS:
+            g_value_set_uint (value, self->min_output_buffers);
+            break;
+        case ARG_MAX_OUTPUT_BUFFERS:
+            g_value_set_uint (value, self->max_output_buffers);
+            break;
+        case ARG_LAZY_CROP:
+            g_value_set_boolean (value, self->lazy_crop);
+            break;
+        case ARG_PEAK_OUTPUT_BUFFERS:
+            g_value_set_uint (value,
+                    g_atomic_int_get (&omx_base->out_port->stats.max_outstanding));
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -274,29 +506,26 @@ omx_setup (GstOmxBaseFilter *omx_base)
 {
     GstOmxBaseVfpc *self;
     GOmxCore *gomx;
-    GOmxPort *port;
 
     self = GST_OMX_BASE_VFPC (omx_base);
     gomx = (GOmxCore *) omx_base->gomx;
 
     GST_INFO_OBJECT (omx_base, "begin");
 
+    /* subclasses may leave port enables of their own in flight */
     if (self->omx_setup)
     {
         self->omx_setup (omx_base);
     }
-    
-    /* enable input port */
-    port = omx_base->in_port;
-    OMX_SendCommand (g_omx_core_get_handle (port->core),
-            OMX_CommandPortEnable, port->port_index, NULL);
-    g_sem_down (port->core->port_sem);
-
-    /* enable output port */
-    port = omx_base->out_port;
-    OMX_SendCommand (g_omx_core_get_handle (port->core),
-            OMX_CommandPortEnable, port->port_index, NULL);
-    g_sem_down (port->core->port_sem);
+
+    /* enable input and output port, and wait for all enables at once */
+    g_omx_core_send_command (gomx, OMX_CommandPortEnable,
+            omx_base->in_port->port_index);
+    g_omx_core_send_command (gomx, OMX_CommandPortEnable,
+            omx_base->out_port->port_index);
+
+    if (!g_omx_core_wait_for_commands (gomx, 0))
+        GST_ERROR_OBJECT (omx_base, "enabling ports failed");
 
     /* indicate that port is now configured */
     self->port_configured = TRUE;
@@ -312,6 +541,7 @@ type_class_init (gpointer g_class,
 
     gobject_class = G_OBJECT_CLASS (g_class);
     GST_OMX_BASE_FILTER_CLASS (g_class)->push_buffer = push_buffer;
+    GST_OMX_BASE_FILTER_CLASS (g_class)->pad_chain = pad_chain;
 
     /* Properties stuff */
     {
@@ -322,6 +552,26 @@ type_class_init (gpointer g_class,
                                          g_param_spec_uint ("port-index", "port index",
                                                             "input/output start port index",
                                                             0, 8, 0, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_MIN_OUTPUT_BUFFERS,
+                                         g_param_spec_uint ("min-output-buffers", "Minimum output buffers",
+                                                            "Fewest OMX output buffers to allocate, whatever downstream says",
+                                                            1, 32, DEFAULT_MIN_OUTPUT_BUFFERS, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_MAX_OUTPUT_BUFFERS,
+                                         g_param_spec_uint ("max-output-buffers", "Maximum output buffers",
+                                                            "Most OMX output buffers to allocate, unless the component needs more",
+                                                            1, 32, DEFAULT_MAX_OUTPUT_BUFFERS, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_PEAK_OUTPUT_BUFFERS,
+                                         g_param_spec_uint ("peak-output-buffers", "Peak output buffers",
+                                                            "Most OMX output buffers out of the component (queued or downstream) at once, counted with or without port-stats",
+                                                            0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_LAZY_CROP,
+                                         g_param_spec_boolean ("lazy-crop", "Lazy crop",
+                                                               "Pass the input through with a crop event instead of processing it, when downstream takes the input format at the crop size (downstream must honor crop events)",
+                                                               DEFAULT_LAZY_CROP, G_PARAM_READWRITE));
     }
 }
 
@@ -337,6 +587,9 @@ type_instance_init (GTypeInstance *instance,
 
     omx_base->omx_setup = omx_setup;
     self->g_class = g_class;
+    self->min_output_buffers = DEFAULT_MIN_OUTPUT_BUFFERS;
+    self->max_output_buffers = DEFAULT_MAX_OUTPUT_BUFFERS;
+    self->lazy_crop = DEFAULT_LAZY_CROP;
 
     gst_pad_set_setcaps_function (omx_base->sinkpad,
             GST_DEBUG_FUNCPTR (sink_setcaps));
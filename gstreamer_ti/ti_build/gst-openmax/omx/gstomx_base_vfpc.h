@@ -51,6 +51,11 @@ struct GstOmxBaseVfpc
     gint out_width, out_height, out_stride;
     gint left, top;
     gint port_index, input_port_index, output_port_index;
+    guint min_output_buffers, max_output_buffers;
+    gint crop_width, crop_height;
+    gboolean lazy_crop;         /**< crop without the component when possible */
+    gboolean crop_checked;      /**< in_place decided for the current caps */
+    gboolean in_place;          /**< pass input through with a crop event */
     GstOmxBaseFilterCb omx_setup;
     gpointer g_class;
 };
@@ -61,6 +66,9 @@ struct GstOmxBaseVfpcClass
 };
 
 GType gst_omx_base_vfpc_get_type (void);
+OMX_U32 gst_omx_base_vfpc_get_output_buffer_count (GstOmxBaseVfpc *self, GstPad *srcpad,
+                                                   GstClockTime duration, OMX_U32 min_count,
+                                                   OMX_U32 fallback);
 
 G_END_DECLS
 
@@ -59,6 +59,7 @@ static void gst_omxbuffertransport_init(GstOmxBufferTransport *self)
 
     self->omxbuffer = NULL;
     self->port = NULL;
+    self->index = -1;
 
     GST_LOG("end\n");
 }
@@ -88,6 +89,7 @@ release_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
             /* do nothing */
             break;
         case GOMX_PORT_OUTPUT:
+            g_omx_port_stats_released (port, omx_buffer);
             GST_LOG ("FTB: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
                     omx_buffer, omx_buffer ? omx_buffer->pAppPrivate : 0, omx_buffer ? omx_buffer->pBuffer : 0);
             OMX_FillThisBuffer (port->core->omx_handle, omx_buffer);
@@ -138,6 +140,7 @@ GstBuffer* gst_omxbuffertransport_new (GOmxPort *port, OMX_BUFFERHEADERTYPE *buf
 
     tdt_buf->omxbuffer  = buffer;
     tdt_buf->port       = port;
+    tdt_buf->index      = g_omx_port_get_buffer_index (port, buffer);
 
     GST_LOG("end new\n");
 
@@ -52,6 +52,8 @@ typedef struct _GstOmxBufferTransportClass GstOmxBufferTransportClass;
     ((obj) ? GST_OMXBUFFERTRANSPORT(obj)->omxbuffer : NULL)
 #define GST_GET_OMXPORT(obj) \
     ((obj) ? GST_OMXBUFFERTRANSPORT(obj)->port : NULL)
+#define GST_GET_OMXBUFFER_INDEX(obj) \
+    ((obj) ? GST_OMXBUFFERTRANSPORT(obj)->index : -1)
 
 
 /* _GstOmxBufferTransport object */
@@ -59,6 +61,7 @@ struct _GstOmxBufferTransport {
     GstBuffer  parent_instance;
     OMX_BUFFERHEADERTYPE *omxbuffer;
     GOmxPort *port;
+    gint index;     /* index of omxbuffer in port->buffers, -1 if unknown */
 };
 
 struct _GstOmxBufferTransportClass {
@@ -711,8 +711,8 @@ src_setcaps (GstPad *pad, GstCaps *caps)
             if (err != OMX_ErrorNone)
                 return FALSE;
 
-            if (port_enabled)
-                g_omx_port_enable (omx_base->out_port);
+            if (port_enabled && !g_omx_port_enable (omx_base->out_port))
+                return FALSE;
         }
 
         GST_INFO_OBJECT (omx_base, " Rowstride=%d, Width=%d, Height=%d, Color=%d, Buffersize=%d, framerate=%d",
@@ -21,6 +21,7 @@
  */
 
 #include "gstomx_util.h"
+#include "gstomx_pool.h"
 #include "gstomx.h"
 
 #ifdef USE_OMXTICORE
@@ -76,6 +77,12 @@ FillBufferDone (OMX_HANDLETYPE omx_handle,
 
 static inline GOmxPort *get_port (GOmxCore *core, guint index);
 
+static void
+complete_command (GOmxCore *core,
+                  OMX_COMMANDTYPE cmd,
+                  OMX_U32 param,
+                  gboolean *tracked);
+
 
 static OMX_CALLBACKTYPE callbacks = { EventHandler, EmptyBufferDone, FillBufferDone };
 
@@ -84,6 +91,16 @@ static OMX_CALLBACKTYPE callbacks = { EventHandler, EmptyBufferDone, FillBufferD
  * Util
  */
 
+/** a command sent with g_omx_core_send_command() */
+typedef struct
+{
+    OMX_COMMANDTYPE cmd;
+    OMX_U32 param;
+    OMX_STATETYPE from;     /**< for OMX_CommandStateSet */
+    GstClockTime sent;
+    GThread *waiter;        /**< NULL if nobody waits for it (any more) */
+} GOmxCommand;
+
 static void
 g_ptr_array_clear (GPtrArray *array)
 {
@@ -124,6 +141,112 @@ core_for_each_port (GOmxCore *core,
     }
 }
 
+/* for restore_ports(), if the core uses the pool */
+static void
+save_port_defaults (GOmxPort *port)
+{
+    GOmxCore *core = port->core;
+
+    if (!core->use_pool || !core->omx_handle || port->defaults)
+        return;
+
+    port->defaults = g_new0 (OMX_PARAM_PORTDEFINITIONTYPE, 1);
+    _G_OMX_INIT_PARAM (port->defaults);
+    port->defaults->nPortIndex = port->port_index;
+
+    if (OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition,
+                          port->defaults) != OMX_ErrorNone)
+    {
+        g_free (port->defaults);
+        port->defaults = NULL;
+    }
+}
+
+static gboolean
+same_port_definition (const OMX_PARAM_PORTDEFINITIONTYPE *a,
+                      const OMX_PARAM_PORTDEFINITIONTYPE *b)
+{
+    if (a->bEnabled != b->bEnabled ||
+        a->nBufferCountActual != b->nBufferCountActual ||
+        a->nBufferSize != b->nBufferSize ||
+        a->eDomain != b->eDomain)
+        return FALSE;
+
+    if (a->eDomain == OMX_PortDomainVideo)
+    {
+        return a->format.video.nFrameWidth == b->format.video.nFrameWidth &&
+            a->format.video.nFrameHeight == b->format.video.nFrameHeight &&
+            a->format.video.nStride == b->format.video.nStride &&
+            a->format.video.eColorFormat == b->format.video.eColorFormat &&
+            a->format.video.eCompressionFormat == b->format.video.eCompressionFormat;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Put every port back the way save_port_defaults() found it: enabled or
+ * not, and its definition.  Only in OMX_StateLoaded, where enabling and
+ * disabling ports involves no buffers.
+ *
+ * Returns FALSE if a port could not be put back, the handle must not go
+ * to the pool then.
+ */
+static gboolean
+restore_ports (GOmxCore *core)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    guint index;
+
+    for (index = 0; index < core->ports->len; index++)
+    {
+        GOmxPort *port = get_port (core, index);
+
+        if (!port)
+            continue;
+
+        if (!port->defaults)
+            return FALSE;
+
+        _G_OMX_INIT_PARAM (&param);
+        param.nPortIndex = port->port_index;
+        OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param);
+
+        if (param.bEnabled != port->defaults->bEnabled &&
+            !g_omx_core_send_command (core, port->defaults->bEnabled ?
+                                      OMX_CommandPortEnable : OMX_CommandPortDisable,
+                                      port->port_index))
+            return FALSE;
+    }
+
+    if (!g_omx_core_wait_for_commands (core, 0))
+        return FALSE;
+
+    for (index = 0; index < core->ports->len; index++)
+    {
+        GOmxPort *port = get_port (core, index);
+
+        if (!port)
+            continue;
+
+        OMX_SetParameter (core->omx_handle, OMX_IndexParamPortDefinition,
+                          port->defaults);
+
+        _G_OMX_INIT_PARAM (&param);
+        param.nPortIndex = port->port_index;
+        if (OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition,
+                              &param) != OMX_ErrorNone ||
+            !same_port_definition (port->defaults, &param))
+        {
+            GST_DEBUG_OBJECT (core->object, "could not restore port %d",
+                    port->port_index);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 
 /*
  * Core
@@ -154,6 +277,10 @@ g_omx_core_new (gpointer object, gpointer klass)
     core->flush_sem = g_sem_new ();
     core->port_sem = g_sem_new ();
 
+    core->command_mutex = g_mutex_new ();
+    core->command_cond = g_cond_new ();
+    core->command_timeout = G_OMX_CORE_DEFAULT_COMMAND_TIMEOUT;
+
     core->omx_state = OMX_StateInvalid;
 
     core->use_timestamps = TRUE;
@@ -192,6 +319,11 @@ g_omx_core_free (GOmxCore *core)
     g_mutex_free (core->omx_state_mutex);
     g_cond_free (core->omx_state_condition);
 
+    g_list_foreach (core->commands, (GFunc) g_free, NULL);
+    g_list_free (core->commands);
+    g_cond_free (core->command_cond);
+    g_mutex_free (core->command_mutex);
+
     g_ptr_array_free (core->ports, TRUE);
 
     g_free (core);
@@ -201,6 +333,7 @@ void
 g_omx_core_init (GOmxCore *core)
 {
     gchar *library_name=NULL, *component_name=NULL, *component_role=NULL;
+    gchar *key;
 
     if (core->omx_handle)
       return;
@@ -217,26 +350,49 @@ g_omx_core_init (GOmxCore *core)
     g_return_if_fail (component_name);
     g_return_if_fail (library_name);
 
+    key = g_omx_pool_key (library_name, component_name, component_role);
+
+    if (core->use_pool && g_omx_pool_adopt (core, key))
+    {
+        /* same role, and the ports are as OMX_GetHandle() left them */
+        g_free (key);
+        core->omx_error = OMX_ErrorNone;
+        goto loaded;
+    }
+
     core->imp = g_omx_request_imp (library_name);
 
     if (!core->imp)
-        return;
+    {
+        g_free (key);
+        goto leave;
+    }
+
+    core->app_data = g_new0 (GOmxAppData, 1);
+    core->app_data->core = core;
+    core->app_data->key = key;
 
     #ifdef USE_STATIC
     core->omx_error = core->imp->sym_table.get_handle (&core->omx_handle,
                                                        (char *) component_name,
-                                                       core,
+                                                       core->app_data,
                                                        &callbacks);
     #else
     core->omx_error = OMX_GetHandle (&core->omx_handle, (char *) component_name,
-                                                       core,
+                                                       core->app_data,
                                                        &callbacks);
     #endif
 
     GST_DEBUG_OBJECT (core->object, "OMX_GetHandle(&%p) -> %s",
         core->omx_handle, g_omx_error_to_str (core->omx_error));
 
-    g_return_if_fail (core->omx_handle);
+    if (!core->omx_handle)
+    {
+        g_free (core->app_data->key);
+        g_free (core->app_data);
+        core->app_data = NULL;
+        goto leave;
+    }
 
     if (component_role)
     {
@@ -252,15 +408,19 @@ g_omx_core_init (GOmxCore *core)
 
         G_OMX_CORE_SET_PARAM (core,
                 OMX_IndexParamStandardComponentRole, &param);
+    }
 
-        g_free (component_role);
+loaded:
+    if (!core->omx_error)
+    {
+        core->omx_state = OMX_StateLoaded;
+        core_for_each_port (core, save_port_defaults);
     }
 
+leave:
+    g_free (component_role);
     g_free (component_name);
     g_free (library_name);
-
-    if (!core->omx_error)
-        core->omx_state = OMX_StateLoaded;
 }
 
 void 
@@ -270,15 +430,261 @@ g_omx_core_change_state (GOmxCore *core, OMX_STATETYPE state)
     wait_for_state (core, state);
 }
 
+/* Forget the commands nobody waits for (state sets, and commands given up
+ * on by g_omx_core_wait_for_commands()) that are older than command_timeout:
+ * a component that did not complete them by then most likely never will.
+ * Called with command_mutex held.
+ */
+static void
+expire_commands (GOmxCore *core,
+                 GstClockTime now)
+{
+    GList *l, *next;
+
+    for (l = core->commands; l; l = next)
+    {
+        GOmxCommand *command = l->data;
+
+        next = l->next;
+
+        if (command->waiter ||
+            now - command->sent < core->command_timeout * GST_MSECOND)
+            continue;
+
+        GST_DEBUG_OBJECT (core->object, "forgetting command %d (%lu)",
+                command->cmd, command->param);
+
+        core->commands = g_list_delete_link (core->commands, l);
+        g_free (command);
+    }
+}
+
+static gboolean
+track_command (GOmxCore *core,
+               OMX_COMMANDTYPE cmd,
+               OMX_U32 param,
+               GThread *waiter)
+{
+    GOmxCommand *command;
+    OMX_ERRORTYPE err;
+
+    command = g_new0 (GOmxCommand, 1);
+    command->cmd = cmd;
+    command->param = param;
+    command->from = core->omx_state;
+    command->waiter = waiter;
+
+    /* the component may complete it before OMX_SendCommand() returns */
+    g_mutex_lock (core->command_mutex);
+    command->sent = gst_util_get_timestamp ();
+    expire_commands (core, command->sent);
+    core->commands = g_list_append (core->commands, command);
+    g_mutex_unlock (core->command_mutex);
+
+    err = OMX_SendCommand (g_omx_core_get_handle (core), cmd, param, NULL);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ERROR_OBJECT (core->object, "OMX_SendCommand(%d, %lu) -> %s",
+                cmd, param, g_omx_error_to_str (err));
+
+        g_mutex_lock (core->command_mutex);
+        core->commands = g_list_remove (core->commands, command);
+        g_mutex_unlock (core->command_mutex);
+        g_free (command);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Send @cmd without waiting for it to complete, so that several commands
+ * (port enables, a state set..) can be in flight at once.  Wait for all of
+ * them with g_omx_core_wait_for_commands().  Completions of commands sent
+ * this way do not go to port_sem/flush_sem.
+ *
+ * Returns FALSE if the component refused the command.
+ */
+gboolean
+g_omx_core_send_command (GOmxCore *core,
+                         OMX_COMMANDTYPE cmd,
+                         OMX_U32 param)
+{
+    GST_DEBUG_OBJECT (core->object, "cmd=%d, param=%lu", cmd, param);
+
+    return track_command (core, cmd, param, g_thread_self ());
+}
+
+static gboolean
+has_pending_commands (GOmxCore *core, GThread *waiter)
+{
+    GList *l;
+
+    for (l = core->commands; l; l = l->next)
+    {
+        if (((GOmxCommand *) l->data)->waiter == waiter)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void
+abandon_commands (GOmxCore *core, GThread *waiter)
+{
+    GList *l;
+
+    for (l = core->commands; l; l = l->next)
+    {
+        GOmxCommand *command = l->data;
+
+        if (command->waiter != waiter)
+            continue;
+
+        GST_ERROR_OBJECT (core->object, "no completion for command %d (%lu)",
+                command->cmd, command->param);
+
+        command->waiter = NULL;
+        core->stats.timeouts++;
+    }
+}
+
+/**
+ * Wait until every command this thread sent with g_omx_core_send_command()
+ * completed, for at most @timeout msec (0 = command_timeout).
+ *
+ * Returns FALSE on timeout or if the component reported an error; the
+ * commands still pending are then forgotten.
+ */
+gboolean
+g_omx_core_wait_for_commands (GOmxCore *core,
+                              guint timeout)
+{
+    GThread *waiter = g_thread_self ();
+    GTimeVal deadline;
+    gboolean ret = TRUE;
+
+    if (!timeout)
+        timeout = core->command_timeout;
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, (glong) timeout * 1000);
+
+    g_mutex_lock (core->command_mutex);
+
+    while (has_pending_commands (core, waiter))
+    {
+        if (core->omx_error != OMX_ErrorNone)
+        {
+            ret = FALSE;
+            break;
+        }
+
+        if (!g_cond_timed_wait (core->command_cond, core->command_mutex, &deadline) &&
+            has_pending_commands (core, waiter))
+        {
+            GST_ERROR_OBJECT (core->object, "timed out after %u ms", timeout);
+            ret = FALSE;
+            break;
+        }
+    }
+
+    if (!ret)
+        abandon_commands (core, waiter);
+
+    g_mutex_unlock (core->command_mutex);
+
+    return ret;
+}
+
+static const gchar *
+state_name (guint state)
+{
+    switch (state)
+    {
+        case OMX_StateInvalid: return "invalid";
+        case OMX_StateLoaded: return "loaded";
+        case OMX_StateIdle: return "idle";
+        case OMX_StateExecuting: return "executing";
+        case OMX_StatePause: return "pause";
+        case OMX_StateWaitForResources: return "wait-for-resources";
+        default: return "unknown";
+    }
+}
+
+static gboolean
+histogram_is_empty (const guint *histogram)
+{
+    guint i;
+
+    for (i = 0; i < G_OMX_HISTOGRAM_BUCKETS; i++)
+    {
+        if (g_atomic_int_get ((gint *) &histogram[i]))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Add the command completion times to @structure: a histogram (usec, see
+ * GOmxCoreStats) per state transition seen, named "state-FROM-to-TO", as
+ * well as "port-enable", "port-disable", "flush", and the number of
+ * commands given up on as "command-timeouts".
+ */
+void
+g_omx_core_get_stats (GOmxCore *core,
+                      GstStructure *structure)
+{
+    guint from, to;
+
+    for (from = 0; from < G_OMX_CORE_NUM_STATES; from++)
+    {
+        for (to = 0; to < G_OMX_CORE_NUM_STATES; to++)
+        {
+            gchar *field;
+
+            if (histogram_is_empty (core->stats.state[from][to]))
+                continue;
+
+            field = g_strdup_printf ("state-%s-to-%s",
+                    state_name (from), state_name (to));
+            g_omx_histogram_set (structure, field, core->stats.state[from][to]);
+            g_free (field);
+        }
+    }
+
+    g_omx_histogram_set (structure, "port-enable", core->stats.port_enable);
+    g_omx_histogram_set (structure, "port-disable", core->stats.port_disable);
+    g_omx_histogram_set (structure, "flush", core->stats.flush);
+
+    gst_structure_set (structure, "command-timeouts", G_TYPE_UINT,
+            core->stats.timeouts, NULL);
+}
+
 void
 g_omx_core_deinit (GOmxCore *core)
 {
+    gboolean parked = FALSE;
+
     if (!core->imp)
         return;
 
+    if (core->use_pool && core->omx_handle &&
+        core->omx_state == OMX_StateLoaded &&
+        core->omx_error == OMX_ErrorNone)
+    {
+        parked = restore_ports (core) && g_omx_pool_park (core);
+    }
+
     core_for_each_port (core, g_omx_port_free);
     g_ptr_array_clear (core->ports);
 
+    if (parked)
+        return;
+
     if (core->omx_state == OMX_StateLoaded ||
         core->omx_state == OMX_StateInvalid)
     {
@@ -295,6 +701,14 @@ g_omx_core_deinit (GOmxCore *core)
         }
     }
 
+    /* the component may still call back if it could not be freed */
+    if (!core->omx_handle && core->app_data)
+    {
+        g_free (core->app_data->key);
+        g_free (core->app_data);
+        core->app_data = NULL;
+    }
+
     g_omx_release_imp (core->imp);
     core->imp = NULL;
 }
@@ -405,6 +819,7 @@ g_omx_core_get_port (GOmxCore *core, const gchar *name, guint index)
     {
         port = g_omx_port_new (core, name, index);
         g_ptr_array_insert (core->ports, index, port);
+        save_port_defaults (port);
     }
 
     return port;
@@ -467,7 +882,98 @@ change_state (GOmxCore *core,
               OMX_STATETYPE state)
 {
     GST_DEBUG_OBJECT (core->object, "state=%d", state);
-    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, state, NULL);
+
+    /* timed, but waited for with wait_for_state() */
+    track_command (core, OMX_CommandStateSet, state, NULL);
+}
+
+static GList *
+find_command (GOmxCore *core,
+              OMX_COMMANDTYPE cmd,
+              OMX_U32 param,
+              gboolean waited)
+{
+    GList *l;
+
+    for (l = core->commands; l; l = l->next)
+    {
+        GOmxCommand *command = l->data;
+
+        if (command->cmd == cmd && command->param == param &&
+            (command->waiter != NULL) == waited)
+            return l;
+    }
+
+    return NULL;
+}
+
+/* Account a completed command, and tell whether a g_omx_core_send_command()
+ * caller waits for it: those completions do not signal the semaphores.
+ * The oldest matching command with a waiter goes first.  A completion that
+ * only matches a command nobody waits for (a state set, or one given up on)
+ * consumes it, but still signals the semaphores in case a caller of
+ * OMX_SendCommand() waits on them for the same command.
+ */
+static void
+complete_command (GOmxCore *core,
+                  OMX_COMMANDTYPE cmd,
+                  OMX_U32 param,
+                  gboolean *tracked)
+{
+    GOmxCommand *command = NULL;
+    GList *l;
+
+    g_mutex_lock (core->command_mutex);
+
+    l = find_command (core, cmd, param, TRUE);
+    if (!l)
+        l = find_command (core, cmd, param, FALSE);
+
+    *tracked = FALSE;
+
+    if (l)
+    {
+        guint64 usec;
+        guint *histogram = NULL;
+
+        command = l->data;
+        *tracked = (command->waiter != NULL);
+
+        core->commands = g_list_delete_link (core->commands, l);
+
+        usec = (gst_util_get_timestamp () - command->sent) / GST_USECOND;
+
+        switch (cmd)
+        {
+            case OMX_CommandStateSet:
+                if (command->from < G_OMX_CORE_NUM_STATES &&
+                    param < G_OMX_CORE_NUM_STATES)
+                    histogram = core->stats.state[command->from][param];
+                break;
+            case OMX_CommandPortEnable:
+                histogram = core->stats.port_enable;
+                break;
+            case OMX_CommandPortDisable:
+                histogram = core->stats.port_disable;
+                break;
+            case OMX_CommandFlush:
+                histogram = core->stats.flush;
+                break;
+            default:
+                break;
+        }
+
+        if (histogram)
+            g_omx_histogram_add (histogram, usec);
+
+        GST_DEBUG_OBJECT (core->object, "command %d (%lu) took %" G_GUINT64_FORMAT " usec",
+                cmd, param, usec);
+
+        g_free (command);
+        g_cond_broadcast (core->command_cond);
+    }
+
+    g_mutex_unlock (core->command_mutex);
 }
 
 static inline void
@@ -496,7 +1002,7 @@ wait_for_state (GOmxCore *core,
         goto leave;
 
     g_get_current_time (&tv);
-    g_time_val_add (&tv, 100000000);
+    g_time_val_add (&tv, (glong) core->command_timeout * 1000);
 
     /* try once */
     if (core->omx_state != state)
@@ -534,6 +1040,8 @@ in_port_cb (GOmxPort *port,
 
     if (!port->enabled)
         return;
+
+    g_omx_port_stats_returned (port, omx_buffer);
 }
 
 static inline void
@@ -545,6 +1053,8 @@ out_port_cb (GOmxPort *port,
     if (!port->enabled)
         return;
 
+    g_omx_port_stats_returned (port, omx_buffer);
+
 #if 0
     if (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS)
     {
@@ -566,8 +1076,9 @@ g_omx_core_got_buffer (GOmxCore *core,
 
     if (G_LIKELY (port))
     {
-        g_omx_port_push_buffer (port, omx_buffer);
-
+        /* before pushing, so the buffer is accounted before anyone can
+         * pick it up again
+         */
         switch (port->type)
         {
             case GOMX_PORT_INPUT:
@@ -579,6 +1090,8 @@ g_omx_core_got_buffer (GOmxCore *core,
             default:
                 break;
         }
+
+        g_omx_port_push_buffer (port, omx_buffer);
     }
 }
 
@@ -596,29 +1109,38 @@ EventHandler (OMX_HANDLETYPE omx_handle,
 {
     GOmxCore *core;
 
-    core = (GOmxCore *) app_data;
+    core = ((GOmxAppData *) app_data)->core;
+
+    /* parked in the pool */
+    if (!core)
+        return OMX_ErrorNone;
 
     switch (event)
     {
         case OMX_EventCmdComplete:
             {
                 OMX_COMMANDTYPE cmd;
+                gboolean tracked;
 
                 cmd = (OMX_COMMANDTYPE) data_1;
 
                 GST_DEBUG_OBJECT (core->object, "OMX_EventCmdComplete: %d", cmd);
 
+                complete_command (core, cmd, data_2, &tracked);
+
                 switch (cmd)
                 {
                     case OMX_CommandStateSet:
                         complete_change_state (core, data_2);
                         break;
                     case OMX_CommandFlush:
-                        g_sem_up (core->flush_sem);
+                        if (!tracked)
+                            g_sem_up (core->flush_sem);
                         break;
                     case OMX_CommandPortDisable:
                     case OMX_CommandPortEnable:
-                        g_sem_up (core->port_sem);
+                        if (!tracked)
+                            g_sem_up (core->port_sem);
                     default:
                         break;
                 }
@@ -664,6 +1186,10 @@ EventHandler (OMX_HANDLETYPE omx_handle,
                 g_mutex_lock (core->omx_state_mutex);
                 g_cond_signal (core->omx_state_condition);
                 g_mutex_unlock (core->omx_state_mutex);
+                /* and g_omx_core_wait_for_commands */
+                g_mutex_lock (core->command_mutex);
+                g_cond_broadcast (core->command_cond);
+                g_mutex_unlock (core->command_mutex);
                 break;
             }
 #ifdef USE_OMXTICORE
@@ -701,7 +1227,8 @@ EmptyBufferDone (OMX_HANDLETYPE omx_handle,
 
     g_return_val_if_fail (omx_buffer, OMX_ErrorBadParameter);
 
-    core = (GOmxCore*) app_data;
+    core = ((GOmxAppData *) app_data)->core;
+    g_return_val_if_fail (core, OMX_ErrorBadParameter);
     port = get_port (core, omx_buffer->nInputPortIndex);
 
     GST_DEBUG_OBJECT (core->object, "EBD: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
@@ -722,7 +1249,8 @@ FillBufferDone (OMX_HANDLETYPE omx_handle,
 
     g_return_val_if_fail (omx_buffer, OMX_ErrorBadParameter);
 
-    core = (GOmxCore *) app_data;
+    core = ((GOmxAppData *) app_data)->core;
+    g_return_val_if_fail (core, OMX_ErrorBadParameter);
     port = get_port (core, omx_buffer->nOutputPortIndex);
 
     GST_DEBUG_OBJECT (core->object, "FBD: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
@@ -32,8 +32,39 @@ G_BEGIN_DECLS
 typedef void (*GOmxCb) (GOmxCore *core);
 typedef void (*GOmxCbargs2) (GOmxCore *core, gint data1, gint data2);
 
+/** states a GOmxCore keeps transition times for: OMX_StateInvalid to
+ * OMX_StateWaitForResources */
+#define G_OMX_CORE_NUM_STATES (OMX_StateWaitForResources + 1)
+
+/** msec to wait for a command to complete, unless set otherwise */
+#define G_OMX_CORE_DEFAULT_COMMAND_TIMEOUT 100000
+
 /* Structures. */
 
+/**
+ * usec from OMX_SendCommand() to OMX_EventCmdComplete, per kind of
+ * command, log2 bucketed (see G_OMX_HISTOGRAM_BUCKETS).
+ */
+typedef struct
+{
+    guint state[G_OMX_CORE_NUM_STATES][G_OMX_CORE_NUM_STATES][G_OMX_HISTOGRAM_BUCKETS]; /**< [from][to] */
+    guint port_enable[G_OMX_HISTOGRAM_BUCKETS];
+    guint port_disable[G_OMX_HISTOGRAM_BUCKETS];
+    guint flush[G_OMX_HISTOGRAM_BUCKETS];
+    guint timeouts;             /**< commands given up on */
+} GOmxCoreStats;
+
+/**
+ * What the OMX callbacks get as app data.  It goes with the handle rather
+ * than the core, so that a handle parked in the pool (see gstomx_pool.h)
+ * can be adopted by another core.
+ */
+typedef struct
+{
+    GOmxCore *core;     /**< NULL while parked */
+    gchar *key;         /**< see g_omx_pool_key() */
+} GOmxAppData;
+
 struct GOmxCore
 {
     gpointer object; /**< GStreamer element. */
@@ -55,10 +86,23 @@ struct GOmxCore
     GOmxCbargs2 index_settings_changed_cb;
 
     GOmxImp *imp;
+    GOmxAppData *app_data;
+
+    /** adopt a parked handle in g_omx_core_init() and park it again in
+     * g_omx_core_deinit() */
+    gboolean use_pool;
 
     gboolean done;
 
     gboolean use_timestamps; /** @todo remove; timestamps should always be used */
+
+    /** commands sent and not complete yet, see g_omx_core_send_command() */
+    GMutex *command_mutex;
+    GCond *command_cond;
+    GList *commands;
+    guint command_timeout;  /**< msec, for commands and state changes */
+
+    GOmxCoreStats stats;
 };
 
 /* Utility Macros */
@@ -107,6 +151,9 @@ void g_omx_core_flush_stop (GOmxCore *core);
 OMX_HANDLETYPE g_omx_core_get_handle (GOmxCore *core);
 GOmxPort *g_omx_core_get_port (GOmxCore *core, const gchar *name, guint index);
 void g_omx_core_change_state (GOmxCore *core, OMX_STATETYPE state);
+gboolean g_omx_core_send_command (GOmxCore *core, OMX_COMMANDTYPE cmd, OMX_U32 param);
+gboolean g_omx_core_wait_for_commands (GOmxCore *core, guint timeout);
+void g_omx_core_get_stats (GOmxCore *core, GstStructure *structure);
 
 /* Friend:  helpers used by GOmxPort */
 void g_omx_core_got_buffer (GOmxCore *core,
@@ -0,0 +1,1433 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Multi-channel scaler: every sink/src pad pair is one channel of a single
+ * VFPC scaler handle, so N streams share one component, one set of state
+ * transitions and one output loop per channel instead of N components.
+ *
+ * Input is sent in cycles: a buffer arriving on a channel waits until every
+ * other running channel has one as well (or batch-timeout expires), and
+ * the whole set is then queued with back to back EmptyThisBuffer calls.
+ * The first cycle always waits for every linked channel, since the set of
+ * channels and their resolutions is fixed when the component is set up.
+ * Each sink pad therefore needs a streaming thread of its own (e.g. a
+ * queue in front of it), or batch-timeout set to 0.
+ */
+
+#include "gstomx_mcscaler.h"
+#include "gstomx.h"
+#include <gst/video/video.h>
+
+#include "cpu_load.h"
+
+#include <stdio.h> /* for sscanf */
+
+enum
+{
+    ARG_0,
+    ARG_BATCH_TIMEOUT,
+    ARG_NUM_CHANNELS,
+    ARG_CYCLES,
+    ARG_PARTIAL_CYCLES,
+};
+
+#define DEFAULT_BATCH_TIMEOUT 40
+#define NUM_OUTPUT_BUFFERS 8
+
+GSTOMX_BOILERPLATE (GstOmxMcScaler, gst_omx_mcscaler, GstOmxBaseVfpc, GST_OMX_BASE_VFPC_TYPE);
+
+static GstStaticPadTemplate sink_template =
+        GST_STATIC_PAD_TEMPLATE ("sink",
+                GST_PAD_SINK,
+                GST_PAD_ALWAYS,
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV_STRIDED (
+                        "{NV12}", "[ 0, max ]"))
+        );
+
+static GstStaticPadTemplate src_template =
+        GST_STATIC_PAD_TEMPLATE ("src",
+                GST_PAD_SRC,
+                GST_PAD_ALWAYS,
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ( "{YUY2}" ))
+        );
+
+static GstStaticPadTemplate sink_request_template =
+        GST_STATIC_PAD_TEMPLATE ("sink_%d",
+                GST_PAD_SINK,
+                GST_PAD_REQUEST,
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV_STRIDED (
+                        "{NV12}", "[ 0, max ]"))
+        );
+
+static GstStaticPadTemplate src_sometimes_template =
+        GST_STATIC_PAD_TEMPLATE ("src_%d",
+                GST_PAD_SRC,
+                GST_PAD_SOMETIMES,
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ( "{YUY2}" ))
+        );
+
+static GstFlowReturn pad_chain (GstPad *pad, GstBuffer *buf);
+static gboolean pad_event (GstPad *pad, GstEvent *event);
+static gboolean sink_setcaps (GstPad *pad, GstCaps *caps);
+static gboolean src_setcaps (GstPad *pad, GstCaps *caps);
+static gboolean activate_push (GstPad *pad, gboolean active);
+
+static void
+type_base_init (gpointer g_class)
+{
+    GstElementClass *element_class;
+
+    element_class = GST_ELEMENT_CLASS (g_class);
+
+    {
+        GstElementDetails details;
+
+        details.longname = "OpenMAX IL for OMX.TI.VPSSM3.VFPC.INDTXSCWB component (multi-channel)";
+        details.klass = "Filter";
+        details.description = "Scale several video streams through one VPSS Scaler instance";
+        details.author = "Texas Instruments";
+
+        gst_element_class_set_details (element_class, &details);
+    }
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&sink_template));
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&src_template));
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&sink_request_template));
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&src_sometimes_template));
+}
+
+static GstOmxMcScalerChannel *
+channel_new (GstOmxMcScaler *self,
+             guint id,
+             GstPad *sinkpad,
+             GstPad *srcpad)
+{
+    GstOmxBaseFilter *omx_base;
+    GstOmxMcScalerChannel *channel;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    channel = g_new0 (GstOmxMcScalerChannel, 1);
+    channel->self = self;
+    channel->id = id;
+    channel->sinkpad = sinkpad;
+    channel->srcpad = srcpad;
+    channel->duration = GST_CLOCK_TIME_NONE;
+    channel->last_return = GST_FLOW_OK;
+    channel->send_return = GST_FLOW_OK;
+
+    if (id == 0)
+    {
+        channel->in_port = omx_base->in_port;
+        channel->out_port = omx_base->out_port;
+    }
+    else
+    {
+        channel->in_port = g_omx_core_get_port (omx_base->gomx, "in",
+                OMX_VFPC_INPUT_PORT_START_INDEX + id);
+        channel->out_port = g_omx_core_get_port (omx_base->gomx, "out",
+                OMX_VFPC_OUTPUT_PORT_START_INDEX + id);
+
+        channel->in_port->omx_allocate = TRUE;
+        channel->in_port->share_buffer = FALSE;
+        channel->in_port->always_copy = FALSE;
+
+        channel->out_port->omx_allocate = TRUE;
+        channel->out_port->share_buffer = FALSE;
+        channel->out_port->always_copy = FALSE;
+    }
+
+    gst_pad_set_element_private (sinkpad, channel);
+    gst_pad_set_element_private (srcpad, channel);
+
+    gst_pad_set_chain_function (sinkpad, GST_DEBUG_FUNCPTR (pad_chain));
+    /* buffer lists one buffer at a time, like the always sink pad */
+    gst_pad_set_chain_list_function (sinkpad,
+            GST_PAD_CHAINLISTFUNC (omx_base->sinkpad));
+    gst_pad_set_event_function (sinkpad, GST_DEBUG_FUNCPTR (pad_event));
+    gst_pad_set_setcaps_function (sinkpad, GST_DEBUG_FUNCPTR (sink_setcaps));
+    gst_pad_set_setcaps_function (srcpad, GST_DEBUG_FUNCPTR (src_setcaps));
+    gst_pad_set_activatepush_function (srcpad, GST_DEBUG_FUNCPTR (activate_push));
+
+    self->channels[id] = channel;
+    self->num_channels++;
+
+    return channel;
+}
+
+static gint
+calculate_stride (int width, GstVideoFormat format)
+{
+    switch (format)
+    {
+        case GST_VIDEO_FORMAT_NV12:
+            return width;
+        case GST_VIDEO_FORMAT_YUY2:
+            return width * 2;
+        default:
+            GST_ERROR ("unsupported color format");
+    }
+    return -1;
+}
+
+static GstCaps *
+create_src_caps (GstOmxMcScalerChannel *channel)
+{
+    GstCaps *caps;
+    GstStructure *struc;
+    int width, height;
+
+    width = channel->in_width;
+    height = channel->in_height;
+
+    caps = gst_pad_peer_get_caps (channel->srcpad);
+
+    if (caps && !gst_caps_is_empty (caps) && !gst_caps_is_any (caps))
+    {
+        GstStructure *s;
+
+        s = gst_caps_get_structure (caps, 0);
+
+        if (!(gst_structure_get_int (s, "width", &width) &&
+            gst_structure_get_int (s, "height", &height)))
+        {
+            width = channel->in_width;
+            height = channel->in_height;
+        }
+    }
+
+    if (caps)
+        gst_caps_unref (caps);
+
+    caps = gst_caps_new_empty ();
+    struc = gst_structure_new (("video/x-raw-yuv"),
+            "width",  G_TYPE_INT, width,
+            "height", G_TYPE_INT, height,
+            "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('Y', 'U', 'Y', '2'),
+            NULL);
+
+    if (channel->framerate_denom)
+    {
+        gst_structure_set (struc,
+        "framerate", GST_TYPE_FRACTION, channel->framerate_num, channel->framerate_denom, NULL);
+    }
+
+    gst_caps_append_structure (caps, struc);
+
+    return caps;
+}
+
+static OMX_ERRORTYPE
+setup_channel_ports (GstOmxMcScaler *self,
+                     GstOmxMcScalerChannel *channel)
+{
+    GOmxCore *gomx;
+    OMX_ERRORTYPE err;
+    OMX_PARAM_PORTDEFINITIONTYPE paramPort;
+    OMX_PARAM_BUFFER_MEMORYTYPE memTypeCfg;
+    GstCaps *caps;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    /* set the output cap */
+    caps = create_src_caps (channel);
+    gst_pad_set_caps (channel->srcpad, caps);
+    gst_caps_unref (caps);
+
+    /* Setting Memory type at input and output port to Raw Memory */
+    GST_LOG_OBJECT (self, "Setting ports of channel %u to Raw memory", channel->id);
+
+    _G_OMX_INIT_PARAM (&memTypeCfg);
+    memTypeCfg.nPortIndex = channel->in_port->port_index;
+    memTypeCfg.eBufMemoryType = OMX_BUFFER_MEMORY_DEFAULT;
+    err = OMX_SetParameter (gomx->omx_handle, OMX_TI_IndexParamBuffMemType, &memTypeCfg);
+
+    if (err != OMX_ErrorNone)
+        return err;
+
+    _G_OMX_INIT_PARAM (&memTypeCfg);
+    memTypeCfg.nPortIndex = channel->out_port->port_index;
+    memTypeCfg.eBufMemoryType = OMX_BUFFER_MEMORY_DEFAULT;
+    err = OMX_SetParameter (gomx->omx_handle, OMX_TI_IndexParamBuffMemType, &memTypeCfg);
+
+    if (err != OMX_ErrorNone)
+        return err;
+
+    /* Input port configuration. */
+    G_OMX_PORT_GET_DEFINITION (channel->in_port, &paramPort);
+    paramPort.format.video.nFrameWidth = channel->in_width;
+    paramPort.format.video.nFrameHeight = channel->in_height;
+    paramPort.format.video.nStride = channel->in_stride;
+    paramPort.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+    paramPort.format.video.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+    paramPort.nBufferSize =  channel->in_stride * channel->in_height * 1.5;
+    paramPort.nBufferAlignment = 0;
+    paramPort.bBuffersContiguous = 0;
+    G_OMX_PORT_SET_DEFINITION (channel->in_port, &paramPort);
+    g_omx_port_setup (channel->in_port, &paramPort);
+
+    /* Output port configuration. */
+    G_OMX_PORT_GET_DEFINITION (channel->out_port, &paramPort);
+    paramPort.format.video.nFrameWidth = channel->out_width;
+    paramPort.format.video.nFrameHeight = channel->out_height;
+    paramPort.format.video.nStride = channel->out_stride;
+    paramPort.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+    paramPort.format.video.eColorFormat = OMX_COLOR_FormatYCbYCr;
+    paramPort.nBufferSize =  channel->out_stride * channel->out_height;
+    paramPort.nBufferCountActual = gst_omx_base_vfpc_get_output_buffer_count (
+            GST_OMX_BASE_VFPC (channel->self), channel->srcpad, channel->duration,
+            paramPort.nBufferCountMin, NUM_OUTPUT_BUFFERS);
+    paramPort.nBufferAlignment = 0;
+    paramPort.bBuffersContiguous = 0;
+    G_OMX_PORT_SET_DEFINITION (channel->out_port, &paramPort);
+    g_omx_port_setup (channel->out_port, &paramPort);
+
+    channel->in_port->enabled = TRUE;
+    channel->out_port->enabled = TRUE;
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+setup_channel_resolution (GstOmxMcScaler *self,
+                          GstOmxMcScalerChannel *channel)
+{
+    GOmxCore *gomx;
+    OMX_ERRORTYPE err;
+    OMX_CONFIG_VIDCHANNEL_RESOLUTION chResolution;
+    OMX_CONFIG_ALG_ENABLE algEnable;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    /* Set input channel resolution */
+    GST_LOG_OBJECT (self, "Setting resolution of channel %u", channel->id);
+
+    _G_OMX_INIT_PARAM (&chResolution);
+    chResolution.Frm0Width = channel->in_width;
+    chResolution.Frm0Height = channel->in_height;
+    chResolution.Frm0Pitch = channel->in_stride;
+    chResolution.Frm1Width = 0;
+    chResolution.Frm1Height = 0;
+    chResolution.Frm1Pitch = 0;
+    chResolution.FrmStartX = channel->left;
+    chResolution.FrmStartY = channel->top;
+    chResolution.FrmCropWidth = 0;
+    chResolution.FrmCropHeight = 0;
+    chResolution.eDir = OMX_DirInput;
+    chResolution.nChId = channel->id;
+    err = OMX_SetConfig (gomx->omx_handle, OMX_TI_IndexConfigVidChResolution, &chResolution);
+
+    if (err != OMX_ErrorNone)
+        return err;
+
+    /* Set output channel resolution */
+    _G_OMX_INIT_PARAM (&chResolution);
+    chResolution.Frm0Width = channel->out_width;
+    chResolution.Frm0Height = channel->out_height;
+    chResolution.Frm0Pitch = channel->out_stride;
+    chResolution.Frm1Width = 0;
+    chResolution.Frm1Height = 0;
+    chResolution.Frm1Pitch = 0;
+    chResolution.FrmStartX = 0;
+    chResolution.FrmStartY = 0;
+    chResolution.FrmCropWidth = 0;
+    chResolution.FrmCropHeight = 0;
+    chResolution.eDir = OMX_DirOutput;
+    chResolution.nChId = channel->id;
+    err = OMX_SetConfig (gomx->omx_handle, OMX_TI_IndexConfigVidChResolution, &chResolution);
+
+    if (err != OMX_ErrorNone)
+        return err;
+
+    _G_OMX_INIT_PARAM (&algEnable);
+    algEnable.nPortIndex = 0;
+    algEnable.nChId = channel->id;
+    algEnable.bAlgBypass = OMX_FALSE;
+
+    return OMX_SetConfig (gomx->omx_handle, (OMX_INDEXTYPE) OMX_TI_IndexConfigAlgEnable, &algEnable);
+}
+
+/**
+ * Called through GstOmxBaseVfpc's omx_setup, which enables the ports of
+ * channel 0 afterwards.  Channels without caps yet are left out of the
+ * handle for good.
+ */
+static void
+omx_setup (GstOmxBaseFilter *omx_base)
+{
+    GstOmxMcScaler *self;
+    GOmxCore *gomx;
+    OMX_ERRORTYPE err;
+    OMX_PARAM_VFPC_NUMCHANNELPERHANDLE numChannels;
+    guint i, last = 0;
+
+    self = GST_OMX_MCSCALER (omx_base);
+    gomx = (GOmxCore *) omx_base->gomx;
+
+    GST_LOG_OBJECT (self, "begin");
+
+    for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+    {
+        GstOmxMcScalerChannel *channel = self->channels[i];
+
+        if (!channel)
+            continue;
+
+        channel->configured = channel->in_width > 0 && !channel->eos;
+
+        if (!channel->configured)
+        {
+            GST_WARNING_OBJECT (self, "channel %u has no caps, leaving it out", i);
+            channel->in_port->enabled = FALSE;
+            channel->out_port->enabled = FALSE;
+            continue;
+        }
+
+        err = setup_channel_ports (self, channel);
+
+        if (err != OMX_ErrorNone)
+        {
+            GST_ERROR_OBJECT (self, "channel %u: %s", i, g_omx_error_to_str (err));
+            return;
+        }
+
+        last = i;
+    }
+
+    /* Set number of channels */
+    GST_LOG_OBJECT (self, "Setting number of channels: %u", last + 1);
+
+    _G_OMX_INIT_PARAM (&numChannels);
+    numChannels.nNumChannelsPerHandle = last + 1;
+    err = OMX_SetParameter (gomx->omx_handle,
+        (OMX_INDEXTYPE) OMX_TI_IndexParamVFPCNumChPerHandle, &numChannels);
+
+    if (err != OMX_ErrorNone)
+        return;
+
+    for (i = 0; i <= last; i++)
+    {
+        GstOmxMcScalerChannel *channel = self->channels[i];
+
+        if (!channel || !channel->configured)
+            continue;
+
+        err = setup_channel_resolution (self, channel);
+
+        if (err != OMX_ErrorNone)
+        {
+            GST_ERROR_OBJECT (self, "channel %u: %s", i, g_omx_error_to_str (err));
+            return;
+        }
+
+        /* the base class enables channel 0, and waits for all enables */
+        if (i == 0)
+            continue;
+
+        g_omx_core_send_command (gomx, OMX_CommandPortEnable,
+                channel->in_port->port_index);
+        g_omx_core_send_command (gomx, OMX_CommandPortEnable,
+                channel->out_port->port_index);
+    }
+
+    GST_LOG_OBJECT (self, "end");
+}
+
+static void
+output_loop (gpointer data)
+{
+    GstOmxMcScalerChannel *channel;
+    GstOmxMcScaler *self;
+    GstOmxBaseFilter *omx_base;
+    GOmxCore *gomx;
+    GstFlowReturn ret = GST_FLOW_OK;
+    gpointer obj;
+
+    channel = data;
+    self = channel->self;
+    omx_base = GST_OMX_BASE_FILTER (self);
+    gomx = omx_base->gomx;
+
+    if (channel->id == 0)
+        g_atomic_int_set (&omx_base->output_tid, cpu_load_get_tid ());
+
+    obj = g_omx_port_recv (channel->out_port);
+
+    if (G_UNLIKELY (!obj))
+    {
+        GST_DEBUG_OBJECT (self, "channel %u: null buffer: leaving", channel->id);
+        ret = GST_FLOW_WRONG_STATE;
+    }
+    else if (G_LIKELY (GST_IS_BUFFER (obj)))
+    {
+        GstBuffer *buf = GST_BUFFER (obj);
+
+        GST_BUFFER_DURATION (buf) = channel->duration;
+
+        ret = gst_pad_push (channel->srcpad, buf);
+        GST_LOG_OBJECT (self, "channel %u: ret=%s", channel->id, gst_flow_get_name (ret));
+
+        g_atomic_int_inc (&channel->pushed);
+    }
+    else if (GST_IS_EVENT (obj))
+    {
+        GST_DEBUG_OBJECT (self, "channel %u: got eos", channel->id);
+        gst_pad_push_event (channel->srcpad, obj);
+        ret = GST_FLOW_UNEXPECTED;
+    }
+
+    if (gomx->omx_error != OMX_ErrorNone)
+    {
+        GST_DEBUG_OBJECT (self, "omx_error=%s", g_omx_error_to_str (gomx->omx_error));
+        ret = GST_FLOW_ERROR;
+    }
+
+    channel->last_return = ret;
+
+    /* wake up EOS waiting for the channel to drain */
+    if (ret != GST_FLOW_OK || g_atomic_int_get (&channel->draining))
+    {
+        g_mutex_lock (self->cycle_lock);
+        g_cond_broadcast (self->cycle_cond);
+        g_mutex_unlock (self->cycle_lock);
+    }
+
+    if (ret != GST_FLOW_OK)
+    {
+        GST_INFO_OBJECT (self, "channel %u: pause task, reason:  %s",
+                         channel->id, gst_flow_get_name (ret));
+        gst_pad_pause_task (channel->srcpad);
+    }
+}
+
+static void
+start_channel (GstOmxMcScalerChannel *channel)
+{
+    if (channel->configured && gst_pad_is_linked (channel->srcpad))
+        gst_pad_start_task (channel->srcpad, output_loop, channel);
+}
+
+/**
+ * Set the component up for the channels of the first cycle, @bufs[i]
+ * being the buffer of channel @batch[i].
+ */
+static gboolean
+prepare (GstOmxMcScaler *self,
+         GstOmxMcScalerChannel **batch,
+         GstBuffer **bufs,
+         guint n)
+{
+    GstOmxBaseFilter *omx_base;
+    GOmxCore *gomx;
+    guint i;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+    gomx = omx_base->gomx;
+
+    g_mutex_lock (omx_base->ready_lock);
+
+    if (gomx->omx_state == OMX_StateLoaded)
+    {
+        GST_INFO_OBJECT (self, "omx: prepare");
+
+        if (!self->channels[0] || self->channels[0]->in_width <= 0)
+        {
+            g_mutex_unlock (omx_base->ready_lock);
+            GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+                    ("channel 0 (the sink pad) has no caps"));
+            return FALSE;
+        }
+
+        omx_base->omx_setup (omx_base);
+
+        for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+        {
+            GstOmxMcScalerChannel *channel = self->channels[i];
+
+            if (channel && channel->configured)
+            {
+                channel->in_port->omx_allocate = TRUE;
+                channel->in_port->always_copy = TRUE;
+            }
+        }
+
+        /* share the buffers of upstream OMX ports where we can */
+        for (i = 0; i < n; i++)
+        {
+            if (batch[i]->configured)
+                gst_omx_base_filter_setup_input_port (omx_base, batch[i]->in_port, bufs[i]);
+        }
+
+        g_omx_core_prepare (gomx);
+
+        if (gomx->omx_state == OMX_StateIdle)
+        {
+            omx_base->ready = TRUE;
+
+            for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+            {
+                if (self->channels[i])
+                    start_channel (self->channels[i]);
+            }
+        }
+    }
+
+    g_mutex_unlock (omx_base->ready_lock);
+
+    if (gomx->omx_state == OMX_StateIdle)
+    {
+        GST_INFO_OBJECT (self, "omx: play");
+        g_omx_core_start (gomx);
+    }
+
+    if (gomx->omx_state != OMX_StateExecuting)
+    {
+        GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                ("OpenMAX component in wrong state"));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static GstFlowReturn
+send_buffer (GstOmxMcScaler *self,
+             GstOmxMcScalerChannel *channel,
+             GstBuffer *buf)
+{
+    GOmxCore *gomx;
+
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    if (!channel->configured)
+    {
+        GST_WARNING_OBJECT (self, "channel %u is not part of the component", channel->id);
+        gst_buffer_unref (buf);
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    while (TRUE)
+    {
+        gint sent;
+
+        if (G_UNLIKELY (gomx->omx_error ||
+                        !(gomx->omx_state == OMX_StateExecuting ||
+                          gomx->omx_state == OMX_StatePause)))
+        {
+            gst_buffer_unref (buf);
+
+            if (gomx->omx_error)
+            {
+                GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                        ("Error from OpenMAX component"));
+                return GST_FLOW_ERROR;
+            }
+
+            return GST_FLOW_WRONG_STATE;
+        }
+
+        sent = g_omx_port_send (channel->in_port, buf);
+
+        if (G_UNLIKELY (sent == G_OMX_PORT_SEND_MISROUTED))
+        {
+            GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                    ("input buffer %p of channel %u does not belong to the negotiated buffer pool",
+                     buf, channel->id));
+            gst_buffer_unref (buf);
+            return GST_FLOW_ERROR;
+        }
+        else if (G_UNLIKELY (sent < 0))
+        {
+            gst_buffer_unref (buf);
+            return GST_FLOW_WRONG_STATE;
+        }
+        else if (sent < GST_BUFFER_SIZE (buf))
+        {
+            GstBuffer *subbuf = gst_buffer_create_sub (buf, sent,
+                    GST_BUFFER_SIZE (buf) - sent);
+            gst_buffer_unref (buf);
+            buf = subbuf;
+        }
+        else
+        {
+            gst_buffer_unref (buf);
+            g_atomic_int_inc (&channel->sent);
+            return GST_FLOW_OK;
+        }
+    }
+}
+
+/* called with the cycle lock */
+static gboolean
+cycle_complete (GstOmxMcScaler *self)
+{
+    gboolean ready;
+    guint i;
+
+    ready = GST_OMX_BASE_FILTER (self)->ready;
+
+    for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+    {
+        GstOmxMcScalerChannel *channel = self->channels[i];
+
+        if (!channel || channel->pending || channel->eos || channel->flushing)
+            continue;
+
+        if (ready && !channel->configured)
+            continue;
+
+        if (gst_pad_is_linked (channel->sinkpad))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Take the pending buffer of every channel and queue them all to the
+ * component.  Called with the cycle lock, which is released while sending;
+ * no other cycle starts until this one is out, so the buffers of a channel
+ * keep their order.
+ */
+static void
+submit_cycle (GstOmxMcScaler *self,
+              gboolean partial)
+{
+    GstOmxMcScalerChannel *batch[GST_OMX_MCSCALER_MAX_CHANNELS];
+    GstBuffer *bufs[GST_OMX_MCSCALER_MAX_CHANNELS];
+    gboolean ok = TRUE;
+    guint i, n = 0;
+
+    for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+    {
+        GstOmxMcScalerChannel *channel = self->channels[i];
+
+        if (!channel || !channel->pending)
+            continue;
+
+        batch[n] = channel;
+        bufs[n] = channel->pending;
+        channel->pending = NULL;
+        channel->submitting = TRUE;
+        n++;
+    }
+
+    self->sending = TRUE;
+    self->cycles++;
+    if (partial)
+        self->partial_cycles++;
+
+    g_mutex_unlock (self->cycle_lock);
+
+    GST_LOG_OBJECT (self, "cycle of %u buffers%s", n, partial ? " (partial)" : "");
+
+    if (G_UNLIKELY (!GST_OMX_BASE_FILTER (self)->ready))
+        ok = prepare (self, batch, bufs, n);
+
+    for (i = 0; i < n; i++)
+    {
+        if (ok)
+        {
+            batch[i]->send_return = send_buffer (self, batch[i], bufs[i]);
+        }
+        else
+        {
+            gst_buffer_unref (bufs[i]);
+            batch[i]->send_return = GST_FLOW_ERROR;
+        }
+    }
+
+    g_mutex_lock (self->cycle_lock);
+
+    for (i = 0; i < n; i++)
+        batch[i]->submitting = FALSE;
+
+    self->sending = FALSE;
+    g_cond_broadcast (self->cycle_cond);
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxMcScalerChannel *channel;
+    GstOmxMcScaler *self;
+    GstOmxBaseFilter *omx_base;
+    GstFlowReturn ret;
+    GTimeVal deadline;
+    gboolean timed_out = FALSE;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->self;
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    PRINT_BUFFER (self, buf);
+
+    if (channel->id == 0)
+        g_atomic_int_set (&omx_base->input_tid, cpu_load_get_tid ());
+
+    if (channel->last_return != GST_FLOW_OK)
+    {
+        GST_DEBUG_OBJECT (self, "channel %u: last_return=%s", channel->id,
+                          gst_flow_get_name (channel->last_return));
+        gst_buffer_unref (buf);
+        return channel->last_return;
+    }
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, (glong) self->batch_timeout * 1000);
+
+    g_mutex_lock (self->cycle_lock);
+
+    channel->pending = buf;
+
+    while (TRUE)
+    {
+        if (self->flushing || channel->flushing)
+        {
+            if (channel->pending)
+            {
+                gst_buffer_unref (channel->pending);
+                channel->pending = NULL;
+            }
+
+            /* the buffer belongs to a cycle being sent, wait for it */
+            if (!channel->submitting)
+            {
+                ret = GST_FLOW_WRONG_STATE;
+                break;
+            }
+        }
+        else if (!channel->pending && !channel->submitting)
+        {
+            ret = channel->send_return;
+            break;
+        }
+        else if (channel->pending && !self->sending)
+        {
+            gboolean full = cycle_complete (self);
+
+            /* the first cycle has to see every channel */
+            if (full || (omx_base->ready && (!self->batch_timeout || timed_out)))
+            {
+                submit_cycle (self, !full);
+                continue;
+            }
+        }
+
+        if (channel->pending && !self->sending && omx_base->ready && self->batch_timeout)
+            timed_out = !g_cond_timed_wait (self->cycle_cond, self->cycle_lock, &deadline);
+        else
+            g_cond_wait (self->cycle_cond, self->cycle_lock);
+    }
+
+    g_mutex_unlock (self->cycle_lock);
+
+    if (ret == GST_FLOW_OK && channel->last_return != GST_FLOW_OK)
+        ret = channel->last_return;
+
+    return ret;
+}
+
+/**
+ * The component does not return buffers flagged EOS, so EOS goes downstream
+ * once every frame sent on the channel has come out.
+ */
+static void
+drain_channel (GstOmxMcScalerChannel *channel)
+{
+    GstOmxMcScaler *self;
+    GOmxCore *gomx;
+
+    self = channel->self;
+    gomx = GST_OMX_BASE_FILTER (self)->gomx;
+
+    g_atomic_int_set (&channel->draining, 1);
+
+    g_mutex_lock (self->cycle_lock);
+
+    while (g_atomic_int_get (&channel->pushed) < g_atomic_int_get (&channel->sent) &&
+           channel->last_return == GST_FLOW_OK &&
+           !channel->flushing && !self->flushing &&
+           gomx->omx_error == OMX_ErrorNone)
+    {
+        g_cond_wait (self->cycle_cond, self->cycle_lock);
+    }
+
+    g_mutex_unlock (self->cycle_lock);
+
+    g_atomic_int_set (&channel->draining, 0);
+}
+
+static gboolean
+pad_event (GstPad *pad,
+           GstEvent *event)
+{
+    GstOmxMcScalerChannel *channel;
+    GstOmxMcScaler *self;
+    GstOmxBaseFilter *omx_base;
+    gboolean ret = TRUE;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->self;
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    GST_INFO_OBJECT (self, "channel %u: event=%s", channel->id, GST_EVENT_TYPE_NAME (event));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_CROP:
+            gst_event_parse_crop (event, &channel->top, &channel->left, NULL, NULL);
+            gst_event_unref (event);
+            break;
+
+        case GST_EVENT_EOS:
+            g_mutex_lock (self->cycle_lock);
+            channel->eos = TRUE;
+            /* the others no longer wait for this channel */
+            g_cond_broadcast (self->cycle_cond);
+            g_mutex_unlock (self->cycle_lock);
+
+            if (omx_base->ready && channel->configured &&
+                channel->last_return == GST_FLOW_OK)
+                drain_channel (channel);
+
+            ret = gst_pad_push_event (channel->srcpad, event);
+            break;
+
+        case GST_EVENT_FLUSH_START:
+            gst_pad_push_event (channel->srcpad, event);
+
+            g_mutex_lock (self->cycle_lock);
+            channel->flushing = TRUE;
+            g_cond_broadcast (self->cycle_cond);
+            g_mutex_unlock (self->cycle_lock);
+
+            channel->last_return = GST_FLOW_WRONG_STATE;
+
+            if (omx_base->ready && channel->configured)
+            {
+                g_omx_port_pause (channel->in_port);
+                g_omx_port_pause (channel->out_port);
+            }
+
+            gst_pad_pause_task (channel->srcpad);
+            break;
+
+        case GST_EVENT_FLUSH_STOP:
+            gst_pad_push_event (channel->srcpad, event);
+
+            if (omx_base->ready && channel->configured)
+            {
+                g_omx_port_flush (channel->in_port);
+                g_omx_port_flush (channel->out_port);
+                g_omx_port_resume (channel->in_port);
+                g_omx_port_resume (channel->out_port);
+            }
+
+            g_mutex_lock (self->cycle_lock);
+            channel->flushing = FALSE;
+            channel->eos = FALSE;
+            g_atomic_int_set (&channel->sent, 0);
+            g_atomic_int_set (&channel->pushed, 0);
+            g_mutex_unlock (self->cycle_lock);
+
+            channel->last_return = GST_FLOW_OK;
+
+            if (omx_base->ready)
+                start_channel (channel);
+            break;
+
+        default:
+            ret = gst_pad_push_event (channel->srcpad, event);
+            break;
+    }
+
+    return ret;
+}
+
+static gboolean
+sink_setcaps (GstPad *pad,
+              GstCaps *caps)
+{
+    GstOmxMcScalerChannel *channel;
+    GstOmxMcScaler *self;
+    GstStructure *structure;
+    GstVideoFormat format;
+    gint width, height, stride;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->self;
+
+    GST_INFO_OBJECT (self, "setcaps (sink %u): %" GST_PTR_FORMAT, channel->id, caps);
+
+    g_return_val_if_fail (caps, FALSE);
+    g_return_val_if_fail (gst_caps_is_fixed (caps), FALSE);
+
+    structure = gst_caps_get_structure (caps, 0);
+
+    if (!gst_video_format_parse_caps_strided (caps,
+            &format, &width, &height, &stride))
+    {
+        GST_WARNING_OBJECT (self, "width and/or height is not set in caps");
+        return FALSE;
+    }
+
+    if (!stride)
+        stride = calculate_stride (width, format);
+
+    /* the channel resolution is part of the component setup */
+    if (channel->configured && GST_OMX_BASE_FILTER (self)->ready &&
+        (width != channel->in_width || height != channel->in_height ||
+         stride != channel->in_stride))
+    {
+        GST_WARNING_OBJECT (self, "channel %u is running, can't change its size", channel->id);
+        return FALSE;
+    }
+
+    channel->in_width = width;
+    channel->in_height = height;
+    channel->in_stride = stride;
+
+    {
+        const GValue *framerate = NULL;
+        framerate = gst_structure_get_value (structure, "framerate");
+        if (framerate)
+        {
+            channel->framerate_num = gst_value_get_fraction_numerator (framerate);
+            channel->framerate_denom = gst_value_get_fraction_denominator (framerate);
+
+            if (channel->framerate_num)
+                channel->duration = gst_util_uint64_scale_int (GST_SECOND,
+                        channel->framerate_denom, channel->framerate_num);
+        }
+    }
+
+    return TRUE;
+}
+
+static gboolean
+src_setcaps (GstPad *pad,
+             GstCaps *caps)
+{
+    GstOmxMcScalerChannel *channel;
+    GstOmxMcScaler *self;
+    GstVideoFormat format;
+
+    channel = gst_pad_get_element_private (pad);
+    self = channel->self;
+
+    GST_INFO_OBJECT (self, "setcaps (src %u): %" GST_PTR_FORMAT, channel->id, caps);
+    g_return_val_if_fail (caps, FALSE);
+    g_return_val_if_fail (gst_caps_is_fixed (caps), FALSE);
+
+    if (!gst_video_format_parse_caps_strided (caps,
+            &format, &channel->out_width, &channel->out_height, &channel->out_stride))
+    {
+        GST_WARNING_OBJECT (self, "width and/or height is not set in caps");
+        return FALSE;
+    }
+
+    if (!channel->out_stride)
+        channel->out_stride = calculate_stride (channel->out_width, format);
+
+    /* save the src caps later needed by omx transport buffer */
+    if (channel->out_port->caps)
+        gst_caps_unref (channel->out_port->caps);
+
+    channel->out_port->caps = gst_caps_copy (caps);
+
+    return TRUE;
+}
+
+static gboolean
+activate_push (GstPad *pad,
+               gboolean active)
+{
+    GstOmxMcScalerChannel *channel;
+    GstOmxBaseFilter *omx_base;
+    gboolean result = TRUE;
+
+    channel = gst_pad_get_element_private (pad);
+    omx_base = GST_OMX_BASE_FILTER (channel->self);
+
+    if (active)
+    {
+        channel->last_return = GST_FLOW_OK;
+
+        if (omx_base->ready && channel->configured)
+        {
+            g_omx_port_resume (channel->in_port);
+            g_omx_port_resume (channel->out_port);
+
+            start_channel (channel);
+        }
+    }
+    else
+    {
+        if (omx_base->ready && channel->configured)
+        {
+            /* unlock loops */
+            g_omx_port_pause (channel->in_port);
+            g_omx_port_pause (channel->out_port);
+        }
+
+        /* make sure streaming finishes */
+        result = gst_pad_stop_task (pad);
+    }
+
+    return result;
+}
+
+static GstPad *
+request_new_pad (GstElement *element,
+                 GstPadTemplate *templ,
+                 const gchar *name)
+{
+    GstOmxMcScaler *self;
+    GstOmxBaseFilter *omx_base;
+    GstElementClass *element_class;
+    GstPad *sinkpad, *srcpad;
+    gchar *pad_name;
+    guint id = 0;
+
+    self = GST_OMX_MCSCALER (element);
+    omx_base = GST_OMX_BASE_FILTER (element);
+    element_class = GST_ELEMENT_GET_CLASS (element);
+
+    if (templ != gst_element_class_get_pad_template (element_class, "sink_%d"))
+        return NULL;
+
+    g_mutex_lock (omx_base->ready_lock);
+
+    if (omx_base->ready)
+    {
+        g_mutex_unlock (omx_base->ready_lock);
+        GST_WARNING_OBJECT (self, "channels can't be added once the component is set up");
+        return NULL;
+    }
+
+    g_mutex_lock (self->cycle_lock);
+
+    if (name && sscanf (name, "sink_%u", &id) == 1)
+    {
+        if (id == 0 || id >= GST_OMX_MCSCALER_MAX_CHANNELS || self->channels[id])
+            id = 0;
+    }
+    else
+    {
+        for (id = 1; id < GST_OMX_MCSCALER_MAX_CHANNELS && self->channels[id]; id++)
+            ;
+        if (id == GST_OMX_MCSCALER_MAX_CHANNELS)
+            id = 0;
+    }
+
+    if (!id)
+    {
+        g_mutex_unlock (self->cycle_lock);
+        g_mutex_unlock (omx_base->ready_lock);
+        GST_WARNING_OBJECT (self, "no free channel for %s", name ? name : "sink_%d");
+        return NULL;
+    }
+
+    pad_name = g_strdup_printf ("sink_%u", id);
+    sinkpad = gst_pad_new_from_template (templ, pad_name);
+    g_free (pad_name);
+
+    pad_name = g_strdup_printf ("src_%u", id);
+    srcpad = gst_pad_new_from_template (
+            gst_element_class_get_pad_template (element_class, "src_%d"), pad_name);
+    g_free (pad_name);
+
+    gst_pad_use_fixed_caps (srcpad);
+
+    channel_new (self, id, sinkpad, srcpad);
+
+    g_mutex_unlock (self->cycle_lock);
+    g_mutex_unlock (omx_base->ready_lock);
+
+    GST_INFO_OBJECT (self, "added channel %u", id);
+
+    if (GST_STATE (element) > GST_STATE_READY)
+    {
+        gst_pad_set_active (srcpad, TRUE);
+        gst_pad_set_active (sinkpad, TRUE);
+    }
+
+    gst_element_add_pad (element, srcpad);
+    gst_element_add_pad (element, sinkpad);
+
+    return sinkpad;
+}
+
+static void
+release_pad (GstElement *element,
+             GstPad *pad)
+{
+    GstOmxMcScaler *self;
+    GstOmxMcScalerChannel *channel;
+
+    self = GST_OMX_MCSCALER (element);
+    channel = gst_pad_get_element_private (pad);
+
+    if (!channel || channel->id == 0 || pad != channel->sinkpad)
+        return;
+
+    GST_INFO_OBJECT (self, "removing channel %u", channel->id);
+
+    /* get the streaming threads of the channel out */
+    g_mutex_lock (self->cycle_lock);
+    channel->flushing = TRUE;
+    g_cond_broadcast (self->cycle_cond);
+    g_mutex_unlock (self->cycle_lock);
+
+    gst_pad_set_active (channel->sinkpad, FALSE);
+    gst_pad_set_active (channel->srcpad, FALSE);
+
+    g_mutex_lock (self->cycle_lock);
+    self->channels[channel->id] = NULL;
+    self->num_channels--;
+    g_mutex_unlock (self->cycle_lock);
+
+    /* its ports stay with the component until it is unloaded */
+    gst_element_remove_pad (element, channel->srcpad);
+    gst_element_remove_pad (element, channel->sinkpad);
+
+    g_free (channel);
+}
+
+static GstStateChangeReturn
+change_state (GstElement *element,
+              GstStateChange transition)
+{
+    GstOmxMcScaler *self;
+    GstStateChangeReturn ret;
+    guint i;
+
+    self = GST_OMX_MCSCALER (element);
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            g_mutex_lock (self->cycle_lock);
+            self->flushing = FALSE;
+            for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+            {
+                GstOmxMcScalerChannel *channel = self->channels[i];
+
+                if (!channel)
+                    continue;
+
+                channel->eos = FALSE;
+                channel->flushing = FALSE;
+                channel->last_return = GST_FLOW_OK;
+                channel->send_return = GST_FLOW_OK;
+                g_atomic_int_set (&channel->sent, 0);
+                g_atomic_int_set (&channel->pushed, 0);
+            }
+            g_mutex_unlock (self->cycle_lock);
+            break;
+
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            g_mutex_lock (self->cycle_lock);
+            self->flushing = TRUE;
+            g_cond_broadcast (self->cycle_cond);
+            g_mutex_unlock (self->cycle_lock);
+
+            /* the base class only knows about the ports of channel 0 */
+            for (i = 1; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+            {
+                GstOmxMcScalerChannel *channel = self->channels[i];
+
+                if (channel && channel->configured)
+                {
+                    g_omx_port_finish (channel->in_port);
+                    g_omx_port_finish (channel->out_port);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+    if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    {
+        for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+        {
+            if (self->channels[i])
+                self->channels[i]->configured = FALSE;
+        }
+    }
+
+    return ret;
+}
+
+static void
+finalize (GObject *obj)
+{
+    GstOmxMcScaler *self;
+    guint i;
+
+    self = GST_OMX_MCSCALER (obj);
+
+    for (i = 0; i < GST_OMX_MCSCALER_MAX_CHANNELS; i++)
+        g_free (self->channels[i]);
+
+    g_cond_free (self->cycle_cond);
+    g_mutex_free (self->cycle_lock);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMcScaler *self;
+
+    self = GST_OMX_MCSCALER (obj);
+
+    switch (prop_id)
+    {
+        case ARG_BATCH_TIMEOUT:
+            g_mutex_lock (self->cycle_lock);
+            self->batch_timeout = g_value_get_uint (value);
+            g_cond_broadcast (self->cycle_cond);
+            g_mutex_unlock (self->cycle_lock);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMcScaler *self;
+
+    self = GST_OMX_MCSCALER (obj);
+
+    g_mutex_lock (self->cycle_lock);
+
+    switch (prop_id)
+    {
+        case ARG_BATCH_TIMEOUT:
+            g_value_set_uint (value, self->batch_timeout);
+            break;
+        case ARG_NUM_CHANNELS:
+            g_value_set_uint (value, self->num_channels);
+            break;
+        case ARG_CYCLES:
+            g_value_set_uint64 (value, self->cycles);
+            break;
+        case ARG_PARTIAL_CYCLES:
+            g_value_set_uint64 (value, self->partial_cycles);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+
+    g_mutex_unlock (self->cycle_lock);
+}
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+    GstOmxBaseFilterClass *bclass;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+    gstelement_class = GST_ELEMENT_CLASS (g_class);
+    bclass = GST_OMX_BASE_FILTER_CLASS (g_class);
+
+    gobject_class->finalize = finalize;
+    gstelement_class->change_state = change_state;
+    gstelement_class->request_new_pad = request_new_pad;
+    gstelement_class->release_pad = release_pad;
+    bclass->pad_chain = pad_chain;
+    bclass->pad_event = pad_event;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_BATCH_TIMEOUT,
+                                         g_param_spec_uint ("batch-timeout", "Batch timeout",
+                                                            "Msec to wait for a frame on every channel before sending a partial cycle (0 = don't wait)",
+                                                            0, G_MAXUINT, DEFAULT_BATCH_TIMEOUT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_NUM_CHANNELS,
+                                         g_param_spec_uint ("num-channels", "Number of channels",
+                                                            "Number of sink/src pad pairs",
+                                                            1, GST_OMX_MCSCALER_MAX_CHANNELS, 1, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_CYCLES,
+                                         g_param_spec_uint64 ("cycles", "Cycles",
+                                                              "Number of input cycles sent to the component",
+                                                              0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_PARTIAL_CYCLES,
+                                         g_param_spec_uint64 ("partial-cycles", "Partial cycles",
+                                                              "Number of cycles sent on batch-timeout with channels missing",
+                                                              0, G_MAXUINT64, 0, G_PARAM_READABLE));
+    }
+}
+
+static void
+type_instance_init (GTypeInstance *instance,
+                    gpointer g_class)
+{
+    GstOmxBaseFilter *omx_base;
+    GstOmxBaseVfpc *vfpc;
+    GstOmxMcScaler *self;
+
+    omx_base = GST_OMX_BASE_FILTER (instance);
+    vfpc = GST_OMX_BASE_VFPC (instance);
+    self = GST_OMX_MCSCALER (instance);
+
+    self->cycle_lock = g_mutex_new ();
+    self->cycle_cond = g_cond_new ();
+    self->batch_timeout = DEFAULT_BATCH_TIMEOUT;
+
+    vfpc->omx_setup = omx_setup;
+    g_object_set (self, "port-index", 0, NULL);
+
+    channel_new (self, 0, omx_base->sinkpad, omx_base->srcpad);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_MCSCALER_H
+#define GSTOMX_MCSCALER_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_MCSCALER(obj) (GstOmxMcScaler *) (obj)
+#define GST_OMX_MCSCALER_TYPE (gst_omx_mcscaler_get_type ())
+
+/** channels of one VFPC handle, one input/output port pair each */
+#define GST_OMX_MCSCALER_MAX_CHANNELS 16
+
+typedef struct GstOmxMcScaler GstOmxMcScaler;
+typedef struct GstOmxMcScalerClass GstOmxMcScalerClass;
+typedef struct GstOmxMcScalerChannel GstOmxMcScalerChannel;
+
+#include "gstomx_base_vfpc.h"
+
+/**
+ * One sink/src pad pair.  Channel 0 is the "sink"/"src" pair of the base
+ * filter, the others come from requesting "sink_%d" pads.  The id is the
+ * nChId of the channel and the offset of its ports from
+ * OMX_VFPC_INPUT_PORT_START_INDEX and OMX_VFPC_OUTPUT_PORT_START_INDEX.
+ */
+struct GstOmxMcScalerChannel
+{
+    GstOmxMcScaler *self;
+    guint id;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+    GOmxPort *in_port;
+    GOmxPort *out_port;
+
+    gint framerate_num, framerate_denom;
+    gint in_width, in_height, in_stride;
+    gint out_width, out_height, out_stride;
+    gint left, top;
+    GstClockTime duration;
+
+    gboolean configured;        /**< part of the component setup */
+    gboolean eos;
+    gboolean flushing;
+    GstFlowReturn last_return;  /**< of the last push on srcpad */
+
+    GstBuffer *pending;         /**< waiting for the next cycle */
+    gboolean submitting;        /**< taken by a cycle, not sent yet */
+    GstFlowReturn send_return;  /**< of sending the last pending buffer */
+
+    volatile gint sent;         /**< frames given to the component */
+    volatile gint pushed;       /**< frames that came out of it */
+    volatile gint draining;     /**< EOS waits for sent == pushed */
+};
+
+struct GstOmxMcScaler
+{
+    GstOmxBaseVfpc omx_base;
+
+    GstOmxMcScalerChannel *channels[GST_OMX_MCSCALER_MAX_CHANNELS];
+    guint num_channels;
+
+    GMutex *cycle_lock;         /**< protects the channels and the cycle state */
+    GCond *cycle_cond;
+    gboolean sending;           /**< a cycle is being sent */
+    gboolean flushing;
+    guint batch_timeout;        /**< msec to wait for a full cycle */
+
+    guint64 cycles;
+    guint64 partial_cycles;     /**< sent on timeout, with channels missing */
+};
+
+struct GstOmxMcScalerClass
+{
+    GstOmxBaseVfpcClass parent_class;
+};
+
+GType gst_omx_mcscaler_get_type (void);
+
+G_END_DECLS
+
+#endif /* GSTOMX_MCSCALER_H */
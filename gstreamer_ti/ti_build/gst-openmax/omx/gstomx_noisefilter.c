@@ -164,7 +164,8 @@ omx_setup (GstOmxBaseFilter *omx_base)
     paramPort.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
     paramPort.format.video.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
     paramPort.nBufferSize =  self->out_stride * self->out_height * 1.5;
-    paramPort.nBufferCountActual = 3;
+    paramPort.nBufferCountActual = gst_omx_base_vfpc_get_output_buffer_count (self,
+            omx_base->srcpad, omx_base->duration, paramPort.nBufferCountMin, 3);
     paramPort.nBufferAlignment = 0;
     paramPort.bBuffersContiguous = 0;
     G_OMX_PORT_SET_DEFINITION (omx_base->out_port, &paramPort);
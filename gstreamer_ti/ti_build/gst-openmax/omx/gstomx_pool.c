@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstomx_pool.h"
+#include "gstomx.h"
+
+#include <string.h>
+
+/** a parked handle */
+typedef struct
+{
+    OMX_HANDLETYPE omx_handle;
+    GOmxImp *imp;
+    GOmxAppData *app_data;
+    GstClockTime parked;    /**< gst_util_get_timestamp() */
+} GOmxPoolEntry;
+
+/* protects everything below */
+static GStaticMutex pool_mutex = G_STATIC_MUTEX_INIT;
+static GCond *pool_cond;        /**< entries or limits changed */
+static GQueue pool_entries = G_QUEUE_INIT;  /**< oldest first */
+static GThread *pool_thread;    /**< frees expired entries, while there are any */
+
+static guint pool_size = G_OMX_POOL_DEFAULT_SIZE;
+static guint pool_timeout = G_OMX_POOL_DEFAULT_TIMEOUT;
+
+static guint64 pool_hits;
+static guint64 pool_misses;
+static guint64 pool_evictions;
+
+static void
+free_entry (GOmxPoolEntry *entry)
+{
+    OMX_ERRORTYPE omx_error;
+
+    #ifdef USE_STATIC
+    omx_error = OMX_FreeHandle (entry->omx_handle);
+    #else
+    omx_error = entry->imp->sym_table.free_handle (entry->omx_handle);
+    #endif
+    GST_DEBUG ("OMX_FreeHandle(%p) -> %s", entry->omx_handle,
+            g_omx_error_to_str (omx_error));
+
+    g_omx_release_imp (entry->imp);
+
+    g_free (entry->app_data->key);
+    g_free (entry->app_data);
+    g_free (entry);
+}
+
+/* called with pool_mutex, returns the entries to free once it is released */
+static GList *
+trim (guint size)
+{
+    GList *evicted = NULL;
+
+    while (g_queue_get_length (&pool_entries) > size)
+    {
+        evicted = g_list_prepend (evicted, g_queue_pop_head (&pool_entries));
+        pool_evictions++;
+    }
+
+    return evicted;
+}
+
+static void
+free_entries (GList *entries)
+{
+    g_list_foreach (entries, (GFunc) free_entry, NULL);
+    g_list_free (entries);
+}
+
+static gpointer
+evict_thread (gpointer data)
+{
+    GMutex *mutex = g_static_mutex_get_mutex (&pool_mutex);
+
+    g_mutex_lock (mutex);
+
+    while (!g_queue_is_empty (&pool_entries))
+    {
+        GOmxPoolEntry *oldest = g_queue_peek_head (&pool_entries);
+        GstClockTime now, deadline;
+
+        if (!pool_timeout)
+        {
+            g_cond_wait (pool_cond, mutex);
+            continue;
+        }
+
+        now = gst_util_get_timestamp ();
+        deadline = oldest->parked + pool_timeout * GST_MSECOND;
+
+        if (now < deadline)
+        {
+            GTimeVal abs_time;
+
+            g_get_current_time (&abs_time);
+            g_time_val_add (&abs_time, (glong) ((deadline - now) / GST_USECOND));
+            g_cond_timed_wait (pool_cond, mutex, &abs_time);
+            continue;
+        }
+
+        g_queue_pop_head (&pool_entries);
+        pool_evictions++;
+
+        g_mutex_unlock (mutex);
+        free_entry (oldest);
+        g_mutex_lock (mutex);
+    }
+
+    pool_thread = NULL;
+
+    g_mutex_unlock (mutex);
+
+    return NULL;
+}
+
+/**
+ * What parked handles are matched on; free with g_free().
+ */
+gchar *
+g_omx_pool_key (const gchar *library_name,
+                const gchar *component_name,
+                const gchar *component_role)
+{
+    return g_strdup_printf ("%s|%s|%s", library_name, component_name,
+            component_role ? component_role : "");
+}
+
+/**
+ * Give @core the most recently parked handle for @key, with its GOmxImp
+ * and app data.
+ *
+ * Returns FALSE if there is none.
+ */
+gboolean
+g_omx_pool_adopt (GOmxCore *core,
+                  const gchar *key)
+{
+    GOmxPoolEntry *entry = NULL;
+    GList *l;
+
+    g_static_mutex_lock (&pool_mutex);
+
+    for (l = pool_entries.tail; l; l = l->prev)
+    {
+        if (strcmp (((GOmxPoolEntry *) l->data)->app_data->key, key) == 0)
+        {
+            entry = l->data;
+            g_queue_delete_link (&pool_entries, l);
+            break;
+        }
+    }
+
+    if (entry)
+        pool_hits++;
+    else
+        pool_misses++;
+
+    g_static_mutex_unlock (&pool_mutex);
+
+    if (!entry)
+        return FALSE;
+
+    GST_DEBUG_OBJECT (core->object, "adopting %p (%s)", entry->omx_handle, key);
+
+    core->omx_handle = entry->omx_handle;
+    core->imp = entry->imp;
+    core->app_data = entry->app_data;
+    core->app_data->core = core;
+    g_free (entry);
+
+    return TRUE;
+}
+
+/**
+ * Take the handle of @core, with its GOmxImp and app data, making room
+ * for it if the pool is full.  The handle must be in OMX_StateLoaded.
+ *
+ * Returns FALSE, and leaves @core alone, if the pool is disabled.
+ */
+gboolean
+g_omx_pool_park (GOmxCore *core)
+{
+    GOmxPoolEntry *entry;
+    GList *evicted;
+
+    g_static_mutex_lock (&pool_mutex);
+
+    if (!pool_size)
+    {
+        g_static_mutex_unlock (&pool_mutex);
+        return FALSE;
+    }
+
+    evicted = trim (pool_size - 1);
+
+    GST_DEBUG_OBJECT (core->object, "parking %p (%s)", core->omx_handle,
+            core->app_data->key);
+
+    entry = g_new0 (GOmxPoolEntry, 1);
+    entry->omx_handle = core->omx_handle;
+    entry->imp = core->imp;
+    entry->app_data = core->app_data;
+    entry->app_data->core = NULL;
+    entry->parked = gst_util_get_timestamp ();
+    g_queue_push_tail (&pool_entries, entry);
+
+    core->omx_handle = NULL;
+    core->imp = NULL;
+    core->app_data = NULL;
+
+    if (!pool_cond)
+        pool_cond = g_cond_new ();
+
+    if (pool_thread)
+        g_cond_signal (pool_cond);
+    else
+        pool_thread = g_thread_create (evict_thread, NULL, FALSE, NULL);
+
+    g_static_mutex_unlock (&pool_mutex);
+
+    free_entries (evicted);
+
+    return TRUE;
+}
+
+/**
+ * Keep at most @size idle handles (0 disables the pool), each for at most
+ * @timeout msec (0 = until the size limit evicts it).  Applies to the
+ * handles already parked.
+ */
+void
+g_omx_pool_set_limits (guint size,
+                       guint timeout)
+{
+    GList *evicted;
+
+    g_static_mutex_lock (&pool_mutex);
+
+    pool_size = size;
+    pool_timeout = timeout;
+    evicted = trim (size);
+
+    if (pool_thread)
+        g_cond_signal (pool_cond);
+
+    g_static_mutex_unlock (&pool_mutex);
+
+    free_entries (evicted);
+}
+
+void
+g_omx_pool_get_limits (guint *size,
+                       guint *timeout)
+{
+    g_static_mutex_lock (&pool_mutex);
+    if (size)
+        *size = pool_size;
+    if (timeout)
+        *timeout = pool_timeout;
+    g_static_mutex_unlock (&pool_mutex);
+}
+
+/**
+ * Set the "idle" handle count and the "hits", "misses" and "evictions"
+ * counters of the pool in @structure.
+ */
+void
+g_omx_pool_get_stats (GstStructure *structure)
+{
+    g_static_mutex_lock (&pool_mutex);
+    gst_structure_set (structure,
+            "idle", G_TYPE_UINT, g_queue_get_length (&pool_entries),
+            "hits", G_TYPE_UINT64, pool_hits,
+            "misses", G_TYPE_UINT64, pool_misses,
+            "evictions", G_TYPE_UINT64, pool_evictions,
+            NULL);
+    g_static_mutex_unlock (&pool_mutex);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_POOL_H
+#define GSTOMX_POOL_H
+
+#include "gstomx_util.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Process-wide pool of idle component handles in OMX_StateLoaded.
+ *
+ * A core that uses the pool parks its handle here in g_omx_core_deinit()
+ * instead of freeing it, with its ports put back the way it found them,
+ * and g_omx_core_init() adopts a parked handle of the same library,
+ * component and role instead of calling OMX_GetHandle().  A parked handle
+ * keeps its GOmxImp requested, so the library stays loaded and
+ * initialized.  Handles are freed when they have been idle for longer
+ * than the idle timeout or to make room under the size limit.
+ */
+
+/** idle handles kept at most, unless set otherwise */
+#define G_OMX_POOL_DEFAULT_SIZE 4
+
+/** msec an idle handle is kept, unless set otherwise */
+#define G_OMX_POOL_DEFAULT_TIMEOUT 30000
+
+gchar *g_omx_pool_key (const gchar *library_name, const gchar *component_name, const gchar *component_role);
+gboolean g_omx_pool_adopt (GOmxCore *core, const gchar *key);
+gboolean g_omx_pool_park (GOmxCore *core);
+void g_omx_pool_set_limits (guint size, guint timeout);
+void g_omx_pool_get_limits (guint *size, guint *timeout);
+void g_omx_pool_get_stats (GstStructure *structure);
+
+G_END_DECLS
+
+#endif /* GSTOMX_POOL_H */
@@ -50,6 +50,9 @@ static void setup_shared_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffe
 #define WARNING(port, fmt, args...) \
     GST_WARNING ("<%s:%s> "fmt, GST_OBJECT_NAME ((port)->core->object), (port)->name, ##args)
 
+/* initial queue size, grown to fit the real buffer count once it is known */
+#define DEFAULT_QUEUE_SIZE 16
+
 /*
  * Port
  */
@@ -66,7 +69,7 @@ g_omx_port_new (GOmxCore *core, const gchar *name, guint index)
     port->buffers = NULL;
 
     port->enabled = TRUE;
-    port->queue = async_queue_new ();
+    port->queue = async_ring_new (DEFAULT_QUEUE_SIZE);
     port->mutex = g_mutex_new ();
 
     port->ignore_count = 0;
@@ -82,11 +85,12 @@ g_omx_port_free (GOmxPort *port)
     DEBUG (port, "begin");
 
     g_mutex_free (port->mutex);
-    async_queue_free (port->queue);
+    async_ring_free (port->queue);
 
     g_free (port->name);
 
     g_free (port->buffers);
+    g_free (port->defaults);
     g_free (port);
 
     GST_DEBUG ("end");
@@ -214,6 +218,18 @@ g_omx_port_allocate_buffers (GOmxPort *port)
 
     port->buffers = g_new0 (OMX_BUFFERHEADERTYPE *, port->num_buffers);
 
+    /* every header can be queued at most once, but leave headroom for the
+     * component reporting a buffer again (OMX_TI_EventBufferRefCount)
+     */
+    async_ring_reserve (port->queue, port->num_buffers * 2);
+
+    port->buffer_index = g_hash_table_new (NULL, NULL);
+
+    memset (&port->stats, 0, sizeof (port->stats));
+    port->stats.release_time = g_new0 (GstClockTime, port->num_buffers);
+    port->stats.return_time = g_new0 (GstClockTime, port->num_buffers);
+    port->stats.owned = g_new0 (gint, port->num_buffers);
+
     for (i = 0; i < port->num_buffers; i++)
     {
 
@@ -235,6 +251,11 @@ g_omx_port_allocate_buffers (GOmxPort *port)
             if (!port->always_copy)
             {
                 buffer_data = port->share_buffer_info->pBuffer[i];
+
+                if (!port->pbuffer_index)
+                    port->pbuffer_index = g_hash_table_new (NULL, NULL);
+                g_hash_table_insert (port->pbuffer_index, buffer_data,
+                        GUINT_TO_POINTER (i + 1));
             }
             else if (! port->share_buffer)
             {
@@ -257,6 +278,9 @@ g_omx_port_allocate_buffers (GOmxPort *port)
                 port->buffers[i]->nAllocLen = size;
             }
         }
+
+        g_hash_table_insert (port->buffer_index, port->buffers[i],
+                GUINT_TO_POINTER (i + 1));
     }
     
     DEBUG (port, "end");
@@ -280,7 +304,7 @@ g_omx_port_free_buffers (GOmxPort *port)
          * OMX component, to avoid freeing a buffer that the component
          * is still accessing:
          */
-        omx_buffer = async_queue_pop_full (port->queue, TRUE, TRUE);
+        omx_buffer = async_ring_pop_full (port->queue, TRUE, TRUE);
 
         if (omx_buffer)
         {
@@ -302,6 +326,25 @@ g_omx_port_free_buffers (GOmxPort *port)
     g_free (port->buffers);
     port->buffers = NULL;
 
+    if (port->buffer_index)
+    {
+        g_hash_table_destroy (port->buffer_index);
+        port->buffer_index = NULL;
+    }
+
+    if (port->pbuffer_index)
+    {
+        g_hash_table_destroy (port->pbuffer_index);
+        port->pbuffer_index = NULL;
+    }
+
+    g_free (port->stats.release_time);
+    g_free (port->stats.return_time);
+    g_free (port->stats.owned);
+    port->stats.release_time = NULL;
+    port->stats.return_time = NULL;
+    port->stats.owned = NULL;
+
     DEBUG (port, "end");
 }
 
@@ -350,19 +393,48 @@ g_omx_port_push_buffer (GOmxPort *port,
         omx_buffer->pAppPrivate = NULL;
     }
 
-    async_queue_push (port->queue, omx_buffer);
+    if (G_UNLIKELY (!async_ring_push (port->queue, omx_buffer)))
+    {
+        /* the ring is sized for twice the buffer count, so this means the
+         * component returned a header we never gave it
+         */
+        WARNING (port, "queue full, dropping omx_buffer=%p", omx_buffer);
+    }
 }
 
 static OMX_BUFFERHEADERTYPE *
-request_buffer (GOmxPort *port)
+request_buffer_full (GOmxPort *port, gboolean wait)
 {
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+    gint index;
+
     LOG (port, "request buffer");
-    return async_queue_pop (port->queue);
+    omx_buffer = async_ring_pop_full (port->queue, wait, FALSE);
+
+    if (!omx_buffer || G_LIKELY (!g_atomic_int_get (&port->stats_enabled)))
+        return omx_buffer;
+
+    index = g_omx_port_get_buffer_index (port, omx_buffer);
+    if (index >= 0 && port->stats.return_time[index])
+    {
+        g_omx_histogram_add (port->stats.queue_time,
+                (gst_util_get_timestamp () - port->stats.return_time[index]) / GST_USECOND);
+    }
+
+    return omx_buffer;
+}
+
+static OMX_BUFFERHEADERTYPE *
+request_buffer (GOmxPort *port)
+{
+    return request_buffer_full (port, TRUE);
 }
 
 static void
 release_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
 {
+    g_omx_port_stats_released (port, omx_buffer);
+
     switch (port->type)
     {
         case GOMX_PORT_INPUT:
@@ -442,9 +514,19 @@ send_prep_codec_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuffe
     }
 }
 
-static void
-send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuffer *buf)
+/* fill @omx_buffer from @buf, skipping the first @offset bytes (only when
+ * copying); the timestamp goes with the start of the buffer, like it does
+ * for a sub-buffer.  Returns the number of bytes of @buf used, which is
+ * less than nFilledLen when the VP6 frame-length prefix was added.
+ */
+static guint
+send_prep_buffer_range (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer,
+                        GstBuffer *buf, guint offset)
 {
+    guint8 *data = GST_BUFFER_DATA (buf) + offset;
+    guint size = GST_BUFFER_SIZE (buf) - offset;
+    guint used;
+
     if (port->share_buffer)
     {
         omx_buffer->nOffset     = port->n_offset;
@@ -457,15 +539,24 @@ send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuff
 
         /* special hack.. this should be removed: */
         omx_buffer->nFlags     |= OMX_BUFFERHEADERFLAG_MODIFIED;
+
+        used = GST_BUFFER_SIZE (buf);
     }
     else
     {
         if (port->always_copy)
         {
-            omx_buffer->nFilledLen = MIN (GST_BUFFER_SIZE (buf),
-                omx_buffer->nAllocLen - omx_buffer->nOffset);
+            guint room = omx_buffer->nAllocLen - omx_buffer->nOffset;
+
+            /* leave room for the frame-length the VP6 hack prepends */
+            if (G_UNLIKELY (port->vp6_hack))
+                room = room > 4 ? room - 4 : 0;
+
+            omx_buffer->nFilledLen = MIN (size, room);
         }
 
+        used = omx_buffer->nFilledLen;
+
         if (G_UNLIKELY (port->vp6_hack))
         {
             DEBUG (port, "VP6 hack begin");
@@ -474,8 +565,7 @@ send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuff
             memcpy (omx_buffer->pBuffer, &(omx_buffer->nFilledLen), 4);
 
             DEBUG (port, "memcpy the vp6 data");
-            memcpy (omx_buffer->pBuffer + 4, GST_BUFFER_DATA (buf),
-                    omx_buffer->nFilledLen);
+            memcpy (omx_buffer->pBuffer + 4, data, omx_buffer->nFilledLen);
 
             DEBUG (port, "add four bytes to nFilledLen");
             omx_buffer->nFilledLen += 4;
@@ -487,7 +577,7 @@ send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuff
             if (port->always_copy) 
             {
                 memcpy (omx_buffer->pBuffer + omx_buffer->nOffset,
-                    GST_BUFFER_DATA (buf), omx_buffer->nFilledLen);
+                    data, omx_buffer->nFilledLen);
             }
         }
     }
@@ -495,13 +585,21 @@ send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuff
     if (port->core->use_timestamps)
     {
         omx_buffer->nTimeStamp = gst_util_uint64_scale_int (
-                GST_BUFFER_TIMESTAMP (buf),
+                offset ? GST_CLOCK_TIME_NONE : GST_BUFFER_TIMESTAMP (buf),
                 OMX_TICKS_PER_SECOND, GST_SECOND);
     }
 
     DEBUG (port, "omx_buffer: size=%lu, len=%lu, flags=%lu, offset=%lu, timestamp=%lld",
             omx_buffer->nAllocLen, omx_buffer->nFilledLen, omx_buffer->nFlags,
             omx_buffer->nOffset, omx_buffer->nTimeStamp);
+
+    return used;
+}
+
+static void
+send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuffer *buf)
+{
+    send_prep_buffer_range (port, omx_buffer, buf, 0);
 }
 
 static void
@@ -523,16 +621,202 @@ send_prep_eos_event (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstEvent
     }
 }
 
+/**
+ * Index of @omx_buffer in port->buffers, or -1 if the header does not
+ * belong to @port.
+ */
+gint
+g_omx_port_get_buffer_index (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    gpointer index;
+
+    if (G_UNLIKELY (!port->buffer_index))
+        return -1;
+
+    index = g_hash_table_lookup (port->buffer_index, omx_buffer);
+
+    return GPOINTER_TO_UINT (index) - 1;
+}
+
+/**
+ * Start collecting the statistics reported by g_omx_port_get_stats().
+ * Until then the buffer hooks below only keep the in-component and
+ * max-outstanding counters, so ports nobody looks at do not pay for the
+ * timestamps and histograms.  Buffers already in the component when this
+ * is called are not timed.
+ */
+void
+g_omx_port_enable_stats (GOmxPort *port)
+{
+    g_atomic_int_set (&port->stats_enabled, TRUE);
+}
+
+/**
+ * Account @omx_buffer being handed to the component (ETB/FTB).
+ */
+void
+g_omx_port_stats_released (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    gint index, depth;
+
+    index = g_omx_port_get_buffer_index (port, omx_buffer);
+    if (index < 0)
+        return;
+
+    /* the counters are always kept, "peak-output-buffers" reads them */
+    if (g_atomic_int_compare_and_exchange (&port->stats.owned[index], FALSE, TRUE))
+        depth = g_atomic_int_exchange_and_add (&port->stats.in_component, 1);
+    else
+        depth = g_atomic_int_get (&port->stats.in_component);
+
+    if (G_LIKELY (!g_atomic_int_get (&port->stats_enabled)))
+        return;
+
+    port->stats.release_time[index] = gst_util_get_timestamp ();
+    g_omx_histogram_add (port->stats.component_depth, depth);
+}
+
+/**
+ * Account @omx_buffer coming back from the component
+ * (EmptyBufferDone/FillBufferDone), before it is queued on the port.
+ */
+void
+g_omx_port_stats_returned (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    GstClockTime now, residency;
+    gint index, outstanding, peak;
+
+    index = g_omx_port_get_buffer_index (port, omx_buffer);
+    if (index < 0)
+        return;
+
+    /* a buffer reported again (OMX_TI_EventBufferRefCount) is not counted twice */
+    if (g_atomic_int_compare_and_exchange (&port->stats.owned[index], TRUE, FALSE))
+    {
+        outstanding = port->num_buffers -
+                (g_atomic_int_exchange_and_add (&port->stats.in_component, -1) - 1);
+
+        do
+        {
+            peak = g_atomic_int_get (&port->stats.max_outstanding);
+            if (outstanding <= peak)
+                break;
+        } while (!g_atomic_int_compare_and_exchange (&port->stats.max_outstanding,
+                    peak, outstanding));
+    }
+
+    if (G_LIKELY (!g_atomic_int_get (&port->stats_enabled)))
+        return;
+
+    now = gst_util_get_timestamp ();
+    port->stats.return_time[index] = now;
+    g_omx_histogram_add (port->stats.queue_depth, async_ring_length (port->queue));
+
+    /* buffers queued in g_omx_port_start_buffers() etc. before the stats
+     * were set up have no release time
+     */
+    if (!port->stats.release_time[index])
+        return;
+
+    residency = now - port->stats.release_time[index];
+    port->stats.release_time[index] = 0;
+
+    g_omx_histogram_add (port->stats.residency, residency / GST_USECOND);
+
+    port->stats.buffers++;
+    if (residency > port->stats.max_residency)
+        port->stats.max_residency = residency;
+}
+
+static void
+add_histogram (GstStructure *structure, const gchar *prefix,
+               const gchar *name, const guint *histogram)
+{
+    gchar *field;
+
+    field = g_strdup_printf ("%s-%s", prefix, name);
+    g_omx_histogram_set (structure, field, histogram);
+    g_free (field);
+}
+
+/**
+ * Add the port statistics to @structure as fields named "@prefix-...":
+ * buffers, in-component, max-outstanding (most buffers out of the
+ * component at once), max-residency (usec) and the residency,
+ * queue-time, component-depth and queue-depth histograms (arrays of
+ * G_OMX_PORT_STATS_BUCKETS uints, see GOmxPortStats).
+ */
+void
+g_omx_port_get_stats (GOmxPort *port, GstStructure *structure, const gchar *prefix)
+{
+    gchar *field;
+
+    field = g_strdup_printf ("%s-buffers", prefix);
+    gst_structure_set (structure, field, G_TYPE_UINT64, port->stats.buffers, NULL);
+    g_free (field);
+
+    field = g_strdup_printf ("%s-in-component", prefix);
+    gst_structure_set (structure, field, G_TYPE_INT,
+            g_atomic_int_get (&port->stats.in_component), NULL);
+    g_free (field);
+
+    field = g_strdup_printf ("%s-max-outstanding", prefix);
+    gst_structure_set (structure, field, G_TYPE_INT,
+            g_atomic_int_get (&port->stats.max_outstanding), NULL);
+    g_free (field);
+
+    field = g_strdup_printf ("%s-max-residency", prefix);
+    gst_structure_set (structure, field, G_TYPE_UINT64,
+            port->stats.max_residency / GST_USECOND, NULL);
+    g_free (field);
+
+    add_histogram (structure, prefix, "residency", port->stats.residency);
+    add_histogram (structure, prefix, "queue-time", port->stats.queue_time);
+    add_histogram (structure, prefix, "component-depth", port->stats.component_depth);
+    add_histogram (structure, prefix, "queue-depth", port->stats.queue_depth);
+}
+
+/* Find the input header that was set up (OMX_UseBuffer) on the same pBuffer
+ * as the upstream header wrapped by @src.  Buffers coming straight from the
+ * upstream port we were configured against carry the header index, which
+ * maps 1:1 onto our own headers; anything else goes through the pBuffer
+ * hash.  A buffer matching neither must not be sent: reusing an arbitrary
+ * header could alias one the component is still processing.
+ */
 static gint
-omxbuffer_index (GOmxPort *port, OMX_U8 *pBuffer)
+input_buffer_index (GOmxPort *port, GstBuffer *src)
 {
-    int i;
-    
-    for (i=0; i < port->num_buffers; i++) 
-        if (port->buffers[i]->pBuffer == pBuffer)
-            return i;
+    GstOmxBufferTransport *transport = GST_OMXBUFFERTRANSPORT (src);
+    OmxBufferInfo *info = port->share_buffer_info;
+    gpointer index;
+
+    if (G_LIKELY (info && transport->port == info->port &&
+                  transport->index >= 0 &&
+                  transport->index < info->num_buffers &&
+                  info->pBuffer[transport->index] == GST_BUFFER_DATA (src)))
+    {
+        return transport->index;
+    }
+
+    if (port->pbuffer_index)
+    {
+        index = g_hash_table_lookup (port->pbuffer_index, GST_BUFFER_DATA (src));
+
+        if (index)
+        {
+            port->foreign_buffers++;
+            LOG (port, "foreign buffer %p resolved to %u",
+                    GST_BUFFER_DATA (src), GPOINTER_TO_UINT (index) - 1);
+            return GPOINTER_TO_UINT (index) - 1;
+        }
+    }
+
+    port->misrouted_buffers++;
+    GST_ERROR ("<%s:%s> buffer %p (pBuffer=%p) matches no input header (%u misrouted)",
+            GST_OBJECT_NAME (port->core->object), port->name, src,
+            GST_BUFFER_DATA (src), port->misrouted_buffers);
 
-    return 0; 
+    return -1;
 }
 
 /* we are configured not copy the input buffer then update the pBuffer
@@ -543,10 +827,13 @@ static OMX_BUFFERHEADERTYPE *
 get_input_buffer_header (GOmxPort *port, GstBuffer *src)
 {
     OMX_BUFFERHEADERTYPE *omx_buffer;
-    int index;
+    gint index;
+
+    index = input_buffer_index (port, src);
+
+    if (G_UNLIKELY (index < 0))
+        return NULL;
 
-    index = omxbuffer_index(port, GST_BUFFER_DATA (src));
-     
     omx_buffer = port->buffers[index];
 
     omx_buffer->pBuffer = GST_BUFFER_DATA(src);
@@ -558,6 +845,29 @@ get_input_buffer_header (GOmxPort *port, GstBuffer *src)
     return omx_buffer;
 }
 
+/* get a header we requested ready to be filled */
+static void
+reset_input_header (OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    /* don't assume OMX component clears flags!
+     */
+    omx_buffer->nFlags = 0;
+
+    /* if buffer sharing is enabled, pAppPrivate might hold the ref to
+     * a buffer that is no longer required and should be unref'd.  We
+     * do this check here, rather than in send_prep_buffer_data() so
+     * we don't keep the reference live in case, for example, this time
+     * the buffer is used for an EOS event.
+     */
+    if (omx_buffer->pAppPrivate)
+    {
+        GstBuffer *old_buf = omx_buffer->pAppPrivate;
+        gst_buffer_unref (old_buf);
+        omx_buffer->pAppPrivate = NULL;
+        omx_buffer->pBuffer = NULL;     /* just to ease debugging */
+    }
+}
+
 /**
  * Send a buffer/event to the OMX component.  This handles conversion of
  * GST buffer, codec-data, and EOS events to the equivalent OMX buffer.
@@ -565,6 +875,8 @@ get_input_buffer_header (GOmxPort *port, GstBuffer *src)
  * This method does not take ownership of the ref to @obj
  *
  * Returns number of bytes sent, or negative if error
+ * (G_OMX_PORT_SEND_MISROUTED if a zero-copy buffer matched none of our
+ * input headers)
  */
 gint
 g_omx_port_send (GOmxPort *port, gpointer obj)
@@ -601,23 +913,7 @@ g_omx_port_send (GOmxPort *port, gpointer obj)
                 return -1;
             }
 
-            /* don't assume OMX component clears flags!
-             */
-            omx_buffer->nFlags = 0;
-
-            /* if buffer sharing is enabled, pAppPrivate might hold the ref to
-             * a buffer that is no longer required and should be unref'd.  We
-             * do this check here, rather than in send_prep_buffer_data() so
-             * we don't keep the reference live in case, for example, this time
-             * the buffer is used for an EOS event.
-             */
-            if (omx_buffer->pAppPrivate)
-            {
-                GstBuffer *old_buf = omx_buffer->pAppPrivate;
-                gst_buffer_unref (old_buf);
-                omx_buffer->pAppPrivate = NULL;
-                omx_buffer->pBuffer = NULL;     /* just to ease debugging */
-            }
+            reset_input_header (omx_buffer);
         }
         else
         {
@@ -625,6 +921,9 @@ g_omx_port_send (GOmxPort *port, gpointer obj)
                 omx_buffer = get_input_buffer_header (port, obj);
             else
                 return -1; /* something went wrong */
+
+            if (G_UNLIKELY (!omx_buffer))
+                return G_OMX_PORT_SEND_MISROUTED;
         }
 
         send_prep (port, omx_buffer, obj);
@@ -640,6 +939,136 @@ g_omx_port_send (GOmxPort *port, gpointer obj)
     return -1;
 }
 
+/* hand the filled headers to the component back to back */
+static void
+release_batch (GOmxPort *port, OMX_BUFFERHEADERTYPE **batch, guint *n_batch)
+{
+    guint i;
+
+    for (i = 0; i < *n_batch; i++)
+        release_buffer (port, batch[i]);
+
+    *n_batch = 0;
+}
+
+/**
+ * Send @n_bufs buffers to the OMX component, in order, as if each was
+ * passed to g_omx_port_send() until it was sent completely.
+ *
+ * The headers are filled in one pass: headers the component has already
+ * returned are taken without blocking and handed back to it together once
+ * none is left, so blocking is needed only when the component holds all
+ * of them.  A buffer larger than a header is spread over several headers
+ * directly, instead of through sub-buffers.  Codec-data buffers are sent
+ * as by g_omx_port_send().
+ *
+ * This method does not take ownership of the refs to @bufs
+ *
+ * Returns the number of buffers sent, or negative if error
+ * (G_OMX_PORT_SEND_MISROUTED if a zero-copy buffer matched none of our
+ * input headers).  The headers filled before an error are still sent.
+ */
+gint
+g_omx_port_send_batch (GOmxPort *port, GstBuffer **bufs, guint n_bufs)
+{
+    OMX_BUFFERHEADERTYPE **batch;
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+    guint n_batch = 0;
+    guint i;
+
+    g_return_val_if_fail (port->type == GOMX_PORT_INPUT, -1);
+
+    /* the component cannot return a header we have not released, so we
+     * never hold more than all of them
+     */
+    batch = g_newa (OMX_BUFFERHEADERTYPE *, MAX (port->num_buffers, 1));
+
+    for (i = 0; i < n_bufs; i++)
+    {
+        GstBuffer *buf = bufs[i];
+        gboolean codec_data;
+        guint offset = 0;
+        guint used;
+
+        codec_data = GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_IN_CAPS);
+
+        if (!port->always_copy)
+        {
+            if (G_UNLIKELY (!GST_IS_OMXBUFFERTRANSPORT (buf)))
+                goto error;
+
+            if (n_batch == port->num_buffers)
+                release_batch (port, batch, &n_batch);
+
+            omx_buffer = get_input_buffer_header (port, buf);
+
+            if (G_UNLIKELY (!omx_buffer))
+            {
+                release_batch (port, batch, &n_batch);
+                return G_OMX_PORT_SEND_MISROUTED;
+            }
+
+            if (codec_data)
+                send_prep_codec_data (port, omx_buffer, buf);
+            else
+                send_prep_buffer_data (port, omx_buffer, buf);
+
+            batch[n_batch++] = omx_buffer;
+            continue;
+        }
+
+        do
+        {
+            omx_buffer = NULL;
+
+            if (n_batch < port->num_buffers)
+                omx_buffer = request_buffer_full (port, FALSE);
+
+            if (!omx_buffer)
+            {
+                release_batch (port, batch, &n_batch);
+                omx_buffer = request_buffer (port);
+
+                if (!omx_buffer)
+                {
+                    DEBUG (port, "null buffer");
+                    goto error;
+                }
+            }
+
+            reset_input_header (omx_buffer);
+
+            if (codec_data)
+            {
+                send_prep_codec_data (port, omx_buffer, buf);
+                used = GST_BUFFER_SIZE (buf);
+                offset = used;
+            }
+            else
+            {
+                used = send_prep_buffer_range (port, omx_buffer, buf, offset);
+                offset += used;
+            }
+
+            batch[n_batch++] = omx_buffer;
+
+            if (G_UNLIKELY (!used && offset < GST_BUFFER_SIZE (buf)))
+            {
+                WARNING (port, "header has no room left");
+                goto error;
+            }
+        } while (offset < GST_BUFFER_SIZE (buf));
+    }
+
+    release_batch (port, batch, &n_batch);
+
+    return n_bufs;
+
+error:
+    release_batch (port, batch, &n_batch);
+    return -1;
+}
+
 /**
  * Receive a buffer/event from OMX component.  This handles the conversion
  * of OMX buffer to GST buffer, codec-data, or EOS event.
@@ -799,14 +1228,14 @@ void
 g_omx_port_resume (GOmxPort *port)
 {
     DEBUG (port, "resume");
-    async_queue_enable (port->queue);
+    async_ring_enable (port->queue);
 }
 
 void
 g_omx_port_pause (GOmxPort *port)
 {
     DEBUG (port, "pause");
-    async_queue_disable (port->queue);
+    async_ring_disable (port->queue);
 }
 
 void
@@ -820,7 +1249,7 @@ g_omx_port_flush (GOmxPort *port)
          * yet processed in the output_loop.
          */
         OMX_BUFFERHEADERTYPE *omx_buffer;
-        while ((omx_buffer = async_queue_pop_full (port->queue, FALSE, TRUE)))
+        while ((omx_buffer = async_ring_pop_full (port->queue, FALSE, TRUE)))
         {
             omx_buffer->nFilledLen = 0;
 
@@ -844,19 +1273,27 @@ g_omx_port_flush (GOmxPort *port)
     }
 
     DEBUG (port, "SendCommand(Flush, %d)", port->port_index);
-    OMX_SendCommand (port->core->omx_handle, OMX_CommandFlush, port->port_index, NULL);
-    g_sem_down (port->core->flush_sem);
+    if (g_omx_core_send_command (port->core, OMX_CommandFlush, port->port_index))
+        g_omx_core_wait_for_commands (port->core, 0);
     port->ignore_count = port->num_buffers;
     DEBUG (port, "end");
 }
 
-void
+/**
+ * Enable the port, and start its buffers if the component is executing.
+ *
+ * Returns FALSE, leaving the port disabled, if the component refused the
+ * command or did not complete it.
+ */
+gboolean
 g_omx_port_enable (GOmxPort *port)
 {
+    gboolean ret;
+
     if (port->enabled)
     {
         DEBUG (port, "already enabled");
-        return;
+        return TRUE;
     }
 
     DEBUG (port, "begin");
@@ -864,12 +1301,18 @@ g_omx_port_enable (GOmxPort *port)
     g_omx_port_prepare (port);
 
     DEBUG (port, "SendCommand(PortEnable, %d)", port->port_index);
-    OMX_SendCommand (g_omx_core_get_handle (port->core),
-            OMX_CommandPortEnable, port->port_index, NULL);
+    ret = g_omx_core_send_command (port->core, OMX_CommandPortEnable,
+                                   port->port_index);
 
     g_omx_port_allocate_buffers (port);
 
-    g_sem_down (port->core->port_sem);
+    if (!g_omx_core_wait_for_commands (port->core, 0) || !ret)
+    {
+        GST_ERROR ("<%s:%s> failed to enable port %d",
+                GST_OBJECT_NAME (port->core->object), port->name,
+                port->port_index);
+        return FALSE;
+    }
 
     port->enabled = TRUE;
 
@@ -877,6 +1320,8 @@ g_omx_port_enable (GOmxPort *port)
         g_omx_port_start_buffers (port);
 
     DEBUG (port, "end");
+
+    return TRUE;
 }
 
 void
@@ -893,12 +1338,11 @@ g_omx_port_disable (GOmxPort *port)
     port->enabled = FALSE;
 
     DEBUG (port, "SendCommand(PortDisable, %d)", port->port_index);
-    OMX_SendCommand (g_omx_core_get_handle (port->core),
-            OMX_CommandPortDisable, port->port_index, NULL);
+    g_omx_core_send_command (port->core, OMX_CommandPortDisable, port->port_index);
 
     g_omx_port_free_buffers (port);
 
-    g_sem_down (port->core->port_sem);
+    g_omx_core_wait_for_commands (port->core, 0);
 
     DEBUG (port, "end");
 }
@@ -908,7 +1352,7 @@ g_omx_port_finish (GOmxPort *port)
 {
     DEBUG (port, "finish");
     port->enabled = FALSE;
-    async_queue_disable (port->queue);
+    async_ring_disable (port->queue);
 }
 
 
@@ -34,6 +34,9 @@ G_BEGIN_DECLS
 
 typedef enum GOmxPortType GOmxPortType;
 typedef struct OmxBufferInfo OmxBufferInfo;
+typedef struct GOmxPortStats GOmxPortStats;
+
+#define G_OMX_PORT_STATS_BUCKETS G_OMX_HISTOGRAM_BUCKETS
 
 /* Enums. */
 
@@ -45,6 +48,9 @@ enum GOmxPortType
 
 struct OmxBufferInfo 
 {
+    /** upstream port the pBuffer pointers belong to */
+    GOmxPort *port;
+
     /** number of pBuffer pointer */
     guint num_buffers;
     
@@ -52,6 +58,26 @@ struct OmxBufferInfo
     OMX_U8 **pBuffer;
 };
 
+/**
+ * Histograms are log2 bucketed, see G_OMX_HISTOGRAM_BUCKETS.
+ */
+struct GOmxPortStats
+{
+    GstClockTime *release_time;     /**< per buffer: last ETB/FTB */
+    GstClockTime *return_time;      /**< per buffer: last EmptyBufferDone/FillBufferDone */
+    gint *owned;                    /**< per buffer: owned by the component */
+    gint in_component;              /**< buffers currently owned by the component */
+
+    guint64 buffers;                /**< buffers returned by the component */
+    GstClockTime max_residency;
+    gint max_outstanding;           /**< most buffers out of the component at once */
+
+    guint residency[G_OMX_PORT_STATS_BUCKETS];        /**< usec from ETB/FTB to done */
+    guint queue_time[G_OMX_PORT_STATS_BUCKETS];       /**< usec from done until we pick the buffer up */
+    guint component_depth[G_OMX_PORT_STATS_BUCKETS];  /**< buffers in the component, at ETB/FTB */
+    guint queue_depth[G_OMX_PORT_STATS_BUCKETS];      /**< buffers waiting in our queue, at done */
+};
+
 struct GOmxPort
 {
     GOmxCore *core;
@@ -65,7 +91,7 @@ struct GOmxPort
     GMutex *mutex;
     gboolean enabled;
     gboolean omx_allocate; /**< Setup with OMX_AllocateBuffer rather than OMX_UseBuffer */
-    AsyncQueue *queue;
+    AsyncRing *queue;   /**< buffers returned by the component, sized in g_omx_port_allocate_buffers() */
 
     GstBuffer * (*buffer_alloc)(GOmxPort *port, gint len); /**< allows elements to override shared buffer allocation for output ports */
 
@@ -88,10 +114,35 @@ struct GOmxPort
 
     /** if omx_allocate flag is not set then structure will contain upstream omx buffer pointer information */
     OmxBufferInfo *share_buffer_info;   
+
+    /** header -> index + 1, for the index carried by GstOmxBufferTransport */
+    GHashTable *buffer_index;
+
+    /** upstream pBuffer -> index + 1, fallback lookup for zero-copy input */
+    GHashTable *pbuffer_index;
+
+    /** zero-copy input buffers resolved through pbuffer_index */
+    guint foreign_buffers;
+
+    /** zero-copy input buffers that matched none of our headers */
+    guint misrouted_buffers;
+
+    /** where buffers spend their time, see g_omx_port_get_stats();
+     * in_component and max_outstanding are always kept, the rest is
+     * only collected once g_omx_port_enable_stats() was called */
+    GOmxPortStats stats;
+    gint stats_enabled;
+
+    /** the port definition as the core got the handle, put back before
+     * the handle goes to the pool; NULL unless the core uses the pool */
+    OMX_PARAM_PORTDEFINITIONTYPE *defaults;
 };
 
 /* Macros. */
 
+/** g_omx_port_send() result for a buffer not backed by one of our headers */
+#define G_OMX_PORT_SEND_MISROUTED (-2)
+
 #define G_OMX_PORT_GET_PARAM(port, idx, param) G_STMT_START {  \
 		_G_OMX_INIT_PARAM (param);                         \
         (param)->nPortIndex = (port)->port_index;          \
@@ -132,12 +183,18 @@ void g_omx_port_start_buffers (GOmxPort *port);
 void g_omx_port_resume (GOmxPort *port);
 void g_omx_port_pause (GOmxPort *port);
 void g_omx_port_flush (GOmxPort *port);
-void g_omx_port_enable (GOmxPort *port);
+gboolean g_omx_port_enable (GOmxPort *port);
 void g_omx_port_disable (GOmxPort *port);
 void g_omx_port_finish (GOmxPort *port);
 void g_omx_port_push_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
 gint g_omx_port_send (GOmxPort *port, gpointer obj);
+gint g_omx_port_send_batch (GOmxPort *port, GstBuffer **bufs, guint n_bufs);
 gpointer g_omx_port_recv (GOmxPort *port);
+gint g_omx_port_get_buffer_index (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
+void g_omx_port_enable_stats (GOmxPort *port);
+void g_omx_port_stats_released (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
+void g_omx_port_stats_returned (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
+void g_omx_port_get_stats (GOmxPort *port, GstStructure *structure, const gchar *prefix);
 
 /*
  * Some domain specific port related utility functions:
@@ -36,7 +36,8 @@ static GstStaticPadTemplate src_template =
         GST_STATIC_PAD_TEMPLATE ("src",
                 GST_PAD_SRC,
                 GST_PAD_ALWAYS,
-                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ( "{YUY2}" ))
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ( "{YUY2}" ) ";"
+                        GST_VIDEO_CAPS_YUV_STRIDED ("{NV12}", "[ 0, max ]"))
         );
 
 static void
@@ -180,7 +181,8 @@ omx_setup (GstOmxBaseFilter *omx_base)
     paramPort.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
     paramPort.format.video.eColorFormat = OMX_COLOR_FormatYCbYCr;
     paramPort.nBufferSize =  self->out_stride * self->out_height;
-    paramPort.nBufferCountActual = 8;
+    paramPort.nBufferCountActual = gst_omx_base_vfpc_get_output_buffer_count (self,
+            omx_base->srcpad, omx_base->duration, paramPort.nBufferCountMin, 8);
     paramPort.nBufferAlignment = 0;
     paramPort.bBuffersContiguous = 0;
     G_OMX_PORT_SET_DEFINITION (omx_base->out_port, &paramPort);
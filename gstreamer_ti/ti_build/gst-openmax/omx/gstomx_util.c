@@ -181,6 +181,48 @@ g_omx_deinit (void)
  * Some misc utilities..
  */
 
+/**
+ * Count @value in @histogram, G_OMX_HISTOGRAM_BUCKETS log2 buckets.
+ */
+void
+g_omx_histogram_add (guint *histogram, guint64 value)
+{
+    guint bucket = 0;
+
+    /* g_bit_storage() takes a gulong, which is 32 bits on ARM; anything
+     * that large lands in the last bucket anyway */
+    if (value)
+        bucket = MIN (g_bit_storage ((gulong) MIN (value, G_MAXUINT32)),
+                      G_OMX_HISTOGRAM_BUCKETS - 1);
+
+    g_atomic_int_inc ((gint *) &histogram[bucket]);
+}
+
+/**
+ * Set @field of @structure to @histogram, as an array of uints.
+ */
+void
+g_omx_histogram_set (GstStructure *structure, const gchar *field, const guint *histogram)
+{
+    GValue array = { 0, };
+    GValue item = { 0, };
+    guint i;
+
+    g_value_init (&array, GST_TYPE_ARRAY);
+    g_value_init (&item, G_TYPE_UINT);
+
+    for (i = 0; i < G_OMX_HISTOGRAM_BUCKETS; i++)
+    {
+        g_value_set_uint (&item, g_atomic_int_get ((gint *) &histogram[i]));
+        gst_value_array_append_value (&array, &item);
+    }
+
+    gst_structure_set_value (structure, field, &array);
+
+    g_value_unset (&item);
+    g_value_unset (&array);
+}
+
 const char *
 g_omx_error_to_str (OMX_ERRORTYPE omx_error)
 {
@@ -30,12 +30,19 @@
 #include <OMX_TI_Video.h> /* for OMX_TI_VIDEO_CODINGTYPE enumeration including VP6 and VP7 formats*/
 
 #include <async_queue.h>
+#include <async_ring.h>
 #include <sem.h>
 
 G_BEGIN_DECLS
 
 #define GST_BUFFERFLAG_UNREF_CHECK 0x10000000
 
+/**
+ * Histograms are log2 bucketed: bucket 0 counts zero, bucket n counts
+ * values in [2^(n-1), 2^n) and the last bucket everything above.
+ */
+#define G_OMX_HISTOGRAM_BUCKETS 20
+
 /* Typedefs. */
 
 typedef struct GOmxCore GOmxCore;
@@ -82,6 +89,9 @@ OMX_COLOR_FORMATTYPE g_omx_fourcc_to_colorformat (guint32 fourcc);
 guint32 g_omx_colorformat_to_fourcc (OMX_COLOR_FORMATTYPE eColorFormat);
 OMX_COLOR_FORMATTYPE g_omx_gstvformat_to_colorformat (GstVideoFormat videoformat);
 
+void g_omx_histogram_add (guint *histogram, guint64 value);
+void g_omx_histogram_set (GstStructure *structure, const gchar *field, const guint *histogram);
+
 
 
 /**
@@ -33,14 +33,28 @@ GST_DEBUG_CATEGORY_STATIC (gst_perf_debug);
 #define DEFAULT_INTERVAL  1
 #define PRINT_ARM_LOAD    TRUE
 #define PRINT_FPS         TRUE
+#define TRACE_INTERVAL    1000
+#define TRACE_CAPACITY    4096
 
 enum
 {
   PROP_0,
   PROP_PRINT_ARM_LOAD,
-  PROP_PRINT_FPS
+  PROP_PRINT_FPS,
+  PROP_TRACE_LOCATION,
+  PROP_TRACE_MESSAGES,
+  PROP_TRACE_INTERVAL,
+  PROP_CPU_MESSAGES,
+  PROP_ARM_LOAD,
+  PROP_CORE_LOADS,
+  PROP_STREAMING_THREAD_LOAD,
+  PROP_INPUT_THREAD_LOAD,
+  PROP_OUTPUT_THREAD_LOAD
 };
 
+/* Upstream elements searched for an OMX element's thread ids */
+#define MAX_UPSTREAM_DEPTH 16
+
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
   GST_PAD_SINK,
   GST_PAD_ALWAYS,
@@ -62,6 +76,7 @@ static GstFlowReturn gst_perf_transform_ip (GstBaseTransform * trans,GstBuffer *
 static gboolean gst_perf_start (GstBaseTransform * trans);
 static gboolean gst_perf_stop (GstBaseTransform * trans);
 static void gst_perf_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_perf_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
 
 static void
 gst_perf_init (Gstperf * perf, GstperfClass * gclass)
@@ -72,6 +87,8 @@ gst_perf_init (Gstperf * perf, GstperfClass * gclass)
     self->fps_update_interval = GST_SECOND * DEFAULT_INTERVAL;
     self->print_arm_load = PRINT_ARM_LOAD;
     self->print_fps = PRINT_FPS;
+    self->trace_interval = TRACE_INTERVAL;
+    self->stream_load = self->input_load = self->output_load = -1;
 }
 
 static gboolean
@@ -168,6 +185,7 @@ gst_perf_class_init (GstperfClass * klass)
     gobject_class = (GObjectClass *) klass;
 
     gobject_class->set_property = gst_perf_set_property;
+    gobject_class->get_property = gst_perf_get_property;
     gobject_class = (GObjectClass *) klass;
     trans_class = (GstBaseTransformClass *) klass;
 
@@ -187,6 +205,56 @@ gst_perf_class_init (GstperfClass * klass)
     g_object_class_install_property (gobject_class, PROP_PRINT_FPS,
       g_param_spec_boolean ("print-fps", "print-fps",
           "Print framerate", PRINT_FPS, G_PARAM_WRITABLE));
+
+    g_object_class_install_property (gobject_class, PROP_TRACE_LOCATION,
+      g_param_spec_string ("trace-location", "trace-location",
+          "Write a binary record per buffer to this file "
+          "(read it with gst-perf-trace)", NULL, G_PARAM_WRITABLE));
+
+    g_object_class_install_property (gobject_class, PROP_TRACE_MESSAGES,
+      g_param_spec_boolean ("trace-messages", "trace-messages",
+          "Post binary records per buffer in perf-trace element messages",
+          FALSE, G_PARAM_WRITABLE));
+
+    g_object_class_install_property (gobject_class, PROP_TRACE_INTERVAL,
+      g_param_spec_uint ("trace-interval", "trace-interval",
+          "Interval in ms at which trace records are flushed and the CPU "
+          "load is sampled", 1, G_MAXUINT, TRACE_INTERVAL, G_PARAM_WRITABLE));
+
+    g_object_class_install_property (gobject_class, PROP_CPU_MESSAGES,
+      g_param_spec_boolean ("cpu-messages", "cpu-messages",
+          "Post the CPU loads in a perf-cpu element message every interval",
+          FALSE, G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class, PROP_ARM_LOAD,
+      g_param_spec_double ("arm-load", "arm-load",
+          "System load in percent over the last interval", 0.0, 100.0, 0.0,
+          G_PARAM_READABLE));
+
+    g_object_class_install_property (gobject_class, PROP_CORE_LOADS,
+      g_param_spec_value_array ("core-loads", "core-loads",
+          "Load of each core in percent over the last interval",
+          g_param_spec_double ("core-load", "core-load", "Core load",
+              0.0, 100.0, 0.0, G_PARAM_READABLE),
+          G_PARAM_READABLE));
+
+    g_object_class_install_property (gobject_class, PROP_STREAMING_THREAD_LOAD,
+      g_param_spec_double ("streaming-thread-load", "streaming-thread-load",
+          "CPU used by the thread pushing into this element, in percent of "
+          "one core (-1 if unknown)", -1.0, G_MAXDOUBLE, -1.0,
+          G_PARAM_READABLE));
+
+    g_object_class_install_property (gobject_class, PROP_INPUT_THREAD_LOAD,
+      g_param_spec_double ("input-thread-load", "input-thread-load",
+          "CPU used by the thread feeding the nearest OMX element upstream, "
+          "in percent of one core (-1 if unknown)", -1.0, G_MAXDOUBLE, -1.0,
+          G_PARAM_READABLE));
+
+    g_object_class_install_property (gobject_class, PROP_OUTPUT_THREAD_LOAD,
+      g_param_spec_double ("output-thread-load", "output-thread-load",
+          "CPU used by the output_loop task of the nearest OMX element "
+          "upstream, in percent of one core (-1 if unknown)", -1.0,
+          G_MAXDOUBLE, -1.0, G_PARAM_READABLE));
 }
 
 static void
@@ -204,17 +272,137 @@ gst_perf_set_property (GObject * object, guint prop_id,
             perf->print_fps = g_value_get_boolean(value);
             break;
 
+        case PROP_TRACE_LOCATION:
+            g_free (perf->trace_location);
+            perf->trace_location = g_value_dup_string(value);
+            break;
+
+        case PROP_TRACE_MESSAGES:
+            perf->trace_messages = g_value_get_boolean(value);
+            break;
+
+        case PROP_TRACE_INTERVAL:
+            perf->trace_interval = g_value_get_uint(value);
+            break;
+
+        case PROP_CPU_MESSAGES:
+            perf->cpu_messages = g_value_get_boolean(value);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
     }
 }
 
+static gdouble
+load_percent (gint load)
+{
+    return load < 0 ? -1.0 : load / 10.0;
+}
+
+static void
+gst_perf_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+    Gstperf *perf = GST_PERF (object);
+
+    GST_OBJECT_LOCK (perf);
+
+    switch (prop_id) {
+        case PROP_CPU_MESSAGES:
+            g_value_set_boolean (value, perf->cpu_messages);
+            break;
+
+        case PROP_ARM_LOAD:
+            g_value_set_double (value, perf->arm_load / 10.0);
+            break;
+
+        case PROP_CORE_LOADS:
+        {
+            GValueArray *array;
+            GValue load = { 0 };
+            gint i;
+
+            array = g_value_array_new (perf->cores);
+            g_value_init (&load, G_TYPE_DOUBLE);
+            for (i = 0; i < perf->cores; i++) {
+                g_value_set_double (&load, perf->core_load[i] / 10.0);
+                g_value_array_append (array, &load);
+            }
+            g_value_unset (&load);
+            g_value_take_boxed (value, array);
+            break;
+        }
+
+        case PROP_STREAMING_THREAD_LOAD:
+            g_value_set_double (value, load_percent (perf->stream_load));
+            break;
+
+        case PROP_INPUT_THREAD_LOAD:
+            g_value_set_double (value, load_percent (perf->input_load));
+            break;
+
+        case PROP_OUTPUT_THREAD_LOAD:
+            g_value_set_double (value, load_percent (perf->output_load));
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+
+    GST_OBJECT_UNLOCK (perf);
+}
+
+static void
+post_trace (PerfTrace *trace, const PerfTraceRecord *records, guint count,
+    gpointer user_data)
+{
+    Gstperf *self = GST_PERF (user_data);
+    GstStructure *structure;
+    GstBuffer *buffer;
+
+    buffer = gst_buffer_new_and_alloc (count * sizeof (PerfTraceRecord));
+    memcpy (GST_BUFFER_DATA (buffer), records, GST_BUFFER_SIZE (buffer));
+
+    structure = gst_structure_new ("perf-trace",
+        "records", GST_TYPE_BUFFER, buffer,
+        "record-size", G_TYPE_UINT, (guint) sizeof (PerfTraceRecord),
+        "count", G_TYPE_UINT, count, NULL);
+    gst_buffer_unref (buffer);
+
+    gst_element_post_message (GST_ELEMENT (self),
+        gst_message_new_element (GST_OBJECT (self), structure));
+}
+
 static gboolean
 gst_perf_start (GstBaseTransform * trans)
 {
     Gstperf *self = (Gstperf *) trans;
 
+    if (self->trace_location || self->trace_messages) {
+        self->trace = perf_trace_new (GST_OBJECT_NAME (self), TRACE_CAPACITY);
+
+        if (!perf_trace_set_file (self->trace, self->trace_location)) {
+            GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, (NULL),
+                ("failed to open trace file \"%s\"", self->trace_location));
+            perf_trace_free (self->trace);
+            self->trace = NULL;
+            return FALSE;
+        }
+
+        if (self->trace_messages)
+            perf_trace_set_flush_func (self->trace, post_trace, self);
+
+        perf_trace_start (self->trace, self->trace_interval);
+    }
+
+    self->cpu_load = cpu_load_new ();
+    self->stream_thread = cpu_load_thread_new ();
+    self->input_thread = cpu_load_thread_new ();
+    self->output_thread = cpu_load_thread_new ();
+
     /* Init counters */
     self->frames_count = G_GUINT64_CONSTANT (0);
     self->total_size = G_GUINT64_CONSTANT (0);
@@ -229,61 +417,149 @@ gst_perf_start (GstBaseTransform * trans)
 static gboolean
 gst_perf_stop (GstBaseTransform * trans)
 {
+    Gstperf *self = (Gstperf *) trans;
+
+    if (self->trace) {
+        perf_trace_free (self->trace);
+        self->trace = NULL;
+    }
+
+    cpu_load_free (self->cpu_load);
+    cpu_load_thread_free (self->stream_thread);
+    cpu_load_thread_free (self->input_thread);
+    cpu_load_thread_free (self->output_thread);
+    self->cpu_load = NULL;
+    self->stream_thread = self->input_thread = self->output_thread = NULL;
 
     return TRUE;
 }
 
-static int 
-print_cpu_load (Gstperf *perf)
+/* Walk upstream through single-input elements to the nearest OMX element
+ * that reports its thread ids */
+static GstElement *
+find_upstream_omx (Gstperf *perf)
 {
-    int   cpuLoadFound = FALSE;
-    unsigned long   nice, sys, idle, iowait, irq, softirq, steal;  
-    unsigned long   deltaTotal;
-    char  textBuf[4];
-    FILE *fptr;
-    int load;
-
-    /* Read the overall system information */
-    fptr = fopen("/proc/stat", "r");
-
-    if (fptr == NULL) {
-        return -1;
+    GstElement *element;
+    GstPad *pad, *peer;
+    guint depth;
+
+    pad = gst_object_ref (GST_BASE_TRANSFORM_SINK_PAD (perf));
+
+    for (depth = 0; depth < MAX_UPSTREAM_DEPTH; depth++) {
+        peer = gst_pad_get_peer (pad);
+        gst_object_unref (pad);
+        if (!peer)
+            return NULL;
+
+        element = gst_pad_get_parent_element (peer);
+        gst_object_unref (peer);
+        if (!element)
+            return NULL;
+
+        if (g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+                "output-thread-id"))
+            return element;
+
+        pad = gst_element_get_static_pad (element, "sink");
+        gst_object_unref (element);
+        if (!pad)
+            return NULL;
     }
 
-    perf->prevTotal = perf->total;
-    perf->prevuserTime = perf->userTime;
+    gst_object_unref (pad);
 
-    /* Scan the file line by line */
-    while (fscanf(fptr, "%4s %lu %lu %lu %lu %lu %lu %lu %lu", textBuf,
-                  &perf->userTime, &nice, &sys, &idle, &iowait, &irq, &softirq,
-                  &steal) != EOF) {
-        if (strcmp(textBuf, "cpu") == 0) {
-            cpuLoadFound = TRUE;
-            break;
-        }
-    }
+    return NULL;
+}
 
-    if (fclose(fptr) != 0) {
-        return -1;
+static void
+update_cpu_load (Gstperf *perf)
+{
+    guint16 arm_load = 0, core_load[CPU_LOAD_MAX_CPUS] = { 0 };
+    gint cores, stream_load, input_load = -1, output_load = -1;
+    guint64 stream_time = 0, input_time = 0, output_time = 0;
+    gint input_tid = 0, output_tid = 0;
+    GstElement *omx;
+
+    cores = cpu_load_sample (perf->cpu_load, &arm_load, core_load);
+
+    omx = find_upstream_omx (perf);
+    if (omx) {
+        g_object_get (omx, "input-thread-id", &input_tid,
+            "output-thread-id", &output_tid, NULL);
+        gst_object_unref (omx);
     }
 
-    if (!cpuLoadFound) {
-        return -1;
+    stream_load = cpu_load_thread_sample (perf->stream_thread,
+        cpu_load_get_tid (), &stream_time);
+    if (input_tid)
+        input_load = cpu_load_thread_sample (perf->input_thread, input_tid,
+            &input_time);
+    if (output_tid)
+        output_load = cpu_load_thread_sample (perf->output_thread, output_tid,
+            &output_time);
+
+    GST_OBJECT_LOCK (perf);
+    perf->arm_load = arm_load;
+    perf->cores = MAX (cores, 0);
+    memcpy (perf->core_load, core_load, sizeof (core_load));
+    perf->stream_load = stream_load;
+    perf->stream_time = stream_time;
+    perf->input_load = input_load;
+    perf->input_time = input_time;
+    perf->output_load = output_load;
+    perf->output_time = output_time;
+    GST_OBJECT_UNLOCK (perf);
+}
+
+static void
+print_cpu_load (Gstperf *perf)
+{
+    gint i;
+
+    g_print ("\tarm-load: %d", perf->arm_load / 10);
+
+    if (perf->cores > 1) {
+        for (i = 0; i < perf->cores; i++)
+            g_print (" cpu%d: %d", i, perf->core_load[i] / 10);
     }
 
-    perf->total = perf->userTime + nice + sys + idle + iowait + irq + softirq +
-                  steal;
-    perf->userTime += nice + sys + iowait + irq + softirq + steal;
-    deltaTotal = perf->total - perf->prevTotal;
+    if (perf->stream_load >= 0)
+        g_print ("\tstreaming: %d", perf->stream_load / 10);
+    if (perf->input_load >= 0)
+        g_print (" omx-input: %d", perf->input_load / 10);
+    if (perf->output_load >= 0)
+        g_print (" omx-output: %d", perf->output_load / 10);
+}
 
-    if(deltaTotal) {
-        load = 100 * (perf->userTime - perf->prevuserTime) / deltaTotal;
-    } else {
-        load = 0;
+static void
+post_cpu_load (Gstperf *perf)
+{
+    GstStructure *structure;
+    GValue array = { 0 }, load = { 0 };
+    gint i;
+
+    g_value_init (&array, GST_TYPE_ARRAY);
+    g_value_init (&load, G_TYPE_DOUBLE);
+    for (i = 0; i < perf->cores; i++) {
+        g_value_set_double (&load, perf->core_load[i] / 10.0);
+        gst_value_array_append_value (&array, &load);
     }
 
-    g_print ("\tarm-load: %d", load);
-    return 0;
+    structure = gst_structure_new ("perf-cpu",
+        "arm-load", G_TYPE_DOUBLE, perf->arm_load / 10.0,
+        "streaming-thread-load", G_TYPE_DOUBLE, load_percent (perf->stream_load),
+        "streaming-thread-time", G_TYPE_UINT64, perf->stream_time,
+        "input-thread-load", G_TYPE_DOUBLE, load_percent (perf->input_load),
+        "input-thread-time", G_TYPE_UINT64, perf->input_time,
+        "output-thread-load", G_TYPE_DOUBLE, load_percent (perf->output_load),
+        "output-thread-time", G_TYPE_UINT64, perf->output_time, NULL);
+    gst_structure_set_value (structure, "core-loads", &array);
+
+    g_value_unset (&load);
+    g_value_unset (&array);
+
+    gst_element_post_message (GST_ELEMENT (perf),
+        gst_message_new_element (GST_OBJECT (perf), structure));
 }
 
 static GstFlowReturn
@@ -301,15 +577,28 @@ gst_perf_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
             self->interval_ts = self->last_ts = self->start_ts = ts;
         }
 
+        if (self->trace) {
+            perf_trace_record (self->trace, ts,
+                GST_BUFFER_TIMESTAMP_IS_VALID (buf) ?
+                GST_BUFFER_TIMESTAMP (buf) : G_MAXUINT64,
+                GST_BUFFER_SIZE (buf));
+        }
+
         if (GST_CLOCK_DIFF (self->interval_ts, ts) > self->fps_update_interval) {
 
             if (self->print_fps) 
                 display_current_fps (self);
 
+            update_cpu_load (self);
+
             if (self->print_arm_load) 
                 print_cpu_load (self);
 
-            g_print ("\n");
+            if (self->cpu_messages)
+                post_cpu_load (self);
+
+            if (self->print_fps || self->print_arm_load)
+                g_print ("\n");
             self->interval_ts = ts;
         }
     }
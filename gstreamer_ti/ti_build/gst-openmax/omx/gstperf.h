@@ -28,6 +28,9 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
 
+#include "cpu_load.h"
+#include "perf_trace.h"
+
 G_BEGIN_DECLS
 
 /* Standard macros for maniuplating perf objects */
@@ -61,10 +64,25 @@ struct _Gstperf
   GstClockTime interval_ts;
 
   gboolean print_fps, print_arm_load, fps_update_interval;
-  unsigned long int  total;
-  unsigned long int  prevTotal;
-  unsigned long int userTime;
-  unsigned long int  prevuserTime;
+
+  /* cpu accounting, loads in 1/10 percent and -1 when unknown */
+  CpuLoad *cpu_load;
+  guint16 arm_load;
+  guint16 core_load[CPU_LOAD_MAX_CPUS];
+  gint cores;
+  gboolean cpu_messages;
+
+  /* this element's streaming thread and the input and output threads of
+   * the nearest OMX element upstream */
+  CpuLoadThread *stream_thread, *input_thread, *output_thread;
+  gint stream_load, input_load, output_load;
+  guint64 stream_time, input_time, output_time;
+
+  /* binary trace */
+  PerfTrace *trace;
+  gchar *trace_location;
+  gboolean trace_messages;
+  guint trace_interval;
 };
 
 /* _GstperfClass object */
@@ -21,11 +21,19 @@
 
 #include <check.h>
 #include "async_queue.h"
+#include "async_ring.h"
 #include "sem.h"
 
 #define PROCESS_COUNT 0x1000
 #define DISABLE_AT PROCESS_COUNT / 2
 
+/* a port never holds more than a few dozen buffers */
+#define RING_CAPACITY 0x20
+
+#define BENCH_PRODUCERS 4
+#define BENCH_BUFFERS 16
+#define BENCH_COUNT 0x10000
+
 typedef struct CustomData CustomData;
 
 struct CustomData
@@ -379,6 +387,482 @@ START_TEST (test_async_queue_stress)
 }
 END_TEST
 
+START_TEST (test_async_ring_create)
+{
+    AsyncRing *ring;
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+    async_ring_free (ring);
+}
+END_TEST
+
+START_TEST (test_async_ring_pop)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    gpointer tmp;
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+    foo = GINT_TO_POINTER (1);
+    async_ring_push (ring, foo);
+    tmp = async_ring_pop (ring);
+    fail_if (tmp != foo,
+             "Pop failed");
+    async_ring_free (ring);
+}
+END_TEST
+
+START_TEST (test_async_ring_full)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    guint i;
+
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < RING_CAPACITY; i++, foo++)
+    {
+        fail_if (!async_ring_push (ring, foo),
+                 "Push failed");
+    }
+    fail_if (async_ring_push (ring, foo),
+             "Push on full ring succeeded");
+    fail_if (async_ring_length (ring) != RING_CAPACITY,
+             "Wrong length");
+
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < RING_CAPACITY; i++, foo++)
+    {
+        fail_if (async_ring_pop (ring) != foo,
+                 "Pop failed");
+    }
+    fail_if (async_ring_pop_full (ring, FALSE, FALSE),
+             "Pop on empty ring succeeded");
+
+    async_ring_free (ring);
+}
+END_TEST
+
+START_TEST (test_async_ring_process)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    guint i;
+
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+
+    async_ring_reserve (ring, PROCESS_COUNT);
+
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < PROCESS_COUNT; i++, foo++)
+    {
+        fail_if (!async_ring_push (ring, foo),
+                 "Push failed");
+    }
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < PROCESS_COUNT; i++, foo++)
+    {
+        gpointer tmp;
+        tmp = async_ring_pop (ring);
+        fail_if (tmp != foo,
+                 "Pop failed");
+    }
+
+    async_ring_free (ring);
+}
+END_TEST
+
+static void
+ring_push_retry (AsyncRing *ring, gpointer data)
+{
+    while (!async_ring_push (ring, data))
+        g_thread_yield ();
+}
+
+static gpointer
+ring_push_func (gpointer data)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    guint i;
+
+    ring = data;
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < PROCESS_COUNT; i++, foo++)
+    {
+        ring_push_retry (ring, foo);
+    }
+
+    return NULL;
+}
+
+static gpointer
+ring_pop_func (gpointer data)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    guint i;
+
+    ring = data;
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < PROCESS_COUNT; i++, foo++)
+    {
+        gpointer tmp;
+        tmp = async_ring_pop (ring);
+        fail_if (tmp != foo,
+                 "Pop failed");
+    }
+
+    return NULL;
+}
+
+START_TEST (test_async_ring_threads)
+{
+    AsyncRing *ring;
+    GThread *push_thread;
+    GThread *pop_thread;
+
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+
+    pop_thread = g_thread_create (ring_pop_func, ring, TRUE, NULL);
+    push_thread = g_thread_create (ring_push_func, ring, TRUE, NULL);
+
+    g_thread_join (pop_thread);
+    g_thread_join (push_thread);
+
+    async_ring_free (ring);
+}
+END_TEST
+
+static gpointer
+ring_push_and_disable_func (gpointer data)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    guint i;
+
+    ring = data;
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < DISABLE_AT; i++, foo++)
+    {
+        ring_push_retry (ring, foo);
+    }
+
+    async_ring_disable (ring);
+
+    return NULL;
+}
+
+static gpointer
+ring_pop_with_disable_func (gpointer data)
+{
+    AsyncRing *ring;
+    gpointer foo;
+    guint i;
+    guint count = 0;
+
+    ring = data;
+    foo = GINT_TO_POINTER (1);
+    for (i = 0; i < PROCESS_COUNT; i++)
+    {
+        gpointer tmp;
+        tmp = async_ring_pop (ring);
+        if (!tmp)
+            continue;
+        count++;
+        fail_if (tmp != foo,
+                 "Pop failed");
+        foo++;
+    }
+
+    return GINT_TO_POINTER (count);
+}
+
+START_TEST (test_async_ring_disable_simple)
+{
+    AsyncRing *ring;
+    GThread *pop_thread;
+    guint count;
+
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+
+    pop_thread = g_thread_create (ring_pop_with_disable_func, ring, TRUE, NULL);
+
+    async_ring_disable (ring);
+
+    count = GPOINTER_TO_INT (g_thread_join (pop_thread));
+
+    fail_if (count != 0,
+             "Disable failed");
+
+    async_ring_free (ring);
+}
+END_TEST
+
+START_TEST (test_async_ring_disable)
+{
+    AsyncRing *ring;
+    GThread *push_thread;
+    GThread *pop_thread;
+    guint count;
+
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+
+    pop_thread = g_thread_create (ring_pop_with_disable_func, ring, TRUE, NULL);
+    push_thread = g_thread_create (ring_push_and_disable_func, ring, TRUE, NULL);
+
+    count = GPOINTER_TO_INT (g_thread_join (pop_thread));
+    g_thread_join (push_thread);
+
+    fail_if (count > DISABLE_AT,
+             "Disable failed");
+
+    async_ring_free (ring);
+}
+END_TEST
+
+START_TEST (test_async_ring_force)
+{
+    AsyncRing *ring;
+    gpointer foo;
+
+    ring = async_ring_new (RING_CAPACITY);
+    fail_if (!ring,
+             "Construction failed");
+
+    foo = GINT_TO_POINTER (1);
+    async_ring_push (ring, foo);
+    async_ring_disable (ring);
+
+    fail_if (async_ring_pop (ring),
+             "Pop from disabled ring succeeded");
+    fail_if (async_ring_pop_full (ring, TRUE, TRUE) != foo,
+             "Forced pop failed");
+
+    async_ring_enable (ring);
+    async_ring_push (ring, foo);
+    async_ring_flush (ring);
+
+    fail_if (async_ring_length (ring) != 0,
+             "Flush failed");
+    fail_if (async_ring_pop_full (ring, FALSE, FALSE),
+             "Pop after flush succeeded");
+
+    async_ring_free (ring);
+}
+END_TEST
+
+#define RESERVE_ROUNDS 200
+#define RESERVE_POPPERS 2
+
+static volatile gint reserve_started;
+
+static gpointer
+ring_poll_one_func (gpointer data)
+{
+    AsyncRing *ring;
+
+    ring = data;
+    g_atomic_int_inc (&reserve_started);
+    while (!async_ring_pop_full (ring, FALSE, FALSE))
+        ;
+
+    return NULL;
+}
+
+static gpointer
+ring_pop_one_func (gpointer data)
+{
+    AsyncRing *ring;
+
+    ring = data;
+    g_atomic_int_inc (&reserve_started);
+    fail_if (!async_ring_pop (ring),
+             "Pop failed");
+
+    return NULL;
+}
+
+START_TEST (test_async_ring_reserve_waiting)
+{
+    AsyncRing *ring;
+    GThread *pop_threads[RESERVE_POPPERS];
+    guint i, round;
+
+    /* grow the ring while poppers spin or sleep on it, as a port enable
+     * does while its output loop waits for a buffer
+     */
+    for (round = 0; round < RESERVE_ROUNDS; round++)
+    {
+        ring = async_ring_new (2);
+        fail_if (!ring,
+                 "Construction failed");
+
+        reserve_started = 0;
+        pop_threads[0] = g_thread_create (ring_poll_one_func, ring, TRUE, NULL);
+        pop_threads[1] = g_thread_create (ring_pop_one_func, ring, TRUE, NULL);
+        while (g_atomic_int_get (&reserve_started) != RESERVE_POPPERS)
+            ;
+
+        async_ring_reserve (ring, RING_CAPACITY);
+
+        for (i = 0; i < RESERVE_POPPERS; i++)
+        {
+            fail_if (!async_ring_push (ring, GUINT_TO_POINTER (i + 1)),
+                     "Push failed");
+        }
+
+        for (i = 0; i < RESERVE_POPPERS; i++)
+            g_thread_join (pop_threads[i]);
+
+        fail_if (async_ring_length (ring) != 0,
+                 "Wrong length");
+
+        async_ring_free (ring);
+    }
+}
+END_TEST
+
+/*
+ * Contention benchmark: a fixed pool of BENCH_BUFFERS tokens circulates
+ * between BENCH_PRODUCERS "component" threads and one "element" thread
+ * through a free queue and a done queue, the same way port buffers go
+ * round through ETB/FTB and the EBD/FBD callbacks.
+ */
+
+typedef struct BenchData BenchData;
+
+struct BenchData
+{
+    gboolean use_ring;
+    AsyncQueue *free_queue;
+    AsyncQueue *done_queue;
+    AsyncRing *free_ring;
+    AsyncRing *done_ring;
+};
+
+static gpointer
+bench_component_func (gpointer data)
+{
+    BenchData *bench;
+    guint i;
+
+    bench = data;
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        gpointer token;
+
+        if (bench->use_ring)
+        {
+            token = async_ring_pop (bench->free_ring);
+            ring_push_retry (bench->done_ring, token);
+        }
+        else
+        {
+            /* with several waiters, a woken pop may find the queue already
+             * drained by another thread and return NULL; just retry
+             */
+            while (!(token = async_queue_pop (bench->free_queue)))
+                ;
+            async_queue_push (bench->done_queue, token);
+        }
+    }
+
+    return NULL;
+}
+
+static gdouble
+bench_run (gboolean use_ring)
+{
+    BenchData bench;
+    GThread *threads[BENCH_PRODUCERS];
+    GTimer *timer;
+    gdouble elapsed;
+    guint i;
+
+    bench.use_ring = use_ring;
+    bench.free_queue = async_queue_new ();
+    bench.done_queue = async_queue_new ();
+    bench.free_ring = async_ring_new (RING_CAPACITY);
+    bench.done_ring = async_ring_new (RING_CAPACITY);
+
+    for (i = 1; i <= BENCH_BUFFERS; i++)
+    {
+        if (use_ring)
+            async_ring_push (bench.free_ring, GUINT_TO_POINTER (i));
+        else
+            async_queue_push (bench.free_queue, GUINT_TO_POINTER (i));
+    }
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < BENCH_PRODUCERS; i++)
+        threads[i] = g_thread_create (bench_component_func, &bench, TRUE, NULL);
+
+    for (i = 0; i < BENCH_PRODUCERS * BENCH_COUNT; i++)
+    {
+        gpointer token;
+
+        if (use_ring)
+        {
+            token = async_ring_pop (bench.done_ring);
+            fail_if (!token,
+                     "Pop failed");
+            ring_push_retry (bench.free_ring, token);
+        }
+        else
+        {
+            token = async_queue_pop (bench.done_queue);
+            fail_if (!token,
+                     "Pop failed");
+            async_queue_push (bench.free_queue, token);
+        }
+    }
+
+    for (i = 0; i < BENCH_PRODUCERS; i++)
+        g_thread_join (threads[i]);
+
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    async_ring_free (bench.done_ring);
+    async_ring_free (bench.free_ring);
+    async_queue_free (bench.done_queue);
+    async_queue_free (bench.free_queue);
+
+    return elapsed;
+}
+
+START_TEST (test_async_ring_benchmark)
+{
+    gdouble queue_time, ring_time;
+    guint total = BENCH_PRODUCERS * BENCH_COUNT;
+
+    queue_time = bench_run (FALSE);
+    ring_time = bench_run (TRUE);
+
+    g_print ("contention: %d threads, %d buffers, %u transfers\n",
+             BENCH_PRODUCERS, BENCH_BUFFERS, total);
+    g_print ("  AsyncQueue: %.3f s (%.1f ns/buffer)\n",
+             queue_time, queue_time * 1e9 / total);
+    g_print ("  AsyncRing:  %.3f s (%.1f ns/buffer)\n",
+             ring_time, ring_time * 1e9 / total);
+}
+END_TEST
+
 Suite *
 util_suite (void)
 {
@@ -397,8 +881,23 @@ util_suite (void)
     tcase_add_test (tc_core, test_async_queue_disable);
     tcase_add_test (tc_core, test_async_queue_enable);
     tcase_add_test (tc_core, test_async_queue_stress);
+    tcase_add_test (tc_core, test_async_ring_create);
+    tcase_add_test (tc_core, test_async_ring_pop);
+    tcase_add_test (tc_core, test_async_ring_full);
+    tcase_add_test (tc_core, test_async_ring_process);
+    tcase_add_test (tc_core, test_async_ring_threads);
+    tcase_add_test (tc_core, test_async_ring_disable_simple);
+    tcase_add_test (tc_core, test_async_ring_disable);
+    tcase_add_test (tc_core, test_async_ring_force);
+    tcase_add_test (tc_core, test_async_ring_reserve_waiting);
     suite_add_tcase (s, tc_core);
 
+    /* Benchmarks */
+    TCase *tc_bench = tcase_create ("Benchmark");
+    tcase_set_timeout (tc_bench, 60);
+    tcase_add_test (tc_bench, test_async_ring_benchmark);
+    suite_add_tcase (s, tc_bench);
+
     return s;
 }
 
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Throughput of the element side of gst-openmax: buffers are pushed
+ * through omx_dummy backed by the benchmarking core in libomxil-foo.so,
+ * so g_omx_port_send(), g_omx_port_recv() and the output loop are the
+ * only real work per buffer.
+ *
+ * Set BENCH_MAX_OVERHEAD_US to fail when the per-buffer overhead (wall
+ * time minus modeled processing time) exceeds that many microseconds.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+
+#include "bench_core.h"
+
+#define BENCH_BUFFER_SIZE 0x1000
+#define BENCH_BUFFER_COUNT 0x1000
+#define BENCH_BUFFERS_IN_FLIGHT 4
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static void (*get_config) (BenchCoreConfig *config);
+static void (*set_config) (const BenchCoreConfig *config);
+static void (*get_stats) (BenchCoreStats *stats);
+static void (*reset_stats) (void);
+
+static GMutex *eos_mutex;
+static GCond *eos_cond;
+static gboolean eos_arrived;
+static guint buffers_received;
+static guint64 bytes_received;
+
+static gboolean
+bench_sink_event (GstPad *pad, GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (eos_mutex);
+        eos_arrived = TRUE;
+        g_cond_signal (eos_cond);
+        g_mutex_unlock (eos_mutex);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+/* don't keep the output around like gst_check_chain_func() does */
+static GstFlowReturn
+bench_sink_chain (GstPad *pad, GstBuffer *buffer)
+{
+    buffers_received++;
+    bytes_received += GST_BUFFER_SIZE (buffer);
+    gst_buffer_unref (buffer);
+
+    return GST_FLOW_OK;
+}
+
+static void
+report (const gchar *name, guint64 elapsed, const BenchCoreStats *stats)
+{
+    gdouble per_buffer, overhead;
+    const gchar *max_overhead;
+
+    per_buffer = (gdouble) elapsed / BENCH_BUFFER_COUNT / 1000;
+    overhead = per_buffer - (gdouble) stats->processing_ns / BENCH_BUFFER_COUNT / 1000;
+
+    g_print ("%s: %u buffers, %.2f us/buffer, overhead %.2f us/buffer\n",
+             name, BENCH_BUFFER_COUNT, per_buffer, overhead);
+
+    if (stats->in_turnaround_count)
+        g_print ("%s: input turnaround avg %.2f us, max %.2f us\n", name,
+                 (gdouble) stats->in_turnaround_ns / stats->in_turnaround_count / 1000,
+                 (gdouble) stats->in_turnaround_max_ns / 1000);
+
+    if (stats->out_turnaround_count)
+        g_print ("%s: output turnaround avg %.2f us, max %.2f us\n", name,
+                 (gdouble) stats->out_turnaround_ns / stats->out_turnaround_count / 1000,
+                 (gdouble) stats->out_turnaround_max_ns / 1000);
+
+    max_overhead = g_getenv ("BENCH_MAX_OVERHEAD_US");
+    if (max_overhead)
+    {
+        fail_if (overhead > g_ascii_strtod (max_overhead, NULL),
+                 "%s: overhead %.2f us/buffer above limit of %s us",
+                 name, overhead, max_overhead);
+    }
+}
+
+static void
+run (const gchar *name,
+     const gchar *role,
+     guint latency_us,
+     guint jitter_us)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    BenchCoreConfig config, old_config;
+    BenchCoreStats stats;
+    GTimer *timer;
+    guint64 elapsed;
+    guint i;
+
+    get_config (&old_config);
+    config = old_config;
+    config.latency_us = latency_us;
+    config.jitter_us = jitter_us;
+    config.buffer_count = BENCH_BUFFERS_IN_FLIGHT;
+    config.buffer_size = BENCH_BUFFER_SIZE;
+    set_config (&config);
+
+    /* init */
+    filter = gst_check_setup_element ("omx_dummy");
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+
+    gst_pad_set_event_function (mysinkpad, bench_sink_event);
+    gst_pad_set_chain_function (mysinkpad, bench_sink_chain);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    eos_mutex = g_mutex_new ();
+    eos_cond = g_cond_new ();
+    eos_arrived = FALSE;
+    buffers_received = 0;
+    bytes_received = 0;
+
+    g_object_set (G_OBJECT (filter),
+                  "library-name", "libomxil-foo.so",
+                  "component-role", role,
+                  NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    reset_stats ();
+    timer = g_timer_new ();
+
+    for (i = 0; i < BENCH_BUFFER_COUNT; i++)
+    {
+        GstBuffer *inbuffer;
+
+        inbuffer = gst_buffer_new_and_alloc (BENCH_BUFFER_SIZE);
+        GST_BUFFER_DATA (inbuffer)[0] = i;
+
+        fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+    }
+
+    gst_pad_push_event (mysrcpad, gst_event_new_eos ());
+
+    g_mutex_lock (eos_mutex);
+    while (!eos_arrived)
+        g_cond_wait (eos_cond, eos_mutex);
+    g_mutex_unlock (eos_mutex);
+
+    elapsed = g_timer_elapsed (timer, NULL) * 1000000000;
+    g_timer_destroy (timer);
+
+    get_stats (&stats);
+
+    /* the EOS buffer goes through the core as well */
+    fail_unless (stats.processed >= BENCH_BUFFER_COUNT);
+    fail_unless (buffers_received >= BENCH_BUFFER_COUNT);
+    fail_unless (bytes_received <= stats.bytes_out);
+
+    report (name, elapsed, &stats);
+
+    /* deinit */
+    gst_element_set_state (filter, GST_STATE_NULL);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+
+    g_mutex_free (eos_mutex);
+    g_cond_free (eos_cond);
+
+    set_config (&old_config);
+}
+
+GST_START_TEST (test_passthrough)
+{
+    run ("passthrough", BENCH_CORE_ROLE_PASSTHROUGH, 0, 0);
+}
+GST_END_TEST
+
+GST_START_TEST (test_encoder)
+{
+    run ("encoder", BENCH_CORE_ROLE_ENCODER, 0, 0);
+}
+GST_END_TEST
+
+GST_START_TEST (test_latency)
+{
+    run ("passthrough-latency", BENCH_CORE_ROLE_PASSTHROUGH, 100, 50);
+}
+GST_END_TEST
+
+static Suite *
+benchmark_suite (void)
+{
+    Suite *s = suite_create ("benchmark");
+    TCase *tc_chain = tcase_create ("general");
+    void *dl_handle;
+
+    /* the same instance the OMX elements will load */
+    dl_handle = dlopen ("libomxil-foo.so", RTLD_LAZY);
+    if (!dl_handle)
+        g_error ("%s", dlerror ());
+
+    get_config = dlsym (dl_handle, "bench_core_get_config");
+    set_config = dlsym (dl_handle, "bench_core_set_config");
+    get_stats = dlsym (dl_handle, "bench_core_get_stats");
+    reset_stats = dlsym (dl_handle, "bench_core_reset_stats");
+
+    tcase_set_timeout (tc_chain, 60);
+    tcase_add_test (tc_chain, test_passthrough);
+    tcase_add_test (tc_chain, test_encoder);
+    tcase_add_test (tc_chain, test_latency);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (benchmark);
@@ -20,6 +20,9 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <dlfcn.h>
+
+#include "bench_core.h"
 
 #define BUFFER_SIZE 0x1000
 #define BUFFER_COUNT 0x100
@@ -207,15 +210,169 @@ GST_START_TEST (test_basic)
 }
 GST_END_TEST
 
+/* control interface of libomxil-foo.so, see bench_core.h */
+static void (*get_config) (BenchCoreConfig *config);
+static void (*set_config) (const BenchCoreConfig *config);
+
+static BenchCoreConfig saved_config;
+
+static GstElement *
+setup_streaming (GstPad **mysrcpad)
+{
+    GstElement *filter;
+    GstPad *mysinkpad;
+    BenchCoreConfig config;
+
+    /* more than one input header, so batches have something to gather;
+     * the core reads its environment only once, so set it directly
+     */
+    get_config (&saved_config);
+    config = saved_config;
+    config.buffer_count = 4;
+    set_config (&config);
+
+    filter = gst_check_setup_element ("omx_dummy");
+    *mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+    gst_pad_set_active (*mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    g_object_set (G_OBJECT (filter), "library-name", "libomxil-foo.so", NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    return filter;
+}
+
+static void
+teardown_streaming (GstElement *filter, GstPad *mysrcpad)
+{
+    gst_check_drop_buffers ();
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+
+    set_config (&saved_config);
+}
+
+/* output comes from the output task; the test timeout catches a hang */
+static void
+wait_for_buffers (guint count)
+{
+    g_mutex_lock (check_mutex);
+    while (g_list_length (buffers) < count)
+        g_cond_wait (check_cond, check_mutex);
+    g_mutex_unlock (check_mutex);
+
+    fail_unless_equals_int (g_list_length (buffers), count);
+}
+
+GST_START_TEST (test_buffer_list)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstBufferList *list;
+    GstBufferListIterator *it;
+    guint i;
+
+    filter = setup_streaming (&mysrcpad);
+
+    list = gst_buffer_list_new ();
+    it = gst_buffer_list_iterate (list);
+    for (i = 0; i < FLUSH_AT; i++)
+    {
+        GstBuffer *inbuffer;
+
+        gst_buffer_list_iterator_add_group (it);
+
+        /* and one group in two pieces, which arrives as one buffer */
+        if (i == FLUSH_AT / 2)
+        {
+            inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE / 2);
+            GST_BUFFER_DATA (inbuffer)[0] = i;
+            gst_buffer_list_iterator_add (it, inbuffer);
+            inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE / 2);
+            gst_buffer_list_iterator_add (it, inbuffer);
+            continue;
+        }
+
+        inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE);
+        GST_BUFFER_DATA (inbuffer)[0] = i;
+        gst_buffer_list_iterator_add (it, inbuffer);
+    }
+    gst_buffer_list_iterator_free (it);
+
+    fail_unless (gst_pad_push_list (mysrcpad, list) == GST_FLOW_OK);
+
+    wait_for_buffers (FLUSH_AT);
+    for (i = 0; i < FLUSH_AT; i++)
+    {
+        GstBuffer *buffer = g_list_nth_data (buffers, i);
+
+        fail_unless_equals_int (GST_BUFFER_SIZE (buffer), BUFFER_SIZE);
+        fail_unless_equals_int (GST_BUFFER_DATA (buffer)[0], i);
+    }
+
+    teardown_streaming (filter, mysrcpad);
+}
+GST_END_TEST
+
+GST_START_TEST (test_split)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstBuffer *inbuffer;
+    guint i;
+
+    filter = setup_streaming (&mysrcpad);
+
+    /* three and a half input headers worth */
+    inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE * 3 + BUFFER_SIZE / 2);
+    for (i = 0; i < 4; i++)
+        GST_BUFFER_DATA (inbuffer)[i * BUFFER_SIZE] = i;
+
+    fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+
+    wait_for_buffers (4);
+    for (i = 0; i < 4; i++)
+    {
+        GstBuffer *buffer = g_list_nth_data (buffers, i);
+
+        fail_unless_equals_int (GST_BUFFER_SIZE (buffer),
+                                i < 3 ? BUFFER_SIZE : BUFFER_SIZE / 2);
+        fail_unless_equals_int (GST_BUFFER_DATA (buffer)[0], i);
+    }
+
+    teardown_streaming (filter, mysrcpad);
+}
+GST_END_TEST
+
 static Suite *
 gstomx_suite (void)
 {
     Suite *s = suite_create ("gstomx");
     TCase *tc_chain = tcase_create ("general");
+    void *dl_handle;
+
+    /* the same instance the OMX elements will load */
+    dl_handle = dlopen ("libomxil-foo.so", RTLD_LAZY);
+    if (!dl_handle)
+        g_error ("%s", dlerror ());
+
+    get_config = dlsym (dl_handle, "bench_core_get_config");
+    set_config = dlsym (dl_handle, "bench_core_set_config");
 
     tcase_set_timeout (tc_chain, 10);
     tcase_add_test (tc_chain, test_basic);
     tcase_add_test (tc_chain, test_flush);
+    tcase_add_test (tc_chain, test_buffer_list);
+    tcase_add_test (tc_chain, test_split);
     suite_add_tcase (s, tc_chain);
 
     return s;
@@ -26,6 +26,11 @@
 #include <glib.h>
 #include <dlfcn.h>
 
+#include "bench_core.h"
+
+#define SCALER_CHANNELS 4
+#define SCALER_BUFFERS 2
+
 static const char *lib_name;
 static void *dl_handle;
 static OMX_ERRORTYPE (*init) (void);
@@ -35,6 +40,8 @@ static OMX_ERRORTYPE (*get_handle) (OMX_HANDLETYPE *handle,
                                     OMX_PTR data,
                                     OMX_CALLBACKTYPE *callbacks);
 static OMX_ERRORTYPE (*free_handle) (OMX_HANDLETYPE handle);
+static void (*get_config) (BenchCoreConfig *config);
+static void (*set_config) (const BenchCoreConfig *config);
 
 typedef struct CustomData CustomData;
 
@@ -44,6 +51,10 @@ struct CustomData
     OMX_STATETYPE omx_state;
     GCond *omx_state_condition;
     GMutex *omx_state_mutex;
+    guint empty_done;
+    guint fill_done;
+    gboolean command_complete;
+    OMX_U32 command_port;   /**< port of the last completed port command */
 };
 
 static CustomData *
@@ -120,6 +131,14 @@ EventHandler (OMX_HANDLETYPE omx_handle,
                     case OMX_CommandStateSet:
                         complete_change_state (core, data_2);
                         break;
+                    case OMX_CommandPortDisable:
+                    case OMX_CommandPortEnable:
+                        g_mutex_lock (core->omx_state_mutex);
+                        core->command_complete = TRUE;
+                        core->command_port = data_2;
+                        g_cond_broadcast (core->omx_state_condition);
+                        g_mutex_unlock (core->omx_state_mutex);
+                        break;
                     default:
                         break;
                 }
@@ -132,7 +151,69 @@ EventHandler (OMX_HANDLETYPE omx_handle,
     return OMX_ErrorNone;
 }
 
+static inline void
+wait_for_buffers (CustomData *core,
+                  guint empty_done,
+                  guint fill_done)
+{
+    g_mutex_lock (core->omx_state_mutex);
+
+    while (core->empty_done < empty_done || core->fill_done < fill_done)
+        g_cond_wait (core->omx_state_condition, core->omx_state_mutex);
+
+    g_mutex_unlock (core->omx_state_mutex);
+}
+
+static inline void
+wait_for_command (CustomData *core,
+                  OMX_U32 port)
+{
+    g_mutex_lock (core->omx_state_mutex);
+
+    while (!core->command_complete || core->command_port != port)
+        g_cond_wait (core->omx_state_condition, core->omx_state_mutex);
+
+    core->command_complete = FALSE;
+
+    g_mutex_unlock (core->omx_state_mutex);
+}
+
+static OMX_ERRORTYPE
+EmptyBufferDone (OMX_HANDLETYPE omx_handle,
+                 OMX_PTR app_data,
+                 OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    CustomData *core;
+
+    core = app_data;
+
+    g_mutex_lock (core->omx_state_mutex);
+    core->empty_done++;
+    g_cond_broadcast (core->omx_state_condition);
+    g_mutex_unlock (core->omx_state_mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+FillBufferDone (OMX_HANDLETYPE omx_handle,
+                OMX_PTR app_data,
+                OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    CustomData *core;
+
+    core = app_data;
+
+    g_mutex_lock (core->omx_state_mutex);
+    core->fill_done++;
+    g_cond_broadcast (core->omx_state_condition);
+    g_mutex_unlock (core->omx_state_mutex);
+
+    return OMX_ErrorNone;
+}
+
 static OMX_CALLBACKTYPE callbacks = { EventHandler, NULL, NULL };
+static OMX_CALLBACKTYPE buffer_callbacks = { EventHandler, EmptyBufferDone, FillBufferDone };
 
 START_TEST (test_basic)
 {
@@ -201,6 +282,186 @@ START_TEST (test_idle)
 }
 END_TEST
 
+START_TEST (test_allocate)
+{
+    CustomData *custom_data;
+    OMX_ERRORTYPE omx_error;
+    OMX_HANDLETYPE omx_handle;
+    OMX_BUFFERHEADERTYPE *in_buffer, *out_buffer;
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+
+    custom_data = custom_data_new ();
+
+    omx_error = init ();
+    fail_if (omx_error != OMX_ErrorNone);
+
+    omx_error = get_handle (&omx_handle, "OMX.check.dummy", custom_data, &buffer_callbacks);
+    fail_if (omx_error != OMX_ErrorNone);
+
+    custom_data->omx_handle = omx_handle;
+
+    memset (&param, 0, sizeof (param));
+    param.nSize = sizeof (param);
+    param.nPortIndex = 0;
+    fail_if (OMX_GetParameter (omx_handle, OMX_IndexParamPortDefinition, &param) != OMX_ErrorNone);
+
+    change_state (custom_data, OMX_StateIdle);
+
+    fail_if (OMX_AllocateBuffer (omx_handle, &in_buffer, 0, NULL, param.nBufferSize) != OMX_ErrorNone);
+    fail_if (OMX_AllocateBuffer (omx_handle, &out_buffer, 1, NULL, param.nBufferSize) != OMX_ErrorNone);
+    fail_unless (in_buffer->pBuffer && out_buffer->pBuffer);
+
+    wait_for_state (custom_data, OMX_StateIdle);
+
+    change_state (custom_data, OMX_StateExecuting);
+    wait_for_state (custom_data, OMX_StateExecuting);
+
+    memset (in_buffer->pBuffer, 0x5a, param.nBufferSize);
+    in_buffer->nFilledLen = param.nBufferSize;
+    in_buffer->nOffset = 0;
+
+    fail_if (OMX_FillThisBuffer (omx_handle, out_buffer) != OMX_ErrorNone);
+    fail_if (OMX_EmptyThisBuffer (omx_handle, in_buffer) != OMX_ErrorNone);
+
+    wait_for_buffers (custom_data, 1, 1);
+
+    fail_unless (out_buffer->nFilledLen == param.nBufferSize);
+    fail_unless (out_buffer->pBuffer[param.nBufferSize - 1] == 0x5a);
+
+    change_state (custom_data, OMX_StateIdle);
+    wait_for_state (custom_data, OMX_StateIdle);
+
+    change_state (custom_data, OMX_StateLoaded);
+
+    fail_if (OMX_FreeBuffer (omx_handle, 0, in_buffer) != OMX_ErrorNone);
+    fail_if (OMX_FreeBuffer (omx_handle, 1, out_buffer) != OMX_ErrorNone);
+
+    wait_for_state (custom_data, OMX_StateLoaded);
+
+    omx_error = free_handle (omx_handle);
+    fail_if (omx_error != OMX_ErrorNone);
+
+    omx_error = deinit ();
+    fail_if (omx_error != OMX_ErrorNone);
+
+    custom_data_free (custom_data);
+}
+END_TEST
+
+START_TEST (test_scaler)
+{
+    CustomData *custom_data;
+    OMX_ERRORTYPE omx_error;
+    OMX_HANDLETYPE omx_handle;
+    OMX_BUFFERHEADERTYPE *in_buffers[SCALER_CHANNELS][SCALER_BUFFERS];
+    OMX_BUFFERHEADERTYPE *out_buffers[SCALER_CHANNELS][SCALER_BUFFERS];
+    BenchCoreConfig config, old_config;
+    guint ch, i;
+
+    get_config (&old_config);
+    config = old_config;
+    config.channels = SCALER_CHANNELS;
+    config.buffer_count = SCALER_BUFFERS;
+    set_config (&config);
+
+    custom_data = custom_data_new ();
+
+    omx_error = init ();
+    fail_if (omx_error != OMX_ErrorNone);
+
+    omx_error = get_handle (&omx_handle, "OMX.check.scaler", custom_data, &buffer_callbacks);
+    fail_if (omx_error != OMX_ErrorNone);
+
+    custom_data->omx_handle = omx_handle;
+
+    change_state (custom_data, OMX_StateIdle);
+
+    for (ch = 0; ch < SCALER_CHANNELS; ch++)
+    {
+        for (i = 0; i < SCALER_BUFFERS; i++)
+        {
+            fail_if (OMX_AllocateBuffer (omx_handle, &in_buffers[ch][i], ch,
+                        NULL, config.buffer_size) != OMX_ErrorNone);
+            fail_if (OMX_AllocateBuffer (omx_handle, &out_buffers[ch][i],
+                        BENCH_CORE_SCALER_OUTPUT_PORT_START + ch,
+                        NULL, config.buffer_size) != OMX_ErrorNone);
+        }
+    }
+
+    wait_for_state (custom_data, OMX_StateIdle);
+
+    change_state (custom_data, OMX_StateExecuting);
+    wait_for_state (custom_data, OMX_StateExecuting);
+
+    /* every channel converts all of its input buffers */
+    for (ch = 0; ch < SCALER_CHANNELS; ch++)
+    {
+        for (i = 0; i < SCALER_BUFFERS; i++)
+        {
+            in_buffers[ch][i]->nFilledLen = config.buffer_size / 2;
+            fail_if (OMX_FillThisBuffer (omx_handle, out_buffers[ch][i]) != OMX_ErrorNone);
+            fail_if (OMX_EmptyThisBuffer (omx_handle, in_buffers[ch][i]) != OMX_ErrorNone);
+        }
+    }
+
+    wait_for_buffers (custom_data, SCALER_CHANNELS * SCALER_BUFFERS,
+                      SCALER_CHANNELS * SCALER_BUFFERS);
+
+    for (ch = 0; ch < SCALER_CHANNELS; ch++)
+        for (i = 0; i < SCALER_BUFFERS; i++)
+            fail_unless (out_buffers[ch][i]->nFilledLen == config.buffer_size);
+
+    /* a disabled port hands back the buffers it holds */
+    for (i = 0; i < SCALER_BUFFERS; i++)
+        fail_if (OMX_FillThisBuffer (omx_handle, out_buffers[0][i]) != OMX_ErrorNone);
+
+    fail_if (OMX_SendCommand (omx_handle, OMX_CommandPortDisable,
+                BENCH_CORE_SCALER_OUTPUT_PORT_START, NULL) != OMX_ErrorNone);
+    wait_for_command (custom_data, BENCH_CORE_SCALER_OUTPUT_PORT_START);
+
+    wait_for_buffers (custom_data, SCALER_CHANNELS * SCALER_BUFFERS,
+                      (SCALER_CHANNELS + 1) * SCALER_BUFFERS);
+
+    fail_unless (OMX_FillThisBuffer (omx_handle, out_buffers[0][0]) != OMX_ErrorNone);
+
+    fail_if (OMX_SendCommand (omx_handle, OMX_CommandPortEnable,
+                BENCH_CORE_SCALER_OUTPUT_PORT_START, NULL) != OMX_ErrorNone);
+    wait_for_command (custom_data, BENCH_CORE_SCALER_OUTPUT_PORT_START);
+
+    fail_if (OMX_FillThisBuffer (omx_handle, out_buffers[0][0]) != OMX_ErrorNone);
+
+    change_state (custom_data, OMX_StateIdle);
+    wait_for_state (custom_data, OMX_StateIdle);
+
+    /* going to idle returned the pending output buffer */
+    fail_unless (custom_data->fill_done == (SCALER_CHANNELS + 1) * SCALER_BUFFERS + 1);
+
+    change_state (custom_data, OMX_StateLoaded);
+
+    for (ch = 0; ch < SCALER_CHANNELS; ch++)
+    {
+        for (i = 0; i < SCALER_BUFFERS; i++)
+        {
+            OMX_FreeBuffer (omx_handle, ch, in_buffers[ch][i]);
+            OMX_FreeBuffer (omx_handle, BENCH_CORE_SCALER_OUTPUT_PORT_START + ch,
+                            out_buffers[ch][i]);
+        }
+    }
+
+    wait_for_state (custom_data, OMX_StateLoaded);
+
+    omx_error = free_handle (omx_handle);
+    fail_if (omx_error != OMX_ErrorNone);
+
+    omx_error = deinit ();
+    fail_if (omx_error != OMX_ErrorNone);
+
+    custom_data_free (custom_data);
+
+    set_config (&old_config);
+}
+END_TEST
+
 static Suite *
 util_suite (void)
 {
@@ -223,11 +484,15 @@ util_suite (void)
         deinit = dlsym (dl_handle, "OMX_Deinit");
         get_handle = dlsym (dl_handle, "OMX_GetHandle");
         free_handle = dlsym (dl_handle, "OMX_FreeHandle");
+        get_config = dlsym (dl_handle, "bench_core_get_config");
+        set_config = dlsym (dl_handle, "bench_core_set_config");
     }
 
     tcase_add_test (tc_chain, test_basic);
     tcase_add_test (tc_chain, test_handle);
     tcase_add_test (tc_chain, test_idle);
+    tcase_add_test (tc_chain, test_allocate);
+    tcase_add_test (tc_chain, test_scaler);
     suite_add_tcase (s, tc_chain);
 
     return s;
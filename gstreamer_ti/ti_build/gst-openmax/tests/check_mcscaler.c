@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * omx_mcscaler driving several channels through one handle of the
+ * scaler role of the benchmarking core in libomxil-foo.so.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <dlfcn.h>
+
+#include "bench_core.h"
+
+#define CHANNELS 4
+#define FRAMES 64
+
+#define IN_WIDTH 64
+#define IN_HEIGHT 32
+#define OUT_WIDTH 32
+#define OUT_HEIGHT 16
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-raw-yuv, "
+                                          "format = (fourcc) YUY2, "
+                                          "width = (int) 32, "
+                                          "height = (int) 16"));
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static void (*get_config) (BenchCoreConfig *config);
+static void (*set_config) (const BenchCoreConfig *config);
+static void (*get_stats) (BenchCoreStats *stats);
+static void (*reset_stats) (void);
+
+typedef struct
+{
+    GstPad *filter_sinkpad;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    guint received;
+    guint bad_size;
+    guint push_errors;
+    gboolean eos;
+} Channel;
+
+static Channel channels[CHANNELS];
+static GMutex *eos_mutex;
+static GCond *eos_cond;
+
+static gboolean
+channel_sink_event (GstPad *pad, GstEvent *event)
+{
+    Channel *channel = gst_pad_get_element_private (pad);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (eos_mutex);
+        channel->eos = TRUE;
+        g_cond_signal (eos_cond);
+        g_mutex_unlock (eos_mutex);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+static GstFlowReturn
+channel_sink_chain (GstPad *pad, GstBuffer *buffer)
+{
+    Channel *channel = gst_pad_get_element_private (pad);
+
+    channel->received++;
+    if (GST_BUFFER_SIZE (buffer) != OUT_WIDTH * OUT_HEIGHT * 2)
+        channel->bad_size++;
+    gst_buffer_unref (buffer);
+
+    return GST_FLOW_OK;
+}
+
+static GstElement *
+setup_mcscaler (void)
+{
+    GstElement *filter;
+    BenchCoreConfig config;
+    guint i;
+
+    get_config (&config);
+    config.latency_us = 0;
+    config.jitter_us = 0;
+    config.channels = CHANNELS;
+    config.buffer_count = 4;
+    set_config (&config);
+    reset_stats ();
+
+    eos_mutex = g_mutex_new ();
+    eos_cond = g_cond_new ();
+
+    filter = gst_check_setup_element ("omx_mcscaler");
+    g_object_set (G_OBJECT (filter), "library-name", "libomxil-foo.so", NULL);
+
+    for (i = 0; i < CHANNELS; i++)
+    {
+        Channel *channel = &channels[i];
+        GstPad *filter_srcpad;
+        gchar *name;
+
+        memset (channel, 0, sizeof (*channel));
+
+        if (i == 0)
+        {
+            channel->filter_sinkpad = gst_element_get_static_pad (filter, "sink");
+            filter_srcpad = gst_element_get_static_pad (filter, "src");
+        }
+        else
+        {
+            channel->filter_sinkpad = gst_element_get_request_pad (filter, "sink_%d");
+            fail_unless (channel->filter_sinkpad != NULL);
+
+            name = g_strdup_printf ("src_%u", i);
+            filter_srcpad = gst_element_get_static_pad (filter, name);
+            g_free (name);
+        }
+        fail_unless (filter_srcpad != NULL);
+
+        channel->mysrcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+        channel->mysinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
+        gst_pad_set_element_private (channel->mysinkpad, channel);
+        gst_pad_set_chain_function (channel->mysinkpad, channel_sink_chain);
+        gst_pad_set_event_function (channel->mysinkpad, channel_sink_event);
+
+        fail_unless (gst_pad_link (channel->mysrcpad, channel->filter_sinkpad) == GST_PAD_LINK_OK);
+        fail_unless (gst_pad_link (filter_srcpad, channel->mysinkpad) == GST_PAD_LINK_OK);
+        gst_object_unref (filter_srcpad);
+
+        gst_pad_set_active (channel->mysrcpad, TRUE);
+        gst_pad_set_active (channel->mysinkpad, TRUE);
+    }
+
+    {
+        guint num_channels;
+
+        g_object_get (G_OBJECT (filter), "num-channels", &num_channels, NULL);
+        fail_unless_equals_int (num_channels, CHANNELS);
+    }
+
+    return filter;
+}
+
+static void
+teardown_mcscaler (GstElement *filter)
+{
+    guint i;
+
+    gst_element_set_state (filter, GST_STATE_NULL);
+
+    for (i = 0; i < CHANNELS; i++)
+    {
+        Channel *channel = &channels[i];
+
+        gst_pad_set_active (channel->mysrcpad, FALSE);
+        gst_pad_set_active (channel->mysinkpad, FALSE);
+        gst_object_unref (channel->mysrcpad);
+        gst_object_unref (channel->mysinkpad);
+
+        if (i > 0)
+            gst_element_release_request_pad (filter, channel->filter_sinkpad);
+        gst_object_unref (channel->filter_sinkpad);
+    }
+
+    gst_check_teardown_element (filter);
+
+    g_mutex_free (eos_mutex);
+    g_cond_free (eos_cond);
+}
+
+static GstBuffer *
+new_frame (guint frame)
+{
+    GstBuffer *buffer;
+    GstCaps *caps;
+
+    buffer = gst_buffer_new_and_alloc (IN_WIDTH * IN_HEIGHT * 3 / 2);
+    GST_BUFFER_DATA (buffer)[0] = frame;
+    GST_BUFFER_TIMESTAMP (buffer) = gst_util_uint64_scale_int (frame, GST_SECOND, 30);
+
+    caps = gst_caps_new_simple ("video/x-raw-yuv",
+                                "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('N', 'V', '1', '2'),
+                                "width", G_TYPE_INT, IN_WIDTH,
+                                "height", G_TYPE_INT, IN_HEIGHT,
+                                "framerate", GST_TYPE_FRACTION, 30, 1,
+                                NULL);
+    gst_buffer_set_caps (buffer, caps);
+    gst_caps_unref (caps);
+
+    return buffer;
+}
+
+/* the pushes of a channel block until its cycle is out, so every channel
+ * gets a thread of its own
+ */
+static gpointer
+feed_channel (gpointer data)
+{
+    Channel *channel = data;
+    guint i;
+
+    for (i = 0; i < FRAMES; i++)
+    {
+        if (gst_pad_push (channel->mysrcpad, new_frame (i)) != GST_FLOW_OK)
+            channel->push_errors++;
+    }
+
+    gst_pad_push_event (channel->mysrcpad, gst_event_new_eos ());
+
+    return NULL;
+}
+
+static gpointer
+prime_channel (gpointer data)
+{
+    Channel *channel = data;
+
+    if (gst_pad_push (channel->mysrcpad, new_frame (0)) != GST_FLOW_OK)
+        channel->push_errors++;
+
+    return NULL;
+}
+
+static void
+wait_for_eos (void)
+{
+    guint i;
+
+    g_mutex_lock (eos_mutex);
+    for (i = 0; i < CHANNELS; i++)
+    {
+        while (!channels[i].eos)
+            g_cond_wait (eos_cond, eos_mutex);
+    }
+    g_mutex_unlock (eos_mutex);
+}
+
+static void
+check_output (void)
+{
+    BenchCoreStats stats;
+    guint i;
+
+    get_stats (&stats);
+    fail_unless_equals_int (stats.processed, CHANNELS * FRAMES);
+
+    for (i = 0; i < CHANNELS; i++)
+    {
+        fail_unless_equals_int (channels[i].push_errors, 0);
+        fail_unless_equals_int (channels[i].received, FRAMES);
+        fail_unless_equals_int (channels[i].bad_size, 0);
+    }
+}
+
+static guint
+histogram_count (const GstStructure *structure, const gchar *field)
+{
+    const GValue *array;
+    guint i, count = 0;
+
+    array = gst_structure_get_value (structure, field);
+    fail_unless (array != NULL, "no %s", field);
+
+    for (i = 0; i < gst_value_array_get_size (array); i++)
+        count += g_value_get_uint (gst_value_array_get_value (array, i));
+
+    return count;
+}
+
+/* the port enables of all channels went out together and were timed */
+static void
+check_command_stats (GstElement *filter)
+{
+    GstStructure *structure;
+    guint timeouts;
+
+    g_object_get (G_OBJECT (filter), "command-stats", &structure, NULL);
+    fail_unless (structure != NULL);
+
+    fail_unless_equals_int (histogram_count (structure, "port-enable"), 2 * CHANNELS);
+    fail_unless_equals_int (histogram_count (structure, "state-loaded-to-idle"), 1);
+    fail_unless_equals_int (histogram_count (structure, "state-idle-to-executing"), 1);
+    fail_unless (gst_structure_get_uint (structure, "command-timeouts", &timeouts));
+    fail_unless_equals_int (timeouts, 0);
+
+    gst_structure_free (structure);
+}
+
+GST_START_TEST (test_batched)
+{
+    GstElement *filter;
+    GThread *threads[CHANNELS];
+    guint64 cycles, partial_cycles;
+    guint i;
+
+    filter = setup_mcscaler ();
+
+    /* long enough never to expire here */
+    g_object_set (G_OBJECT (filter), "batch-timeout", 5000, NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    for (i = 0; i < CHANNELS; i++)
+        threads[i] = g_thread_create (feed_channel, &channels[i], TRUE, NULL);
+
+    for (i = 0; i < CHANNELS; i++)
+        g_thread_join (threads[i]);
+
+    wait_for_eos ();
+    check_output ();
+
+    /* every cycle carries one frame of every channel */
+    g_object_get (G_OBJECT (filter),
+                  "cycles", &cycles,
+                  "partial-cycles", &partial_cycles,
+                  NULL);
+    fail_unless (cycles == FRAMES, "%" G_GUINT64_FORMAT " cycles", cycles);
+    fail_unless (partial_cycles == 0, "%" G_GUINT64_FORMAT " partial cycles", partial_cycles);
+
+    check_command_stats (filter);
+
+    /* the channel set is fixed once the component runs */
+    fail_unless (gst_element_get_request_pad (filter, "sink_%d") == NULL);
+
+    teardown_mcscaler (filter);
+}
+GST_END_TEST
+
+GST_START_TEST (test_unbatched)
+{
+    GstElement *filter;
+    guint64 cycles;
+    guint i, j;
+
+    filter = setup_mcscaler ();
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    /* the first cycle needs every channel, so prime it from threads and
+     * then feed all channels round robin from this one
+     */
+    g_object_set (G_OBJECT (filter), "batch-timeout", 0, NULL);
+
+    {
+        GThread *threads[CHANNELS];
+
+        for (i = 0; i < CHANNELS; i++)
+            threads[i] = g_thread_create (prime_channel, &channels[i], TRUE, NULL);
+        for (i = 0; i < CHANNELS; i++)
+            g_thread_join (threads[i]);
+    }
+
+    for (j = 1; j < FRAMES; j++)
+    {
+        for (i = 0; i < CHANNELS; i++)
+            fail_unless (gst_pad_push (channels[i].mysrcpad, new_frame (j)) == GST_FLOW_OK);
+    }
+
+    for (i = 0; i < CHANNELS; i++)
+        gst_pad_push_event (channels[i].mysrcpad, gst_event_new_eos ());
+
+    wait_for_eos ();
+    check_output ();
+
+    g_object_get (G_OBJECT (filter), "cycles", &cycles, NULL);
+    fail_unless (cycles > FRAMES);
+
+    teardown_mcscaler (filter);
+}
+GST_END_TEST
+
+GST_START_TEST (test_output_pool)
+{
+    GstElement *filter;
+    GThread *threads[CHANNELS];
+    guint count, peak;
+    guint i;
+
+    filter = setup_mcscaler ();
+
+    /* nobody downstream answers the buffers or latency query here, so
+     * the pool size comes from the limits alone
+     */
+    g_object_set (G_OBJECT (filter),
+                  "min-output-buffers", 6,
+                  "max-output-buffers", 6,
+                  NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    for (i = 0; i < CHANNELS; i++)
+        threads[i] = g_thread_create (feed_channel, &channels[i], TRUE, NULL);
+    for (i = 0; i < CHANNELS; i++)
+        g_thread_join (threads[i]);
+
+    wait_for_eos ();
+    check_output ();
+
+    /* neither "port-stats" nor "stats-interval" was touched: the peak
+     * has to be counted without the port statistics
+     */
+    g_object_get (G_OBJECT (filter),
+                  "output-buffers", &count,
+                  "peak-output-buffers", &peak,
+                  NULL);
+    fail_unless_equals_int (count, 6);
+    fail_unless (peak >= 1 && peak <= count, "peak %u of %u", peak, count);
+
+    teardown_mcscaler (filter);
+
+    /* never below what the component asks for (buffer_count 4) */
+    filter = setup_mcscaler ();
+    g_object_set (G_OBJECT (filter), "max-output-buffers", 2, NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    for (i = 0; i < CHANNELS; i++)
+        threads[i] = g_thread_create (feed_channel, &channels[i], TRUE, NULL);
+    for (i = 0; i < CHANNELS; i++)
+        g_thread_join (threads[i]);
+
+    wait_for_eos ();
+    check_output ();
+
+    g_object_get (G_OBJECT (filter), "output-buffers", &count, NULL);
+    fail_unless_equals_int (count, 4);
+
+    teardown_mcscaler (filter);
+}
+GST_END_TEST
+
+static Suite *
+mcscaler_suite (void)
+{
+    Suite *s = suite_create ("mcscaler");
+    TCase *tc_chain = tcase_create ("general");
+    void *dl_handle;
+
+    /* the same instance the OMX elements will load */
+    dl_handle = dlopen ("libomxil-foo.so", RTLD_LAZY);
+    if (!dl_handle)
+        g_error ("%s", dlerror ());
+
+    get_config = dlsym (dl_handle, "bench_core_get_config");
+    set_config = dlsym (dl_handle, "bench_core_set_config");
+    get_stats = dlsym (dl_handle, "bench_core_get_stats");
+    reset_stats = dlsym (dl_handle, "bench_core_reset_stats");
+
+    tcase_set_timeout (tc_chain, 60);
+    tcase_add_test (tc_chain, test_batched);
+    tcase_add_test (tc_chain, test_unbatched);
+    tcase_add_test (tc_chain, test_output_pool);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (mcscaler);
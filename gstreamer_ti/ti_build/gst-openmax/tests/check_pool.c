@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The process-wide component pool, with omx_dummy on libomxil-foo.so.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define BUFFER_SIZE 0x1000
+#define BUFFER_COUNT 0x20
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+typedef struct
+{
+    guint idle;
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+} PoolStats;
+
+static GstElement *
+new_filter (void)
+{
+    GstElement *filter;
+
+    filter = gst_check_setup_element ("omx_dummy");
+    g_object_set (G_OBJECT (filter),
+                  "library-name", "libomxil-foo.so",
+                  "use-pool", TRUE,
+                  NULL);
+
+    return filter;
+}
+
+static void
+get_pool_stats (GstElement *filter, PoolStats *stats)
+{
+    GstStructure *structure;
+
+    g_object_get (G_OBJECT (filter), "pool-stats", &structure, NULL);
+    fail_unless (structure != NULL);
+    fail_unless (gst_structure_get_uint (structure, "idle", &stats->idle));
+    fail_unless (gst_structure_get (structure,
+                                    "hits", G_TYPE_UINT64, &stats->hits,
+                                    "misses", G_TYPE_UINT64, &stats->misses,
+                                    "evictions", G_TYPE_UINT64, &stats->evictions,
+                                    NULL));
+    gst_structure_free (structure);
+}
+
+/* empty the pool and go back to the default limits */
+static void
+reset_pool (void)
+{
+    GstElement *filter = new_filter ();
+    guint size;
+
+    g_object_get (G_OBJECT (filter), "pool-size", &size, NULL);
+    g_object_set (G_OBJECT (filter), "pool-size", 0, NULL);
+    g_object_set (G_OBJECT (filter), "pool-size", size, NULL);
+    gst_check_teardown_element (filter);
+}
+
+static void
+cycle (GstElement *filter)
+{
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_READY),
+                            GST_STATE_CHANGE_SUCCESS);
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+}
+
+/* push BUFFER_COUNT buffers through @filter and check they all came out */
+static void
+stream (GstElement *filter)
+{
+    GstPad *mysrcpad, *mysinkpad;
+    guint i;
+
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    for (i = 0; i < BUFFER_COUNT; i++)
+    {
+        GstBuffer *inbuffer;
+
+        inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE);
+        GST_BUFFER_DATA (inbuffer)[0] = i;
+        fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+    }
+
+    /* output comes from the output task */
+    for (i = 0; i < 500 && g_list_length (buffers) < BUFFER_COUNT; i++)
+        g_usleep (10000);
+
+    fail_unless_equals_int (g_list_length (buffers), BUFFER_COUNT);
+    for (i = 0; i < BUFFER_COUNT; i++)
+        fail_unless_equals_int (GST_BUFFER_DATA (g_list_nth_data (buffers, i))[0], i);
+
+    gst_check_drop_buffers ();
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+}
+
+GST_START_TEST (test_adopt)
+{
+    GstElement *filter;
+    PoolStats before, stats;
+
+    reset_pool ();
+
+    filter = new_filter ();
+    get_pool_stats (filter, &before);
+    fail_unless_equals_int (before.idle, 0);
+
+    /* nothing to adopt the first time */
+    cycle (filter);
+    get_pool_stats (filter, &stats);
+    fail_unless_equals_int (stats.idle, 1);
+    fail_unless_equals_uint64 (stats.misses, before.misses + 1);
+    fail_unless_equals_uint64 (stats.hits, before.hits);
+    gst_check_teardown_element (filter);
+
+    /* a new element gets the handle back, and parks it again */
+    filter = new_filter ();
+    cycle (filter);
+    get_pool_stats (filter, &stats);
+    fail_unless_equals_int (stats.idle, 1);
+    fail_unless_equals_uint64 (stats.misses, before.misses + 1);
+    fail_unless_equals_uint64 (stats.hits, before.hits + 1);
+    gst_check_teardown_element (filter);
+
+    reset_pool ();
+}
+GST_END_TEST
+
+GST_START_TEST (test_adopt_after_streaming)
+{
+    GstElement *filter;
+    PoolStats before, stats;
+
+    reset_pool ();
+
+    filter = new_filter ();
+    get_pool_stats (filter, &before);
+    stream (filter);
+
+    /* the ports could be put back, so the handle was parked */
+    get_pool_stats (filter, &stats);
+    fail_unless_equals_int (stats.idle, 1);
+    gst_check_teardown_element (filter);
+
+    /* and works for the next element */
+    filter = new_filter ();
+    stream (filter);
+    get_pool_stats (filter, &stats);
+    fail_unless_equals_int (stats.idle, 1);
+    fail_unless_equals_uint64 (stats.hits, before.hits + 1);
+    gst_check_teardown_element (filter);
+
+    reset_pool ();
+}
+GST_END_TEST
+
+GST_START_TEST (test_limits)
+{
+    GstElement *filters[3];
+    GstElement *filter;
+    PoolStats before, stats;
+    guint size, timeout;
+    guint i;
+
+    reset_pool ();
+
+    for (i = 0; i < G_N_ELEMENTS (filters); i++)
+    {
+        filters[i] = new_filter ();
+        fail_unless_equals_int (gst_element_set_state (filters[i], GST_STATE_READY),
+                                GST_STATE_CHANGE_SUCCESS);
+    }
+
+    g_object_get (G_OBJECT (filters[0]),
+                  "pool-size", &size,
+                  "pool-timeout", &timeout,
+                  NULL);
+    g_object_set (G_OBJECT (filters[0]), "pool-size", 1, NULL);
+    get_pool_stats (filters[0], &before);
+
+    /* only the last one parked stays */
+    for (i = 0; i < G_N_ELEMENTS (filters); i++)
+    {
+        fail_unless_equals_int (gst_element_set_state (filters[i], GST_STATE_NULL),
+                                GST_STATE_CHANGE_SUCCESS);
+    }
+    get_pool_stats (filters[0], &stats);
+    fail_unless_equals_int (stats.idle, 1);
+    fail_unless_equals_uint64 (stats.evictions, before.evictions + 2);
+
+    /* and not for long */
+    g_object_set (G_OBJECT (filters[0]), "pool-timeout", 50, NULL);
+    for (i = 0; i < 200 && stats.idle; i++)
+    {
+        g_usleep (10000);
+        get_pool_stats (filters[0], &stats);
+    }
+    fail_unless_equals_int (stats.idle, 0);
+    fail_unless_equals_uint64 (stats.evictions, before.evictions + 3);
+
+    for (i = 0; i < G_N_ELEMENTS (filters); i++)
+        gst_check_teardown_element (filters[i]);
+
+    /* a disabled pool keeps nothing */
+    filter = new_filter ();
+    g_object_set (G_OBJECT (filter), "pool-size", 0, NULL);
+    cycle (filter);
+    get_pool_stats (filter, &stats);
+    fail_unless_equals_int (stats.idle, 0);
+
+    g_object_set (G_OBJECT (filter),
+                  "pool-size", size,
+                  "pool-timeout", timeout,
+                  NULL);
+    gst_check_teardown_element (filter);
+}
+GST_END_TEST
+
+static Suite *
+pool_suite (void)
+{
+    Suite *s = suite_create ("pool");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 60);
+    tcase_add_test (tc_chain, test_adopt);
+    tcase_add_test (tc_chain, test_adopt_after_streaming);
+    tcase_add_test (tc_chain, test_limits);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (pool);
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * omx_scaler cropping, in place or through the scaler role of the
+ * benchmarking core in libomxil-foo.so.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <dlfcn.h>
+
+#include "bench_core.h"
+
+#define FRAMES 16
+
+#define IN_WIDTH 64
+#define IN_HEIGHT 32
+#define CROP_TOP 4
+#define CROP_LEFT 8
+#define CROP_WIDTH 32
+#define CROP_HEIGHT 16
+
+static GstStaticPadTemplate nv12_sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-raw-yuv-strided, "
+                                          "format = (fourcc) NV12, "
+                                          "width = (int) [ 1, max ], "
+                                          "height = (int) [ 1, max ], "
+                                          "rowstride = (int) [ 0, max ]"));
+
+static GstStaticPadTemplate yuy2_sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-raw-yuv, "
+                                          "format = (fourcc) YUY2, "
+                                          "width = (int) 32, "
+                                          "height = (int) 16"));
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static void (*get_config) (BenchCoreConfig *config);
+static void (*set_config) (const BenchCoreConfig *config);
+static void (*get_stats) (BenchCoreStats *stats);
+static void (*reset_stats) (void);
+
+static GstPad *mysrcpad, *mysinkpad;
+static guint8 *sent_data[FRAMES];
+static volatile gint received;
+static guint same_data;
+static guint crop_events;
+static guint bad_crop_events;
+
+static gboolean
+sink_event (GstPad *pad, GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CROP)
+    {
+        gint top, left, width, height;
+
+        gst_event_parse_crop (event, &top, &left, &width, &height);
+
+        crop_events++;
+        if (top != CROP_TOP || left != CROP_LEFT ||
+            width != CROP_WIDTH || height != CROP_HEIGHT)
+            bad_crop_events++;
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+static GstFlowReturn
+sink_chain (GstPad *pad, GstBuffer *buffer)
+{
+    gint i = g_atomic_int_get (&received);
+
+    if (i < FRAMES && GST_BUFFER_DATA (buffer) == sent_data[i])
+        same_data++;
+
+    g_atomic_int_inc (&received);
+    gst_buffer_unref (buffer);
+
+    return GST_FLOW_OK;
+}
+
+static GstElement *
+setup_scaler (GstStaticPadTemplate *sinktemplate)
+{
+    GstElement *filter;
+    BenchCoreConfig config;
+
+    get_config (&config);
+    config.latency_us = 0;
+    config.jitter_us = 0;
+    config.channels = 1;
+    config.buffer_count = 4;
+    set_config (&config);
+    reset_stats ();
+
+    received = 0;
+    same_data = 0;
+    crop_events = 0;
+    bad_crop_events = 0;
+
+    filter = gst_check_setup_element ("omx_scaler");
+    g_object_set (G_OBJECT (filter), "library-name", "libomxil-foo.so", NULL);
+
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, sinktemplate, NULL);
+    gst_pad_set_event_function (mysinkpad, sink_event);
+    gst_pad_set_chain_function (mysinkpad, sink_chain);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    return filter;
+}
+
+static void
+teardown_scaler (GstElement *filter)
+{
+    gst_element_set_state (filter, GST_STATE_NULL);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+}
+
+static GstBuffer *
+new_frame (guint frame)
+{
+    GstBuffer *buffer;
+    GstCaps *caps;
+
+    buffer = gst_buffer_new_and_alloc (IN_WIDTH * IN_HEIGHT * 3 / 2);
+    GST_BUFFER_DATA (buffer)[0] = frame;
+    GST_BUFFER_TIMESTAMP (buffer) = gst_util_uint64_scale_int (frame, GST_SECOND, 30);
+
+    caps = gst_caps_new_simple ("video/x-raw-yuv",
+                                "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('N', 'V', '1', '2'),
+                                "width", G_TYPE_INT, IN_WIDTH,
+                                "height", G_TYPE_INT, IN_HEIGHT,
+                                "framerate", GST_TYPE_FRACTION, 30, 1,
+                                NULL);
+    gst_buffer_set_caps (buffer, caps);
+    gst_caps_unref (caps);
+
+    return buffer;
+}
+
+static void
+push_frames (void)
+{
+    guint i;
+
+    fail_unless (gst_pad_push_event (mysrcpad,
+                gst_event_new_crop (CROP_TOP, CROP_LEFT, CROP_WIDTH, CROP_HEIGHT)));
+
+    for (i = 0; i < FRAMES; i++)
+    {
+        GstBuffer *buffer = new_frame (i);
+
+        sent_data[i] = GST_BUFFER_DATA (buffer);
+        fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+    }
+}
+
+/* the same frames, in one buffer list */
+static void
+push_frame_list (void)
+{
+    GstBufferList *list;
+    GstBufferListIterator *it;
+    guint i;
+
+    fail_unless (gst_pad_push_event (mysrcpad,
+                gst_event_new_crop (CROP_TOP, CROP_LEFT, CROP_WIDTH, CROP_HEIGHT)));
+
+    list = gst_buffer_list_new ();
+    it = gst_buffer_list_iterate (list);
+    for (i = 0; i < FRAMES; i++)
+    {
+        GstBuffer *buffer = new_frame (i);
+
+        sent_data[i] = GST_BUFFER_DATA (buffer);
+        gst_buffer_list_iterator_add_group (it);
+        gst_buffer_list_iterator_add (it, buffer);
+    }
+    gst_buffer_list_iterator_free (it);
+
+    fail_unless (gst_pad_push_list (mysrcpad, list) == GST_FLOW_OK);
+}
+
+GST_START_TEST (test_crop_in_place)
+{
+    GstElement *filter;
+    BenchCoreStats stats;
+    GstCaps *caps;
+    GstStructure *structure;
+    gint width, height, rowstride;
+
+    filter = setup_scaler (&nv12_sinktemplate);
+    g_object_set (G_OBJECT (filter), "lazy-crop", TRUE, NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    push_frames ();
+
+    /* handed on from the streaming thread, nothing to wait for */
+    fail_unless_equals_int (received, FRAMES);
+    fail_unless_equals_int (same_data, FRAMES);
+    fail_unless_equals_int (crop_events, FRAMES);
+    fail_unless_equals_int (bad_crop_events, 0);
+
+    caps = gst_pad_get_negotiated_caps (mysinkpad);
+    fail_unless (caps != NULL);
+    structure = gst_caps_get_structure (caps, 0);
+    fail_unless (gst_structure_get_int (structure, "width", &width));
+    fail_unless (gst_structure_get_int (structure, "height", &height));
+    fail_unless (gst_structure_get_int (structure, "rowstride", &rowstride));
+    fail_unless_equals_int (width, CROP_WIDTH);
+    fail_unless_equals_int (height, CROP_HEIGHT);
+    fail_unless_equals_int (rowstride, IN_WIDTH);
+    gst_caps_unref (caps);
+
+    /* the component never saw a frame */
+    get_stats (&stats);
+    fail_unless_equals_int (stats.processed, 0);
+
+    teardown_scaler (filter);
+}
+GST_END_TEST
+
+GST_START_TEST (test_crop_in_place_list)
+{
+    GstElement *filter;
+    BenchCoreStats stats;
+
+    filter = setup_scaler (&nv12_sinktemplate);
+    g_object_set (G_OBJECT (filter), "lazy-crop", TRUE, NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    push_frame_list ();
+
+    /* every frame went through the scaler's own pad_chain */
+    fail_unless_equals_int (received, FRAMES);
+    fail_unless_equals_int (same_data, FRAMES);
+    fail_unless_equals_int (crop_events, FRAMES);
+
+    get_stats (&stats);
+    fail_unless_equals_int (stats.processed, 0);
+
+    teardown_scaler (filter);
+}
+GST_END_TEST
+
+GST_START_TEST (test_crop_default)
+{
+    GstElement *filter;
+    BenchCoreStats stats;
+    guint i;
+
+    /* same caps as test_crop_in_place, but lazy-crop left at its default */
+    filter = setup_scaler (&nv12_sinktemplate);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    push_frames ();
+
+    /* output comes from the output task */
+    for (i = 0; i < 500 && g_atomic_int_get (&received) < FRAMES; i++)
+        g_usleep (10000);
+
+    fail_unless_equals_int (received, FRAMES);
+    fail_unless_equals_int (same_data, 0);
+    fail_unless_equals_int (crop_events, 0);
+
+    get_stats (&stats);
+    fail_unless_equals_int (stats.processed, FRAMES);
+
+    teardown_scaler (filter);
+}
+GST_END_TEST
+
+GST_START_TEST (test_crop_scaled)
+{
+    GstElement *filter;
+    BenchCoreStats stats;
+    guint i;
+
+    filter = setup_scaler (&yuy2_sinktemplate);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    push_frames ();
+
+    /* output comes from the output task */
+    for (i = 0; i < 500 && g_atomic_int_get (&received) < FRAMES; i++)
+        g_usleep (10000);
+
+    fail_unless_equals_int (received, FRAMES);
+    fail_unless_equals_int (same_data, 0);
+    fail_unless_equals_int (crop_events, 0);
+
+    get_stats (&stats);
+    fail_unless_equals_int (stats.processed, FRAMES);
+
+    teardown_scaler (filter);
+}
+GST_END_TEST
+
+static Suite *
+scaler_suite (void)
+{
+    Suite *s = suite_create ("scaler");
+    TCase *tc_chain = tcase_create ("general");
+    void *dl_handle;
+
+    /* the same instance the OMX elements will load */
+    dl_handle = dlopen ("libomxil-foo.so", RTLD_LAZY);
+    if (!dl_handle)
+        g_error ("%s", dlerror ());
+
+    get_config = dlsym (dl_handle, "bench_core_get_config");
+    set_config = dlsym (dl_handle, "bench_core_set_config");
+    get_stats = dlsym (dl_handle, "bench_core_get_stats");
+    reset_stats = dlsym (dl_handle, "bench_core_reset_stats");
+
+    tcase_set_timeout (tc_chain, 60);
+    tcase_add_test (tc_chain, test_crop_in_place);
+    tcase_add_test (tc_chain, test_crop_in_place_list);
+    tcase_add_test (tc_chain, test_crop_default);
+    tcase_add_test (tc_chain, test_crop_scaled);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (scaler);
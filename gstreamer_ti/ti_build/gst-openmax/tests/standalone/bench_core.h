@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BENCH_CORE_H
+#define BENCH_CORE_H
+
+#include <glib.h>
+
+/*
+ * Control interface of the host-side OMX core in libomxil-foo.so.
+ *
+ * The core picks its behaviour from the component role (set with
+ * OMX_IndexParamStandardComponentRole) or, failing that, from the
+ * component name:
+ *
+ *   benchmark.passthrough  copies input to output (the default)
+ *   benchmark.scaler       VFPC-like: one input/output port pair per
+ *                          channel, fixed size output frames
+ *   benchmark.encoder      one input/output pair, variable size output
+ *                          with a sync frame every gop frames
+ *
+ * Configuration is read from the environment when the library is loaded
+ * (BENCH_CORE_LATENCY, BENCH_CORE_JITTER, BENCH_CORE_CHANNELS,
+ * BENCH_CORE_BUFFER_COUNT, BENCH_CORE_BUFFER_SIZE, BENCH_CORE_GOP) and can
+ * be replaced with bench_core_set_config(); it applies to handles created
+ * afterwards.  Tests reach these functions with dlsym() on the library the
+ * OMX elements loaded.
+ */
+
+#define BENCH_CORE_ROLE_PASSTHROUGH "benchmark.passthrough"
+#define BENCH_CORE_ROLE_SCALER      "benchmark.scaler"
+#define BENCH_CORE_ROLE_ENCODER     "benchmark.encoder"
+
+/** first output port of the scaler role, as on the VFPC components */
+#define BENCH_CORE_SCALER_OUTPUT_PORT_START 16
+#define BENCH_CORE_MAX_CHANNELS 16
+
+typedef struct BenchCoreConfig BenchCoreConfig;
+typedef struct BenchCoreStats BenchCoreStats;
+
+struct BenchCoreConfig
+{
+    guint latency_us;       /**< processing time of every buffer */
+    guint jitter_us;        /**< uniform random extra processing time */
+    guint channels;         /**< port pairs of the scaler role */
+    guint buffer_count;     /**< nBufferCountActual/nBufferCountMin */
+    guint buffer_size;      /**< nBufferSize of every port */
+    guint gop;              /**< sync frame interval of the encoder role */
+};
+
+/*
+ * Turnaround is the time a header spends on the client side: from the
+ * EmptyBufferDone/FillBufferDone that returned it to the
+ * EmptyThisBuffer/FillThisBuffer that gives it back.  With no modeled
+ * latency it is what g_omx_port_recv(), g_omx_port_send() and the element
+ * around them cost per buffer.
+ */
+struct BenchCoreStats
+{
+    guint64 processed;          /**< input buffers consumed */
+    guint64 produced;           /**< output buffers filled */
+    guint64 bytes_out;
+    guint64 processing_ns;      /**< total modeled latency */
+
+    guint64 in_turnaround_count;
+    guint64 in_turnaround_ns;
+    guint64 in_turnaround_max_ns;
+
+    guint64 out_turnaround_count;
+    guint64 out_turnaround_ns;
+    guint64 out_turnaround_max_ns;
+};
+
+void bench_core_get_config (BenchCoreConfig *config);
+void bench_core_set_config (const BenchCoreConfig *config);
+void bench_core_get_stats (BenchCoreStats *stats);
+void bench_core_reset_stats (void);
+
+#endif /* BENCH_CORE_H */
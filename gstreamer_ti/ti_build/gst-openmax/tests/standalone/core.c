@@ -1,5 +1,6 @@
 /*
  * Copyright (C) 2008-2009 Nokia Corporation.
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
  *
  * Author: Felipe Contreras <felipe.contreras@nokia.com>
  *
@@ -24,12 +25,190 @@
 
 #include <glib.h>
 
-#include <stdlib.h> /* For calloc, free */
+#include <stdlib.h> /* For calloc, free, getenv */
 #include <string.h> /* For memcpy */
+#include <time.h>   /* For clock_gettime */
 
-#include "async_queue.h"
+#include "bench_core.h"
 
-static void *foo_thread (void *cb_data);
+#define BUFFER_ALIGN 128
+
+/* below this, sleeping would overshoot the modeled latency, so spin */
+#define SPIN_THRESHOLD_US 200
+
+static gpointer channel_thread (gpointer cb_data);
+
+typedef enum CompRole CompRole;
+typedef struct CompPrivate CompPrivate;
+typedef struct CompPrivatePort CompPrivatePort;
+typedef struct CompChannel CompChannel;
+typedef struct CompBuffer CompBuffer;
+
+enum CompRole
+{
+    ROLE_PASSTHROUGH,
+    ROLE_SCALER,
+    ROLE_ENCODER
+};
+
+struct CompPrivatePort
+{
+    OMX_PARAM_PORTDEFINITIONTYPE port_def;
+    gboolean valid;     /**< index is a port of the current role */
+    GQueue queue;       /**< buffers handed to us, waiting to be processed */
+};
+
+struct CompChannel
+{
+    OMX_COMPONENTTYPE *comp;
+    guint in_port;
+    guint out_port;
+    GThread *thread;
+    GRand *rand;
+    guint frame;
+    gboolean busy;      /**< processing a buffer pair outside the lock */
+};
+
+struct CompPrivate
+{
+    OMX_STATETYPE state;
+    OMX_CALLBACKTYPE *callbacks;
+    OMX_PTR app_data;
+
+    CompRole role;
+    BenchCoreConfig config;
+
+    guint num_ports;
+    CompPrivatePort *ports;
+    guint num_channels;
+    CompChannel *channels;
+
+    gboolean done;
+    GMutex *mutex;      /**< protects everything above and the port queues */
+    GCond *cond;        /**< work queued, state changed or channel idle */
+};
+
+/* kept in pPlatformPrivate of every header we hand out */
+struct CompBuffer
+{
+    gboolean allocated; /**< pBuffer came from OMX_AllocateBuffer */
+    guint64 returned;   /**< when the header was last returned, 0 if never */
+};
+
+static const gchar *role_names[] =
+{
+    BENCH_CORE_ROLE_PASSTHROUGH,
+    BENCH_CORE_ROLE_SCALER,
+    BENCH_CORE_ROLE_ENCODER,
+};
+
+G_LOCK_DEFINE_STATIC (bench);
+static gboolean config_loaded;
+static BenchCoreConfig config;
+static BenchCoreStats stats;
+
+static guint64
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (guint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static guint
+env_uint (const gchar *name, guint def)
+{
+    const gchar *value;
+
+    value = getenv (name);
+
+    return value ? strtoul (value, NULL, 0) : def;
+}
+
+/* called with the bench lock */
+static void
+load_config (void)
+{
+    if (config_loaded)
+        return;
+
+    config.latency_us = env_uint ("BENCH_CORE_LATENCY", 0);
+    config.jitter_us = env_uint ("BENCH_CORE_JITTER", 0);
+    config.channels = env_uint ("BENCH_CORE_CHANNELS", 1);
+    config.buffer_count = env_uint ("BENCH_CORE_BUFFER_COUNT", 1);
+    config.buffer_size = env_uint ("BENCH_CORE_BUFFER_SIZE", 0x1000);
+    config.gop = env_uint ("BENCH_CORE_GOP", 30);
+
+    config_loaded = TRUE;
+}
+
+void
+bench_core_get_config (BenchCoreConfig *ret)
+{
+    G_LOCK (bench);
+    load_config ();
+    *ret = config;
+    G_UNLOCK (bench);
+}
+
+void
+bench_core_set_config (const BenchCoreConfig *new_config)
+{
+    G_LOCK (bench);
+    config = *new_config;
+    config.channels = CLAMP (config.channels, 1, BENCH_CORE_MAX_CHANNELS);
+    config.buffer_count = MAX (config.buffer_count, 1);
+    config.gop = MAX (config.gop, 1);
+    config_loaded = TRUE;
+    G_UNLOCK (bench);
+}
+
+void
+bench_core_get_stats (BenchCoreStats *ret)
+{
+    G_LOCK (bench);
+    *ret = stats;
+    G_UNLOCK (bench);
+}
+
+void
+bench_core_reset_stats (void)
+{
+    G_LOCK (bench);
+    memset (&stats, 0, sizeof (stats));
+    G_UNLOCK (bench);
+}
+
+static void
+account_turnaround (OMX_BUFFERHEADERTYPE *buffer, gboolean input)
+{
+    CompBuffer *comp_buffer;
+    guint64 elapsed;
+
+    comp_buffer = buffer->pPlatformPrivate;
+
+    if (!comp_buffer->returned)
+        return;
+
+    elapsed = now_ns () - comp_buffer->returned;
+
+    G_LOCK (bench);
+    if (input)
+    {
+        stats.in_turnaround_count++;
+        stats.in_turnaround_ns += elapsed;
+        stats.in_turnaround_max_ns = MAX (stats.in_turnaround_max_ns, elapsed);
+    }
+    else
+    {
+        stats.out_turnaround_count++;
+        stats.out_turnaround_ns += elapsed;
+        stats.out_turnaround_max_ns = MAX (stats.out_turnaround_max_ns, elapsed);
+    }
+    G_UNLOCK (bench);
+}
 
 OMX_ERRORTYPE
 OMX_Init (void)
@@ -39,6 +218,10 @@ OMX_Init (void)
         g_thread_init (NULL);
     }
 
+    G_LOCK (bench);
+    load_config ();
+    G_UNLOCK (bench);
+
     return OMX_ErrorNone;
 }
 
@@ -48,24 +231,188 @@ OMX_Deinit (void)
     return OMX_ErrorNone;
 }
 
-typedef struct CompPrivate CompPrivate;
-typedef struct CompPrivatePort CompPrivatePort;
+static inline gboolean
+is_input_port (CompPrivate *private, guint index)
+{
+    return private->ports[index].port_def.eDir == OMX_DirInput;
+}
 
-struct CompPrivate
+static void
+init_port (CompPrivate *private, guint index, OMX_DIRTYPE dir)
 {
-    OMX_STATETYPE state;
-    OMX_CALLBACKTYPE *callbacks;
-    OMX_PTR app_data;
-    CompPrivatePort *ports;
-    gboolean done;
-    GMutex *flush_mutex;
-};
+    OMX_PARAM_PORTDEFINITIONTYPE *port_def;
+
+    port_def = &private->ports[index].port_def;
+    port_def->nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    port_def->nVersion.nVersion = 1;
+    port_def->nPortIndex = index;
+    port_def->eDir = dir;
+    port_def->nBufferCountActual = private->config.buffer_count;
+    port_def->nBufferCountMin = private->config.buffer_count;
+    port_def->nBufferSize = private->config.buffer_size;
+    port_def->nBufferAlignment = BUFFER_ALIGN;
+    port_def->bEnabled = OMX_TRUE;
+    port_def->bPopulated = OMX_FALSE;
+
+    if (private->role == ROLE_PASSTHROUGH)
+    {
+        port_def->eDomain = OMX_PortDomainAudio;
+    }
+    else
+    {
+        port_def->eDomain = OMX_PortDomainVideo;
+        port_def->format.video.eCompressionFormat =
+            (private->role == ROLE_ENCODER && dir == OMX_DirOutput) ?
+            OMX_VIDEO_CodingAVC : OMX_VIDEO_CodingUnused;
+    }
 
-struct CompPrivatePort
+    private->ports[index].valid = TRUE;
+    g_queue_init (&private->ports[index].queue);
+}
+
+/* (re)build the port layout for private->role, only in OMX_StateLoaded */
+static void
+setup_ports (OMX_COMPONENTTYPE *comp)
 {
-    OMX_PARAM_PORTDEFINITIONTYPE port_def;
-    AsyncQueue *queue;
-};
+    CompPrivate *private;
+    guint i;
+
+    private = comp->pComponentPrivate;
+
+    for (i = 0; i < private->num_channels; i++)
+        g_rand_free (private->channels[i].rand);
+    g_free (private->channels);
+    g_free (private->ports);
+
+    if (private->role == ROLE_SCALER)
+    {
+        private->num_channels = private->config.channels;
+        private->num_ports = BENCH_CORE_SCALER_OUTPUT_PORT_START + private->num_channels;
+    }
+    else
+    {
+        private->num_channels = 1;
+        private->num_ports = 2;
+    }
+
+    private->ports = g_new0 (CompPrivatePort, private->num_ports);
+    private->channels = g_new0 (CompChannel, private->num_channels);
+
+    for (i = 0; i < private->num_channels; i++)
+    {
+        CompChannel *channel = &private->channels[i];
+
+        channel->comp = comp;
+        channel->in_port = i;
+        channel->out_port = (private->role == ROLE_SCALER) ?
+            BENCH_CORE_SCALER_OUTPUT_PORT_START + i : 1;
+        channel->rand = g_rand_new_with_seed (i);
+
+        init_port (private, channel->in_port, OMX_DirInput);
+        init_port (private, channel->out_port, OMX_DirOutput);
+    }
+}
+
+static CompPrivatePort *
+get_port (CompPrivate *private, OMX_U32 index)
+{
+    if (index >= private->num_ports || !private->ports[index].valid)
+        return NULL;
+
+    return &private->ports[index];
+}
+
+static inline void
+return_buffer (OMX_COMPONENTTYPE *comp, OMX_BUFFERHEADERTYPE *buffer, gboolean input)
+{
+    CompPrivate *private;
+    CompBuffer *comp_buffer;
+
+    private = comp->pComponentPrivate;
+    comp_buffer = buffer->pPlatformPrivate;
+    comp_buffer->returned = now_ns ();
+
+    if (input)
+        private->callbacks->EmptyBufferDone (comp, private->app_data, buffer);
+    else
+        private->callbacks->FillBufferDone (comp, private->app_data, buffer);
+}
+
+/* give back every queued buffer of @index (or all ports), called with
+ * the lock held once no channel is busy
+ */
+static void
+return_queued (OMX_COMPONENTTYPE *comp, OMX_U32 index)
+{
+    CompPrivate *private;
+    guint i;
+
+    private = comp->pComponentPrivate;
+
+    for (i = 0; i < private->num_ports; i++)
+    {
+        OMX_BUFFERHEADERTYPE *buffer;
+
+        if (!private->ports[i].valid || (index != OMX_ALL && index != i))
+            continue;
+
+        while ((buffer = g_queue_pop_head (&private->ports[i].queue)))
+        {
+            if (is_input_port (private, i))
+                buffer->nFilledLen = 0;
+            return_buffer (comp, buffer, is_input_port (private, i));
+        }
+    }
+}
+
+static void
+wait_idle (CompPrivate *private)
+{
+    guint i;
+
+    for (i = 0; i < private->num_channels; i++)
+    {
+        while (private->channels[i].busy)
+            g_cond_wait (private->cond, private->mutex);
+    }
+}
+
+static void
+start_channels (OMX_COMPONENTTYPE *comp)
+{
+    CompPrivate *private;
+    guint i;
+
+    private = comp->pComponentPrivate;
+    private->done = FALSE;
+
+    for (i = 0; i < private->num_channels; i++)
+    {
+        private->channels[i].thread =
+            g_thread_create (channel_thread, &private->channels[i], TRUE, NULL);
+    }
+}
+
+static void
+stop_channels (OMX_COMPONENTTYPE *comp)
+{
+    CompPrivate *private;
+    guint i;
+
+    private = comp->pComponentPrivate;
+
+    g_mutex_lock (private->mutex);
+    private->done = TRUE;
+    g_cond_broadcast (private->cond);
+    g_mutex_unlock (private->mutex);
+
+    for (i = 0; i < private->num_channels; i++)
+    {
+        if (private->channels[i].thread)
+            g_thread_join (private->channels[i].thread);
+        private->channels[i].thread = NULL;
+    }
+}
 
 static OMX_ERRORTYPE
 comp_GetState (OMX_HANDLETYPE handle,
@@ -91,26 +438,48 @@ comp_GetParameter (OMX_HANDLETYPE handle,
 {
     OMX_COMPONENTTYPE *comp;
     CompPrivate *private;
+    OMX_ERRORTYPE error = OMX_ErrorNone;
 
     /* printf ("GetParameter\n"); */
 
     comp = handle;
     private = comp->pComponentPrivate;
 
+    g_mutex_lock (private->mutex);
+
     switch (index)
     {
         case OMX_IndexParamPortDefinition:
             {
                 OMX_PARAM_PORTDEFINITIONTYPE *port_def;
+                CompPrivatePort *port;
+
                 port_def = param;
-                memcpy (port_def, &private->ports[port_def->nPortIndex].port_def, port_def->nSize);
+                port = get_port (private, port_def->nPortIndex);
+                if (!port)
+                {
+                    error = OMX_ErrorBadPortIndex;
+                    break;
+                }
+                memcpy (port_def, &port->port_def, port_def->nSize);
+                break;
+            }
+        case OMX_IndexParamStandardComponentRole:
+            {
+                OMX_PARAM_COMPONENTROLETYPE *role;
+
+                role = param;
+                g_strlcpy ((gchar *) role->cRole, role_names[private->role],
+                           OMX_MAX_STRINGNAME_SIZE);
                 break;
             }
         default:
             break;
     }
 
-    return OMX_ErrorNone;
+    g_mutex_unlock (private->mutex);
+
+    return error;
 }
 
 static OMX_ERRORTYPE
@@ -120,28 +489,106 @@ comp_SetParameter (OMX_HANDLETYPE handle,
 {
     OMX_COMPONENTTYPE *comp;
     CompPrivate *private;
+    OMX_ERRORTYPE error = OMX_ErrorNone;
 
     /* printf ("SetParameter\n"); */
 
     comp = handle;
     private = comp->pComponentPrivate;
 
+    g_mutex_lock (private->mutex);
+
     switch (index)
     {
         case OMX_IndexParamPortDefinition:
             {
                 OMX_PARAM_PORTDEFINITIONTYPE *port_def;
+                CompPrivatePort *port;
+
                 port_def = param;
-                memcpy (&private->ports[port_def->nPortIndex].port_def, port_def, port_def->nSize);
+                port = get_port (private, port_def->nPortIndex);
+                if (!port)
+                {
+                    error = OMX_ErrorBadPortIndex;
+                    break;
+                }
+                memcpy (&port->port_def, port_def, port_def->nSize);
+                break;
+            }
+        case OMX_IndexParamStandardComponentRole:
+            {
+                OMX_PARAM_COMPONENTROLETYPE *role;
+                guint i;
+
+                if (private->state != OMX_StateLoaded)
+                {
+                    error = OMX_ErrorIncorrectStateOperation;
+                    break;
+                }
+
+                role = param;
+                for (i = 0; i < G_N_ELEMENTS (role_names); i++)
+                {
+                    if (strcmp ((gchar *) role->cRole, role_names[i]) == 0)
+                        break;
+                }
+
+                /* keep the current role for roles we do not know, e.g. an
+                 * element's default role
+                 */
+                if (i < G_N_ELEMENTS (role_names) && i != private->role)
+                {
+                    private->role = i;
+                    setup_ports (comp);
+                }
                 break;
             }
         default:
             break;
     }
 
+    g_mutex_unlock (private->mutex);
+
+    return error;
+}
+
+static OMX_ERRORTYPE
+comp_GetConfig (OMX_HANDLETYPE handle,
+                OMX_INDEXTYPE index,
+                OMX_PTR config)
+{
+    return OMX_ErrorUnsupportedIndex;
+}
+
+/* accepted and ignored, e.g. the per channel resolution of VFPC elements */
+static OMX_ERRORTYPE
+comp_SetConfig (OMX_HANDLETYPE handle,
+                OMX_INDEXTYPE index,
+                OMX_PTR config)
+{
     return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+comp_GetExtensionIndex (OMX_HANDLETYPE handle,
+                        OMX_STRING name,
+                        OMX_INDEXTYPE *index)
+{
+    return OMX_ErrorUnsupportedIndex;
+}
+
+static void
+set_port_enabled (CompPrivate *private, OMX_U32 index, gboolean enabled)
+{
+    guint i;
+
+    for (i = 0; i < private->num_ports; i++)
+    {
+        if (private->ports[i].valid && (index == OMX_ALL || index == i))
+            private->ports[i].port_def.bEnabled = enabled;
+    }
+}
+
 static OMX_ERRORTYPE
 comp_SendCommand (OMX_HANDLETYPE handle,
                   OMX_COMMANDTYPE command,
@@ -160,11 +607,29 @@ comp_SendCommand (OMX_HANDLETYPE handle,
     {
         case OMX_CommandStateSet:
             {
-                if (private->state == OMX_StateLoaded && param_1 == OMX_StateIdle)
+                OMX_STATETYPE old_state = private->state;
+
+                if (old_state == OMX_StateLoaded && param_1 == OMX_StateIdle)
+                {
+                    start_channels (comp);
+                }
+                else if (old_state == OMX_StateIdle && param_1 == OMX_StateLoaded)
                 {
-                    g_thread_create (foo_thread, comp, TRUE, NULL);
+                    stop_channels (comp);
                 }
+
+                g_mutex_lock (private->mutex);
                 private->state = param_1;
+                if (param_1 == OMX_StateIdle &&
+                    (old_state == OMX_StateExecuting || old_state == OMX_StatePause))
+                {
+                    /* all buffers go back to the client on the way to idle */
+                    wait_idle (private);
+                    return_queued (comp, OMX_ALL);
+                }
+                g_cond_broadcast (private->cond);
+                g_mutex_unlock (private->mutex);
+
                 private->callbacks->EventHandler (handle,
                                                   private->app_data, OMX_EventCmdComplete,
                                                   OMX_CommandStateSet, private->state, data);
@@ -172,27 +637,34 @@ comp_SendCommand (OMX_HANDLETYPE handle,
             break;
         case  OMX_CommandFlush:
             {
-                g_mutex_lock (private->flush_mutex);
+                g_mutex_lock (private->mutex);
+                wait_idle (private);
+                return_queued (comp, param_1);
+                g_mutex_unlock (private->mutex);
+
+                private->callbacks->EventHandler (handle,
+                                                  private->app_data, OMX_EventCmdComplete,
+                                                  OMX_CommandFlush, param_1, data);
+            }
+            break;
+        case OMX_CommandPortDisable:
+        case OMX_CommandPortEnable:
+            {
+                gboolean enable = (command == OMX_CommandPortEnable);
+
+                g_mutex_lock (private->mutex);
+                if (!enable)
                 {
-                    OMX_BUFFERHEADERTYPE *buffer;
-
-                    while (buffer = async_queue_pop_full (private->ports[0].queue, FALSE, TRUE))
-                    {
-                        private->callbacks->EmptyBufferDone (comp,
-                                                             private->app_data, buffer);
-                    }
-
-                    while (buffer = async_queue_pop_full (private->ports[1].queue, FALSE, TRUE))
-                    {
-                        private->callbacks->FillBufferDone (comp,
-                                                            private->app_data, buffer);
-                    }
+                    wait_idle (private);
+                    return_queued (comp, param_1);
                 }
-                g_mutex_unlock (private->flush_mutex);
+                set_port_enabled (private, param_1, enable);
+                g_cond_broadcast (private->cond);
+                g_mutex_unlock (private->mutex);
 
                 private->callbacks->EventHandler (handle,
                                                   private->app_data, OMX_EventCmdComplete,
-                                                  OMX_CommandFlush, param_1, data);
+                                                  command, param_1, data);
             }
             break;
         default:
@@ -203,6 +675,36 @@ comp_SendCommand (OMX_HANDLETYPE handle,
     return OMX_ErrorNone;
 }
 
+static OMX_BUFFERHEADERTYPE *
+new_buffer_header (CompPrivate *private,
+                   OMX_U32 index,
+                   OMX_PTR data,
+                   OMX_U32 size,
+                   OMX_U8 *buffer,
+                   gboolean allocated)
+{
+    OMX_BUFFERHEADERTYPE *new;
+    CompBuffer *comp_buffer;
+
+    new = calloc (1, sizeof (OMX_BUFFERHEADERTYPE));
+    new->nSize = sizeof (OMX_BUFFERHEADERTYPE);
+    new->nVersion.nVersion = 1;
+    new->pBuffer = buffer;
+    new->nAllocLen = size;
+    new->pAppPrivate = data;
+
+    if (is_input_port (private, index))
+        new->nInputPortIndex = index;
+    else
+        new->nOutputPortIndex = index;
+
+    comp_buffer = calloc (1, sizeof (CompBuffer));
+    comp_buffer->allocated = allocated;
+    new->pPlatformPrivate = comp_buffer;
+
+    return new;
+}
+
 static OMX_ERRORTYPE
 comp_UseBuffer (OMX_HANDLETYPE handle,
                 OMX_BUFFERHEADERTYPE **buffer_header,
@@ -211,22 +713,41 @@ comp_UseBuffer (OMX_HANDLETYPE handle,
                 OMX_U32 size,
                 OMX_U8 *buffer)
 {
-    OMX_BUFFERHEADERTYPE *new;
+    OMX_COMPONENTTYPE *comp;
+    CompPrivate *private;
 
-    new = calloc (1, sizeof (OMX_BUFFERHEADERTYPE));
-    new->nSize = sizeof (OMX_BUFFERHEADERTYPE);
-    new->nVersion.nVersion = 1;
-    new->pBuffer = buffer;
-    new->nAllocLen = size;
+    comp = handle;
+    private = comp->pComponentPrivate;
 
-    switch (index)
-    {
-        case 0: new->nInputPortIndex = 0; break;
-        case 1: new->nOutputPortIndex = 1; break;
-        default: break;
-    }
+    if (!get_port (private, index))
+        return OMX_ErrorBadPortIndex;
+
+    *buffer_header = new_buffer_header (private, index, data, size, buffer, FALSE);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+comp_AllocateBuffer (OMX_HANDLETYPE handle,
+                     OMX_BUFFERHEADERTYPE **buffer_header,
+                     OMX_U32 index,
+                     OMX_PTR data,
+                     OMX_U32 size)
+{
+    OMX_COMPONENTTYPE *comp;
+    CompPrivate *private;
+    void *buffer;
+
+    comp = handle;
+    private = comp->pComponentPrivate;
+
+    if (!get_port (private, index))
+        return OMX_ErrorBadPortIndex;
 
-    *buffer_header = new;
+    if (posix_memalign (&buffer, BUFFER_ALIGN, MAX (size, 1)) != 0)
+        return OMX_ErrorInsufficientResources;
+
+    *buffer_header = new_buffer_header (private, index, data, size, buffer, TRUE);
 
     return OMX_ErrorNone;
 }
@@ -236,90 +757,266 @@ comp_FreeBuffer (OMX_HANDLETYPE handle,
                  OMX_U32 index,
                  OMX_BUFFERHEADERTYPE *buffer_header)
 {
+    CompBuffer *comp_buffer;
+
+    comp_buffer = buffer_header->pPlatformPrivate;
+
+    if (comp_buffer->allocated)
+        free (buffer_header->pBuffer);
+
+    free (comp_buffer);
     free (buffer_header);
 
     return OMX_ErrorNone;
 }
 
+/* model the processing time of one buffer, returns the time spent */
+static guint64
+process_delay (CompChannel *channel)
+{
+    CompPrivate *private;
+    guint64 start, delay_ns;
+    guint delay_us;
+
+    private = channel->comp->pComponentPrivate;
+
+    delay_us = private->config.latency_us;
+    if (private->config.jitter_us)
+        delay_us += g_rand_int_range (channel->rand, 0, private->config.jitter_us + 1);
+
+    if (!delay_us)
+        return 0;
+
+    start = now_ns ();
+    delay_ns = (guint64) delay_us * 1000;
+
+    if (delay_us > SPIN_THRESHOLD_US)
+        g_usleep (delay_us - SPIN_THRESHOLD_US);
+
+    while (now_ns () - start < delay_ns)
+        ;
+
+    return now_ns () - start;
+}
+
+/* fill @out from @in according to the role, returns TRUE once @in is
+ * fully consumed
+ */
+static gboolean
+process_buffers (CompChannel *channel,
+                 OMX_BUFFERHEADERTYPE *in_buffer,
+                 OMX_BUFFERHEADERTYPE *out_buffer)
+{
+    CompPrivate *private;
+    unsigned long size;
+
+    private = channel->comp->pComponentPrivate;
+
+    out_buffer->nOffset = 0;
+    out_buffer->nTimeStamp = in_buffer->nTimeStamp;
+    out_buffer->nFlags = in_buffer->nFlags;
+
+    switch (private->role)
+    {
+        case ROLE_SCALER:
+            {
+                OMX_PARAM_PORTDEFINITIONTYPE *port_def;
+
+                /* every input frame becomes one full output frame */
+                port_def = &private->ports[channel->out_port].port_def;
+                size = MIN (in_buffer->nFilledLen, out_buffer->nAllocLen);
+                memcpy (out_buffer->pBuffer, in_buffer->pBuffer + in_buffer->nOffset, size);
+                out_buffer->nFilledLen = MIN (port_def->nBufferSize, out_buffer->nAllocLen);
+                in_buffer->nFilledLen = 0;
+                break;
+            }
+        case ROLE_ENCODER:
+            {
+                /* sync frames compress to about a quarter of the input,
+                 * the others to between 1/64 and 1/16 of it
+                 */
+                if (channel->frame % private->config.gop == 0)
+                {
+                    size = in_buffer->nFilledLen / 4;
+                    out_buffer->nFlags |= OMX_BUFFERFLAG_SYNCFRAME;
+                }
+                else
+                {
+                    size = in_buffer->nFilledLen /
+                        g_rand_int_range (channel->rand, 16, 65);
+                }
+
+                if (in_buffer->nFilledLen)
+                    size = CLAMP (size, 1, out_buffer->nAllocLen);
+
+                memcpy (out_buffer->pBuffer, in_buffer->pBuffer + in_buffer->nOffset,
+                        MIN (size, in_buffer->nFilledLen));
+                out_buffer->nFilledLen = size;
+                in_buffer->nFilledLen = 0;
+                break;
+            }
+        default:
+            {
+                size = MIN (in_buffer->nFilledLen, out_buffer->nAllocLen);
+                memcpy (out_buffer->pBuffer, in_buffer->pBuffer + in_buffer->nOffset, size);
+                out_buffer->nFilledLen = size;
+                in_buffer->nFilledLen -= size;
+                in_buffer->nOffset += size;
+
+                if (in_buffer->nFilledLen)
+                    out_buffer->nFlags &= ~OMX_BUFFERFLAG_EOS;
+                break;
+            }
+    }
+
+    channel->frame++;
+
+    return in_buffer->nFilledLen == 0;
+}
+
+static inline gboolean
+channel_ready (CompPrivate *private, CompChannel *channel)
+{
+    CompPrivatePort *in_port = &private->ports[channel->in_port];
+    CompPrivatePort *out_port = &private->ports[channel->out_port];
+
+    return private->state == OMX_StateExecuting &&
+        in_port->port_def.bEnabled && out_port->port_def.bEnabled &&
+        !g_queue_is_empty (&in_port->queue) &&
+        !g_queue_is_empty (&out_port->queue);
+}
+
 static gpointer
-foo_thread (gpointer cb_data)
+channel_thread (gpointer cb_data)
 {
+    CompChannel *channel;
     OMX_COMPONENTTYPE *comp;
     CompPrivate *private;
 
-    comp = cb_data;
+    channel = cb_data;
+    comp = channel->comp;
     private = comp->pComponentPrivate;
 
+    g_mutex_lock (private->mutex);
+
     while (!private->done)
     {
         OMX_BUFFERHEADERTYPE *in_buffer;
         OMX_BUFFERHEADERTYPE *out_buffer;
+        guint64 delay;
+        gboolean consumed;
 
-        in_buffer = async_queue_pop (private->ports[0].queue);
-        if (!in_buffer) continue;
-
-        out_buffer = async_queue_pop (private->ports[1].queue);
-        if (!out_buffer) continue;
-
-        /* process buffers */
+        if (!channel_ready (private, channel))
         {
-            unsigned long size;
-            size = MIN (in_buffer->nFilledLen, out_buffer->nAllocLen);
-            memcpy (out_buffer->pBuffer, in_buffer->pBuffer, size);
-            out_buffer->nFilledLen = size;
-            in_buffer->nFilledLen -= size;
-            out_buffer->nTimeStamp = in_buffer->nTimeStamp;
-            out_buffer->nFlags = in_buffer->nFlags;
+            g_cond_wait (private->cond, private->mutex);
+            continue;
         }
 
-        g_mutex_lock (private->flush_mutex);
+        in_buffer = g_queue_pop_head (&private->ports[channel->in_port].queue);
+        out_buffer = g_queue_pop_head (&private->ports[channel->out_port].queue);
+        channel->busy = TRUE;
 
-        private->callbacks->FillBufferDone (comp,
-                                            private->app_data, out_buffer);
-        if (in_buffer->nFilledLen == 0)
-        {
-            private->callbacks->EmptyBufferDone (comp,
-                                                 private->app_data, in_buffer);
-        }
+        g_mutex_unlock (private->mutex);
+
+        delay = process_delay (channel);
+        consumed = process_buffers (channel, in_buffer, out_buffer);
+
+        G_LOCK (bench);
+        stats.processing_ns += delay;
+        stats.produced++;
+        stats.bytes_out += out_buffer->nFilledLen;
+        if (consumed)
+            stats.processed++;
+        G_UNLOCK (bench);
+
+        g_mutex_lock (private->mutex);
+
+        channel->busy = FALSE;
 
-        g_mutex_unlock (private->flush_mutex);
+        return_buffer (comp, out_buffer, FALSE);
+        if (consumed)
+            return_buffer (comp, in_buffer, TRUE);
+        else
+            g_queue_push_head (&private->ports[channel->in_port].queue, in_buffer);
+
+        /* flush, disable or a state change may be waiting for us */
+        g_cond_broadcast (private->cond);
     }
 
+    g_mutex_unlock (private->mutex);
+
     return NULL;
 }
 
 static OMX_ERRORTYPE
-comp_EmptyThisBuffer (OMX_HANDLETYPE handle,
-                      OMX_BUFFERHEADERTYPE *buffer_header)
+queue_buffer (OMX_HANDLETYPE handle,
+              OMX_BUFFERHEADERTYPE *buffer_header,
+              guint index,
+              gboolean input)
 {
     OMX_COMPONENTTYPE *comp;
     CompPrivate *private;
-
-    /* printf ("EmptyThisBuffer\n"); */
+    CompPrivatePort *port;
+    OMX_ERRORTYPE error = OMX_ErrorNone;
 
     comp = handle;
     private = comp->pComponentPrivate;
 
-    async_queue_push (private->ports[0].queue, buffer_header);
+    account_turnaround (buffer_header, input);
 
-    return OMX_ErrorNone;
+    g_mutex_lock (private->mutex);
+
+    port = get_port (private, index);
+    if (!port)
+    {
+        error = OMX_ErrorBadPortIndex;
+    }
+    else if (!port->port_def.bEnabled || is_input_port (private, index) != input)
+    {
+        error = OMX_ErrorIncorrectStateOperation;
+    }
+    else
+    {
+        g_queue_push_tail (&port->queue, buffer_header);
+        g_cond_broadcast (private->cond);
+    }
+
+    g_mutex_unlock (private->mutex);
+
+    return error;
+}
+
+static OMX_ERRORTYPE
+comp_EmptyThisBuffer (OMX_HANDLETYPE handle,
+                      OMX_BUFFERHEADERTYPE *buffer_header)
+{
+    /* printf ("EmptyThisBuffer\n"); */
+
+    return queue_buffer (handle, buffer_header, buffer_header->nInputPortIndex, TRUE);
 }
 
 static OMX_ERRORTYPE
 comp_FillThisBuffer (OMX_HANDLETYPE handle,
                      OMX_BUFFERHEADERTYPE *buffer_header)
 {
-    OMX_COMPONENTTYPE *comp;
-    CompPrivate *private;
-
     /* printf ("FillThisBuffer\n"); */
 
-    comp = handle;
-    private = comp->pComponentPrivate;
+    return queue_buffer (handle, buffer_header, buffer_header->nOutputPortIndex, FALSE);
+}
+
+static CompRole
+role_from_name (const gchar *component_name)
+{
+    if (!component_name)
+        return ROLE_PASSTHROUGH;
 
-    async_queue_push (private->ports[1].queue, buffer_header);
+    if (strstr (component_name, "scaler") || strstr (component_name, "VFPC"))
+        return ROLE_SCALER;
 
-    return OMX_ErrorNone;
+    if (strstr (component_name, "encoder") || strstr (component_name, "VIDENC"))
+        return ROLE_ENCODER;
+
+    return ROLE_PASSTHROUGH;
 }
 
 OMX_ERRORTYPE
@@ -337,8 +1034,12 @@ OMX_GetHandle (OMX_HANDLETYPE *handle,
     comp->GetState = comp_GetState;
     comp->GetParameter = comp_GetParameter;
     comp->SetParameter = comp_SetParameter;
+    comp->GetConfig = comp_GetConfig;
+    comp->SetConfig = comp_SetConfig;
+    comp->GetExtensionIndex = comp_GetExtensionIndex;
     comp->SendCommand = comp_SendCommand;
     comp->UseBuffer = comp_UseBuffer;
+    comp->AllocateBuffer = comp_AllocateBuffer;
     comp->FreeBuffer = comp_FreeBuffer;
     comp->EmptyThisBuffer = comp_EmptyThisBuffer;
     comp->FillThisBuffer = comp_FillThisBuffer;
@@ -350,42 +1051,15 @@ OMX_GetHandle (OMX_HANDLETYPE *handle,
         private->state = OMX_StateLoaded;
         private->callbacks = callbacks;
         private->app_data = data;
-        private->ports = calloc (2, sizeof (CompPrivatePort));
-        private->flush_mutex = g_mutex_new ();
+        private->role = role_from_name (component_name);
+        private->mutex = g_mutex_new ();
+        private->cond = g_cond_new ();
 
-        private->ports[0].queue = async_queue_new ();
-        private->ports[1].queue = async_queue_new ();
-
-        {
-            OMX_PARAM_PORTDEFINITIONTYPE *port_def;
-
-            port_def = &private->ports[0].port_def;
-            port_def->nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
-            port_def->nVersion.nVersion = 1;
-            port_def->nPortIndex = 0;
-            port_def->eDir = OMX_DirInput;
-            port_def->nBufferCountActual = 1;
-            port_def->nBufferCountMin = 1;
-            port_def->nBufferSize = 0x1000;
-            port_def->eDomain = OMX_PortDomainAudio;
-
-        }
-
-        {
-            OMX_PARAM_PORTDEFINITIONTYPE *port_def;
-
-            port_def = &private->ports[1].port_def;
-            port_def->nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
-            port_def->nVersion.nVersion = 1;
-            port_def->nPortIndex = 1;
-            port_def->eDir = OMX_DirOutput;
-            port_def->nBufferCountActual = 1;
-            port_def->nBufferCountMin = 1;
-            port_def->nBufferSize = 0x1000;
-            port_def->eDomain = OMX_PortDomainAudio;
-        }
+        bench_core_get_config (&private->config);
 
         comp->pComponentPrivate = private;
+
+        setup_ports (comp);
     }
 
     *handle = comp;
@@ -396,6 +1070,24 @@ OMX_GetHandle (OMX_HANDLETYPE *handle,
 OMX_ERRORTYPE
 OMX_FreeHandle (OMX_HANDLETYPE handle)
 {
-    /** @todo Free private structure? */
+    OMX_COMPONENTTYPE *comp;
+    CompPrivate *private;
+    guint i;
+
+    comp = handle;
+    private = comp->pComponentPrivate;
+
+    stop_channels (comp);
+
+    for (i = 0; i < private->num_channels; i++)
+        g_rand_free (private->channels[i].rand);
+
+    g_free (private->channels);
+    g_free (private->ports);
+    g_cond_free (private->cond);
+    g_mutex_free (private->mutex);
+    free (private);
+    free (comp);
+
     return OMX_ErrorNone;
 }
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <glib.h>
+
+#ifdef __linux__
+#  include <unistd.h>
+#  include <limits.h>
+#  include <sys/syscall.h>
+#  include <linux/futex.h>
+#endif
+
+#include "async_ring.h"
+
+#define RING_SPIN_COUNT 200
+
+/*
+ * The ring is a bounded multi-producer/multi-consumer queue: every cell
+ * carries a sequence number telling whether it is ready to be written
+ * (sequence == position) or read (sequence == position + 1) for a given
+ * lap around the ring.  Producers and consumers claim positions with a
+ * compare-and-exchange on tail/head, so neither side ever blocks the other.
+ */
+
+static inline gint
+seq_diff (gint a, gint b)
+{
+    return (gint) ((guint) a - (guint) b);
+}
+
+static guint
+round_capacity (guint capacity)
+{
+    guint n = 2;
+
+    while (n < capacity)
+        n <<= 1;
+
+    return n;
+}
+
+/*
+ * Cells for an empty ring whose next position is @pos.  The mask travels
+ * with the cells so that a thread always indexes an array with its own
+ * size, however late it loaded the pointer.
+ */
+static AsyncRingCells *
+cells_new (guint capacity, gint pos)
+{
+    AsyncRingCells *cells;
+    guint i;
+
+    cells = g_malloc0 (sizeof (AsyncRingCells) +
+                       (capacity - 1) * sizeof (AsyncRingCell));
+    cells->mask = capacity - 1;
+
+    for (i = 0; i < capacity; i++, pos++)
+        cells->cell[pos & cells->mask].sequence = pos;
+
+    return cells;
+}
+
+/*
+ * Sleeping/waking.  A waiter samples ring->signal, re-checks its condition
+ * and then sleeps only if signal has not moved in between, so a wake-up can
+ * never be lost.  A push wakes a single waiter, since it only makes one
+ * entry available; disable wakes them all.
+ */
+
+#ifdef __linux__
+
+static inline void
+ring_sleep (AsyncRing *ring, gint seen)
+{
+    syscall (SYS_futex, &ring->signal, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+}
+
+static inline void
+ring_wake (AsyncRing *ring, gboolean all)
+{
+    g_atomic_int_inc (&ring->signal);
+
+    if (g_atomic_int_get (&ring->waiters))
+        syscall (SYS_futex, &ring->signal, FUTEX_WAKE_PRIVATE,
+                 all ? INT_MAX : 1, NULL, NULL, 0);
+}
+
+#else
+
+static inline void
+ring_sleep (AsyncRing *ring, gint seen)
+{
+    g_mutex_lock (ring->mutex);
+    if (g_atomic_int_get (&ring->signal) == seen)
+        g_cond_wait (ring->condition, ring->mutex);
+    g_mutex_unlock (ring->mutex);
+}
+
+static inline void
+ring_wake (AsyncRing *ring, gboolean all)
+{
+    g_atomic_int_inc (&ring->signal);
+
+    if (g_atomic_int_get (&ring->waiters))
+    {
+        g_mutex_lock (ring->mutex);
+        if (all)
+            g_cond_broadcast (ring->condition);
+        else
+            g_cond_signal (ring->condition);
+        g_mutex_unlock (ring->mutex);
+    }
+}
+
+#endif
+
+AsyncRing *
+async_ring_new (guint capacity)
+{
+    AsyncRing *ring;
+
+    ring = g_slice_new0 (AsyncRing);
+
+    ring->cells = cells_new (round_capacity (capacity), 0);
+    ring->enabled = TRUE;
+
+#ifndef __linux__
+    ring->condition = g_cond_new ();
+    ring->mutex = g_mutex_new ();
+#endif
+
+    return ring;
+}
+
+void
+async_ring_free (AsyncRing *ring)
+{
+#ifndef __linux__
+    g_cond_free (ring->condition);
+    g_mutex_free (ring->mutex);
+#endif
+
+    g_slist_foreach (ring->retired, (GFunc) g_free, NULL);
+    g_slist_free (ring->retired);
+    g_free (ring->cells);
+    g_slice_free (AsyncRing, ring);
+}
+
+/**
+ * Make sure the ring can hold at least @capacity entries.  This may only
+ * be called while the ring is empty and nothing pushes to it, for example
+ * before the buffers it will carry are allocated.
+ *
+ * Other threads may be popping, or waiting in a pop, meanwhile: the new
+ * cells continue from the current position and are published with a
+ * single pointer store, and the old ones are kept until the ring is freed.
+ * A pop still looking at the old cells finds them empty, as they are, and
+ * picks up the new ones on its next attempt.
+ */
+void
+async_ring_reserve (AsyncRing *ring, guint capacity)
+{
+    AsyncRingCells *cells;
+
+    capacity = round_capacity (capacity);
+
+    if (capacity <= ring->cells->mask + 1)
+        return;
+
+    g_return_if_fail (async_ring_length (ring) == 0);
+
+    cells = cells_new (capacity, g_atomic_int_get (&ring->head));
+
+    ring->retired = g_slist_prepend (ring->retired, ring->cells);
+    g_atomic_pointer_set (&ring->cells, cells);
+}
+
+static gboolean
+ring_enqueue (AsyncRing *ring, gpointer data)
+{
+    AsyncRingCells *cells;
+    AsyncRingCell *cell;
+    gint pos;
+
+    cells = g_atomic_pointer_get (&ring->cells);
+    pos = g_atomic_int_get (&ring->tail);
+
+    for (;;)
+    {
+        gint diff;
+
+        cell = &cells->cell[pos & cells->mask];
+        diff = seq_diff (g_atomic_int_get (&cell->sequence), pos);
+
+        if (diff == 0)
+        {
+            if (g_atomic_int_compare_and_exchange (&ring->tail, pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return FALSE; /* full */
+        }
+
+        pos = g_atomic_int_get (&ring->tail);
+    }
+
+    cell->data = data;
+    g_atomic_int_set (&cell->sequence, pos + 1);
+
+    return TRUE;
+}
+
+static gpointer
+ring_dequeue (AsyncRing *ring)
+{
+    AsyncRingCells *cells;
+    AsyncRingCell *cell;
+    gpointer data;
+    gint pos;
+
+    cells = g_atomic_pointer_get (&ring->cells);
+    pos = g_atomic_int_get (&ring->head);
+
+    for (;;)
+    {
+        gint diff;
+
+        cell = &cells->cell[pos & cells->mask];
+        diff = seq_diff (g_atomic_int_get (&cell->sequence), pos + 1);
+
+        if (diff == 0)
+        {
+            if (g_atomic_int_compare_and_exchange (&ring->head, pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return NULL; /* empty */
+        }
+
+        pos = g_atomic_int_get (&ring->head);
+    }
+
+    data = cell->data;
+    g_atomic_int_set (&cell->sequence, pos + cells->mask + 1);
+
+    return data;
+}
+
+/**
+ * Push @data onto the ring.  Returns FALSE if the ring is full; callers
+ * size the ring so that this cannot happen for a well behaved component.
+ */
+gboolean
+async_ring_push (AsyncRing *ring,
+                 gpointer data)
+{
+    if (G_UNLIKELY (!ring_enqueue (ring, data)))
+        return FALSE;
+
+    ring_wake (ring, FALSE);
+
+    return TRUE;
+}
+
+/**
+ * Same contract as async_queue_pop_full(): without @force nothing is
+ * returned from a disabled ring, and a waiting pop returns NULL when the
+ * ring is disabled underneath it.
+ */
+gpointer
+async_ring_pop_full (AsyncRing *ring, gboolean wait, gboolean force)
+{
+    gpointer data;
+    gint disabled;
+    guint spin;
+
+    /* sample before checking enabled, so a racing disable is never missed */
+    disabled = g_atomic_int_get (&ring->disabled);
+
+    if (!force && !g_atomic_int_get (&ring->enabled))
+    {
+        /* g_warning ("not enabled!"); */
+        return NULL;
+    }
+
+    data = ring_dequeue (ring);
+
+    if (data || !wait)
+        return data;
+
+    /* buffers usually come back within a few hundred cycles of each other,
+     * so spin a little before paying for a sleep and the matching wake-up
+     */
+    for (spin = 0; spin < RING_SPIN_COUNT; spin++)
+    {
+        data = ring_dequeue (ring);
+        if (data)
+            return data;
+
+        if (g_atomic_int_get (&ring->disabled) != disabled)
+            return NULL;
+    }
+
+    g_atomic_int_inc (&ring->waiters);
+
+    for (;;)
+    {
+        gint seen = g_atomic_int_get (&ring->signal);
+
+        data = ring_dequeue (ring);
+        if (data)
+            break;
+
+        if (g_atomic_int_get (&ring->disabled) != disabled)
+            break;
+
+        ring_sleep (ring, seen);
+    }
+
+    g_atomic_int_add (&ring->waiters, -1);
+
+    return data;
+}
+
+gpointer
+async_ring_pop (AsyncRing *ring)
+{
+    return async_ring_pop_full (ring, TRUE, FALSE);
+}
+
+void
+async_ring_disable (AsyncRing *ring)
+{
+    g_atomic_int_set (&ring->enabled, FALSE);
+    g_atomic_int_inc (&ring->disabled);
+    ring_wake (ring, TRUE);
+}
+
+void
+async_ring_enable (AsyncRing *ring)
+{
+    g_atomic_int_set (&ring->enabled, TRUE);
+}
+
+void
+async_ring_flush (AsyncRing *ring)
+{
+    while (ring_dequeue (ring))
+        ;
+}
+
+guint
+async_ring_length (AsyncRing *ring)
+{
+    return (guint) seq_diff (g_atomic_int_get (&ring->tail),
+                             g_atomic_int_get (&ring->head));
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef ASYNC_RING_H
+#define ASYNC_RING_H
+
+#include <glib.h>
+
+/*
+ * Fixed-capacity variant of AsyncQueue.  Push and pop never allocate and
+ * never take a lock; a blocked pop sleeps on a futex (or a GCond where
+ * futexes are not available) and is woken by push or disable.
+ *
+ * Any number of threads may push and pop concurrently.  The capacity is
+ * rounded up to a power of two and can be grown with async_ring_reserve()
+ * while the ring is empty and nothing pushes to it; threads popping or
+ * waiting in a pop may keep doing so.
+ */
+
+typedef struct AsyncRing AsyncRing;
+typedef struct AsyncRingCell AsyncRingCell;
+typedef struct AsyncRingCells AsyncRingCells;
+
+struct AsyncRingCell
+{
+    volatile gint sequence;
+    gpointer data;
+};
+
+struct AsyncRingCells
+{
+    guint mask;
+    AsyncRingCell cell[1];
+};
+
+struct AsyncRing
+{
+    AsyncRingCells * volatile cells;
+    GSList *retired;            /**< cells replaced by async_ring_reserve() */
+
+    volatile gint head;         /**< next position to pop */
+    volatile gint tail;         /**< next position to push */
+
+    volatile gint enabled;
+    volatile gint signal;       /**< bumped on every push and disable */
+    volatile gint disabled;     /**< bumped on every disable */
+    volatile gint waiters;
+
+#ifndef __linux__
+    GMutex *mutex;
+    GCond *condition;
+#endif
+};
+
+AsyncRing *async_ring_new (guint capacity);
+void async_ring_free (AsyncRing *ring);
+void async_ring_reserve (AsyncRing *ring, guint capacity);
+gboolean async_ring_push (AsyncRing *ring, gpointer data);
+gpointer async_ring_pop_full (AsyncRing *ring, gboolean wait, gboolean force);
+gpointer async_ring_pop (AsyncRing *ring);
+void async_ring_disable (AsyncRing *ring);
+void async_ring_enable (AsyncRing *ring);
+void async_ring_flush (AsyncRing *ring);
+guint async_ring_length (AsyncRing *ring);
+
+#endif /* ASYNC_RING_H */
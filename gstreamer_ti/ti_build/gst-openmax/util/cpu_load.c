@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <glib.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpu_load.h"
+
+#define STAT_BUFFER_SIZE 4096
+
+struct CpuLoad
+{
+    gint fd;
+    /* index 0 is the aggregate "cpu" line, N + 1 is "cpuN" */
+    guint64 prev_busy[CPU_LOAD_MAX_CPUS + 1];
+    guint64 prev_total[CPU_LOAD_MAX_CPUS + 1];
+};
+
+struct CpuLoadThread
+{
+    gint tid;
+    gint fd;
+    guint64 prev_ticks;
+    guint64 prev_time;
+};
+
+static gssize
+read_stat (gint fd,
+           gchar *buffer,
+           gsize size)
+{
+    gssize r;
+
+    if (fd < 0 || lseek (fd, 0, SEEK_SET) < 0)
+        return -1;
+
+    r = read (fd, buffer, size - 1);
+    if (r <= 0)
+        return -1;
+    buffer[r] = '\0';
+
+    return r;
+}
+
+static guint64
+monotonic_time (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (guint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+CpuLoad *
+cpu_load_new (void)
+{
+    CpuLoad *load;
+
+    load = g_new0 (CpuLoad, 1);
+    load->fd = open ("/proc/stat", O_RDONLY);
+
+    /* take the baseline */
+    cpu_load_sample (load, NULL, NULL);
+
+    return load;
+}
+
+void
+cpu_load_free (CpuLoad *load)
+{
+    if (load->fd >= 0)
+        close (load->fd);
+
+    g_free (load);
+}
+
+/**
+ * Sample the load since the previous call.  The "cpu" lines of /proc/stat
+ * are user, nice, system, idle, iowait, irq, softirq and steal jiffies;
+ * everything but idle and iowait counts as busy.  The system load goes to
+ * total and the per-core loads to cores (CPU_LOAD_MAX_CPUS entries); either
+ * may be NULL.  Returns the number of cores, or -1 if /proc/stat can't be
+ * read.
+ */
+gint
+cpu_load_sample (CpuLoad *load,
+                 guint16 *total,
+                 guint16 *cores)
+{
+    gchar buffer[STAT_BUFFER_SIZE];
+    gchar *line, *end;
+    gint cpus = 0;
+
+    if (read_stat (load->fd, buffer, sizeof (buffer)) < 0)
+        return -1;
+
+    for (line = buffer; line && *line; line = end)
+    {
+        guint64 value[8] = { 0 };
+        guint64 busy, sum;
+        guint index, i;
+        gchar *p;
+
+        end = strchr (line, '\n');
+        if (end)
+            end++;
+
+        if (strncmp (line, "cpu", 3) != 0)
+            break;
+
+        if (line[3] == ' ')
+        {
+            index = 0;
+            p = line + 3;
+        }
+        else
+        {
+            index = strtoul (line + 3, &p, 10) + 1;
+            if (index > CPU_LOAD_MAX_CPUS)
+                continue;
+        }
+
+        sum = 0;
+        for (i = 0; i < G_N_ELEMENTS (value); i++)
+        {
+            value[i] = g_ascii_strtoull (p, &p, 10);
+            sum += value[i];
+        }
+        busy = sum - value[3] - value[4];
+
+        if (sum > load->prev_total[index])
+        {
+            guint16 l = 1000 * (busy - load->prev_busy[index]) /
+                (sum - load->prev_total[index]);
+
+            if (index == 0 && total)
+                *total = l;
+            else if (index > 0 && cores)
+                cores[index - 1] = l;
+        }
+        load->prev_busy[index] = busy;
+        load->prev_total[index] = sum;
+
+        if (index > (guint) cpus)
+            cpus = index;
+    }
+
+    return cpus;
+}
+
+CpuLoadThread *
+cpu_load_thread_new (void)
+{
+    CpuLoadThread *thread;
+
+    thread = g_new0 (CpuLoadThread, 1);
+    thread->fd = -1;
+
+    return thread;
+}
+
+void
+cpu_load_thread_free (CpuLoadThread *thread)
+{
+    if (thread->fd >= 0)
+        close (thread->fd);
+
+    g_free (thread);
+}
+
+/**
+ * Sample the load of thread tid of this process since the previous call.
+ * The stat file is kept open as long as the same tid is passed.  The total
+ * CPU time the thread has used, in ns, goes to cpu_time if it is not NULL.
+ * Returns -1 on the first sample of a thread or if it has gone away.
+ */
+gint
+cpu_load_thread_sample (CpuLoadThread *thread,
+                        gint tid,
+                        guint64 *cpu_time)
+{
+    gchar buffer[1024];
+    guint64 utime, stime, ticks, now;
+    gint load = -1;
+    gchar *p;
+
+    if (tid != thread->tid)
+    {
+        gchar path[64];
+
+        if (thread->fd >= 0)
+            close (thread->fd);
+
+        g_snprintf (path, sizeof (path), "/proc/self/task/%d/stat", tid);
+        thread->fd = tid > 0 ? open (path, O_RDONLY) : -1;
+        thread->tid = tid;
+        thread->prev_time = 0;
+    }
+
+    if (read_stat (thread->fd, buffer, sizeof (buffer)) < 0)
+        return -1;
+
+    /* comm may contain anything, so skip to after its closing paren; utime
+     * and stime are fields 14 and 15, i.e. the 12th and 13th after comm */
+    p = strrchr (buffer, ')');
+    if (!p || sscanf (p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+                      "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
+                      &utime, &stime) != 2)
+        return -1;
+
+    ticks = utime + stime;
+    now = monotonic_time ();
+
+    if (thread->prev_time && now > thread->prev_time)
+    {
+        load = (ticks - thread->prev_ticks) * G_GUINT64_CONSTANT (1000000000000) /
+            (sysconf (_SC_CLK_TCK) * (now - thread->prev_time));
+    }
+
+    thread->prev_ticks = ticks;
+    thread->prev_time = now;
+
+    if (cpu_time)
+        *cpu_time = ticks * G_GUINT64_CONSTANT (1000000000) / sysconf (_SC_CLK_TCK);
+
+    return load;
+}
+
+/**
+ * The kernel thread id of the caller, as used in /proc/self/task.  It is
+ * cached per thread, so this is cheap enough to call for every buffer.
+ */
+gint
+cpu_load_get_tid (void)
+{
+    static __thread gint tid;
+
+    if (G_UNLIKELY (!tid))
+        tid = syscall (SYS_gettid);
+
+    return tid;
+}
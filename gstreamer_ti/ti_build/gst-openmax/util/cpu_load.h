@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include <glib.h>
+
+/*
+ * CPU load sampling from procfs.
+ *
+ * CpuLoad reports the load of the whole system and of every core since the
+ * previous sample, from a /proc/stat fd that stays open.  CpuLoadThread
+ * does the same for one thread of this process through
+ * /proc/self/task/<tid>/stat.  Loads are in 1/10 percent.
+ */
+
+#define CPU_LOAD_MAX_CPUS 8
+
+typedef struct CpuLoad CpuLoad;
+typedef struct CpuLoadThread CpuLoadThread;
+
+CpuLoad *cpu_load_new (void);
+void cpu_load_free (CpuLoad *load);
+gint cpu_load_sample (CpuLoad *load, guint16 *total, guint16 *cores);
+
+CpuLoadThread *cpu_load_thread_new (void);
+void cpu_load_thread_free (CpuLoadThread *thread);
+gint cpu_load_thread_sample (CpuLoadThread *thread, gint tid,
+                             guint64 *cpu_time);
+
+gint cpu_load_get_tid (void);
+
+#endif /* CPU_LOAD_H */
@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <glib.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cpu_load.h"
+#include "perf_trace.h"
+
+struct PerfTrace
+{
+    gchar *name;
+
+    PerfTraceRecord *records;
+    guint mask;
+    volatile gint head;         /**< records written, owned by the producer */
+    volatile gint tail;         /**< records flushed, owned by the flusher */
+
+    /* producer state */
+    guint32 dropped;
+    guint64 last_timestamp;
+    guint64 last_pts;
+
+    /* latest per-core load, written by the flusher */
+    volatile gint cpus;
+    volatile gint load[PERF_TRACE_MAX_CPUS];
+    CpuLoad *cpu_load;
+
+    /* output */
+    gint fd;
+    PerfTraceFlushFunc flush_func;
+    gpointer user_data;
+
+    GThread *thread;
+    GMutex *mutex;
+    GCond *cond;
+    gboolean running;
+    guint interval_ms;
+};
+
+static guint
+round_capacity (guint capacity)
+{
+    guint n = 2;
+
+    while (n < capacity)
+        n <<= 1;
+
+    return n;
+}
+
+static gboolean
+write_all (gint fd, gconstpointer data, gsize size)
+{
+    const gchar *p = data;
+    gssize r;
+
+    while (size > 0)
+    {
+        r = write (fd, p, size);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        p += r;
+        size -= r;
+    }
+
+    return TRUE;
+}
+
+static void
+sample_loads (PerfTrace *trace)
+{
+    guint16 load[CPU_LOAD_MAX_CPUS] = { 0 };
+    gint i, cpus;
+
+    cpus = cpu_load_sample (trace->cpu_load, NULL, load);
+    if (cpus < 0)
+        return;
+
+    cpus = MIN (cpus, PERF_TRACE_MAX_CPUS);
+    for (i = 0; i < cpus; i++)
+        g_atomic_int_set (&trace->load[i], load[i]);
+
+    g_atomic_int_set (&trace->cpus, cpus);
+}
+
+static void
+flush_records (PerfTrace *trace)
+{
+    guint tail, head, count;
+    const PerfTraceRecord *records;
+
+    tail = trace->tail;
+    head = g_atomic_int_get (&trace->head);
+
+    while (tail != head)
+    {
+        /* up to the end of the ring in one go */
+        count = MIN (head - tail, trace->mask + 1 - (tail & trace->mask));
+        records = &trace->records[tail & trace->mask];
+
+        if (trace->fd >= 0 &&
+            !write_all (trace->fd, records, count * sizeof (PerfTraceRecord)))
+        {
+            g_warning ("%s: failed to write trace: %s", trace->name,
+                       g_strerror (errno));
+            close (trace->fd);
+            trace->fd = -1;
+        }
+
+        if (trace->flush_func)
+            trace->flush_func (trace, records, count, trace->user_data);
+
+        tail += count;
+        g_atomic_int_set (&trace->tail, tail);
+    }
+}
+
+static gpointer
+flush_thread (gpointer data)
+{
+    PerfTrace *trace = data;
+    GTimeVal deadline;
+
+    g_mutex_lock (trace->mutex);
+    while (trace->running)
+    {
+        g_get_current_time (&deadline);
+        g_time_val_add (&deadline, trace->interval_ms * 1000);
+        g_cond_timed_wait (trace->cond, trace->mutex, &deadline);
+
+        g_mutex_unlock (trace->mutex);
+        sample_loads (trace);
+        flush_records (trace);
+        g_mutex_lock (trace->mutex);
+    }
+    g_mutex_unlock (trace->mutex);
+
+    return NULL;
+}
+
+PerfTrace *
+perf_trace_new (const gchar *name,
+                guint capacity)
+{
+    PerfTrace *trace;
+
+    trace = g_new0 (PerfTrace, 1);
+    trace->name = g_strdup (name);
+    trace->mask = round_capacity (capacity) - 1;
+    trace->records = g_new0 (PerfTraceRecord, trace->mask + 1);
+    trace->last_timestamp = G_MAXUINT64;
+    trace->last_pts = G_MAXUINT64;
+    trace->fd = -1;
+    trace->mutex = g_mutex_new ();
+    trace->cond = g_cond_new ();
+
+    trace->cpu_load = cpu_load_new ();
+
+    return trace;
+}
+
+void
+perf_trace_free (PerfTrace *trace)
+{
+    perf_trace_stop (trace);
+
+    if (trace->fd >= 0)
+        close (trace->fd);
+    cpu_load_free (trace->cpu_load);
+
+    g_cond_free (trace->cond);
+    g_mutex_free (trace->mutex);
+    g_free (trace->records);
+    g_free (trace->name);
+    g_free (trace);
+}
+
+/**
+ * Write the trace to location, replacing any previous file.  Must be
+ * called before perf_trace_start().
+ */
+gboolean
+perf_trace_set_file (PerfTrace *trace,
+                     const gchar *location)
+{
+    PerfTraceFileHeader header;
+
+    if (trace->fd >= 0)
+    {
+        close (trace->fd);
+        trace->fd = -1;
+    }
+
+    if (!location)
+        return TRUE;
+
+    trace->fd = open (location, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (trace->fd < 0)
+        return FALSE;
+
+    memset (&header, 0, sizeof (header));
+    header.magic = PERF_TRACE_MAGIC;
+    header.version = PERF_TRACE_VERSION;
+    header.record_size = sizeof (PerfTraceRecord);
+    g_strlcpy (header.name, trace->name, sizeof (header.name));
+
+    if (!write_all (trace->fd, &header, sizeof (header)))
+    {
+        close (trace->fd);
+        trace->fd = -1;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Hand flushed records to func as well; it runs on the flush thread and
+ * must not keep the records pointer.
+ */
+void
+perf_trace_set_flush_func (PerfTrace *trace,
+                           PerfTraceFlushFunc func,
+                           gpointer user_data)
+{
+    trace->flush_func = func;
+    trace->user_data = user_data;
+}
+
+gboolean
+perf_trace_start (PerfTrace *trace,
+                  guint interval_ms)
+{
+    if (trace->thread)
+        return TRUE;
+
+    trace->interval_ms = MAX (interval_ms, 1);
+    trace->running = TRUE;
+    trace->thread = g_thread_create (flush_thread, trace, TRUE, NULL);
+
+    if (!trace->thread)
+    {
+        trace->running = FALSE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Stop the flush thread and flush whatever is left in the ring.
+ */
+void
+perf_trace_stop (PerfTrace *trace)
+{
+    if (!trace->thread)
+        return;
+
+    g_mutex_lock (trace->mutex);
+    trace->running = FALSE;
+    g_cond_signal (trace->cond);
+    g_mutex_unlock (trace->mutex);
+
+    g_thread_join (trace->thread);
+    trace->thread = NULL;
+
+    flush_records (trace);
+}
+
+/**
+ * Add a record for a buffer of size bytes with the given pts (or
+ * G_MAXUINT64) that arrived at timestamp.  Only one thread may call this.
+ * If the flush thread has fallen behind and the ring is full the record
+ * is counted in the dropped field of the next one.
+ */
+void
+perf_trace_record (PerfTrace *trace,
+                   guint64 timestamp,
+                   guint64 pts,
+                   guint32 size)
+{
+    PerfTraceRecord *record;
+    guint head, i, cpus;
+    guint64 interarrival = 0;
+    gint64 jitter = 0;
+
+    if (trace->last_timestamp != G_MAXUINT64)
+        interarrival = timestamp - trace->last_timestamp;
+
+    if (trace->last_pts != G_MAXUINT64 && pts != G_MAXUINT64)
+        jitter = (gint64) interarrival - (gint64) (pts - trace->last_pts);
+
+    trace->last_timestamp = timestamp;
+    trace->last_pts = pts;
+
+    head = trace->head;
+    if (head - (guint) g_atomic_int_get (&trace->tail) > trace->mask)
+    {
+        trace->dropped++;
+        return;
+    }
+
+    record = &trace->records[head & trace->mask];
+    record->timestamp = timestamp;
+    record->pts = pts;
+    record->interarrival = interarrival;
+    record->jitter = jitter;
+    record->size = size;
+    record->dropped = trace->dropped;
+
+    cpus = g_atomic_int_get (&trace->cpus);
+    record->cpus = cpus;
+    for (i = 0; i < cpus; i++)
+        record->load[i] = g_atomic_int_get (&trace->load[i]);
+
+    trace->dropped = 0;
+
+    /* publish the record to the flush thread */
+    g_atomic_int_set (&trace->head, head + 1);
+}
+
+/**
+ * Copy the latest per-core load (1/10 percent) into load, which must hold
+ * PERF_TRACE_MAX_CPUS entries, and return the number of cores.
+ */
+guint
+perf_trace_get_loads (PerfTrace *trace,
+                      guint16 *load)
+{
+    guint i, cpus;
+
+    cpus = g_atomic_int_get (&trace->cpus);
+    for (i = 0; i < cpus; i++)
+        load[i] = g_atomic_int_get (&trace->load[i]);
+
+    return cpus;
+}
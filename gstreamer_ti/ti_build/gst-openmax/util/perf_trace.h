@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef PERF_TRACE_H
+#define PERF_TRACE_H
+
+#include <glib.h>
+
+/*
+ * Binary per-buffer trace for the perf elements.
+ *
+ * The streaming thread appends one fixed-size record per buffer to a
+ * single-producer/single-consumer ring without taking a lock or making a
+ * system call.  A flush thread samples the per-core load (see cpu_load.h)
+ * and drains the ring, either into a trace file or into a callback, every
+ * flush interval.
+ *
+ * A trace file is a PerfTraceFileHeader followed by records.  It is
+ * written in host byte order; PERF_TRACE_MAGIC tells the reader whether
+ * that matches its own.  gst-perf-trace turns it into CSV or percentiles.
+ * The TI codec plugin builds this file and cpu_load.c too (through links
+ * in ticodecplugin/src) for its dmaiperf element, so keep them free of
+ * anything gst-openmax specific.
+ */
+
+#define PERF_TRACE_MAGIC 0x50524654     /* "PRFT" */
+#define PERF_TRACE_VERSION 1
+#define PERF_TRACE_MAX_CPUS 8
+
+typedef struct PerfTrace PerfTrace;
+typedef struct PerfTraceRecord PerfTraceRecord;
+typedef struct PerfTraceFileHeader PerfTraceFileHeader;
+
+typedef void (*PerfTraceFlushFunc) (PerfTrace *trace,
+                                    const PerfTraceRecord *records,
+                                    guint count,
+                                    gpointer user_data);
+
+struct PerfTraceRecord
+{
+    guint64 timestamp;          /**< arrival, monotonic ns */
+    guint64 pts;                /**< buffer timestamp, G_MAXUINT64 if none */
+    guint64 interarrival;       /**< ns since the previous buffer */
+    gint64 jitter;              /**< interarrival minus the pts delta */
+    guint32 size;
+    guint32 dropped;            /**< records lost to a full ring before this one */
+    guint32 cpus;               /**< valid entries in load */
+    guint32 reserved;
+    guint16 load[PERF_TRACE_MAX_CPUS]; /**< per-core load, 1/10 percent */
+};
+
+struct PerfTraceFileHeader
+{
+    guint32 magic;
+    guint32 version;
+    guint32 record_size;
+    guint32 reserved;
+    gchar name[48];             /**< element that wrote the trace */
+};
+
+PerfTrace *perf_trace_new (const gchar *name, guint capacity);
+void perf_trace_free (PerfTrace *trace);
+gboolean perf_trace_set_file (PerfTrace *trace, const gchar *location);
+void perf_trace_set_flush_func (PerfTrace *trace, PerfTraceFlushFunc func,
+                                gpointer user_data);
+gboolean perf_trace_start (PerfTrace *trace, guint interval_ms);
+void perf_trace_stop (PerfTrace *trace);
+void perf_trace_record (PerfTrace *trace, guint64 timestamp, guint64 pts,
+                        guint32 size);
+guint perf_trace_get_loads (PerfTrace *trace, guint16 *load);
+
+#endif /* PERF_TRACE_H */
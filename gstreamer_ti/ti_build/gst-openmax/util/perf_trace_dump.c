@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * gst-perf-trace: turn a trace written by perf or dmaiperf
+ * (trace-location property) into CSV or a percentile summary.
+ *
+ *   gst-perf-trace trace.bin          one CSV line per buffer
+ *   gst-perf-trace -p trace.bin       percentiles per column
+ */
+
+#include <glib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perf_trace.h"
+
+static const gdouble percentiles[] = { 50.0, 90.0, 99.0, 99.9, 100.0 };
+
+static gint
+compare_double (gconstpointer a,
+                gconstpointer b)
+{
+    gdouble x = *(const gdouble *) a;
+    gdouble y = *(const gdouble *) b;
+
+    return (x > y) - (x < y);
+}
+
+static void
+print_percentiles (const gchar *name,
+                   gdouble *values,
+                   guint count)
+{
+    guint i, index;
+
+    if (count == 0)
+        return;
+
+    qsort (values, count, sizeof (gdouble), compare_double);
+
+    printf ("%-16s", name);
+    for (i = 0; i < G_N_ELEMENTS (percentiles); i++)
+    {
+        index = (guint) (percentiles[i] / 100.0 * (count - 1) + 0.5);
+        printf (" %14.1f", values[index]);
+    }
+    printf ("\n");
+}
+
+static void
+summarize (const PerfTraceRecord *records,
+           guint count)
+{
+    gdouble *values;
+    guint64 dropped = 0, bytes = 0;
+    guint cpus = 0;
+    guint i, cpu;
+    gdouble seconds;
+    gchar name[16];
+
+    values = g_new (gdouble, count);
+
+    for (i = 0; i < count; i++)
+    {
+        dropped += records[i].dropped;
+        bytes += records[i].size;
+        cpus = MAX (cpus, records[i].cpus);
+    }
+
+    seconds = (records[count - 1].timestamp - records[0].timestamp) / 1e9;
+    printf ("records %u, dropped %" G_GUINT64_FORMAT ", %.1f s", count,
+            dropped, seconds);
+    if (seconds > 0)
+        printf (", %.2f buffers/s, %.0f bytes/s",
+                (count - 1) / seconds, bytes / seconds);
+    printf ("\n\n%-16s", "");
+    for (i = 0; i < G_N_ELEMENTS (percentiles); i++)
+        printf ("          p%-4g", percentiles[i]);
+    printf ("\n");
+
+    for (i = 1; i < count; i++)
+        values[i - 1] = records[i].interarrival / 1e3;
+    print_percentiles ("interarrival us", values, count - 1);
+
+    for (i = 1; i < count; i++)
+        values[i - 1] = ABS (records[i].jitter) / 1e3;
+    print_percentiles ("|jitter| us", values, count - 1);
+
+    for (i = 0; i < count; i++)
+        values[i] = records[i].size;
+    print_percentiles ("size", values, count);
+
+    for (cpu = 0; cpu < cpus; cpu++)
+    {
+        guint n = 0;
+
+        for (i = 0; i < count; i++)
+            if (cpu < records[i].cpus)
+                values[n++] = records[i].load[cpu] / 10.0;
+
+        g_snprintf (name, sizeof (name), "cpu%u load %%", cpu);
+        print_percentiles (name, values, n);
+    }
+
+    g_free (values);
+}
+
+static void
+print_csv (const PerfTraceRecord *records,
+           guint count)
+{
+    guint cpus = 0;
+    guint i, cpu;
+
+    for (i = 0; i < count; i++)
+        cpus = MAX (cpus, records[i].cpus);
+
+    printf ("timestamp_ns,pts_ns,size,interarrival_ns,jitter_ns,dropped");
+    for (cpu = 0; cpu < cpus; cpu++)
+        printf (",cpu%u_load", cpu);
+    printf ("\n");
+
+    for (i = 0; i < count; i++)
+    {
+        const PerfTraceRecord *r = &records[i];
+
+        printf ("%" G_GUINT64_FORMAT ",", r->timestamp);
+        if (r->pts != G_MAXUINT64)
+            printf ("%" G_GUINT64_FORMAT, r->pts);
+        printf (",%u,%" G_GUINT64_FORMAT ",%" G_GINT64_FORMAT ",%u",
+                r->size, r->interarrival, r->jitter, r->dropped);
+        for (cpu = 0; cpu < cpus; cpu++)
+        {
+            if (cpu < r->cpus)
+                printf (",%.1f", r->load[cpu] / 10.0);
+            else
+                printf (",");
+        }
+        printf ("\n");
+    }
+}
+
+int
+main (int argc,
+      char **argv)
+{
+    const PerfTraceFileHeader *header;
+    const PerfTraceRecord *records;
+    gboolean summary = FALSE;
+    const gchar *location;
+    GError *error = NULL;
+    gchar *contents;
+    gsize length;
+    guint count;
+
+    if (argc == 3 && strcmp (argv[1], "-p") == 0)
+    {
+        summary = TRUE;
+        location = argv[2];
+    }
+    else if (argc == 2)
+    {
+        location = argv[1];
+    }
+    else
+    {
+        fprintf (stderr, "usage: %s [-p] trace-file\n", argv[0]);
+        return 1;
+    }
+
+    if (!g_file_get_contents (location, &contents, &length, &error))
+    {
+        fprintf (stderr, "%s\n", error->message);
+        g_error_free (error);
+        return 1;
+    }
+
+    header = (const PerfTraceFileHeader *) contents;
+    if (length < sizeof (*header) || header->magic != PERF_TRACE_MAGIC)
+    {
+        fprintf (stderr, "%s: not a trace file, or written with the other "
+                 "byte order\n", location);
+        return 1;
+    }
+
+    if (header->version != PERF_TRACE_VERSION ||
+        header->record_size != sizeof (PerfTraceRecord))
+    {
+        fprintf (stderr, "%s: unsupported trace version %u\n", location,
+                 header->version);
+        return 1;
+    }
+
+    records = (const PerfTraceRecord *) (contents + sizeof (*header));
+    count = (length - sizeof (*header)) / sizeof (PerfTraceRecord);
+
+    if (summary)
+    {
+        printf ("%s: ", header->name);
+        if (count)
+            summarize (records, count);
+        else
+            printf ("no records\n");
+    }
+    else
+    {
+        print_csv (records, count);
+    }
+
+    g_free (contents);
+
+    return 0;
+}
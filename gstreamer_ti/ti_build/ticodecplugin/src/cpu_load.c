@@ -0,0 +1 @@
+../../gst-openmax/util/cpu_load.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../gst-openmax/util/cpu_load.h
\ No newline at end of file
@@ -72,6 +72,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_tiauddec1_debug);
 #define     DEFAULT_DISPLAY_BUFFER      FALSE
 #define     DEFAULT_GENTIMESTAMPS       TRUE
 #define     DEFAULT_RTCODECTHREAD       TRUE
+#define     DEFAULT_CACHE_CODEC         FALSE
 
 /* Element property identifiers */
 enum
@@ -83,7 +84,8 @@ enum
   PROP_NUM_OUTPUT_BUFS, /* numOutputBufs  (int)     */
   PROP_DISPLAY_BUFFER,  /* displayBuffer  (boolean) */
   PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
-  PROP_RTCODECTHREAD    /* rtCodecThread  (boolean) */
+  PROP_RTCODECTHREAD,   /* rtCodecThread  (boolean) */
+  PROP_CACHE_CODEC      /* cacheCodec     (boolean) */
 };
 
 /* Define sink (input) pad capabilities.  Currently, AAC and MP3 are
@@ -301,6 +303,13 @@ static void gst_tiauddec1_class_init(GstTIAuddec1Class *klass)
         g_param_spec_boolean("genTimeStamps", "Generate Time Stamps",
             "Set timestamps on output buffers",
             DEFAULT_GENTIMESTAMPS, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_CACHE_CODEC,
+        g_param_spec_boolean("cacheCodec", "Cache codec instance",
+            "Keep the codec and its engine open in a process-wide cache "
+            "when stopping, so the next element with the same settings can "
+            "reuse them (see GST_TI_CODEC_CACHE_SIZE/TIMEOUT)",
+            DEFAULT_CACHE_CODEC, G_PARAM_READWRITE));
 }
 
 /******************************************************************************
@@ -348,6 +357,13 @@ static void gst_tiauddec1_init_env(GstTIAuddec1 *auddec1)
                     auddec1->rtCodecThread ? "TRUE" : "FALSE");
     }
 
+    if (gst_ti_env_is_defined("GST_TI_TIAuddec1_cacheCodec")) {
+        auddec1->cacheCodec = 
+                gst_ti_env_get_boolean("GST_TI_TIAuddec1_cacheCodec");
+        GST_LOG("Setting cacheCodec =%s\n", 
+                    auddec1->cacheCodec ? "TRUE" : "FALSE");
+    }
+
     GST_LOG("gst_tiauddec1_init_env - end");
 }
 
@@ -397,6 +413,7 @@ static void gst_tiauddec1_init(GstTIAuddec1 *auddec1, GstTIAuddec1Class *gclass)
     auddec1->codecName          = NULL;
     auddec1->displayBuffer      = DEFAULT_DISPLAY_BUFFER;
     auddec1->genTimeStamps      = DEFAULT_GENTIMESTAMPS;
+    auddec1->cacheCodec         = DEFAULT_CACHE_CODEC;
 
     auddec1->hEngine            = NULL;
     auddec1->codecName          = NULL;
@@ -499,6 +516,11 @@ static void gst_tiauddec1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"RTCodecThread\" to \"%s\"\n",
                 auddec1->rtCodecThread ? "TRUE" : "FALSE");
             break;
+        case PROP_CACHE_CODEC:
+            auddec1->cacheCodec = g_value_get_boolean(value);
+            GST_LOG("setting \"cacheCodec\" to \"%s\"\n",
+                auddec1->cacheCodec ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -528,6 +550,9 @@ static void gst_tiauddec1_get_property(GObject *object, guint prop_id,
         case PROP_RTCODECTHREAD:
             g_value_set_boolean(value, auddec1->rtCodecThread);
             break;
+        case PROP_CACHE_CODEC:
+            g_value_set_boolean(value, auddec1->cacheCodec);
+            break;
         case PROP_GEN_TIMESTAMPS:
             g_value_set_boolean(value, auddec1->genTimeStamps);
             break;
@@ -1070,6 +1095,29 @@ static GstStateChangeReturn gst_tiauddec1_change_state(GstElement *element,
     return ret;
 }
 
+/******************************************************************************
+ * gst_tiauddec1_codec_reset
+ *     Reset a cached audio decoder before it decodes a new stream
+ *****************************************************************************/
+static Bool gst_tiauddec1_codec_reset (Ptr hCodec)
+{
+    AUDDEC1_DynamicParams  dynParams = Adec1_DynamicParams_DEFAULT;
+    AUDDEC1_Status         decStatus;
+
+    decStatus.size     = sizeof(AUDDEC1_Status);
+    decStatus.data.buf = NULL;
+
+    return AUDDEC1_control(Adec1_getVisaHandle((Adec1_Handle) hCodec),
+               XDM_RESET, &dynParams, &decStatus) == AUDDEC1_EOK;
+}
+
+/* Audio decoder functions for the codec cache */
+static const GstTICodecFxns gst_tiauddec1_codec_fxns = {
+    (GstTICodecCreateFxn) Adec1_create,
+    gst_tiauddec1_codec_reset,
+    (GstTICodecDeleteFxn) Adec1_delete
+};
+
 /******************************************************************************
  * gst_tiauddec1_codec_stop
  *     Release codec engine resources
@@ -1088,19 +1136,18 @@ static gboolean gst_tiauddec1_codec_stop (GstTIAuddec1  *auddec1)
 
     if (auddec1->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(auddec1->hOutBufTab,
+            GST_OBJECT(auddec1), "output");
         gst_tidmaibuftab_unref(auddec1->hOutBufTab);
         auddec1->hOutBufTab = NULL;
     }
 
+    /* The codec cache deletes the decoder and closes the engine, or keeps
+     * them for the next decoder */
     if (auddec1->hAd) {
-        GST_LOG("closing audio decoder\n");
-        Adec1_delete(auddec1->hAd);
-        auddec1->hAd = NULL;
-    }
-
-    if (auddec1->hEngine) {
-        GST_LOG("closing codec engine\n");
-        Engine_close(auddec1->hEngine);
+        GST_LOG("releasing audio decoder\n");
+        gst_ti_codec_cache_release(auddec1->hAd);
+        auddec1->hAd     = NULL;
         auddec1->hEngine = NULL;
     }
 
@@ -1118,16 +1165,6 @@ static gboolean gst_tiauddec1_codec_start (GstTIAuddec1  *auddec1)
     AUDDEC1_DynamicParams   dynParams = Adec1_DynamicParams_DEFAULT;
     Buffer_Attrs            bAttrs    = Buffer_Attrs_DEFAULT;
 
-    /* Open the codec engine */
-    GST_LOG("opening codec engine \"%s\"\n", auddec1->engineName);
-    auddec1->hEngine = Engine_open((Char *) auddec1->engineName, NULL, NULL);
-
-    if (auddec1->hEngine == NULL) {
-        GST_ELEMENT_ERROR(auddec1, RESOURCE, FAILED,
-        ("failed to open codec engine \"%s\"\n", auddec1->engineName), (NULL));
-        return FALSE;
-    }
-
     if (gst_tiauddec1_codec_is_aac(auddec1)) {
         #if defined (Platform_dm365) || defined(Platform_dm368)
         params.dataEndianness = XDM_LE_16;
@@ -1136,15 +1173,19 @@ static gboolean gst_tiauddec1_codec_start (GstTIAuddec1  *auddec1)
         #endif
     }
 
-    /* Initialize audio decoder */
-    GST_LOG("opening audio decoder \"%s\"\n", auddec1->codecName);
-    auddec1->hAd = Adec1_create(auddec1->hEngine, (Char*)auddec1->codecName,
-                      &params, &dynParams);
+    /* Open the codec engine and initialize the audio decoder, or reuse a
+     * cached one */
+    GST_LOG("opening audio decoder \"%s\" on codec engine \"%s\"\n",
+        auddec1->codecName, auddec1->engineName);
+    auddec1->hAd = gst_ti_codec_cache_acquire(&gst_tiauddec1_codec_fxns,
+                      auddec1->engineName, auddec1->codecName,
+                      &params, sizeof(params), &dynParams, sizeof(dynParams),
+                      auddec1->cacheCodec, &auddec1->hEngine);
 
     if (auddec1->hAd == NULL) {
         GST_ELEMENT_ERROR(auddec1, STREAM, CODEC_NOT_FOUND,
-        ("failed to create audio decoder: %s\n", auddec1->codecName), (NULL));
-        GST_LOG("closing codec engine\n");
+        ("failed to create audio decoder \"%s\" on codec engine \"%s\"\n",
+         auddec1->codecName, auddec1->engineName), (NULL));
         return FALSE;
     }
 
@@ -1365,7 +1406,8 @@ static void* gst_tiauddec1_decode_thread(void *arg)
         }
 
         /* Release buffers no longer in use by the codec */
-        Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(auddec1->hOutBufTab, hDstBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
 thread_failure:
@@ -1382,7 +1424,8 @@ thread_exit:
     while (bufIdx-- > 0) {
         Buffer_Handle hBuf = BufTab_getBuf(
             GST_TIDMAIBUFTAB_BUFTAB(auddec1->hOutBufTab), bufIdx);
-        Buffer_freeUseMask(hBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(auddec1->hOutBufTab, hBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
     /* Release the last buffer we retrieved from the circular buffer */
@@ -70,6 +70,7 @@ struct _GstTIAuddec1
   gboolean       genTimeStamps;
   gint           sampleRate;
   gboolean       rtCodecThread;
+  gboolean       cacheCodec;
 
   /* Element state */
   Engine_Handle    hEngine;
@@ -976,6 +976,8 @@ static gboolean gst_tiaudenc1_codec_stop (GstTIAudenc1  *audenc1)
 
     if (audenc1->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(audenc1->hOutBufTab,
+            GST_OBJECT(audenc1), "output");
         gst_tidmaibuftab_unref(audenc1->hOutBufTab);
         audenc1->hOutBufTab = NULL;
     }
@@ -1239,7 +1241,8 @@ static void* gst_tiaudenc1_encode_thread(void *arg)
         }
 
         /* Release buffers no longer in use by the codec */
-        Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(audenc1->hOutBufTab, hDstBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
 thread_failure:
@@ -1256,7 +1259,8 @@ thread_exit:
     while (bufIdx-- > 0) {
         Buffer_Handle hBuf = BufTab_getBuf(
             GST_TIDMAIBUFTAB_BUFTAB(audenc1->hOutBufTab), bufIdx);
-        Buffer_freeUseMask(hBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(audenc1->hOutBufTab, hBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
     /* Release the last buffer we retrieved from the circular buffer */
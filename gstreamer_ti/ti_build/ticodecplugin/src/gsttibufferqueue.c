@@ -0,0 +1,223 @@
+/*
+ * gsttibufferqueue.c
+ *
+ * A bounded FIFO of GstBuffers used to hand buffers between a codec thread
+ * and a thread that talks to a neighbouring element.
+ *
+ * A producer blocks in gst_tibufferqueue_push while the queue is full and a
+ * consumer blocks in gst_tibufferqueue_pop while it is empty.  Closing the
+ * queue lets the consumer drain what is left and then see NULL; aborting it
+ * drops what is left and wakes both sides immediately.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <pthread.h>
+
+#include <gst/gst.h>
+
+#include "gsttibufferqueue.h"
+
+struct _GstTIBufferQueue {
+    GQueue          *buffers;
+    guint            depth;
+    gboolean         closed;
+    gboolean         aborted;
+    gboolean         flushing;
+    pthread_mutex_t  mutex;
+    pthread_cond_t   notFull;
+    pthread_cond_t   notEmpty;
+};
+
+
+/******************************************************************************
+ * gst_tibufferqueue_new
+ *    Create a queue that holds at most depth buffers.
+ ******************************************************************************/
+GstTIBufferQueue *gst_tibufferqueue_new(guint depth)
+{
+    GstTIBufferQueue *queue;
+
+    queue          = g_new0(GstTIBufferQueue, 1);
+    queue->buffers = g_queue_new();
+    queue->depth   = MAX(depth, 1);
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+
+    return queue;
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_free
+ *    Release the queue and any buffers still in it.  Neither side may be
+ *    using the queue any more.
+ ******************************************************************************/
+void gst_tibufferqueue_free(GstTIBufferQueue *queue)
+{
+    GstBuffer *buf;
+
+    while ((buf = g_queue_pop_head(queue->buffers))) {
+        gst_buffer_unref(buf);
+    }
+    g_queue_free(queue->buffers);
+
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_cond_destroy(&queue->notFull);
+    pthread_mutex_destroy(&queue->mutex);
+
+    g_free(queue);
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_push
+ *    Append buf, waiting while the queue is full.  The queue takes the
+ *    reference.  Returns FALSE, and drops buf, if the queue was closed or
+ *    aborted, or is flushing.
+ ******************************************************************************/
+gboolean gst_tibufferqueue_push(GstTIBufferQueue *queue, GstBuffer *buf)
+{
+    pthread_mutex_lock(&queue->mutex);
+
+    while (g_queue_get_length(queue->buffers) >= queue->depth &&
+           !queue->closed && !queue->aborted && !queue->flushing) {
+        pthread_cond_wait(&queue->notFull, &queue->mutex);
+    }
+
+    if (queue->closed || queue->aborted || queue->flushing) {
+        pthread_mutex_unlock(&queue->mutex);
+        gst_buffer_unref(buf);
+        return FALSE;
+    }
+
+    g_queue_push_tail(queue->buffers, buf);
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return TRUE;
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_pop
+ *    Remove the oldest buffer, waiting while the queue is empty.  Returns
+ *    NULL once the queue is closed and empty, or as soon as it is aborted.
+ ******************************************************************************/
+GstBuffer *gst_tibufferqueue_pop(GstTIBufferQueue *queue)
+{
+    GstBuffer *buf = NULL;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    while (g_queue_is_empty(queue->buffers) &&
+           !queue->closed && !queue->aborted) {
+        pthread_cond_wait(&queue->notEmpty, &queue->mutex);
+    }
+
+    if (!queue->aborted) {
+        buf = g_queue_pop_head(queue->buffers);
+        pthread_cond_signal(&queue->notFull);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return buf;
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_close
+ *    No more buffers will be pushed; the consumer drains what is queued.
+ ******************************************************************************/
+void gst_tibufferqueue_close(GstTIBufferQueue *queue)
+{
+    pthread_mutex_lock(&queue->mutex);
+    queue->closed = TRUE;
+    pthread_cond_broadcast(&queue->notEmpty);
+    pthread_cond_broadcast(&queue->notFull);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_abort
+ *    Drop everything queued and make pending and later calls on both sides
+ *    return at once.
+ ******************************************************************************/
+void gst_tibufferqueue_abort(GstTIBufferQueue *queue)
+{
+    GstBuffer *buf;
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->aborted = TRUE;
+    while ((buf = g_queue_pop_head(queue->buffers))) {
+        gst_buffer_unref(buf);
+    }
+    pthread_cond_broadcast(&queue->notEmpty);
+    pthread_cond_broadcast(&queue->notFull);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_set_flushing
+ *    While flushing, drop everything queued and refuse new buffers, so that
+ *    a pending push returns at once.  Unlike an abort the consumer keeps
+ *    waiting for buffers, and clearing the flag makes the queue usable
+ *    again.
+ ******************************************************************************/
+void gst_tibufferqueue_set_flushing(GstTIBufferQueue *queue,
+         gboolean flushing)
+{
+    GstBuffer *buf;
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->flushing = flushing;
+    if (flushing) {
+        while ((buf = g_queue_pop_head(queue->buffers))) {
+            gst_buffer_unref(buf);
+        }
+        pthread_cond_broadcast(&queue->notFull);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+
+/******************************************************************************
+ * gst_tibufferqueue_get_level
+ *    Return the number of buffers currently queued.
+ ******************************************************************************/
+guint gst_tibufferqueue_get_level(GstTIBufferQueue *queue)
+{
+    guint level;
+
+    pthread_mutex_lock(&queue->mutex);
+    level = g_queue_get_length(queue->buffers);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return level;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
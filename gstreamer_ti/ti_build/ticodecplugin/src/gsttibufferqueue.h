@@ -0,0 +1,54 @@
+/*
+ * gsttibufferqueue.h
+ *
+ * A bounded FIFO of GstBuffers used to hand buffers between a codec thread
+ * and a thread that talks to a neighbouring element, so that neither has
+ * to wait on the other for more than "depth" buffers.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef __GST_TIBUFFERQUEUE_H__
+#define __GST_TIBUFFERQUEUE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstTIBufferQueue GstTIBufferQueue;
+
+/* External function declarations */
+GstTIBufferQueue *gst_tibufferqueue_new(guint depth);
+void       gst_tibufferqueue_free(GstTIBufferQueue *queue);
+gboolean   gst_tibufferqueue_push(GstTIBufferQueue *queue, GstBuffer *buf);
+GstBuffer *gst_tibufferqueue_pop(GstTIBufferQueue *queue);
+void       gst_tibufferqueue_close(GstTIBufferQueue *queue);
+void       gst_tibufferqueue_abort(GstTIBufferQueue *queue);
+void       gst_tibufferqueue_set_flushing(GstTIBufferQueue *queue,
+               gboolean flushing);
+guint      gst_tibufferqueue_get_level(GstTIBufferQueue *queue);
+
+G_END_DECLS
+
+#endif /* __GST_TIBUFFERQUEUE_H__ */
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -3,6 +3,8 @@
  *
  * This file defines the "TIC6xColorspace" element, which does the 
  * DSP accelerated colorspace coversion using TIC6Accel library.
+ * Conversions the DSP can't do (NV12 or UYVY input, 24 or 32 bit RGB
+ * output) are done on the ARM, as are frames below "softwareMaxPixels".
  *
  * Example usage:
  *     gst-launch videotestsrc ! TIC6xColorspace engineName=codecServer ! 
@@ -44,6 +46,7 @@
 #include "gsttic6xcolorspace.h"
 #include "gsttidmaibuffertransport.h"
 #include "gstticommonutils.h"
+#include "gsttiyuv2rgb.h"
 
 /* Declare variable used to categorize GST_LOG output */
 GST_DEBUG_CATEGORY_STATIC (gst_tic6xcolorspace_debug);
@@ -51,11 +54,17 @@ GST_DEBUG_CATEGORY_STATIC (gst_tic6xcolorspace_debug);
 
 #define DEFAULT_NUM_OUTPUT_BUFS         2
 
+/* Input frames are staged one at a time, transform is synchronous */
+#define NUM_STAGING_BUFS                1
+
 /* Element property identifier */
 enum {
   PROP_0,
   PROP_NUM_OUTPUT_BUFS,          /*  numOutputBufs    (gint)      */
   PROP_ENGINE_NAME,              /*  engineName  (gchar*) */ 
+  PROP_STAGING_HITS,             /*  stagingHits      (guint64)   */
+  PROP_STAGING_ALLOCS,           /*  stagingAllocs    (guint64)   */
+  PROP_SOFTWARE_MAX_PIXELS,      /*  softwareMaxPixels (gint)     */
 };
 
 /* Define sink and src pad capabilities. */
@@ -64,7 +73,7 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE(
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS
-    ( GST_VIDEO_CAPS_YUV("I420"))
+    ( GST_VIDEO_CAPS_YUV("{ I420, NV12, UYVY }"))
 );
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE(
@@ -72,7 +81,9 @@ static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE(
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS
-    ( GST_VIDEO_CAPS_RGB_16 )
+    ( GST_VIDEO_CAPS_RGB_16 ";"
+      GST_VIDEO_CAPS_RGB ";"
+      GST_VIDEO_CAPS_BGRx )
 );
 
 /* Declare a global pointer to our element base class */
@@ -99,13 +110,25 @@ static ColorSpace_Type gst_tic6xcolorspace_get_colorSpace (guint32 fourcc);
 static void gst_tic6xcolorspace_set_property(GObject *object, guint prop_id,
  const GValue *value, GParamSpec *pspec);
 static GstFlowReturn gst_tic6xcolorspace_prepare_output_buffer (GstBaseTransform *trans, GstBuffer *inBuf, gint size, GstCaps *caps, GstBuffer **outBuf);
-static Buffer_Handle gst_tic6xcolorspace_gfx_buffer_create (gint width, 
- gint height, ColorSpace_Type colorSpace, gint size, gboolean is_reference);
 static gboolean gst_tic6xcolorspace_transform_size(GstBaseTransform *trans,
  GstPadDirection direction, GstCaps *caps, guint size, GstCaps *othercaps, 
  guint *othersize);
 static void gst_tic6xcolorspace_get_property(GObject *object, guint prop_id,
  GValue *value, GParamSpec *pspec);
+static Buffer_Handle gst_tic6xcolorspace_get_staging_buf (GstTIC6xColorspace
+ *c6xcolorspace, gint size);
+static void gst_tic6xcolorspace_free_staging_bufs (GstTIC6xColorspace
+ *c6xcolorspace);
+static gboolean gst_tic6xcolorspace_get_dst_format (GstCaps *caps,
+ GstTIYuv2RgbDstFormat *format);
+static gboolean gst_tic6xcolorspace_use_dsp (GstTIC6xColorspace
+ *c6xcolorspace);
+static gboolean gst_tic6xcolorspace_open_dsp (GstTIC6xColorspace
+ *c6xcolorspace);
+static GstFlowReturn gst_tic6xcolorspace_transform_dsp (GstTIC6xColorspace
+ *c6xcolorspace, GstBuffer *src, Buffer_Handle hOutBuf);
+static GstFlowReturn gst_tic6xcolorspace_transform_sw (GstTIC6xColorspace
+ *c6xcolorspace, GstBuffer *src, Buffer_Handle hOutBuf);
 
 /******************************************************************************
  * gst_tic6xcolorspace_init
@@ -121,6 +144,12 @@ static void gst_tic6xcolorspace_init (GstTIC6xColorspace
     c6xcolorspace->hEngine       =  NULL;
     c6xcolorspace->hCoeff        =  NULL;
     c6xcolorspace->engineName    =  NULL;
+    c6xcolorspace->hInBufTab     =  NULL;
+    c6xcolorspace->inBufSize     =  0;
+    c6xcolorspace->stagingHits   =  0;
+    c6xcolorspace->stagingAllocs =  0;
+    c6xcolorspace->softwareMaxPixels = 0;
+    c6xcolorspace->dspFailed     =  FALSE;
 }
 
 /******************************************************************************
@@ -229,34 +258,93 @@ static void gst_tic6xcolorspace_class_init(GstTIC6xColorspaceClass
             "Engine name used by Codec Engine", "codecServer",
             G_PARAM_READWRITE));
 
+    g_object_class_install_property(gobject_class, PROP_STAGING_HITS,
+        g_param_spec_uint64("stagingHits", "Staging buffer hits",
+            "Number of non-DMAI input frames copied into an already "
+            "allocated contiguous buffer",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+    g_object_class_install_property(gobject_class, PROP_STAGING_ALLOCS,
+        g_param_spec_uint64("stagingAllocs", "Staging buffer allocations",
+            "Number of contiguous buffers allocated for copying non-DMAI "
+            "input frames",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+    g_object_class_install_property(gobject_class, PROP_SOFTWARE_MAX_PIXELS,
+        g_param_spec_int("softwareMaxPixels",
+            "Software conversion threshold",
+            "Convert frames of up to this many pixels on the ARM instead of "
+            "the DSP (0 = always use the DSP when it can do the conversion)",
+            0, G_MAXINT32, 0, G_PARAM_READWRITE));
+
     GST_LOG("initialized class init\n");
 }
 
 /******************************************************************************
- * gst_tic6xcolorspace_gfx_buffer_create
- *  Helper function to create dmai graphics buffer
+ * gst_tic6xcolorspace_get_staging_buf
+ *  Get a contiguous buffer to copy a non-DMAI input frame of the given size
+ *  into.  The buffers are kept until the caps or the frame size change.
  *****************************************************************************/
-static Buffer_Handle gst_tic6xcolorspace_gfx_buffer_create (gint width, 
-    gint height, ColorSpace_Type colorSpace, gint size, gboolean is_reference)
+static Buffer_Handle gst_tic6xcolorspace_get_staging_buf (GstTIC6xColorspace
+    *c6xcolorspace, gint size)
 {
     BufferGfx_Attrs gfxAttrs   = BufferGfx_Attrs_DEFAULT;
-    Buffer_Handle   buf        = NULL;
-                
-    gfxAttrs.bAttrs.reference  = is_reference;
-    gfxAttrs.colorSpace     = colorSpace;
-    gfxAttrs.dim.width      = width;
-    gfxAttrs.dim.height     = height;
+    Buffer_Handle   hBuf;
+
+    if (size != c6xcolorspace->inBufSize) {
+        GST_DEBUG("input frame size %d does not match caps (%d)\n", size,
+            c6xcolorspace->inBufSize);
+        gst_tic6xcolorspace_free_staging_bufs(c6xcolorspace);
+        c6xcolorspace->inBufSize = size;
+    }
+
+    /* Only count a hit when the table actually had a buffer for us */
+    if (c6xcolorspace->hInBufTab) {
+        hBuf = gst_tidmaibuftab_get_buf(c6xcolorspace->hInBufTab);
+        if (hBuf) {
+            c6xcolorspace->stagingHits++;
+        }
+        return hBuf;
+    }
+
+    GST_LOG("allocating %d staging buffers of %d bytes\n",
+        NUM_STAGING_BUFS, size);
+
+    gfxAttrs.bAttrs.useMask = gst_tidmaibuffer_CODEC_FREE;
+    gfxAttrs.colorSpace     = c6xcolorspace->srcColorSpace;
+    gfxAttrs.dim.width      = c6xcolorspace->width;
+    gfxAttrs.dim.height     = c6xcolorspace->height;
     gfxAttrs.bAttrs.memParams.align = 128;
     gfxAttrs.dim.lineLength = BufferGfx_calcLineLength(gfxAttrs.dim.width, 
                                 gfxAttrs.colorSpace);
-    buf = Buffer_create(Dmai_roundUp(size, 128), 
-            BufferGfx_getBufferAttrs(&gfxAttrs));
 
-    if (buf == NULL) {
+    /* The chroma planes are found from the buffer size, so keep it the
+     * same as the frame size rounded up to the alignment */
+    c6xcolorspace->hInBufTab = gst_tidmaibuftab_new(NUM_STAGING_BUFS,
+                                   Dmai_roundUp(size, 128),
+                                   BufferGfx_getBufferAttrs(&gfxAttrs));
+    if (c6xcolorspace->hInBufTab == NULL) {
         return NULL;
     }
 
-    return buf;
+    c6xcolorspace->stagingAllocs += NUM_STAGING_BUFS;
+    return gst_tidmaibuftab_get_buf(c6xcolorspace->hInBufTab);
+}
+
+/******************************************************************************
+ * gst_tic6xcolorspace_free_staging_bufs
+ *  Free the buffers non-DMAI input frames are copied into.
+ *****************************************************************************/
+static void gst_tic6xcolorspace_free_staging_bufs (GstTIC6xColorspace
+    *c6xcolorspace)
+{
+    if (c6xcolorspace->hInBufTab) {
+        GST_LOG("freeing staging buffers\n");
+        gst_tidmaibuftab_log_stats(c6xcolorspace->hInBufTab,
+            GST_OBJECT(c6xcolorspace), "staging");
+        gst_tidmaibuftab_unref(c6xcolorspace->hInBufTab);
+        c6xcolorspace->hInBufTab = NULL;
+    }
 }
 
 /*****************************************************************************
@@ -318,6 +406,15 @@ static void gst_tic6xcolorspace_get_property(GObject *object,
         case PROP_ENGINE_NAME:
             g_value_set_string(value, c6xcolorspace->engineName);
             break;
+        case PROP_STAGING_HITS:
+            g_value_set_uint64(value, c6xcolorspace->stagingHits);
+            break;
+        case PROP_STAGING_ALLOCS:
+            g_value_set_uint64(value, c6xcolorspace->stagingAllocs);
+            break;
+        case PROP_SOFTWARE_MAX_PIXELS:
+            g_value_set_int(value, c6xcolorspace->softwareMaxPixels);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -354,6 +451,11 @@ static void gst_tic6xcolorspace_set_property(GObject *object,
             GST_LOG("setting \"engineName\" to \"%s\"\n", 
                 c6xcolorspace->engineName);
             break;
+        case PROP_SOFTWARE_MAX_PIXELS:
+            c6xcolorspace->softwareMaxPixels = g_value_get_int(value);
+            GST_LOG("setting \"softwareMaxPixels\" to \"%d\"\n",
+                c6xcolorspace->softwareMaxPixels);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -364,62 +466,92 @@ static void gst_tic6xcolorspace_set_property(GObject *object,
        
 
 /******************************************************************************
- * gst_tic6xcolorspace_transform 
- *    Transforms one incoming buffer to one outgoing buffer.
+ * gst_tic6xcolorspace_use_dsp
+ *    The DSP only does I420 to RGB565.  Small frames cost less to convert on
+ *    the ARM than a round trip through the codec server, and once the DSP
+ *    fails to open every frame is converted on the ARM.
  *****************************************************************************/
-static GstFlowReturn gst_tic6xcolorspace_transform (GstBaseTransform *trans,
-    GstBuffer *src, GstBuffer *dst)
+static gboolean gst_tic6xcolorspace_use_dsp (GstTIC6xColorspace
+    *c6xcolorspace)
+{
+    if (c6xcolorspace->dspFailed) {
+        return FALSE;
+    }
+
+    if (c6xcolorspace->swFrame.srcFormat != GstTIYuv2Rgb_I420 ||
+        c6xcolorspace->swFrame.dstFormat != GstTIYuv2Rgb_RGB565) {
+        return FALSE;
+    }
+
+    return c6xcolorspace->width * c6xcolorspace->height >
+               c6xcolorspace->softwareMaxPixels;
+}
+
+/******************************************************************************
+ * gst_tic6xcolorspace_open_dsp
+ *    Create the C6Accel handle and the coefficient table the first time a
+ *    frame is converted on the DSP.
+ *****************************************************************************/
+static gboolean gst_tic6xcolorspace_open_dsp (GstTIC6xColorspace
+    *c6xcolorspace)
 {
-    GstTIC6xColorspace *c6xcolorspace  = GST_TIC6XCOLORSPACE(trans);
-    Buffer_Handle  hInBuf = NULL, hOutBuf = NULL;
-    GstFlowReturn  ret  = GST_FLOW_ERROR;
-    unsigned char   *y, *cb, *cr;
-    short  *coeff = NULL;
-    unsigned short  *rgb;
-    BufferGfx_Dimensions  dim;
-    const short yuv2rgb_coeff[] = {0x2000, 0x2BDD, -0x0AC5, -0x1658, 0x3770};
     Buffer_Attrs bAttrs   = Buffer_Attrs_DEFAULT;
 
-    GST_LOG("begin transform\n");
+    if (c6xcolorspace->hC6 && c6xcolorspace->hCoeff) {
+        return TRUE;
+    }
 
-    /* create c6accel handle */
-    if (c6xcolorspace->hC6 == NULL) {
-        GST_LOG("creating C6Accel handle engineName=%s \n", 
-             c6xcolorspace->engineName);
+    GST_LOG("creating C6Accel handle engineName=%s \n",
+         c6xcolorspace->engineName);
 
-        c6xcolorspace->hEngine = Engine_open((Char*) 
-      c6xcolorspace->engineName,  NULL, NULL);
+    if (c6xcolorspace->hEngine == NULL) {
+        c6xcolorspace->hEngine = Engine_open((Char*)
+            c6xcolorspace->engineName,  NULL, NULL);
 
         if (c6xcolorspace->hEngine == NULL) {
-            GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, FAILED,
-            ("failed to create engine handle \n"), (NULL));
-            goto exit;  
+            GST_WARNING("failed to create engine handle\n");
+            return FALSE;
         }
+    }
 
-        c6xcolorspace->hC6 = C6accel_create((Char*) 
+    if (c6xcolorspace->hC6 == NULL) {
+        c6xcolorspace->hC6 = C6accel_create((Char*)
              c6xcolorspace->engineName, c6xcolorspace->hEngine,
              "c6accel", NULL);
 
         if (c6xcolorspace->hC6 == NULL) {
-            GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, FAILED,
-            ("failed to create c6accel handle \n"), (NULL));
-            goto exit;  
-        }
-
-        bAttrs.memParams.align = 128;
-        c6xcolorspace->hCoeff = Buffer_create(5*sizeof(short), &bAttrs);
-        if (c6xcolorspace->hCoeff == NULL) {
-            GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, NO_SPACE_LEFT,
-            ("failed to create memory for coeff table \n"), (NULL));
-            goto exit;  
+            GST_WARNING("failed to create c6accel handle\n");
+            return FALSE;
         }
+    }
 
-        memcpy(Buffer_getUserPtr(c6xcolorspace->hCoeff), yuv2rgb_coeff, 
-            5*sizeof(short));
+    bAttrs.memParams.align = 128;
+    c6xcolorspace->hCoeff = Buffer_create(sizeof(gst_ti_yuv2rgb_coeff),
+                                &bAttrs);
+    if (c6xcolorspace->hCoeff == NULL) {
+        GST_WARNING("failed to create memory for coeff table\n");
+        return FALSE;
     }
 
-    /* Get the output buffer handle */ 
-    hOutBuf = GST_TIDMAIBUFFERTRANSPORT_DMAIBUF(dst);
+    memcpy(Buffer_getUserPtr(c6xcolorspace->hCoeff), gst_ti_yuv2rgb_coeff,
+        sizeof(gst_ti_yuv2rgb_coeff));
+
+    return TRUE;
+}
+
+/******************************************************************************
+ * gst_tic6xcolorspace_transform_dsp
+ *    Convert an I420 frame to RGB565 with C6Accel.
+ *****************************************************************************/
+static GstFlowReturn gst_tic6xcolorspace_transform_dsp (GstTIC6xColorspace
+    *c6xcolorspace, GstBuffer *src, Buffer_Handle hOutBuf)
+{
+    Buffer_Handle  hInBuf = NULL;
+    GstFlowReturn  ret  = GST_FLOW_ERROR;
+    unsigned char   *y, *cb, *cr;
+    short  *coeff = NULL;
+    unsigned short  *rgb;
+    BufferGfx_Dimensions  dim;
 
     /* Get the input buffer handle */
     if (GST_IS_TIDMAIBUFFERTRANSPORT(src)) {
@@ -428,20 +560,18 @@ static GstFlowReturn gst_tic6xcolorspace_transform (GstBaseTransform *trans,
         hInBuf = GST_TIDMAIBUFFERTRANSPORT_DMAIBUF(src);
     }
     else {
-        GST_LOG("found non-dmai buffer, allocating dmai buffer\n");
-        /* If we are recieving non dmai transport buffer then copy the 
+        GST_LOG("found non-dmai buffer, copying to a staging buffer\n");
+        /* If we are recieving non dmai transport buffer then copy the
          * input buffer in dmai buffer.
          */
-        hInBuf = gst_tic6xcolorspace_gfx_buffer_create(
-                c6xcolorspace->width, c6xcolorspace->height, 
-                c6xcolorspace->srcColorSpace, GST_BUFFER_SIZE(src), 
-                FALSE);
+        hInBuf = gst_tic6xcolorspace_get_staging_buf(c6xcolorspace,
+                     GST_BUFFER_SIZE(src));
         if (hInBuf == NULL) {
             GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, NO_SPACE_LEFT,
             ("failed to create input dmai buffer \n"), (NULL));
             goto exit;
         }
-        memcpy(Buffer_getUserPtr(hInBuf), GST_BUFFER_DATA(src), 
+        memcpy(Buffer_getUserPtr(hInBuf), GST_BUFFER_DATA(src),
                 GST_BUFFER_SIZE(src));
     }
 
@@ -453,7 +583,7 @@ static GstFlowReturn gst_tic6xcolorspace_transform (GstBaseTransform *trans,
     rgb = (unsigned short*) Buffer_getUserPtr(hOutBuf);
     coeff = (short*) Buffer_getUserPtr(c6xcolorspace->hCoeff);
 
-    if (C6accel_IMG_yuv420pl_to_rgb565(c6xcolorspace->hC6, coeff, 
+    if (C6accel_IMG_yuv420pl_to_rgb565(c6xcolorspace->hC6, coeff,
          dim.height, dim.width, y, cb, cr, rgb) < 0) {
         GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, FAILED,
         ("failed to execute colorspace coversion \n"), (NULL));
@@ -465,9 +595,71 @@ static GstFlowReturn gst_tic6xcolorspace_transform (GstBaseTransform *trans,
 exit:
 
     if (hInBuf && !GST_IS_TIDMAIBUFFERTRANSPORT(src)) {
-        Buffer_delete(hInBuf);
+        gst_tidmaibuftab_free_buf(c6xcolorspace->hInBufTab, hInBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
+    return ret;
+}
+
+/******************************************************************************
+ * gst_tic6xcolorspace_transform_sw
+ *    Convert a frame on the ARM.  The input is read where it is, so neither
+ *    a staging copy nor a contiguous input buffer is needed.
+ *****************************************************************************/
+static GstFlowReturn gst_tic6xcolorspace_transform_sw (GstTIC6xColorspace
+    *c6xcolorspace, GstBuffer *src, Buffer_Handle hOutBuf)
+{
+    GstTIYuv2RgbFrame  frame = c6xcolorspace->swFrame;
+    gint               i;
+
+    if (GST_BUFFER_SIZE(src) < c6xcolorspace->swSrcSize) {
+        GST_ELEMENT_ERROR(c6xcolorspace, STREAM, FORMAT,
+        ("input buffer is %u bytes, expected %u \n", GST_BUFFER_SIZE(src),
+         c6xcolorspace->swSrcSize), (NULL));
+        return GST_FLOW_ERROR;
+    }
+
+    for (i = 0; i < 3; i++) {
+        frame.src[i] = GST_BUFFER_DATA(src) + c6xcolorspace->swSrcOffset[i];
+    }
+    frame.dst = (guint8*) Buffer_getUserPtr(hOutBuf);
+
+    gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, &frame);
+
+    return GST_FLOW_OK;
+}
+
+/******************************************************************************
+ * gst_tic6xcolorspace_transform
+ *    Transforms one incoming buffer to one outgoing buffer.
+ *****************************************************************************/
+static GstFlowReturn gst_tic6xcolorspace_transform (GstBaseTransform *trans,
+    GstBuffer *src, GstBuffer *dst)
+{
+    GstTIC6xColorspace *c6xcolorspace  = GST_TIC6XCOLORSPACE(trans);
+    Buffer_Handle  hOutBuf = NULL;
+    GstFlowReturn  ret  = GST_FLOW_ERROR;
+
+    GST_LOG("begin transform\n");
+
+    /* Get the output buffer handle */
+    hOutBuf = GST_TIDMAIBUFFERTRANSPORT_DMAIBUF(dst);
+
+    if (gst_tic6xcolorspace_use_dsp(c6xcolorspace)) {
+        if (gst_tic6xcolorspace_open_dsp(c6xcolorspace)) {
+            ret = gst_tic6xcolorspace_transform_dsp(c6xcolorspace, src,
+                      hOutBuf);
+            goto exit;
+        }
+
+        GST_WARNING("DSP is not available, converting on the ARM\n");
+        c6xcolorspace->dspFailed = TRUE;
+    }
+
+    ret = gst_tic6xcolorspace_transform_sw(c6xcolorspace, src, hOutBuf);
+
+exit:
     GST_LOG("end transform\n");
     return ret;
 }
@@ -541,12 +733,49 @@ ColorSpace_Type gst_tic6xcolorspace_get_colorSpace (guint32 fourcc)
     switch (fourcc) {
         case GST_MAKE_FOURCC('I', '4', '2', '0'):
             return ColorSpace_YUV420P;
+        case GST_MAKE_FOURCC('N', 'V', '1', '2'):
+            return ColorSpace_YUV420PSEMI;
+        case GST_MAKE_FOURCC('U', 'Y', 'V', 'Y'):
+            return ColorSpace_UYVY;
         default:
             GST_ERROR("failed to get colorspace\n");
             return ColorSpace_NOTSET;
     }
 }
 
+/*****************************************************************************
+ * gst_tic6xcolorspace_get_dst_format
+ *    Map the bpp of the output caps to the RGB layout written.
+ ****************************************************************************/
+static gboolean gst_tic6xcolorspace_get_dst_format (GstCaps *caps,
+    GstTIYuv2RgbDstFormat *format)
+{
+    GstStructure    *structure;
+    gint            bpp;
+
+    structure = gst_caps_get_structure(caps, 0);
+
+    if (!gst_structure_get_int(structure, "bpp", &bpp)) {
+        GST_ERROR("failed to get bpp from cap\n");
+        return FALSE;
+    }
+
+    switch (bpp) {
+        case 16:
+            *format = GstTIYuv2Rgb_RGB565;
+            return TRUE;
+        case 24:
+            *format = GstTIYuv2Rgb_RGB24;
+            return TRUE;
+        case 32:
+            *format = GstTIYuv2Rgb_BGRx;
+            return TRUE;
+        default:
+            GST_ERROR("unsupported bpp %d\n", bpp);
+            return FALSE;
+    }
+}
+
 /******************************************************************************
  * gst_tic6xcolorspace_transform_size
  * Given the size of a buffer in the given direction with the given caps, 
@@ -560,6 +789,7 @@ static gboolean gst_tic6xcolorspace_transform_size(GstBaseTransform *trans,
 {
     gboolean ret;
     gint width, height;
+    GstTIYuv2RgbDstFormat dstFormat;
 
     GST_LOG("begin gst_tic6xcolorspace_transform_size\n");
 
@@ -569,8 +799,11 @@ static gboolean gst_tic6xcolorspace_transform_size(GstBaseTransform *trans,
             GST_ERROR("failed to get input width/height\n");
             return FALSE;
         }
-        *othersize = gst_ti_calc_buffer_size(width, height, 0, 
-             ColorSpace_RGB565); 
+        if (!gst_tic6xcolorspace_get_dst_format(othercaps, &dstFormat)) {
+            return FALSE;
+        }
+        *othersize = GST_ROUND_UP_4(width *
+                         gst_ti_yuv2rgb_bytes_per_pixel(dstFormat)) * height;
         GST_LOG("size = %d\n", *othersize);
     }
 
@@ -590,6 +823,8 @@ static gboolean gst_tic6xcolorspace_set_caps (GstBaseTransform *trans,
     gboolean            ret         = FALSE;
     guint32             fourcc;
     guint               outBufSize;
+    GstTIYuv2RgbFrame  *frame       = &c6xcolorspace->swFrame;
+    gint                lumaSize, chromaStride;
 
     GST_LOG("begin set caps\n");
 
@@ -607,13 +842,81 @@ static gboolean gst_tic6xcolorspace_set_caps (GstBaseTransform *trans,
     c6xcolorspace->srcColorSpace = 
         gst_tic6xcolorspace_get_colorSpace(fourcc);
 
-    c6xcolorspace->width = c6xcolorspace->width;
-    c6xcolorspace->height = c6xcolorspace->height;
-    c6xcolorspace->dstColorSpace = ColorSpace_RGB565;
+    if (!gst_tic6xcolorspace_get_dst_format(out, &frame->dstFormat)) {
+        GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, FAILED,
+        ("failed to get output format\n"), (NULL));
+        goto exit;
+    }
+
+    c6xcolorspace->dstColorSpace =
+        frame->dstFormat == GstTIYuv2Rgb_RGB565 ? ColorSpace_RGB565 :
+                                                  ColorSpace_RGB888;
+
+    /* Describe the input and output frames for the software conversion,
+     * which uses the GStreamer row strides for the input as it reads
+     * non-DMAI buffers in place.
+     */
+    frame->width     = c6xcolorspace->width;
+    frame->height    = c6xcolorspace->height;
+    frame->dstStride = GST_ROUND_UP_4(c6xcolorspace->width *
+                           gst_ti_yuv2rgb_bytes_per_pixel(frame->dstFormat));
+
+    switch (c6xcolorspace->srcColorSpace) {
+        case ColorSpace_YUV420P:
+            frame->srcFormat    = GstTIYuv2Rgb_I420;
+            frame->srcStride[0] = GST_ROUND_UP_4(c6xcolorspace->width);
+            chromaStride        = GST_ROUND_UP_8(c6xcolorspace->width) / 2;
+            frame->srcStride[1] = chromaStride;
+            frame->srcStride[2] = chromaStride;
+            lumaSize = frame->srcStride[0] *
+                           GST_ROUND_UP_2(c6xcolorspace->height);
+            c6xcolorspace->swSrcOffset[0] = 0;
+            c6xcolorspace->swSrcOffset[1] = lumaSize;
+            c6xcolorspace->swSrcOffset[2] = lumaSize + chromaStride *
+                GST_ROUND_UP_2(c6xcolorspace->height) / 2;
+            c6xcolorspace->swSrcSize = c6xcolorspace->swSrcOffset[2] +
+                chromaStride * GST_ROUND_UP_2(c6xcolorspace->height) / 2;
+            break;
+        case ColorSpace_YUV420PSEMI:
+            frame->srcFormat    = GstTIYuv2Rgb_NV12;
+            frame->srcStride[0] = GST_ROUND_UP_4(c6xcolorspace->width);
+            frame->srcStride[1] = frame->srcStride[0];
+            frame->srcStride[2] = 0;
+            lumaSize = frame->srcStride[0] *
+                           GST_ROUND_UP_2(c6xcolorspace->height);
+            c6xcolorspace->swSrcOffset[0] = 0;
+            c6xcolorspace->swSrcOffset[1] = lumaSize;
+            c6xcolorspace->swSrcOffset[2] = 0;
+            c6xcolorspace->swSrcSize = lumaSize + lumaSize / 2;
+            break;
+        case ColorSpace_UYVY:
+            frame->srcFormat    = GstTIYuv2Rgb_UYVY;
+            frame->srcStride[0] = GST_ROUND_UP_4(c6xcolorspace->width * 2);
+            frame->srcStride[1] = 0;
+            frame->srcStride[2] = 0;
+            c6xcolorspace->swSrcOffset[0] = 0;
+            c6xcolorspace->swSrcOffset[1] = 0;
+            c6xcolorspace->swSrcOffset[2] = 0;
+            c6xcolorspace->swSrcSize = frame->srcStride[0] *
+                                           c6xcolorspace->height;
+            break;
+        default:
+            GST_ELEMENT_ERROR(c6xcolorspace, RESOURCE, FAILED,
+            ("unsupported input fourcc\n"), (NULL));
+            goto exit;
+    }
+
+    GST_LOG("converting %s\n", gst_tic6xcolorspace_use_dsp(c6xcolorspace) ?
+        "on the DSP" : "on the ARM");
+
+    /* staging buffers for non-DMAI input are sized for the new caps the
+     * next time one is needed */
+    gst_tic6xcolorspace_free_staging_bufs(c6xcolorspace);
+    c6xcolorspace->inBufSize = gst_ti_calc_buffer_size(c6xcolorspace->width,
+        c6xcolorspace->height, 0, c6xcolorspace->srcColorSpace);
 
     /* calculate output buffer size */
-    outBufSize = gst_ti_calc_buffer_size(c6xcolorspace->width,
-        c6xcolorspace->height, 0, c6xcolorspace->dstColorSpace);
+    outBufSize = frame->dstStride * c6xcolorspace->height;
 
     /* create rendezvous handle for buffer release */
     c6xcolorspace->waitOnBufTab = Rendezvous_create (100, &rzvAttrs);
@@ -628,8 +931,7 @@ static gboolean gst_tic6xcolorspace_set_caps (GstBaseTransform *trans,
     gfxAttrs.colorSpace = c6xcolorspace->dstColorSpace;
     gfxAttrs.dim.width = c6xcolorspace->width;
     gfxAttrs.dim.height = c6xcolorspace->height;
-    gfxAttrs.dim.lineLength =
-        BufferGfx_calcLineLength (gfxAttrs.dim.width, gfxAttrs.colorSpace);
+    gfxAttrs.dim.lineLength = frame->dstStride;
 
     if (c6xcolorspace->numOutputBufs == 0) {
         c6xcolorspace->numOutputBufs = 2;
@@ -708,10 +1010,19 @@ static gboolean gst_tic6xcolorspace_exit_colorspace(GstTIC6xColorspace *c6xcolor
 
     if (c6xcolorspace->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(c6xcolorspace->hOutBufTab,
+            GST_OBJECT(c6xcolorspace), "output");
         gst_tidmaibuftab_unref(c6xcolorspace->hOutBufTab);
         c6xcolorspace->hOutBufTab = NULL;
     }
 
+    if (c6xcolorspace->hInBufTab) {
+        GST_LOG("staging buffers: %" G_GUINT64_FORMAT " hits, %"
+            G_GUINT64_FORMAT " allocated\n", c6xcolorspace->stagingHits,
+            c6xcolorspace->stagingAllocs);
+    }
+    gst_tic6xcolorspace_free_staging_bufs(c6xcolorspace);
+
     if (c6xcolorspace->hCoeff) {
         GST_LOG("freeing output buffers\n");
         Buffer_delete(c6xcolorspace->hCoeff);
@@ -39,6 +39,7 @@
 #include <c6accelw.h>
 
 #include "gsttidmaibuftab.h"
+#include "gsttiyuv2rgb.h"
 
 G_BEGIN_DECLS
 
@@ -69,6 +70,7 @@ struct _GstTIC6xColorspace
   gboolean          contiguousInputFrame;
   gint              numOutputBufs;
   const gchar*      engineName;
+  gint              softwareMaxPixels;
 
   /* Element state */
   gint              width;
@@ -80,6 +82,18 @@ struct _GstTIC6xColorspace
   C6accel_Handle    hC6;
   Engine_Handle     hEngine;
   Buffer_Handle     hCoeff;
+
+  /* Contiguous buffers non-DMAI input frames are copied into */
+  GstTIDmaiBufTab  *hInBufTab;
+  gint              inBufSize;
+  guint64           stagingHits;
+  guint64           stagingAllocs;
+
+  /* Software conversion, used when the DSP can't or shouldn't be */
+  GstTIYuv2RgbFrame swFrame;
+  guint             swSrcOffset[3];
+  guint             swSrcSize;
+  gboolean          dspFailed;
 };
 
 /* _GstTIC6xColorspaceClass object */
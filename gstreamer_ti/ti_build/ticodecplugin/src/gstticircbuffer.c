@@ -21,6 +21,9 @@
  */
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #include <ti/sdo/dmai/Dmai.h>
 #include <ti/sdo/dmai/Buffer.h>
@@ -56,14 +59,27 @@ static Int32     gst_ticircbuffer_data_size(GstTICircBuffer *circBuf);
 static Int32     gst_ticircbuffer_write_space(GstTICircBuffer *circBuf);
 static Int32     gst_ticircbuffer_is_empty(GstTICircBuffer *circBuf);
 static void      gst_ticircbuffer_display(GstTICircBuffer *circBuf);
+static void      gst_ticircbuffer_commit(GstTICircBuffer *circBuf,
+                     Int32 bytes, GstClockTime duration);
+static void      gst_ticircbuffer_copy_segments(Int8 *dst,
+                     const struct iovec *segs, Int32 *seg, Int32 *segOffset,
+                     Int32 bytes);
+static GstTICircBuffer* gst_ticircbuffer_create(Int32 windowSize,
+                     Int32 numWindows, Bool fixedBlockSize, gboolean mirror);
+static gboolean  gst_ticircbuffer_map_mirror(GstTICircBuffer *circBuf,
+                     int fd, off_t offset, Int32 size);
+static gboolean  gst_ticircbuffer_create_mirror(GstTICircBuffer *circBuf,
+                     Int32 bufSize);
 
 /* Useful macros */
 #define gst_ticircbuffer_first_window_free(circBuf) \
-            ((circBuf)->readPtr - Buffer_getUserPtr((circBuf)->hBuf) >= \
+            (!(circBuf)->mirrored && \
+             (circBuf)->readPtr - Buffer_getUserPtr((circBuf)->hBuf) >= \
              ((circBuf)->windowSize + (circBuf)->readAheadSize))
 
 /* Constants */
 #define DISP_SIZE 77
+#define CMEM_DEVICE "/dev/cmem"
 
 /******************************************************************************
  * gst_ticircbuffer_get_type
@@ -137,6 +153,17 @@ static void gst_ticircbuffer_finalize(GstTICircBuffer* circBuf)
         Buffer_delete(circBuf->hBuf);
     }
 
+    /* Unmap both views of a mirrored buffer before releasing the memory
+     * backing them.
+     */
+    if (circBuf->mirrorBase) {
+        munmap(circBuf->mirrorBase, circBuf->mirrorSize << 1);
+    }
+
+    if (circBuf->hMirrorBuf) {
+        Buffer_delete(circBuf->hMirrorBuf);
+    }
+
     if (circBuf->waitOnProducer) {
         Rendezvous_delete(circBuf->waitOnProducer);
     }
@@ -174,6 +201,10 @@ static void gst_ticircbuffer_init(GTypeInstance *instance,
     circBuf->contiguousData  = TRUE;
     circBuf->fixedBlockSize  = FALSE;
     circBuf->consumerAborted = FALSE;
+    circBuf->mirrored        = FALSE;
+    circBuf->mirrorBase      = NULL;
+    circBuf->mirrorSize      = 0;
+    circBuf->hMirrorBuf      = NULL;
     circBuf->userCopy       = NULL;
 
     GST_LOG("end init");
@@ -188,6 +219,40 @@ static void gst_ticircbuffer_init(GTypeInstance *instance,
  ******************************************************************************/
 GstTICircBuffer* gst_ticircbuffer_new(Int32 windowSize, Int32 numWindows,
                      Bool fixedBlockSize)
+{
+    return gst_ticircbuffer_create(windowSize, numWindows, fixedBlockSize,
+               FALSE);
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_new_mirrored
+ *     Same as gst_ticircbuffer_new, but map the buffer memory twice back to
+ *     back so data wrapping past the end of the buffer stays contiguous.
+ *     Incoming data is then copied exactly once and the last window never
+ *     has to be shifted back to the first one.  Windows returned by
+ *     gst_ticircbuffer_get_data may straddle the end of the buffer, so they
+ *     are only contiguous in virtual memory: only use this when the codec
+ *     runs on the ARM (see gst_ti_codec_is_local), never for a codec that
+ *     reads its input by physical address.  Falls back to a regular buffer
+ *     when the mirror cannot be created.
+ ******************************************************************************/
+GstTICircBuffer* gst_ticircbuffer_new_mirrored(Int32 windowSize,
+                     Int32 numWindows, Bool fixedBlockSize)
+{
+    return gst_ticircbuffer_create(windowSize, numWindows, fixedBlockSize,
+               TRUE);
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_create
+ *     Common implementation of gst_ticircbuffer_new and
+ *     gst_ticircbuffer_new_mirrored.
+ ******************************************************************************/
+static GstTICircBuffer* gst_ticircbuffer_create(Int32 windowSize,
+                            Int32 numWindows, Bool fixedBlockSize,
+                            gboolean mirror)
 {
     GstTICircBuffer *circBuf;
     Buffer_Attrs     bAttrs  = Buffer_Attrs_DEFAULT;
@@ -217,6 +282,20 @@ GstTICircBuffer* gst_ticircbuffer_new(Int32 windowSize, Int32 numWindows,
     /* Allocate the circular buffer */
     bufSize = (numWindows * windowSize) + (circBuf->readAheadSize << 1);
 
+    /* In fixedBlockSize mode the write pointer already wraps without
+     * copying, so there is nothing for a mirror to save.
+     */
+    if (mirror && !fixedBlockSize) {
+        if (gst_ticircbuffer_create_mirror(circBuf, bufSize)) {
+            circBuf->readPtr = circBuf->writePtr =
+                Buffer_getUserPtr(circBuf->hBuf);
+            return circBuf;
+        }
+
+        GST_WARNING("failed to create mirrored buffer, falling back to "
+            "shifting data\n");
+    }
+
     GST_LOG("creating circular input buffer of size %lu\n", bufSize);
     circBuf->hBuf = Buffer_create(bufSize, &bAttrs);
 
@@ -231,6 +310,121 @@ GstTICircBuffer* gst_ticircbuffer_new(Int32 windowSize, Int32 numWindows,
     return circBuf;
 }
 
+
+/******************************************************************************
+ * gst_ticircbuffer_map_mirror
+ *     Map size bytes of fd at offset twice, the second view directly after
+ *     the first one.  size must be a multiple of the page size.
+ ******************************************************************************/
+static gboolean gst_ticircbuffer_map_mirror(GstTICircBuffer *circBuf,
+                    int fd, off_t offset, Int32 size)
+{
+    Int8 *base;
+    void *view;
+
+    /* Reserve the address range for both views so nothing else can be
+     * mapped between them.
+     */
+    base = mmap(NULL, size << 1, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+               -1, 0);
+    if (base == MAP_FAILED) {
+        GST_WARNING("failed to reserve %lu bytes of address space\n",
+            size << 1);
+        return FALSE;
+    }
+
+    view = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+               fd, offset);
+    if (view == MAP_FAILED) {
+        goto fail;
+    }
+
+    view = mmap(base + size, size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED, fd, offset);
+    if (view == MAP_FAILED) {
+        goto fail;
+    }
+
+    /* Make sure both views really are the same pages */
+    base[0] = 0x5a;
+    if (base[size] != 0x5a) {
+        GST_WARNING("buffer views are not mirrored\n");
+        goto fail;
+    }
+
+    circBuf->mirrorBase = base;
+    circBuf->mirrorSize = size;
+    return TRUE;
+
+fail:
+    munmap(base, size << 1);
+    return FALSE;
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_create_mirror
+ *     Allocate the memory for a mirrored buffer from CMEM, so window
+ *     addresses can still be translated by the codec, and map it twice.
+ *     There is deliberately no fallback to other memory.  circBuf->hBuf is
+ *     set to a reference buffer describing the first view.
+ ******************************************************************************/
+static gboolean gst_ticircbuffer_create_mirror(GstTICircBuffer *circBuf,
+                    Int32 bufSize)
+{
+    Buffer_Attrs  bAttrs   = Buffer_Attrs_DEFAULT;
+    Int32         pageSize = sysconf(_SC_PAGESIZE);
+    Int32         size;
+    int           fd;
+
+    /* Both views have to start on a page boundary */
+    size = (bufSize + pageSize - 1) & ~(pageSize - 1);
+
+    /* CMEM buffers are mapped through the driver with their physical
+     * address as the offset.  Without O_SYNC the driver maps them cached,
+     * like the single view Buffer_create hands out.
+     */
+    fd = open(CMEM_DEVICE, O_RDWR);
+    if (fd >= 0) {
+        bAttrs.memParams.align = pageSize;
+        circBuf->hMirrorBuf    = Buffer_create(size, &bAttrs);
+
+        if (circBuf->hMirrorBuf != NULL &&
+            !gst_ticircbuffer_map_mirror(circBuf, fd,
+                 (off_t)Buffer_getPhysicalPtr(circBuf->hMirrorBuf), size)) {
+            Buffer_delete(circBuf->hMirrorBuf);
+            circBuf->hMirrorBuf = NULL;
+        }
+        close(fd);
+    }
+
+    if (circBuf->mirrorBase == NULL) {
+        return FALSE;
+    }
+
+    /* The rest of the circular buffer only ever sees the first view */
+    bAttrs           = Buffer_Attrs_DEFAULT;
+    bAttrs.reference = TRUE;
+    circBuf->hBuf    = Buffer_create(size, &bAttrs);
+
+    if (circBuf->hBuf == NULL) {
+        munmap(circBuf->mirrorBase, size << 1);
+        circBuf->mirrorBase = NULL;
+        if (circBuf->hMirrorBuf) {
+            Buffer_delete(circBuf->hMirrorBuf);
+            circBuf->hMirrorBuf = NULL;
+        }
+        return FALSE;
+    }
+
+    Buffer_setUserPtr(circBuf->hBuf, circBuf->mirrorBase);
+    circBuf->mirrored = TRUE;
+
+    GST_LOG("created mirrored circular input buffer of size %lu\n", size);
+
+    return TRUE;
+}
+
 /******************************************************************************
  * gst_ticircbuffer_copy_config
  *  This function configures circular buffer to use user defined copy routine.
@@ -372,10 +566,43 @@ gboolean gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf, GstBuffer *buf)
     else {        
         memcpy(circBuf->writePtr, GST_BUFFER_DATA(buf), GST_BUFFER_SIZE(buf));
     }
-    circBuf->writePtr += GST_BUFFER_SIZE(buf);
+
+    gst_ticircbuffer_commit(circBuf, GST_BUFFER_SIZE(buf),
+        GST_BUFFER_DURATION(buf));
+
+    goto exit;
+
+exit_fail:
+    result = FALSE;
+exit:
+    return result;
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_commit
+ *     Publish bytes of data already copied to the write pointer to the
+ *     consumer.
+ ******************************************************************************/
+static void gst_ticircbuffer_commit(GstTICircBuffer *circBuf, Int32 bytes,
+                GstClockTime duration)
+{
+    /* In mirror mode the copy may have run into the second view of the
+     * buffer.  Move the write pointer back into the first view; the data
+     * itself is already there.
+     */
+    if (circBuf->mirrored && circBuf->contiguousData &&
+        circBuf->writePtr + bytes >=
+        circBuf->mirrorBase + circBuf->mirrorSize) {
+        circBuf->writePtr -= circBuf->mirrorSize - bytes;
+        circBuf->contiguousData = FALSE;
+    }
+    else {
+        circBuf->writePtr += bytes;
+    }
 
     /* Copy new data to the end of the buffer */
-    GST_LOG("queued %u bytes of data\n", GST_BUFFER_SIZE(buf));
+    GST_LOG("queued %lu bytes of data\n", bytes);
 
     /* Output the buffer status to stdout if buffer debug is enabled */
     if (circBuf->displayBuffer) {
@@ -385,11 +612,11 @@ gboolean gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf, GstBuffer *buf)
     /* If the upstream elements are providing time information, update the
      * duration of time stored by the encoded data.
      */
-    if (!GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(buf))) {
+    if (!GST_CLOCK_TIME_IS_VALID(duration)) {
         circBuf->dataDuration = GST_CLOCK_TIME_NONE;
     }
     else if (GST_CLOCK_TIME_IS_VALID(circBuf->dataDuration)) {
-        circBuf->dataDuration += GST_BUFFER_DURATION(buf);
+        circBuf->dataDuration += duration;
     }
 
 
@@ -401,13 +628,132 @@ gboolean gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf, GstBuffer *buf)
         circBuf->windowSize + circBuf->readAheadSize) {
         gst_ticircbuffer_broadcast_producer(circBuf);
     }
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_copy_segments
+ *     Copy the next bytes of a segment list to dst.  *seg and *segOffset
+ *     track the position in the list between calls.
+ ******************************************************************************/
+static void gst_ticircbuffer_copy_segments(Int8 *dst,
+                const struct iovec *segs, Int32 *seg, Int32 *segOffset,
+                Int32 bytes)
+{
+    Int32 len;
+
+    while (bytes > 0) {
+        len = segs[*seg].iov_len - *segOffset;
+        if (len > bytes) {
+            len = bytes;
+        }
+
+        memcpy(dst, (Int8*)segs[*seg].iov_base + *segOffset, len);
+        dst        += len;
+        bytes      -= len;
+        *segOffset += len;
+
+        if (*segOffset == segs[*seg].iov_len) {
+            (*seg)++;
+            *segOffset = 0;
+        }
+    }
+}
 
-    goto exit;
 
-exit_fail:
-    result = FALSE;
-exit:
-    return result;
+/******************************************************************************
+ * gst_ticircbuffer_queue_segments
+ *     Append a list of data segments to the end of the circular buffer.  The
+ *     segments are gathered into the buffer and published with a single
+ *     write pointer update, so the consumer never sees part of the list.
+ *     Only a list larger than the free space is split, the same way
+ *     gst_ticircbuffer_queue_data splits a large buffer.  buf supplies the
+ *     duration of the data, or is NULL when the data adds no duration to
+ *     the buffer (e.g. headers or part of a sample).  A copy function
+ *     set with gst_ticircbuffer_copy_config is not used.
+ ******************************************************************************/
+gboolean gst_ticircbuffer_queue_segments(GstTICircBuffer *circBuf,
+             GstBuffer *buf, const struct iovec *segs, Int32 numSegs)
+{
+    GstClockTime duration;
+    Int32        bytesLeft = 0;
+    Int32        seg       = 0;
+    Int32        segOffset = 0;
+    Int32        writeSpace;
+    Int32        i;
+
+    /* If the circular buffer doesn't exist, do nothing */
+    if (circBuf == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < numSegs; i++) {
+        bytesLeft += segs[i].iov_len;
+    }
+
+    /* Data queued without a buffer adds no time of its own */
+    if (buf != NULL) {
+        duration = GST_BUFFER_DURATION(buf);
+    }
+    else {
+        duration = 0;
+    }
+
+    /* Reset our mutex condition so a call to wait_on_consumer will block */
+    Rendezvous_reset(circBuf->waitOnConsumer);
+
+    /* If the consumer aborted, abort the buffer queuing.  We don't want to
+     * queue buffers that no one will read.
+     */
+    if (circBuf->consumerAborted) {
+        return FALSE;
+    }
+
+    /* Wait for space the same way gst_ticircbuffer_queue_data does */
+    while ((writeSpace = gst_ticircbuffer_write_space(circBuf)) < bytesLeft) {
+
+        if (circBuf->contiguousData &&
+            gst_ticircbuffer_first_window_free(circBuf)) {
+
+            if (gst_ticircbuffer_shift_data(circBuf)) {
+                continue;
+            }
+        }
+
+        /* Fill the remaining space before blocking so the consumer is
+         * never starved of a full window (see gst_ticircbuffer_queue_data).
+         * The duration is accounted for with the last piece.
+         */
+        if (writeSpace > 0) {
+            GST_LOG("queuing %lu of %lu bytes before blocking\n",
+                writeSpace, bytesLeft);
+
+            gst_ticircbuffer_copy_segments(circBuf->writePtr, segs, &seg,
+                &segOffset, writeSpace);
+            gst_ticircbuffer_commit(circBuf, writeSpace, 0);
+            bytesLeft -= writeSpace;
+            continue;
+        }
+
+        GST_LOG("blocking input until processing thread catches up\n");
+        gst_ticircbuffer_wait_on_consumer(circBuf, bytesLeft);
+        GST_LOG("unblocking input\n");
+
+        /* Reset our mutex condition so calling wait_on_consumer will block */
+        Rendezvous_reset(circBuf->waitOnConsumer);
+
+        if (circBuf->consumerAborted) {
+            return FALSE;
+        }
+
+        gst_ticircbuffer_shift_data(circBuf);
+    }
+
+    gst_ticircbuffer_copy_segments(circBuf->writePtr, segs, &seg, &segOffset,
+        bytesLeft);
+    gst_ticircbuffer_commit(circBuf, bytesLeft, duration);
+
+    return TRUE;
 }
 
 
@@ -443,7 +789,15 @@ gboolean gst_ticircbuffer_data_consumed(
 
     /* Update the read pointer */
     GST_LOG("%ld bytes consumed\n", bytesConsumed);
-    circBuf->readPtr  += bytesConsumed;
+    if (circBuf->mirrored && !circBuf->contiguousData &&
+        circBuf->readPtr + bytesConsumed >=
+        circBuf->mirrorBase + circBuf->mirrorSize) {
+        circBuf->readPtr += bytesConsumed - circBuf->mirrorSize;
+        circBuf->contiguousData = TRUE;
+    }
+    else {
+        circBuf->readPtr  += bytesConsumed;
+    }
 
     /* Update the max bytes consumed statistic */
     if (bytesConsumed > circBuf->maxConsumed) {
@@ -663,6 +1017,13 @@ static gboolean gst_ticircbuffer_shift_data(GstTICircBuffer *circBuf)
     Int32     bytesToCopy   = 0;
     gboolean  writePtrReset = FALSE;
 
+    /* In mirror mode data never needs to be moved; the write pointer wraps
+     * as soon as data is queued past the end of the buffer.
+     */
+    if (circBuf->mirrored) {
+        return FALSE;
+    }
+
     /* In fixedBlockSize mode, just wait until the write poitner reaches the
      * end of the buffer and then reset it to the beginning (no copying).
      */
@@ -727,6 +1088,24 @@ static Int32 gst_ticircbuffer_reset_read_pointer(GstTICircBuffer *circBuf)
     Int8  *lastWindow    = circBufStart + lastWinOffset;
     Int32  resetDelta    = lastWindow - circBufStart;
 
+    /* In mirror mode the read pointer normally wraps when data is consumed.
+     * It can only be left in the second view if it caught up with a write
+     * pointer that had not wrapped yet.
+     */
+    if (circBuf->mirrored) {
+        if (!circBuf->contiguousData &&
+            circBuf->readPtr >= circBufStart + circBuf->mirrorSize) {
+            GST_LOG("resetting read pointer (%lu->%lu)\n",
+                (UInt32)(circBuf->readPtr - circBufStart),
+                (UInt32)(circBuf->readPtr - circBuf->mirrorSize -
+                         circBufStart));
+            circBuf->readPtr        -= circBuf->mirrorSize;
+            circBuf->contiguousData  = TRUE;
+            return TRUE;
+        }
+        return FALSE;
+    }
+
     /* In fixedBlockSize mode, just wait until the read poitner reaches the
      * end of the buffer and then reset it to the beginning.
      */
@@ -798,6 +1177,13 @@ static Int32 gst_ticircbuffer_data_available(GstTICircBuffer *circBuf)
         return (circBuf->writePtr - circBuf->readPtr);
     }
 
+    /* In mirror mode the data wrapping around to the start of the buffer
+     * is also visible right after its end.
+     */
+    else if (circBuf->mirrored) {
+        return (circBuf->writePtr + circBuf->mirrorSize) - circBuf->readPtr;
+    }
+
     /* Otherwise, there needs to be enough data between the read pointer and
      * the end of the buffer.
      */
@@ -834,6 +1220,11 @@ static Int32 gst_ticircbuffer_data_size(GstTICircBuffer *circBuf)
  ******************************************************************************/
 static Int32 gst_ticircbuffer_write_space(GstTICircBuffer *circBuf)
 {
+    /* In mirror mode all free space is contiguous */
+    if (circBuf->mirrored && circBuf->contiguousData) {
+        return circBuf->mirrorSize - (circBuf->writePtr - circBuf->readPtr);
+    }
+
     if (circBuf->contiguousData) {
         return (Buffer_getUserPtr(circBuf->hBuf) +
                 Buffer_getSize(circBuf->hBuf)) - circBuf->writePtr;
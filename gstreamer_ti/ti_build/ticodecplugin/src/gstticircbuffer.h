@@ -23,6 +23,7 @@
 #ifndef __GST_CIRCBUFFER_H__
 #define __GST_CIRCBUFFER_H__
 
+#include <sys/uio.h>
 #include <gst/gst.h>
 
 #include <ti/sdo/dmai/Dmai.h>
@@ -64,6 +65,15 @@ struct _GstTICircBuffer {
     gboolean           contiguousData;
     gboolean           consumerAborted;
 
+    /* Mirror Mode:  the hBuf pages are mapped a second time directly after
+     * themselves, so data that wraps past the end of the buffer is still
+     * contiguous in virtual memory and never has to be shifted.
+     */
+    gboolean           mirrored;
+    Int8              *mirrorBase;
+    Int32              mirrorSize;
+    Buffer_Handle      hMirrorBuf;
+
     /* Timestamp Management */
     GstClockTime       dataTimeStamp;
     GstClockTime       dataDuration;
@@ -90,8 +100,12 @@ struct _GstTICircBuffer {
 GType            gst_ticircbuffer_get_type(void);
 GstTICircBuffer* gst_ticircbuffer_new(Int32 windowSize, Int32 numWindows,
                      Bool fixedBlockSize);
+GstTICircBuffer* gst_ticircbuffer_new_mirrored(Int32 windowSize,
+                     Int32 numWindows, Bool fixedBlockSize);
 gboolean         gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf,
                      GstBuffer *buf);
+gboolean         gst_ticircbuffer_queue_segments(GstTICircBuffer *circBuf,
+                     GstBuffer *buf, const struct iovec *segs, Int32 numSegs);
 gboolean         gst_ticircbuffer_data_consumed(GstTICircBuffer *circBuf,
                      GstBuffer* buf, Int32 bytesConsumed);
 gboolean         gst_ticircbuffer_time_consumed(
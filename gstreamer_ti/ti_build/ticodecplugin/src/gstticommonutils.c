@@ -22,6 +22,10 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/time.h>
 
 #include <xdc/std.h>
 
@@ -32,6 +36,7 @@
 #include <gst/gst.h>
 
 #include "gsttidmaibuffertransport.h"
+#include "gstticommonutils.h"
 
 /* This variable is used to flush the fifo.  It is pushed to the
  * fifo when we want to flush it.  When the encode/decode thread
@@ -121,6 +126,116 @@ gint gst_ti_calc_buffer_size(gint width, gint height, gint bytesPerLine,
     return bufSize;
 }
 
+/******************************************************************************
+ * gst_ti_copy_frame_supported
+ *    Check whether gst_ti_copy_frame can copy frames of a colorspace.
+ *****************************************************************************/
+gboolean gst_ti_copy_frame_supported(ColorSpace_Type colorSpace)
+{
+    switch (colorSpace) {
+        case ColorSpace_UYVY:
+        case ColorSpace_RGB565:
+        case ColorSpace_RGB888:
+        case ColorSpace_YUV420PSEMI:
+        case ColorSpace_YUV422PSEMI:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/******************************************************************************
+ * gst_ti_copy_frame
+ *    Copy the rectangle at (x, y) of size width x height from a frame in
+ *    system memory to the position of the dimensions of hDstBuf.  The copy
+ *    is clipped to the width and height of the dimensions, and to what is
+ *    left of the buffer's lines and rows from their x and y on.  This does
+ *    the same as a non-accelerated Framecopy from a reference buffer, with
+ *    one plane copy per plane instead of one memcpy per line, and it can
+ *    crop.
+ *
+ *    The source frame has lines of srcLineLength bytes and, for the semi
+ *    planar formats, its chroma plane right after srcHeight luma lines.
+ *    Returns FALSE for colorspaces it cannot copy.
+ *****************************************************************************/
+gboolean gst_ti_copy_frame(Buffer_Handle hDstBuf, const guint8 *src,
+             ColorSpace_Type colorSpace, gint srcLineLength, gint srcHeight,
+             gint x, gint y, gint width, gint height)
+{
+    BufferGfx_Dimensions dim;
+    guint8              *dst;
+    const guint8        *srcChroma;
+    guint8              *dstChroma;
+    gint                 lineBytes, dstX, dstLines;
+
+    BufferGfx_getDimensions(hDstBuf, &dim);
+    dst    = (guint8 *) Buffer_getUserPtr(hDstBuf);
+    width  = MIN(width, dim.width);
+    height = MIN(height, dim.height);
+
+    switch (colorSpace) {
+        case ColorSpace_UYVY:
+        case ColorSpace_RGB565:
+        case ColorSpace_RGB888:
+            dstX      = BufferGfx_calcLineLength(dim.x, colorSpace);
+            dstLines  = Buffer_getSize(hDstBuf) / dim.lineLength;
+            lineBytes = MIN(BufferGfx_calcLineLength(width, colorSpace),
+                            dim.lineLength - dstX);
+            height    = MIN(height, dstLines - dim.y);
+
+            gst_ti_copy_plane(dst + dim.y * dim.lineLength + dstX,
+                dim.lineLength,
+                src + y * srcLineLength +
+                    BufferGfx_calcLineLength(x, colorSpace),
+                srcLineLength, lineBytes, height);
+            break;
+
+        case ColorSpace_YUV420PSEMI:
+        case ColorSpace_YUV422PSEMI:
+            /* Chroma samples come in Cb/Cr pairs */
+            x &= ~1;
+            dim.x &= ~1;
+
+            if (colorSpace == ColorSpace_YUV420PSEMI) {
+                dstChroma = dst + Buffer_getSize(hDstBuf) * 2 / 3;
+            }
+            else {
+                dstChroma = dst + Buffer_getSize(hDstBuf) / 2;
+            }
+
+            dstLines = (dstChroma - dst) / dim.lineLength;
+            width    = MIN(width, dim.lineLength - dim.x);
+            height   = MIN(height, dstLines - dim.y);
+
+            gst_ti_copy_plane(dst + dim.y * dim.lineLength + dim.x,
+                dim.lineLength, src + y * srcLineLength + x, srcLineLength,
+                width, height);
+
+            srcChroma = src + srcLineLength * srcHeight;
+
+            if (colorSpace == ColorSpace_YUV420PSEMI) {
+                gst_ti_copy_plane(
+                    dstChroma + (dim.y / 2) * dim.lineLength + dim.x,
+                    dim.lineLength,
+                    srcChroma + (y / 2) * srcLineLength + x, srcLineLength,
+                    width, height / 2);
+            }
+            else {
+                gst_ti_copy_plane(dstChroma + dim.y * dim.lineLength + dim.x,
+                    dim.lineLength, srcChroma + y * srcLineLength + x,
+                    srcLineLength, width, height);
+            }
+            break;
+
+        default:
+            GST_ERROR("unsupported colorspace %d for frame copy\n",
+                colorSpace);
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 /******************************************************************************
  * gst_ti_get_env_boolean 
  *   Function will return environment boolean. 
@@ -435,6 +550,475 @@ void gst_ti_parse_newsegment(GstEvent **event, GstSegment *segment,
 }
 
 
+/******************************************************************************
+ * Codec cache
+ *
+ * Codec instances and their engines, kept open between uses.  An element
+ * gets an instance with gst_ti_codec_cache_acquire and has it to itself
+ * until gst_ti_codec_cache_release; an Engine handle must not be used by
+ * two threads at once, so instances and engines are reused, one user at a
+ * time, never shared.  A released instance stays idle in the cache, with
+ * its engine, until an element asks for the same engine, codec and
+ * parameters.  When no instance matches, an idle engine of the same name
+ * is reused to create one.
+ *
+ * Idle entries are closed after GST_TI_CODEC_CACHE_TIMEOUT msec (default
+ * 30000, 0 = never), and the oldest ones when there are more than
+ * GST_TI_CODEC_CACHE_SIZE (default 4, 0 disables the cache).
+ ******************************************************************************/
+
+#define CODEC_CACHE_DEFAULT_SIZE    4
+#define CODEC_CACHE_DEFAULT_TIMEOUT 30000
+
+typedef struct _GstTICodecCacheEntry {
+    const GstTICodecFxns *fxns;
+    gchar                *engineName;
+    gchar                *codecName;
+    gpointer              params;       /* copies, to match on */
+    gsize                 paramsSize;
+    gpointer              dynParams;
+    gsize                 dynParamsSize;
+    gboolean              cache;        /* keep it once released */
+    Engine_Handle         hEngine;
+    Ptr                   hCodec;       /* NULL for an idle engine */
+    GstClockTime          idleSince;
+} GstTICodecCacheEntry;
+
+static pthread_once_t  codecCacheOnce  = PTHREAD_ONCE_INIT;
+static pthread_mutex_t codecCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  codecCacheCond  = PTHREAD_COND_INITIALIZER;
+static GList          *codecCacheIdle;      /* oldest first */
+static GList          *codecCacheBorrowed;
+static gboolean        codecCacheThread;    /* the eviction thread runs */
+static guint           codecCacheSize;
+static guint           codecCacheTimeout;
+static GstTICodecCacheStats codecCacheStats;
+
+/******************************************************************************
+ * gst_ti_codec_cache_init
+ *    Read the cache limits from the environment, once.
+ ******************************************************************************/
+static void gst_ti_codec_cache_init(void)
+{
+    gst_ti_commonutils_debug_init();
+
+    codecCacheSize    = CODEC_CACHE_DEFAULT_SIZE;
+    codecCacheTimeout = CODEC_CACHE_DEFAULT_TIMEOUT;
+
+    if (gst_ti_env_is_defined("GST_TI_CODEC_CACHE_SIZE")) {
+        codecCacheSize = MAX(gst_ti_env_get_int("GST_TI_CODEC_CACHE_SIZE"), 0);
+    }
+
+    if (gst_ti_env_is_defined("GST_TI_CODEC_CACHE_TIMEOUT")) {
+        codecCacheTimeout =
+            MAX(gst_ti_env_get_int("GST_TI_CODEC_CACHE_TIMEOUT"), 0);
+    }
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_entry_free
+ *    Delete the codec instance, close the engine and free the entry.
+ ******************************************************************************/
+static void gst_ti_codec_cache_entry_free(GstTICodecCacheEntry *entry)
+{
+    if (entry->hCodec) {
+        GST_LOG("deleting codec \"%s\"\n", entry->codecName);
+        entry->fxns->delete(entry->hCodec);
+    }
+
+    if (entry->hEngine) {
+        GST_LOG("closing codec engine \"%s\"\n", entry->engineName);
+        Engine_close(entry->hEngine);
+    }
+
+    g_free(entry->engineName);
+    g_free(entry->codecName);
+    g_free(entry->params);
+    g_free(entry->dynParams);
+    g_free(entry);
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_trim
+ *    Take idle entries off the cache, oldest first, until at most size are
+ *    left.  Called with codecCacheMutex held; the caller frees the returned
+ *    entries once it has released the mutex.
+ ******************************************************************************/
+static GList *gst_ti_codec_cache_trim(guint size)
+{
+    GList *evicted = NULL;
+
+    while (g_list_length(codecCacheIdle) > size) {
+        evicted = g_list_prepend(evicted, codecCacheIdle->data);
+        codecCacheIdle = g_list_delete_link(codecCacheIdle, codecCacheIdle);
+        codecCacheStats.evictions++;
+    }
+
+    return evicted;
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_free_list
+ *    Free the entries of a list returned by gst_ti_codec_cache_trim.
+ ******************************************************************************/
+static void gst_ti_codec_cache_free_list(GList *entries)
+{
+    g_list_foreach(entries, (GFunc) gst_ti_codec_cache_entry_free, NULL);
+    g_list_free(entries);
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_evict_thread
+ *    Close idle entries as they time out.  Exits when the cache is empty.
+ ******************************************************************************/
+static void *gst_ti_codec_cache_evict_thread(void *arg)
+{
+    pthread_mutex_lock(&codecCacheMutex);
+
+    while (codecCacheIdle) {
+        GstTICodecCacheEntry *oldest = codecCacheIdle->data;
+        GstClockTime          now, deadline;
+
+        if (codecCacheTimeout == 0) {
+            pthread_cond_wait(&codecCacheCond, &codecCacheMutex);
+            continue;
+        }
+
+        now      = gst_util_get_timestamp();
+        deadline = oldest->idleSince + codecCacheTimeout * GST_MSECOND;
+
+        if (now < deadline) {
+            struct timeval  tv;
+            struct timespec ts;
+            guint64         wakeup;
+
+            gettimeofday(&tv, NULL);
+            wakeup = GST_TIMEVAL_TO_TIME(tv) + (deadline - now);
+            GST_TIME_TO_TIMESPEC(wakeup, ts);
+            pthread_cond_timedwait(&codecCacheCond, &codecCacheMutex, &ts);
+            continue;
+        }
+
+        codecCacheIdle = g_list_delete_link(codecCacheIdle, codecCacheIdle);
+        codecCacheStats.evictions++;
+
+        pthread_mutex_unlock(&codecCacheMutex);
+        GST_LOG("idle codec \"%s\" timed out\n", oldest->codecName);
+        gst_ti_codec_cache_entry_free(oldest);
+        pthread_mutex_lock(&codecCacheMutex);
+    }
+
+    codecCacheThread = FALSE;
+    pthread_mutex_unlock(&codecCacheMutex);
+
+    return NULL;
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_park
+ *    Put an entry on the idle list, making room for it.  Returns FALSE, and
+ *    leaves the entry alone, if the cache is disabled.
+ ******************************************************************************/
+static gboolean gst_ti_codec_cache_park(GstTICodecCacheEntry *entry)
+{
+    GList *evicted;
+
+    pthread_mutex_lock(&codecCacheMutex);
+
+    if (codecCacheSize == 0) {
+        pthread_mutex_unlock(&codecCacheMutex);
+        return FALSE;
+    }
+
+    evicted = gst_ti_codec_cache_trim(codecCacheSize - 1);
+
+    entry->idleSince = gst_util_get_timestamp();
+    codecCacheIdle   = g_list_append(codecCacheIdle, entry);
+
+    if (codecCacheThread) {
+        pthread_cond_signal(&codecCacheCond);
+    }
+    else {
+        pthread_t      thread;
+        pthread_attr_t attr;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, gst_ti_codec_cache_evict_thread,
+                NULL) == 0) {
+            codecCacheThread = TRUE;
+        }
+        else {
+            GST_WARNING("failed to create codec cache thread; idle codecs "
+                "will not time out\n");
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    pthread_mutex_unlock(&codecCacheMutex);
+
+    gst_ti_codec_cache_free_list(evicted);
+
+    return TRUE;
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_matches
+ *    Whether an idle entry holds an instance created from these arguments.
+ ******************************************************************************/
+static gboolean gst_ti_codec_cache_matches(GstTICodecCacheEntry *entry,
+    const GstTICodecFxns *fxns, const gchar *engineName,
+    const gchar *codecName, Ptr params, gsize paramsSize, Ptr dynParams,
+    gsize dynParamsSize)
+{
+    return entry->hCodec && entry->fxns == fxns &&
+        !strcmp(entry->engineName, engineName) &&
+        !strcmp(entry->codecName, codecName) &&
+        entry->paramsSize == paramsSize &&
+        entry->dynParamsSize == dynParamsSize &&
+        !memcmp(entry->params, params, paramsSize) &&
+        !memcmp(entry->dynParams, dynParams, dynParamsSize);
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_acquire
+ *    Return a codec instance created with fxns->create(hEngine, codecName,
+ *    params, dynParams) on an engine opened with engineName, and that engine
+ *    in *hEngine.  params and dynParams are matched byte for byte, so they
+ *    must not point to other memory.
+ *
+ *    If cache is TRUE, an idle instance created from the same arguments is
+ *    reset and returned if there is one, and the instance is kept idle
+ *    once released.  Otherwise it is deleted, and its engine closed, by
+ *    gst_ti_codec_cache_release.
+ *
+ *    Returns NULL, with *hEngine set to NULL, if the engine could not be
+ *    opened or the instance not be created.
+ ******************************************************************************/
+Ptr gst_ti_codec_cache_acquire(const GstTICodecFxns *fxns,
+    const gchar *engineName, const gchar *codecName, Ptr params,
+    gsize paramsSize, Ptr dynParams, gsize dynParamsSize, gboolean cache,
+    Engine_Handle *hEngine)
+{
+    GstTICodecCacheEntry *entry = NULL;
+    GList                *l;
+
+    pthread_once(&codecCacheOnce, gst_ti_codec_cache_init);
+
+    *hEngine = NULL;
+
+    pthread_mutex_lock(&codecCacheMutex);
+
+    if (cache) {
+        /* Most recently used first */
+        for (l = g_list_last(codecCacheIdle); l; l = l->prev) {
+            if (gst_ti_codec_cache_matches(l->data, fxns, engineName,
+                    codecName, params, paramsSize, dynParams, dynParamsSize)) {
+                entry          = l->data;
+                codecCacheIdle = g_list_delete_link(codecCacheIdle, l);
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&codecCacheMutex);
+
+    if (entry && fxns->reset && !fxns->reset(entry->hCodec)) {
+        GST_WARNING("failed to reset cached codec \"%s\"; creating a new "
+            "one\n", codecName);
+        fxns->delete(entry->hCodec);
+        entry->hCodec = NULL;
+    }
+
+    if (entry && entry->hCodec) {
+        guint64 hits, misses;
+
+        pthread_mutex_lock(&codecCacheMutex);
+        hits   = ++codecCacheStats.hits;
+        misses = codecCacheStats.misses;
+        codecCacheBorrowed = g_list_prepend(codecCacheBorrowed, entry);
+        pthread_mutex_unlock(&codecCacheMutex);
+
+        GST_INFO("reusing codec \"%s\" on engine \"%s\" (%" G_GUINT64_FORMAT
+            " hits, %" G_GUINT64_FORMAT " misses)\n", codecName, engineName,
+            hits, misses);
+
+        *hEngine = entry->hEngine;
+        return entry->hCodec;
+    }
+
+    /* No instance to reuse: find an engine to create one on */
+    if (!entry && cache) {
+        pthread_mutex_lock(&codecCacheMutex);
+        for (l = g_list_last(codecCacheIdle); l; l = l->prev) {
+            GstTICodecCacheEntry *idle = l->data;
+
+            if (!idle->hCodec && !strcmp(idle->engineName, engineName)) {
+                entry          = idle;
+                codecCacheIdle = g_list_delete_link(codecCacheIdle, l);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&codecCacheMutex);
+    }
+
+    if (!entry) {
+        entry             = g_new0(GstTICodecCacheEntry, 1);
+        entry->engineName = g_strdup(engineName);
+
+        GST_LOG("opening codec engine \"%s\"\n", engineName);
+        entry->hEngine = Engine_open((Char *) engineName, NULL, NULL);
+
+        if (entry->hEngine == NULL) {
+            gst_ti_codec_cache_entry_free(entry);
+            return NULL;
+        }
+
+        pthread_mutex_lock(&codecCacheMutex);
+        codecCacheStats.engineMisses++;
+        pthread_mutex_unlock(&codecCacheMutex);
+    }
+    else {
+        pthread_mutex_lock(&codecCacheMutex);
+        codecCacheStats.engineHits++;
+        pthread_mutex_unlock(&codecCacheMutex);
+    }
+
+    /* Fill the entry in for the new instance */
+    g_free(entry->codecName);
+    g_free(entry->params);
+    g_free(entry->dynParams);
+    entry->fxns          = fxns;
+    entry->codecName     = g_strdup(codecName);
+    entry->params        = g_memdup(params, paramsSize);
+    entry->paramsSize    = paramsSize;
+    entry->dynParams     = g_memdup(dynParams, dynParamsSize);
+    entry->dynParamsSize = dynParamsSize;
+    entry->cache         = cache;
+
+    GST_LOG("creating codec \"%s\"\n", codecName);
+    entry->hCodec = fxns->create(entry->hEngine, (Char *) codecName, params,
+                        dynParams);
+
+    if (entry->hCodec == NULL) {
+        /* Keep the engine for the next try */
+        if (!cache || !gst_ti_codec_cache_park(entry)) {
+            gst_ti_codec_cache_entry_free(entry);
+        }
+        return NULL;
+    }
+
+    pthread_mutex_lock(&codecCacheMutex);
+    if (cache) {
+        codecCacheStats.misses++;
+    }
+    codecCacheBorrowed = g_list_prepend(codecCacheBorrowed, entry);
+    pthread_mutex_unlock(&codecCacheMutex);
+
+    *hEngine = entry->hEngine;
+    return entry->hCodec;
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_release
+ *    Give back an instance returned by gst_ti_codec_cache_acquire.  The
+ *    caller must not use it, or its engine, any more.
+ ******************************************************************************/
+void gst_ti_codec_cache_release(Ptr hCodec)
+{
+    GstTICodecCacheEntry *entry = NULL;
+    GList                *l;
+
+    pthread_mutex_lock(&codecCacheMutex);
+    for (l = codecCacheBorrowed; l; l = l->next) {
+        if (((GstTICodecCacheEntry *) l->data)->hCodec == hCodec) {
+            entry              = l->data;
+            codecCacheBorrowed = g_list_delete_link(codecCacheBorrowed, l);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&codecCacheMutex);
+
+    g_return_if_fail(entry != NULL);
+
+    if (!entry->cache || !gst_ti_codec_cache_park(entry)) {
+        gst_ti_codec_cache_entry_free(entry);
+    }
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_get_stats
+ *    Copy the cache counters into stats.
+ ******************************************************************************/
+void gst_ti_codec_cache_get_stats(GstTICodecCacheStats *stats)
+{
+    pthread_mutex_lock(&codecCacheMutex);
+    *stats      = codecCacheStats;
+    stats->idle = g_list_length(codecCacheIdle);
+    pthread_mutex_unlock(&codecCacheMutex);
+}
+
+/******************************************************************************
+ * gst_ti_codec_cache_post_stats
+ *    Post the cache counters on the bus of element, as a "ti-codec-cache"
+ *    element message.  Codec elements call it after releasing their codec.
+ ******************************************************************************/
+void gst_ti_codec_cache_post_stats(GstElement *element)
+{
+    GstTICodecCacheStats stats;
+    GstStructure        *structure;
+
+    gst_ti_codec_cache_get_stats(&stats);
+
+    GST_INFO("codec cache: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT
+        " misses, %" G_GUINT64_FORMAT " evictions, %u idle\n", stats.hits,
+        stats.misses, stats.evictions, stats.idle);
+
+    structure = gst_structure_new("ti-codec-cache",
+        "hits", G_TYPE_UINT64, stats.hits,
+        "misses", G_TYPE_UINT64, stats.misses,
+        "engine-hits", G_TYPE_UINT64, stats.engineHits,
+        "engine-misses", G_TYPE_UINT64, stats.engineMisses,
+        "evictions", G_TYPE_UINT64, stats.evictions,
+        "idle", G_TYPE_UINT, stats.idle, NULL);
+
+    gst_element_post_message(element,
+        gst_message_new_element(GST_OBJECT(element), structure));
+}
+
+
+/******************************************************************************
+ * gst_ti_codec_is_local
+ *    Whether codecName runs on the ARM in the engine engineName.  Remote
+ *    codecs reach their buffers by physical address, so they can only be
+ *    given memory that is contiguous in CMEM.  Anything that can't be looked
+ *    up counts as remote.
+ ******************************************************************************/
+gboolean gst_ti_codec_is_local(const gchar *engineName, const gchar *codecName)
+{
+    Engine_AlgInfo algInfo;
+    Int            numAlgs;
+    Int            i;
+
+    if (Engine_getNumAlgs((String)engineName, &numAlgs) != Engine_EOK) {
+        return FALSE;
+    }
+
+    for (i = 0; i < numAlgs; i++) {
+        algInfo.algInfoSize = sizeof(algInfo);
+        if (Engine_getAlgInfo((String)engineName, &algInfo, i) != Engine_EOK) {
+            return FALSE;
+        }
+
+        if (!strcmp(algInfo.name, codecName)) {
+            return algInfo.isLocal;
+        }
+    }
+
+    return FALSE;
+}
+
+
 /******************************************************************************
  * Custom ViM Settings for editing this file
  ******************************************************************************/
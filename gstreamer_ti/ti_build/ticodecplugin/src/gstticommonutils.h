@@ -32,6 +32,10 @@
 #include <ti/sdo/dmai/Buffer.h>
 #include <ti/sdo/dmai/BufTab.h>
 
+#include <ti/sdo/ce/Engine.h>
+
+#include "gsttisimd.h"
+
 /* This variable is used to flush the fifo.  It is pushed to the
  * fifo when we want to flush it.  When the encode/decode thread
  * receives the address of this variable the fifo is flushed and
@@ -46,6 +50,12 @@ gint gst_ti_correct_display_bufSize (Buffer_Handle hDstBuf);
 gint gst_ti_calc_buffer_size(gint width, gint height, gint bytesPerLine,
                              ColorSpace_Type colorSpace);
 
+/* Functions to copy (part of) a frame in system memory into a BufferGfx */
+gboolean gst_ti_copy_frame_supported(ColorSpace_Type colorSpace);
+gboolean gst_ti_copy_frame(Buffer_Handle hDstBuf, const guint8 *src,
+             ColorSpace_Type colorSpace, gint srcLineLength, gint srcHeight,
+             gint x, gint y, gint width, gint height);
+
 /* Function to read environment variable and return its boolean value */
 gboolean gst_ti_env_get_boolean (gchar *env);
 
@@ -71,6 +81,48 @@ void gst_ti_parse_newsegment(GstEvent **event, GstSegment *segment,
 gboolean gst_ti_query_srcpad(GstPad * pad, GstQuery * query, 
     GstPad *sinkpad, gint64 totalDuration, guint64 totalBytes);
 
+/* Codec cache: the DMAI functions that create, reset and delete one kind of
+ * codec instance (e.g. Vdec2_create, a wrapper sending XDM_RESET and
+ * Vdec2_delete).  reset may be NULL if a reused instance needs no reset.
+ */
+typedef Ptr  (*GstTICodecCreateFxn)(Engine_Handle hEngine, Char *codecName,
+                                    Ptr params, Ptr dynParams);
+typedef Bool (*GstTICodecResetFxn)(Ptr hCodec);
+typedef Int  (*GstTICodecDeleteFxn)(Ptr hCodec);
+
+typedef struct _GstTICodecFxns {
+    GstTICodecCreateFxn create;
+    GstTICodecResetFxn  reset;
+    GstTICodecDeleteFxn delete;
+} GstTICodecFxns;
+
+typedef struct _GstTICodecCacheStats {
+    guint64 hits;           /* codec instances reused */
+    guint64 misses;         /* codec instances created */
+    guint64 engineHits;     /* engines reused for a new instance */
+    guint64 engineMisses;   /* engines opened */
+    guint64 evictions;      /* idle instances and engines closed */
+    guint   idle;           /* idle instances and engines kept */
+} GstTICodecCacheStats;
+
+/* Function to get a codec instance and its engine, reusing idle ones */
+Ptr gst_ti_codec_cache_acquire(const GstTICodecFxns *fxns,
+    const gchar *engineName, const gchar *codecName, Ptr params,
+    gsize paramsSize, Ptr dynParams, gsize dynParamsSize, gboolean cache,
+    Engine_Handle *hEngine);
+
+/* Function to give back a codec instance from gst_ti_codec_cache_acquire */
+void gst_ti_codec_cache_release(Ptr hCodec);
+
+/* Function to read the codec cache counters */
+void gst_ti_codec_cache_get_stats(GstTICodecCacheStats *stats);
+
+/* Function to post the codec cache counters as an element message */
+void gst_ti_codec_cache_post_stats(GstElement *element);
+
+/* Function to check whether a codec runs on the ARM */
+gboolean gst_ti_codec_is_local(const gchar *engineName, const gchar *codecName);
+
 #endif 
 
 /******************************************************************************
@@ -237,13 +237,9 @@ buffer_alloc(GstBaseSink *base, guint64 offset, guint size, GstCaps *caps,
 
     }
 
-    /* Get a buffer from the BufTab */
-    if (!(hDispBuf = gst_tidmaibuftab_get_buf(sink->hBufTab))) {
-        /* Wait for free buffer */
-        gst_tidmaibuftab_set_blocking(sink->hBufTab, TRUE);
-        hDispBuf = gst_tidmaibuftab_get_buf(sink->hBufTab);
-        gst_tidmaibuftab_set_blocking(sink->hBufTab, FALSE);
-    }
+    /* Get a buffer from the BufTab, waiting for one to be freed if needed */
+    hDispBuf = gst_tidmaibuftab_get_buf_timed(sink->hBufTab,
+                   GST_CLOCK_TIME_NONE);
 
     if (!hDispBuf) {
         GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
@@ -280,6 +276,8 @@ stop(GstBaseSink *base)
 
     GST_LOG_OBJECT(sink,"stop begin");
     if (sink->hBufTab) {
+           gst_tidmaibuftab_log_stats(sink->hBufTab,
+               GST_OBJECT(sink), "display");
            gst_tidmaibuftab_unref(sink->hBufTab);
     }
 
@@ -300,8 +298,8 @@ xcopy(GstBaseSink *base, GstBuffer *buf, Buffer_Handle hOutBuf)
 {
     Framecopy_Attrs fcAttrs = Framecopy_Attrs_DEFAULT;
     GstTIDisplaySink2 *sink = (GstTIDisplaySink2 *)base;
-    Buffer_Handle   hInBuf, tmpBuf = NULL;
-    BufferGfx_Attrs gfxAttrs   = BufferGfx_Attrs_DEFAULT;
+    Buffer_Handle   hInBuf;
+    gint            srcLineLength;
 
     GST_LOG_OBJECT(sink,"copy begin");
     /* Check if its dmai transport buffer */
@@ -316,32 +314,36 @@ xcopy(GstBaseSink *base, GstBuffer *buf, Buffer_Handle hOutBuf)
         #endif
     }
     else {
-        /* Create a reference dmai buffer */
-        gfxAttrs.dim.width = sink->dAttrs.width;
-        gfxAttrs.dim.height = sink->dAttrs.height;
-        gfxAttrs.colorSpace = sink->dAttrs.colorSpace;
-        gfxAttrs.dim.lineLength = BufferGfx_calcLineLength(sink->dAttrs.width, sink->dAttrs.colorSpace);
+        /* The DMA cannot read a non contiguous buffer, and the non accel
+         * framecopy does one memcpy per line through a reference buffer.
+         * Copy the planes straight into the display buffer instead.
+         */
+        if (sink->dma_copy) {
+            GST_WARNING_OBJECT(sink, "DMA copy is not possible on non contiguous buffer, defaulting to CPU copy\n");
+        }
+
+        srcLineLength = BufferGfx_calcLineLength(sink->dAttrs.width, sink->dAttrs.colorSpace);
         #if defined(Platform_dm365) || defined(Platform_dm368)
-            gfxAttrs.dim.lineLength = Dmai_roundUp(gfxAttrs.dim.lineLength, 32);
+            srcLineLength = Dmai_roundUp(srcLineLength, 32);
         #endif
-        gfxAttrs.bAttrs.reference = TRUE;
 
-        tmpBuf= Buffer_create(GST_BUFFER_SIZE(buf),
-                BufferGfx_getBufferAttrs(&gfxAttrs));
-        if (tmpBuf == NULL) {
-            GST_ERROR("failed to create  buffer\n");
+        if ((gint)GST_BUFFER_SIZE(buf) < gst_ti_calc_buffer_size(sink->dAttrs.width,
+                sink->dAttrs.height, srcLineLength, sink->dAttrs.colorSpace)) {
+            GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
+            ("Input buffer is smaller than a frame\n"), (NULL));
             return FALSE;
         }
-        Buffer_setUserPtr(tmpBuf, (Int8*)GST_BUFFER_DATA(buf));
-        Buffer_setNumBytesUsed(tmpBuf, GST_BUFFER_SIZE(buf));
-        hInBuf = tmpBuf;
 
-        /* use non accel framecopy */
-        if (sink->dma_copy) {
-            GST_WARNING_OBJECT(sink, "DMA copy is not possible on non contiguous buffer, defaulting to slow copy\n");
+        if (!gst_ti_copy_frame(hOutBuf, GST_BUFFER_DATA(buf),
+                sink->dAttrs.colorSpace, srcLineLength, sink->dAttrs.height,
+                0, 0, sink->dAttrs.width, sink->dAttrs.height)) {
+            GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
+            ("Failed to copy frame\n"), (NULL));
+            return FALSE;
         }
 
-        fcAttrs.accel = FALSE;
+        GST_LOG_OBJECT(sink,"copy end");
+        return TRUE;
     }
     
     if (sink->hFc == NULL) {
@@ -368,10 +370,6 @@ xcopy(GstBaseSink *base, GstBuffer *buf, Buffer_Handle hOutBuf)
         return FALSE;
     }
 
-    if (tmpBuf) {
-        Buffer_delete(tmpBuf);
-    }
-
     GST_LOG_OBJECT(sink,"copy end");
     return TRUE;
 }
@@ -686,11 +684,10 @@ render(GstBaseSink *base, GstBuffer *buffer)
                 ("Failed to put display buffer\n"), (NULL));
                 return GST_FLOW_UNEXPECTED;
             }
-            Buffer_freeUseMask(outBuf, gst_tidmaibuffer_VIDEOSINK_FREE);
-            Buffer_freeUseMask(outBuf, gst_tidmaibuffer_DISPLAY_FREE);
-
-            /* ublock gst_tidmaibuftab_get_buf */
-            Rendezvous_force(GST_TIDMAIBUFTAB_BUFAVAIL_RV(sink->hBufTab));
+            /* also unblocks gst_tidmaibuftab_get_buf_timed */
+            gst_tidmaibuftab_free_buf(sink->hBufTab, outBuf,
+                gst_tidmaibuffer_VIDEOSINK_FREE |
+                gst_tidmaibuffer_DISPLAY_FREE);
         }
         goto finish;
     }
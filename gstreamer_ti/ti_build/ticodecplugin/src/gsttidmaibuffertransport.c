@@ -39,7 +39,6 @@
 #include <ti/sdo/dmai/Dmai.h>
 #include <ti/sdo/dmai/Buffer.h>
 #include <ti/sdo/dmai/BufTab.h>
-#include <ti/sdo/dmai/Rendezvous.h>
 
 #include "gsttidmaibuffertransport.h"
 
@@ -122,35 +121,19 @@ static void gst_tidmaibuffertransport_finalize(GstBuffer *gstbuffer)
 
     GST_LOG("begin finalize\n");
 
-    /* If we're part of a a GstTIDmaiBufTab object, we need to make sure that
-     * changing the useMask and calling Rendezvous_force is done as a single
-     * step, or the condition mutex that waits for an available buffer may
-     * not work properly.
-     */
-    if (self->owner) {
-        pthread_mutex_lock(GST_TIDMAIBUFTAB_GETBUF_MUTEX(self->owner));
-    }
-
     /* If the DMAI buffer is part of a BufTab, free it for re-use.  Otherwise,
-     * destroy the buffer.
+     * destroy the buffer.  If we're part of a GstTIDmaiBufTab object, it puts
+     * the buffer back on its free list and wakes up anyone waiting for one.
      */
     if (Buffer_getBufTab(self->dmaiBuffer) != NULL) {
         GST_LOG("clearing GStreamer useMask bit\n");
-        Buffer_freeUseMask(self->dmaiBuffer, gst_tidmaibuffer_GST_FREE);
-        Buffer_freeUseMask(self->dmaiBuffer, gst_tidmaibuffer_VIDEOSINK_FREE);
+        gst_tidmaibuftab_free_buf(self->owner, self->dmaiBuffer,
+            gst_tidmaibuffer_GST_FREE | gst_tidmaibuffer_VIDEOSINK_FREE);
     } else {
         GST_LOG("calling Buffer_delete()\n");
         Buffer_delete(self->dmaiBuffer);
     }
 
-    /* If a GstTIDmaiBufTab object is blocked waiting for a buffer to be freed,
-     * wake it up.
-     */
-    if (self->owner) {
-        Rendezvous_force(GST_TIDMAIBUFTAB_BUFAVAIL_RV(self->owner));
-        pthread_mutex_unlock(GST_TIDMAIBUFTAB_GETBUF_MUTEX(self->owner));
-    }
-
     /* Remove reference to the GstTIDmaiBufTab object that owns us, if any */
     if (self->owner) {
         gst_tidmaibuftab_unref(self->owner);
@@ -23,11 +23,13 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
 
 #include <ti/sdo/dmai/Dmai.h>
 #include <ti/sdo/dmai/BufTab.h>
 #include <ti/sdo/dmai/Buffer.h>
-#include <ti/sdo/dmai/Rendezvous.h>
 
 #include "gsttidmaibuftab.h"
 
@@ -47,6 +49,13 @@ static void
     gst_tidmaibuftab_class_init(GstTIDmaiBufTabClass *klass);
 static void
     gst_tidmaibuftab_finalize(GstTIDmaiBufTab *self);
+static void
+    gst_tidmaibuftab_push_free(GstTIDmaiBufTab *self, gint bufIdx);
+static Buffer_Handle
+    gst_tidmaibuftab_pop_free(GstTIDmaiBufTab *self);
+static Buffer_Handle
+    gst_tidmaibuftab_get_buf_common(GstTIDmaiBufTab *self, gboolean wait,
+        GstClockTime timeout);
 
 /* Define GST_TYPE_TIDMAIBUFTAB */
 G_DEFINE_TYPE_WITH_CODE (GstTIDmaiBufTab, gst_tidmaibuftab, \
@@ -73,8 +82,12 @@ static void gst_tidmaibuftab_init(GstTIDmaiBufTab *self)
     GST_LOG("begin init\n");
 
     self->hBufTab     = NULL;
-    self->hBufAvailRv = NULL;
     self->blocking    = TRUE;
+    self->freeStack   = NULL;
+    self->onFreeStack = NULL;
+    self->numFree     = 0;
+    self->numWaiting  = 0;
+    memset(&self->stats, 0, sizeof(self->stats));
 
     GST_LOG("end init\n");
 }
@@ -111,16 +124,23 @@ static void gst_tidmaibuftab_finalize(GstTIDmaiBufTab *self)
 {
     GST_LOG("begin finalize\n");
 
+    GST_DEBUG("%" G_GUINT64_FORMAT " buffers handed out, %" G_GUINT64_FORMAT
+        " starvations, %" G_GUINT64_FORMAT " timeouts, waited %"
+        GST_TIME_FORMAT "\n", self->stats.gets,
+        self->stats.starvations, self->stats.timeouts,
+        GST_TIME_ARGS(self->stats.waitTime));
+
     if (self->hBufTab) {
         BufTab_delete(self->hBufTab);
         self->hBufTab = NULL;
     }
 
-    if (self->hBufAvailRv) {
-        Rendezvous_delete(self->hBufAvailRv);
-        self->hBufAvailRv = NULL;
-    }
+    g_free(self->freeStack);
+    g_free(self->onFreeStack);
+    self->freeStack   = NULL;
+    self->onFreeStack = NULL;
 
+    pthread_cond_destroy(&self->bufAvailCond);
     pthread_mutex_destroy(&self->hGetBufMutex);
 
     /* Call GstMiniObject's finalize routine, so our base class can do its
@@ -134,31 +154,135 @@ static void gst_tidmaibuftab_finalize(GstTIDmaiBufTab *self)
 
 
 /******************************************************************************
- * gst_tidmaibuftab_get_buf
- *    Return a free buffer from the DMAI BufTab object.
+ * gst_tidmaibuftab_push_free
+ *    Put a buffer on the free list, unless it is already there.  Called with
+ *    hGetBufMutex held.
  ******************************************************************************/
-Buffer_Handle gst_tidmaibuftab_get_buf(GstTIDmaiBufTab *self)
+static void gst_tidmaibuftab_push_free(GstTIDmaiBufTab *self, gint bufIdx)
+{
+    if (!self->onFreeStack[bufIdx]) {
+        self->onFreeStack[bufIdx]        = TRUE;
+        self->freeStack[self->numFree++] = bufIdx;
+    }
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_pop_free
+ *    Take a buffer off the free list and mark it in use.  Entries for buffers
+ *    that have been taken by someone calling BufTab_getFreeBuf directly are
+ *    dropped.  When the list is empty, the BufTab is scanned once for buffers
+ *    whose useMask was cleared without gst_tidmaibuftab_free_buf.  Called
+ *    with hGetBufMutex held.
+ ******************************************************************************/
+static Buffer_Handle gst_tidmaibuftab_pop_free(GstTIDmaiBufTab *self)
+{
+    Buffer_Handle hBuf;
+    gboolean      scanned = FALSE;
+    gint          bufIdx;
+
+    while (TRUE) {
+        while (self->numFree > 0) {
+            bufIdx = self->freeStack[--self->numFree];
+            self->onFreeStack[bufIdx] = FALSE;
+
+            hBuf = BufTab_getBuf(self->hBufTab, bufIdx);
+            if (Buffer_getUseMask(hBuf) == 0) {
+                Buffer_resetUseMask(hBuf);
+                return hBuf;
+            }
+        }
+
+        if (scanned) {
+            return NULL;
+        }
+
+        /* Push the highest index first, so buffers are handed out in the
+         * same order BufTab_getFreeBuf would use.
+         */
+        bufIdx = BufTab_getNumBufs(self->hBufTab);
+        while (bufIdx-- > 0) {
+            if (Buffer_getUseMask(BufTab_getBuf(self->hBufTab, bufIdx)) == 0) {
+                gst_tidmaibuftab_push_free(self, bufIdx);
+            }
+        }
+        scanned = TRUE;
+    }
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_get_buf_common
+ *    Return a free buffer from the free list.  If there is none and wait is
+ *    TRUE, wait until one is freed, for at most timeout
+ *    (GST_CLOCK_TIME_NONE = no limit).
+ ******************************************************************************/
+static Buffer_Handle gst_tidmaibuftab_get_buf_common(GstTIDmaiBufTab *self,
+                         gboolean wait, GstClockTime timeout)
 {
-    Buffer_Handle hFreeBuf = NULL;
+    Buffer_Handle   hFreeBuf = NULL;
+    GstClockTime    waitStart;
+    struct timeval  now;
+    struct timespec deadline;
+    gboolean        timedOut = FALSE;
 
-    /* Get a free buffer from the BufTab */
     pthread_mutex_lock(&self->hGetBufMutex);
-    hFreeBuf = BufTab_getFreeBuf(self->hBufTab);
+    hFreeBuf = gst_tidmaibuftab_pop_free(self);
 
-    /* If we are configured to block until we have a buffer, wait until a
-     * buffer is available
-     */
-    if (self->blocking && !hFreeBuf) {
-        Rendezvous_reset(self->hBufAvailRv);
+    if (!hFreeBuf) {
+        self->stats.starvations++;
+    }
 
-        pthread_mutex_unlock(&self->hGetBufMutex);
-        Rendezvous_meet(self->hBufAvailRv);
-        pthread_mutex_lock(&self->hGetBufMutex);
+    if (!hFreeBuf && wait) {
+        waitStart = gst_util_get_timestamp();
+
+        if (GST_CLOCK_TIME_IS_VALID(timeout)) {
+            gettimeofday(&now, NULL);
+            timeout          += GST_TIMEVAL_TO_TIME(now);
+            deadline.tv_sec   = timeout / GST_SECOND;
+            deadline.tv_nsec  = timeout % GST_SECOND;
+        }
+
+        self->numWaiting++;
+        while (!hFreeBuf && !timedOut) {
+            if (GST_CLOCK_TIME_IS_VALID(timeout)) {
+                timedOut = pthread_cond_timedwait(&self->bufAvailCond,
+                               &self->hGetBufMutex, &deadline) == ETIMEDOUT;
+            }
+            else {
+                pthread_cond_wait(&self->bufAvailCond, &self->hGetBufMutex);
+            }
+            hFreeBuf = gst_tidmaibuftab_pop_free(self);
+        }
+        self->numWaiting--;
+
+        self->stats.waitTime += gst_util_get_timestamp() - waitStart;
+        if (!hFreeBuf) {
+            self->stats.timeouts++;
+        }
+    }
 
-        hFreeBuf = BufTab_getFreeBuf(self->hBufTab);
+    if (hFreeBuf) {
+        self->stats.gets++;
     }
     pthread_mutex_unlock(&self->hGetBufMutex);
 
+    return hFreeBuf;
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_get_buf
+ *    Return a free buffer from the DMAI BufTab object, waiting for one if
+ *    the object is blocking.
+ ******************************************************************************/
+Buffer_Handle gst_tidmaibuftab_get_buf(GstTIDmaiBufTab *self)
+{
+    Buffer_Handle hFreeBuf;
+
+    hFreeBuf = gst_tidmaibuftab_get_buf_common(self, self->blocking,
+                   GST_CLOCK_TIME_NONE);
+
     if (self->blocking && !hFreeBuf) {
         GST_ERROR("Failed to get a buffer from the GstTIDmaiBufTab object");
     }
@@ -167,6 +291,92 @@ Buffer_Handle gst_tidmaibuftab_get_buf(GstTIDmaiBufTab *self)
 }
 
 
+/******************************************************************************
+ * gst_tidmaibuftab_try_get_buf
+ *    Return a free buffer from the DMAI BufTab object, or NULL right away if
+ *    there is none.
+ ******************************************************************************/
+Buffer_Handle gst_tidmaibuftab_try_get_buf(GstTIDmaiBufTab *self)
+{
+    return gst_tidmaibuftab_get_buf_common(self, FALSE, GST_CLOCK_TIME_NONE);
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_get_buf_timed
+ *    Return a free buffer from the DMAI BufTab object, waiting at most
+ *    timeout for one (GST_CLOCK_TIME_NONE = no limit).  Returns NULL if
+ *    none was freed in time.
+ ******************************************************************************/
+Buffer_Handle gst_tidmaibuftab_get_buf_timed(GstTIDmaiBufTab *self,
+                  GstClockTime timeout)
+{
+    return gst_tidmaibuftab_get_buf_common(self, TRUE, timeout);
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_free_buf
+ *    Clear useMask bits of a buffer.  If the buffer belongs to the object
+ *    and is no longer in use, put it on the free list and wake up anyone
+ *    waiting for a buffer.  Buffers from other BufTabs, and a NULL object,
+ *    only get their useMask bits cleared.
+ ******************************************************************************/
+void gst_tidmaibuftab_free_buf(GstTIDmaiBufTab *self, Buffer_Handle hBuf,
+         UInt16 useMask)
+{
+    if (!self || Buffer_getBufTab(hBuf) != self->hBufTab) {
+        Buffer_freeUseMask(hBuf, useMask);
+        return;
+    }
+
+    pthread_mutex_lock(&self->hGetBufMutex);
+    Buffer_freeUseMask(hBuf, useMask);
+
+    if (Buffer_getUseMask(hBuf) == 0) {
+        gst_tidmaibuftab_push_free(self, Buffer_getId(hBuf));
+
+        if (self->numWaiting > 0) {
+            pthread_cond_signal(&self->bufAvailCond);
+        }
+    }
+    pthread_mutex_unlock(&self->hGetBufMutex);
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_get_stats
+ *    Copy the counters of the DMAI BufTab object.
+ ******************************************************************************/
+void gst_tidmaibuftab_get_stats(GstTIDmaiBufTab *self,
+         GstTIDmaiBufTabStats *stats)
+{
+    pthread_mutex_lock(&self->hGetBufMutex);
+    *stats = self->stats;
+    pthread_mutex_unlock(&self->hGetBufMutex);
+}
+
+
+/******************************************************************************
+ * gst_tidmaibuftab_log_stats
+ *    Log the counters of the DMAI BufTab object against the element owning
+ *    it.  Elements call it when they give up their BufTab; name says which
+ *    one it is.
+ ******************************************************************************/
+void gst_tidmaibuftab_log_stats(GstTIDmaiBufTab *self, GstObject *owner,
+         const gchar *name)
+{
+    GstTIDmaiBufTabStats stats;
+
+    gst_tidmaibuftab_get_stats(self, &stats);
+
+    GST_INFO_OBJECT(owner, "%s buffers: %" G_GUINT64_FORMAT " handed out, %"
+        G_GUINT64_FORMAT " starvations, %" G_GUINT64_FORMAT " timeouts, "
+        "waited %" GST_TIME_FORMAT "\n", name, stats.gets, stats.starvations,
+        stats.timeouts, GST_TIME_ARGS(stats.waitTime));
+}
+
+
 /******************************************************************************
  * gst_tidmaibuftab_set_blocking
  ******************************************************************************/
@@ -183,7 +393,6 @@ void gst_tidmaibuftab_set_blocking(GstTIDmaiBufTab *self, gboolean blocking)
 GstTIDmaiBufTab* gst_tidmaibuftab_new(gint num_bufs, gint32 size,
                      Buffer_Attrs *attrs)
 {
-    Rendezvous_Attrs  rzvAttrs = Rendezvous_Attrs_DEFAULT;
     GstTIDmaiBufTab  *self;
 
     GST_LOG("begin new\n");
@@ -192,16 +401,23 @@ GstTIDmaiBufTab* gst_tidmaibuftab_new(gint num_bufs, gint32 size,
     g_return_val_if_fail(self != NULL, NULL);
 
     self->hBufTab     = BufTab_create(num_bufs, size, attrs);
-    self->hBufAvailRv = Rendezvous_create(Rendezvous_INFINITE, &rzvAttrs);
 
     pthread_mutex_init(&self->hGetBufMutex, NULL);
+    pthread_cond_init(&self->bufAvailCond, NULL);
 
-    if (!self->hBufTab || !self->hBufAvailRv) {
+    if (!self->hBufTab) {
         GST_ERROR("Failed to create a new GstTIDmaiBufTab object");
         gst_mini_object_unref(GST_MINI_OBJECT(self));
         return NULL;
     }
 
+    /* All buffers start out free */
+    self->freeStack   = g_new(gint, num_bufs);
+    self->onFreeStack = g_new0(gboolean, num_bufs);
+    while (num_bufs-- > 0) {
+        gst_tidmaibuftab_push_free(self, num_bufs);
+    }
+
     return self;
 }
 
@@ -32,7 +32,6 @@
 #include <ti/sdo/dmai/Dmai.h>
 #include <ti/sdo/dmai/BufTab.h>
 #include <ti/sdo/dmai/Buffer.h>
-#include <ti/sdo/dmai/Rendezvous.h>
 
 G_BEGIN_DECLS
 
@@ -56,21 +55,43 @@ G_BEGIN_DECLS
 /* Utility macros */
 #define GST_TIDMAIBUFTAB_BUFTAB(obj) \
     ((obj) ? GST_TIDMAIBUFTAB(obj)->hBufTab : NULL)
-#define GST_TIDMAIBUFTAB_BUFAVAIL_RV(obj) \
-    ((obj) ? GST_TIDMAIBUFTAB(obj)->hBufAvailRv : NULL)
 #define GST_TIDMAIBUFTAB_GETBUF_MUTEX(obj) \
     &(GST_TIDMAIBUFTAB(obj)->hGetBufMutex)
 
 typedef struct _GstTIDmaiBufTab      GstTIDmaiBufTab;
 typedef struct _GstTIDmaiBufTabClass GstTIDmaiBufTabClass;
+typedef struct _GstTIDmaiBufTabStats GstTIDmaiBufTabStats;
 
-/* _GstTIDmaiBufTab object */
+/* Counters kept by each GstTIDmaiBufTab */
+struct _GstTIDmaiBufTabStats {
+    guint64      gets;          /* buffers handed out                      */
+    guint64      starvations;   /* get calls that found no free buffer     */
+    guint64      timeouts;      /* waits that ended without a buffer       */
+    GstClockTime waitTime;      /* total time spent waiting for a buffer   */
+};
+
+/* _GstTIDmaiBufTab object
+ *
+ * Free buffers are kept on a stack of BufTab indexes, so getting and
+ * freeing a buffer does not scan the BufTab.  Buffers freed with
+ * gst_tidmaibuftab_free_buf go straight onto the stack; buffers whose
+ * useMask is cleared some other way are picked up by a scan of the BufTab
+ * when the stack runs empty.
+ */
 struct _GstTIDmaiBufTab {
-    GstMiniObject     parent_instance;
-    BufTab_Handle     hBufTab;
-    Rendezvous_Handle hBufAvailRv;
-    pthread_mutex_t   hGetBufMutex;
-    gboolean          blocking;
+    GstMiniObject        parent_instance;
+    BufTab_Handle        hBufTab;
+    pthread_mutex_t      hGetBufMutex;
+    pthread_cond_t       bufAvailCond;
+    gboolean             blocking;
+
+    /* Free list, protected by hGetBufMutex */
+    gint                *freeStack;
+    gboolean            *onFreeStack;
+    gint                 numFree;
+    gint                 numWaiting;
+
+    GstTIDmaiBufTabStats stats;
 };
 
 struct _GstTIDmaiBufTabClass {
@@ -82,6 +103,15 @@ GType            gst_tidmaibuftab_get_type(void);
 GstTIDmaiBufTab* gst_tidmaibuftab_new(gint num_bufs, gint32 size,
                      Buffer_Attrs *attrs);
 Buffer_Handle    gst_tidmaibuftab_get_buf(GstTIDmaiBufTab *self);
+Buffer_Handle    gst_tidmaibuftab_try_get_buf(GstTIDmaiBufTab *self);
+Buffer_Handle    gst_tidmaibuftab_get_buf_timed(GstTIDmaiBufTab *self,
+                     GstClockTime timeout);
+void             gst_tidmaibuftab_free_buf(GstTIDmaiBufTab *self,
+                     Buffer_Handle hBuf, UInt16 useMask);
+void             gst_tidmaibuftab_get_stats(GstTIDmaiBufTab *self,
+                     GstTIDmaiBufTabStats *stats);
+void             gst_tidmaibuftab_log_stats(GstTIDmaiBufTab *self,
+                     GstObject *owner, const gchar *name);
 void             gst_tidmaibuftab_set_blocking(GstTIDmaiBufTab *self,
                      gboolean blocking);
 void             gst_tidmaibuftab_ref(GstTIDmaiBufTab *self);
@@ -80,13 +80,20 @@ GST_DEBUG_CATEGORY_STATIC (gst_dmaiperf_debug);
 /* The message is variable length depending on configuration */
 #define GST_TIME_FORMAT_MAX_SIZE 4096
 
+/* Trace defaults: flush interval in ms and ring size in records */
+#define TRACE_INTERVAL 1000
+#define TRACE_CAPACITY 4096
+
 
 /* Element property identifier */
 enum
 {
   PROP_0,
   PROP_ENGINE_NAME,
-  PROP_PRINT_ARM_LOAD
+  PROP_PRINT_ARM_LOAD,
+  PROP_TRACE_LOCATION,
+  PROP_TRACE_MESSAGES,
+  PROP_TRACE_INTERVAL
 };
 
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -114,7 +121,6 @@ static gboolean gst_dmaiperf_start (GstBaseTransform * trans);
 static gboolean gst_dmaiperf_stop (GstBaseTransform * trans);
 static void gst_dmaiperf_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
-static void gst_dmaiperf_cpu_perf (GstClockTime factor_d, GstClockTime factor_n, GstDmaiperf *dmaiperf ,Int * load);
 
 /******************************************************************************
  * gst_dmaiperf_init
@@ -127,13 +133,17 @@ gst_dmaiperf_init (GstDmaiperf * dmaiperf, GstDmaiperfClass * gclass)
   dmaiperf->hDsp = NULL;
   dmaiperf->hEngine = NULL;
   dmaiperf->lastLoadstamp = GST_CLOCK_TIME_NONE;
-  dmaiperf->lastWorkload = 0;
   dmaiperf->fps = 0;
   dmaiperf->bps = 0;
   dmaiperf->engineName = NULL;
   dmaiperf->hCpu = NULL;
   dmaiperf->printArmLoad = FALSE;
   dmaiperf->error = NULL;
+  dmaiperf->cpuLoad = NULL;
+  dmaiperf->trace = NULL;
+  dmaiperf->traceLocation = NULL;
+  dmaiperf->traceMessages = FALSE;
+  dmaiperf->traceInterval = TRACE_INTERVAL;
 }
 
 /******************************************************************************
@@ -237,7 +247,21 @@ gst_dmaiperf_class_init (GstDmaiperfClass * klass)
       g_param_spec_boolean ("print-arm-load", "print-arm-load",
           "Print the CPU load info", FALSE, G_PARAM_WRITABLE));
 
-  
+  g_object_class_install_property (gobject_class, PROP_TRACE_LOCATION,
+      g_param_spec_string ("trace-location", "trace-location",
+          "Write a binary record per buffer to this file "
+          "(read it with gst-perf-trace)", NULL, G_PARAM_WRITABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TRACE_MESSAGES,
+      g_param_spec_boolean ("trace-messages", "trace-messages",
+          "Post binary records per buffer in perf-trace element messages",
+          FALSE, G_PARAM_WRITABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TRACE_INTERVAL,
+      g_param_spec_uint ("trace-interval", "trace-interval",
+          "Interval in ms at which trace records are flushed and the CPU "
+          "load is sampled", 1, G_MAXUINT, TRACE_INTERVAL, G_PARAM_WRITABLE));
+
   GST_LOG ("initialized class init\n");
 }
 
@@ -262,6 +286,19 @@ gst_dmaiperf_set_property (GObject * object, guint prop_id,
       dmaiperf->printArmLoad = g_value_get_boolean(value);
       break;
 
+    case PROP_TRACE_LOCATION:
+      g_free(dmaiperf->traceLocation);
+      dmaiperf->traceLocation = g_value_dup_string(value);
+      break;
+
+    case PROP_TRACE_MESSAGES:
+      dmaiperf->traceMessages = g_value_get_boolean(value);
+      break;
+
+    case PROP_TRACE_INTERVAL:
+      dmaiperf->traceInterval = g_value_get_uint(value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -270,6 +307,32 @@ gst_dmaiperf_set_property (GObject * object, guint prop_id,
   GST_LOG ("end set_property\n");
 }
 
+/******************************************************************************
+ * gst_dmaiperf_post_trace
+ *    Post flushed trace records in a "perf-trace" element message.  Runs on
+ *    the trace flush thread.
+ ******************************************************************************/
+static void
+gst_dmaiperf_post_trace (PerfTrace * trace,
+    const PerfTraceRecord * records, guint count, gpointer userData)
+{
+  GstDmaiperf *dmaiperf = GST_DMAIPERF (userData);
+  GstStructure *structure;
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_and_alloc (count * sizeof (PerfTraceRecord));
+  memcpy (GST_BUFFER_DATA (buffer), records, GST_BUFFER_SIZE (buffer));
+
+  structure = gst_structure_new ("perf-trace",
+      "records", GST_TYPE_BUFFER, buffer,
+      "record-size", G_TYPE_UINT, (guint) sizeof (PerfTraceRecord),
+      "count", G_TYPE_UINT, count, NULL);
+  gst_buffer_unref (buffer);
+
+  gst_element_post_message ((GstElement *) dmaiperf,
+      gst_message_new_element ((GstObject *) dmaiperf, structure));
+}
+
 /******************************************************************************
  * gst_dmaiperf_start
  *    Start measuring pipeline performance
@@ -307,6 +370,28 @@ gst_dmaiperf_start (GstBaseTransform * trans)
   if (dmaiperf->printArmLoad){
     Cpu_Attrs cpuAttrs = Cpu_Attrs_DEFAULT;
     dmaiperf->hCpu = Cpu_create(&cpuAttrs);
+
+    /* Keeps /proc/stat open and re-reads it every second */
+    dmaiperf->cpuLoad = cpu_load_new ();
+  }
+
+  if (dmaiperf->traceLocation || dmaiperf->traceMessages) {
+    dmaiperf->trace = perf_trace_new (GST_OBJECT_NAME (dmaiperf),
+        TRACE_CAPACITY);
+
+    if (!perf_trace_set_file (dmaiperf->trace, dmaiperf->traceLocation)) {
+      GST_ELEMENT_ERROR (dmaiperf, RESOURCE, OPEN_WRITE, (NULL),
+          ("failed to open trace file \"%s\"", dmaiperf->traceLocation));
+      perf_trace_free (dmaiperf->trace);
+      dmaiperf->trace = NULL;
+      return FALSE;
+    }
+
+    if (dmaiperf->traceMessages)
+      perf_trace_set_flush_func (dmaiperf->trace,
+          gst_dmaiperf_post_trace, dmaiperf);
+
+    perf_trace_start (dmaiperf->trace, dmaiperf->traceInterval);
   }
 
   dmaiperf->error = g_error_new(GST_CORE_ERROR,GST_CORE_ERROR_TAG,"Performance Information");
@@ -345,6 +430,16 @@ gst_dmaiperf_stop (GstBaseTransform * trans)
     dmaiperf->hCpu = NULL;
   }
 
+  if (dmaiperf->cpuLoad) {
+    cpu_load_free (dmaiperf->cpuLoad);
+    dmaiperf->cpuLoad = NULL;
+  }
+
+  if (dmaiperf->trace) {
+    perf_trace_free (dmaiperf->trace);
+    dmaiperf->trace = NULL;
+  }
+
   return TRUE;
 }
 
@@ -360,6 +455,13 @@ gst_dmaiperf_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   GST_LOG ("Transform function\n");
 
   GstClockTime time = gst_util_get_timestamp ();
+
+  if (dmaiperf->trace) {
+    perf_trace_record (dmaiperf->trace, time,
+        GST_BUFFER_TIMESTAMP_IS_VALID (buf) ?
+        GST_BUFFER_TIMESTAMP (buf) : G_MAXUINT64, GST_BUFFER_SIZE (buf));
+  }
+
   if (!GST_CLOCK_TIME_IS_VALID (dmaiperf->lastLoadstamp) ||
         (GST_CLOCK_TIME_IS_VALID (time) &&
             GST_CLOCK_DIFF (dmaiperf->lastLoadstamp, time) > GST_SECOND)) {
@@ -378,11 +480,15 @@ gst_dmaiperf_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
       dmaiperf->fps = 0;
       dmaiperf->bps = 0;
 
-      if (dmaiperf->hCpu){
-          Int load;
-          gst_dmaiperf_cpu_perf(factor_d, factor_n, dmaiperf, &load);
+      if (dmaiperf->cpuLoad){
+          guint16 load = 0;
+
+          if (cpu_load_sample (dmaiperf->cpuLoad, &load, NULL) < 0) {
+              GST_ELEMENT_WARNING (dmaiperf, STREAM, ENCODE, (NULL),
+                    ("can't read /proc/stat\n"));
+          }
           idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE - idx,
-              "CPU: %d; ",load);
+              "CPU: %d; ", load / 10);
       }
 
       if (dmaiperf->hDsp) {
@@ -421,36 +527,3 @@ gst_dmaiperf_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   return GST_FLOW_OK;;
 }
 
-/****************************************************************************
-* gst_dmaiperf_cpu_perf
-*    Returns the cpu's workload
-*****************************************************************************/
-static void
-gst_dmaiperf_cpu_perf (GstClockTime factor_d, GstClockTime factor_n,
-                        GstDmaiperf *dmaiperf, Int * load)
-{
-    FILE * pStat;
-
-    char str[4];
-    int workload[7];
-    int totalWorkload;
-
-    pStat = fopen ("/proc/stat", "r");
-    if ( fscanf (pStat,"%s%d%d%d%d%d%d%d", &str[0], &workload[0], &workload[1],
-                 &workload[2], &workload[3], &workload[4], &workload[5],
-                 &workload[6]) != 8){
-        GST_ELEMENT_WARNING (dmaiperf, STREAM, ENCODE, (NULL),
-              ("can't read /proc/stat\n"));
-        dmaiperf->lastWorkload = 0;
-        *load = 0;
-    } else {
-        totalWorkload =  workload[0] + workload[1] + workload[2] + workload[5] + workload[6];
-        if (dmaiperf->lastWorkload != 0){
-            *load = (totalWorkload - dmaiperf->lastWorkload) * factor_d / factor_n;
-        } else {
-            *load = 0;
-        }
-        dmaiperf->lastWorkload = totalWorkload;
-    }
-    fclose (pStat);
-}
@@ -33,6 +33,9 @@
 
 #include <ti/sdo/dmai/Dmai.h>
 
+#include "perf_trace.h"
+#include "cpu_load.h"
+
 G_BEGIN_DECLS
 
 /* Standard macros for maniuplating Dmaiperf objects */
@@ -66,10 +69,16 @@ struct _GstDmaiperf
 
   /* Element property */
   GstClockTime      lastLoadstamp;
-  int               lastWorkload;
   guint32           fps;
   guint32           bps;
   gboolean          printArmLoad;
+  CpuLoad           *cpuLoad;
+
+  /* Binary trace */
+  PerfTrace         *trace;
+  gchar             *traceLocation;
+  gboolean          traceMessages;
+  guint             traceInterval;
 };
 
 /* _GstDmaiperfClass object */
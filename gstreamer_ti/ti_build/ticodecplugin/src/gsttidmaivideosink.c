@@ -121,7 +121,10 @@ enum
   PROP_CAN_ACTIVATE_PULL,
   PROP_CONTIG_INPUT_BUF,
   PROP_USERPTR_BUFS,
-  PROP_HIDE_OSD
+  PROP_HIDE_OSD,
+  PROP_POOL_NEGOTIATION,
+  PROP_FRAMES_ZERO_COPY,
+  PROP_FRAMES_COPIED
 };
 
 enum
@@ -173,6 +176,9 @@ static gboolean
  gst_tidmaivideosink_event(GstBaseSink * bsink, GstEvent * event);
 static void 
     gst_tidmaivideosink_init_env(GstTIDmaiVideoSink *sink);
+static Buffer_Handle
+    gst_tidmaivideosink_find_disp_buf(GstTIDmaiVideoSink * sink,
+        GstBuffer * buf);
 static gboolean
     gst_tidmaivideosink_alloc_display_buffers(GstTIDmaiVideoSink * sink,
         Int32 bufSize);
@@ -312,6 +318,23 @@ static void gst_tidmaivideosink_class_init(GstTIDmaiVideoSinkClass * klass)
             "Initialize and hide the OSD during video playback",
             FALSE, G_PARAM_READWRITE));
 
+    g_object_class_install_property(gobject_class, PROP_POOL_NEGOTIATION,
+        g_param_spec_boolean("poolNegotiation", "Offer display buffers upstream",
+            "Allocate our own display buffers and hand them out to any "
+            "upstream element that does pad allocation.  Buffers that still "
+            "point to a display buffer are displayed without a copy",
+            FALSE, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_FRAMES_ZERO_COPY,
+        g_param_spec_uint64("framesZeroCopy", "Zero-copy frames",
+            "Number of frames displayed without a copy",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+    g_object_class_install_property(gobject_class, PROP_FRAMES_COPIED,
+        g_param_spec_uint64("framesCopied", "Copied frames",
+            "Number of frames copied to a display buffer",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
     /**
     * GstTIDmaiVideoSink::handoff:
     * @dmaisink: the dmaisink instance
@@ -425,6 +448,13 @@ static void gst_tidmaivideosink_init_env(GstTIDmaiVideoSink *sink)
         GST_LOG("Setting accelFrameCopy=%s\n",
                 sink->accelFrameCopy ? "TRUE" : "FALSE");
     }
+
+    if (gst_ti_env_is_defined("GST_TI_TIDmaiVideoSink_poolNegotiation")) {
+        sink->poolNegotiation =
+                gst_ti_env_get_boolean("GST_TI_TIDmaiVideoSink_poolNegotiation");
+        GST_LOG("Setting poolNegotiation=%s\n",
+                sink->poolNegotiation ? "TRUE" : "FALSE");
+    }
     
     GST_LOG("gst_tidmaivideosink_init_env - end\n");
 }
@@ -456,8 +486,11 @@ static void gst_tidmaivideosink_init(GstTIDmaiVideoSink * dmaisink,
     dmaisink->autoselect          = FALSE;
     dmaisink->prevVideoStd        = 0;
     dmaisink->useUserptrBufs      = FALSE;
+    dmaisink->poolNegotiation     = FALSE;
     dmaisink->hideOSD             = FALSE;
     dmaisink->hDispBufTab         = NULL;
+    dmaisink->framesZeroCopy      = 0;
+    dmaisink->framesCopied        = 0;
 
     dmaisink->signal_handoffs = DEFAULT_SIGNAL_HANDOFFS;
 
@@ -574,6 +607,9 @@ static void gst_tidmaivideosink_set_property(GObject * object, guint prop_id,
         case PROP_HIDE_OSD:
             sink->hideOSD = g_value_get_boolean(value);
             break;
+        case PROP_POOL_NEGOTIATION:
+            sink->poolNegotiation = g_value_get_boolean(value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -643,6 +679,15 @@ static void gst_tidmaivideosink_get_property(GObject * object, guint prop_id,
         case PROP_HIDE_OSD:
             g_value_set_boolean(value, sink->hideOSD);
             break;
+        case PROP_POOL_NEGOTIATION:
+            g_value_set_boolean(value, sink->poolNegotiation);
+            break;
+        case PROP_FRAMES_ZERO_COPY:
+            g_value_set_uint64(value, sink->framesZeroCopy);
+            break;
+        case PROP_FRAMES_COPIED:
+            g_value_set_uint64(value, sink->framesCopied);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -705,6 +750,16 @@ static GstFlowReturn gst_tidmaivideosink_buffer_alloc(GstBaseSink * bsink,
      * buffers.
      */
     if (!dmaisink->useUserptrBufs && dmaisink->hDisplay) {
+
+        /* In pool negotiation mode this only happens when the display could
+         * not use our own buffers; let upstream allocate its own instead.
+         */
+        if (dmaisink->poolNegotiation) {
+            GST_LOG_OBJECT(dmaisink, "display uses mmap buffers; not "
+                "offering display buffers");
+            return GST_FLOW_OK;
+        }
+
         GST_ELEMENT_ERROR(dmaisink, RESOURCE, FAILED,
             ("Cannot use pad buffer allocation after mmap buffers already "
              "in use\n"), (NULL));
@@ -725,6 +780,12 @@ static GstFlowReturn gst_tidmaivideosink_buffer_alloc(GstBaseSink * bsink,
         }
 
         if (!gst_tidmaivideosink_alloc_display_buffers(dmaisink, size)) {
+            if (dmaisink->poolNegotiation) {
+                GST_WARNING("Cannot allocate display buffers; upstream "
+                    "buffers will be copied\n");
+                dmaisink->useUserptrBufs = FALSE;
+                return GST_FLOW_OK;
+            }
             GST_ERROR("Failed to allocate display buffers");
             return GST_FLOW_UNEXPECTED;
         }
@@ -1310,6 +1371,10 @@ static gboolean gst_tidmaivideosink_exit_display(GstTIDmaiVideoSink * sink)
 {
     GST_DEBUG("Begin\n");
 
+    GST_INFO("%" G_GUINT64_FORMAT " frames displayed without a copy, %"
+        G_GUINT64_FORMAT " copied\n", sink->framesZeroCopy,
+        sink->framesCopied);
+
     if (sink->hResize) {
         GST_DEBUG("closing resizer\n");
         Resize_delete(sink->hResize);
@@ -1336,6 +1401,8 @@ static gboolean gst_tidmaivideosink_exit_display(GstTIDmaiVideoSink * sink)
 
     if (sink->hDispBufTab) {
         GST_DEBUG("freeing display buffers\n");
+        gst_tidmaibuftab_log_stats(sink->hDispBufTab,
+            GST_OBJECT(sink), "display");
         gst_tidmaibuftab_unref(sink->hDispBufTab);
         sink->hDispBufTab = NULL;
     }
@@ -1420,6 +1487,18 @@ static gboolean gst_tidmaivideosink_init_display(GstTIDmaiVideoSink * sink)
             #endif
         }
 
+        /* In pool negotiation mode the display buffers are always ours, so
+         * that they can be offered upstream even if pad allocation only
+         * starts after the first buffer.  Only V4L2 displays can use them.
+         */
+        #if defined(Platform_dm365) || defined(Platform_omap3530) || \
+          defined(Platform_dm3730) || defined(Platform_dm368)
+        if (sink->poolNegotiation &&
+            sink->dAttrs.displayStd == Display_Std_V4L2) {
+            sink->useUserptrBufs = TRUE;
+        }
+        #endif
+
         /* Allocate user-allocated display buffers, if requested */
         if (!sink->hDispBufTab && sink->useUserptrBufs) {
             if (!gst_tidmaivideosink_alloc_display_buffers(sink, 0)) {
@@ -1578,8 +1657,10 @@ static GstFlowReturn gst_tidmaivideosink_render(GstBaseSink * bsink,
     Buffer_Handle         hDispBuf     = NULL;
     Buffer_Handle         inBuf        = NULL;
     gboolean              inBufIsOurs  = FALSE;
+    gboolean              cpuCopy      = FALSE;
     GstTIDmaiVideoSink   *sink         = GST_TIDMAIVIDEOSINK(bsink);
     BufferGfx_Dimensions  dim;
+    BufferGfx_Dimensions  inDim;
     gchar                 dur_str[64];
     gchar                 ts_str[64];
     gfloat                heightper;
@@ -1604,6 +1685,8 @@ static GstFlowReturn gst_tidmaivideosink_render(GstBaseSink * bsink,
         inBufIsOurs = (sink->hDispBufTab &&
                           GST_TIDMAIBUFTAB_BUFTAB(sink->hDispBufTab) ==
                               Buffer_getBufTab(inBuf));
+    } else if ((inBuf = gst_tidmaivideosink_find_disp_buf(sink, buf))) {
+        inBufIsOurs = TRUE;
     } else {
         /* allocate DMAI buffer */
         if (sink->tempDmaiBuf == NULL) {
@@ -1635,14 +1718,16 @@ static GstFlowReturn gst_tidmaivideosink_render(GstBaseSink * bsink,
         }
         #endif
 
-        /* If contiguous input frame is not set then use memcpy to copy the 
-         * input buffer in contiguous dmai buffer.
+        /* If contiguous input frame is not set then the frame has to be
+         * copied by the CPU.  That is done below, straight into the display
+         * buffer unless the resizer or the color conversion needs it in
+         * contiguous memory.
          */
         if (sink->contiguousInputFrame) {
             Buffer_setUserPtr(inBuf, (Int8*)buf->data);
         }
         else {
-            memcpy(Buffer_getUserPtr(inBuf), buf->data, buf->size);
+            cpuCopy = TRUE;
         }
     }
 
@@ -1659,10 +1744,20 @@ static GstFlowReturn gst_tidmaivideosink_render(GstBaseSink * bsink,
         }
     }
 
+    /* Only the framecopy can be replaced by a copy from system memory */
+    if (cpuCopy && (sink->resizer ||
+            !gst_ti_copy_frame_supported(sink->dGfxAttrs.colorSpace) ||
+            (sink->cpu_dev == Cpu_Device_DM6467 &&
+             sink->dGfxAttrs.colorSpace != ColorSpace_YUV422PSEMI))) {
+        memcpy(Buffer_getUserPtr(inBuf), buf->data, buf->size);
+        cpuCopy = FALSE;
+    }
+
     /* If the input buffer originated from this element via pad allocation,
      * simply give it back to the display and continue.
      */
     if (inBufIsOurs) {
+        sink->framesZeroCopy++;
 
         /* Mark buffer as in-use by the display so it can't be re-used
          * until it comes back from Display_get */
@@ -1681,6 +1776,11 @@ static GstFlowReturn gst_tidmaivideosink_render(GstBaseSink * bsink,
      * display buffer to copy the contents into.
      */
     else {
+        if (sink->framesCopied++ == 0 && sink->poolNegotiation) {
+            GST_WARNING("upstream did not use our display buffers; copying "
+                "frames\n");
+        }
+
         if (Display_get(sink->hDisplay, &hDispBuf) < 0) {
             GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
             ("Failed to get display buffer\n"), (NULL));
@@ -1797,6 +1897,27 @@ static GstFlowReturn gst_tidmaivideosink_render(GstBaseSink * bsink,
                 ("Failed to execute CCV job\n"), (NULL));
                 goto cleanup;
             }
+        } else if (cpuCopy) {
+            /* Copy the visible part of the frame in one pass instead of a
+             * memcpy to the contiguous buffer followed by the framecopy.
+             */
+            BufferGfx_getDimensions(inBuf, &inDim);
+
+            if ((gint)buf->size < gst_ti_calc_buffer_size(inDim.width,
+                    inDim.height, inDim.lineLength,
+                    sink->dGfxAttrs.colorSpace)) {
+                GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
+                ("Input buffer is smaller than a frame\n"), (NULL));
+                goto cleanup;
+            }
+
+            if (!gst_ti_copy_frame(hDispBuf, buf->data,
+                    sink->dGfxAttrs.colorSpace, inDim.lineLength,
+                    inDim.height, 0, 0, inDim.width, inDim.height)) {
+                GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
+                ("Failed to copy frame\n"), (NULL));
+                goto cleanup;
+            }
         } else {
             if (Framecopy_config(sink->hFc, inBuf, hDispBuf) < 0) {
                 GST_ELEMENT_ERROR(sink, RESOURCE, FAILED,
@@ -2014,6 +2135,45 @@ static gboolean gst_tidmaivideosink_alloc_display_buffers(
 }
 
 
+/******************************************************************************
+ * gst_tidmaivideosink_find_disp_buf
+ *
+ * Return the display buffer the data of a non-DMAI buffer lives in, or NULL.
+ * This is the case for sub-buffers of the buffers we handed out, which other
+ * elements create for instance when they make the metadata of a buffer
+ * writable.  The display buffer must still be held by the pipeline, which
+ * keeps it alive until it has been displayed.  The lookup is part of
+ * poolNegotiation; without it these buffers are copied, and render does
+ * not pay for the scan.
+ ******************************************************************************/
+static Buffer_Handle gst_tidmaivideosink_find_disp_buf(
+                         GstTIDmaiVideoSink * sink, GstBuffer * buf)
+{
+    BufTab_Handle hBufTab;
+    Buffer_Handle hBuf;
+    Int           i;
+
+    if (!sink->poolNegotiation || !sink->hDispBufTab) {
+        return NULL;
+    }
+
+    hBufTab = GST_TIDMAIBUFTAB_BUFTAB(sink->hDispBufTab);
+
+    for (i = 0; i < BufTab_getNumBufs(hBufTab); i++) {
+        hBuf = BufTab_getBuf(hBufTab, i);
+
+        if ((guint8 *) Buffer_getUserPtr(hBuf) == GST_BUFFER_DATA(buf) &&
+            GST_BUFFER_SIZE(buf) <= Buffer_getSize(hBuf) &&
+            (Buffer_getUseMask(hBuf) & gst_tidmaibuffer_GST_FREE)) {
+            GST_LOG("non-DMAI buffer %p is display buffer %d\n", buf, i);
+            return hBuf;
+        }
+    }
+
+    return NULL;
+}
+
+
 /******************************************************************************
  * gst_tidmaivideosink_open_osd
  *    Open the OSD display on certain platforms.
@@ -99,8 +99,13 @@ struct _GstTIDmaiVideoSink {
 
   /* User-allocated Display Buffers */
   gboolean          useUserptrBufs;
+  gboolean          poolNegotiation;
   GstTIDmaiBufTab  *hDispBufTab;
 
+  /* Frames put to the display as they are, and frames copied first */
+  guint64           framesZeroCopy;
+  guint64           framesCopied;
+
   /* Attributes for hardware-accelerated frame-copies */
   Framecopy_Handle  hFc;
   Resize_Handle     hResize;
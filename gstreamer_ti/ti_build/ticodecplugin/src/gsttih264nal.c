@@ -0,0 +1,294 @@
+/*
+ * gsttih264nal.c
+ *
+ * This file implements the H.264 NAL start code search, with NEON and SSE2
+ * backends selected at run time and a scalar reference, and the conversion
+ * of byte-stream access units to length prefixed NAL units built on it.
+ * Nothing in here depends on DMAI, so it can be built and tested on any
+ * host.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <gst/gst.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "gsttisimd.h"
+#include "gsttih264nal.h"
+
+/* Local function declaration */
+static gint gst_h264_find_start_code_init (const guint8 *data, gint size);
+
+/* Start code search selected on first use */
+static gint (*gst_h264_find_start_code_fxn) (const guint8 *data, gint size) =
+    gst_h264_find_start_code_init;
+
+/******************************************************************************
+ * gst_h264_find_start_code_scalar
+ *  Reference start code search.  Returns the offset of the first 00 00 01
+ *  sequence in data, or size if there is none.  Looks at the third byte of
+ *  every candidate first: anything larger than 1 there rules out a start
+ *  code at all three positions ending on it.
+ *****************************************************************************/
+gint gst_h264_find_start_code_scalar (const guint8 *data, gint size)
+{
+    gint offset = 0;
+
+    while (offset + 2 < size) {
+        if (data[offset + 2] > 1) {
+            offset += 3;
+        }
+        else if (data[offset + 2] == 1) {
+            if (data[offset + 1] == 0 && data[offset] == 0) {
+                return offset;
+            }
+            offset += 3;
+        }
+        else {
+            offset++;
+        }
+    }
+
+    return size;
+}
+
+#if defined(__ARM_NEON__)
+/******************************************************************************
+ * gst_h264_find_start_code_neon
+ *  NEON start code search: tests 16 candidate positions per iteration by
+ *  comparing three overlapping loads against 00, 00 and 01.
+ *****************************************************************************/
+gint gst_h264_find_start_code_neon (const guint8 *data, gint size)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one  = vdupq_n_u8(1);
+    uint8x16_t       match;
+    uint8x8_t        fold;
+    gint             offset = 0, found;
+
+    while (offset + 18 <= size) {
+        match = vandq_u8(
+                    vandq_u8(vceqq_u8(vld1q_u8(data + offset), zero),
+                             vceqq_u8(vld1q_u8(data + offset + 1), zero)),
+                    vceqq_u8(vld1q_u8(data + offset + 2), one));
+
+        fold = vorr_u8(vget_low_u8(match), vget_high_u8(match));
+        fold = vpmax_u8(fold, fold);
+
+        if (vget_lane_u32(vreinterpret_u32_u8(fold), 0)) {
+            break;
+        }
+        offset += 16;
+    }
+
+    found = gst_h264_find_start_code_scalar(data + offset, size - offset);
+
+    return offset + found;
+}
+
+#elif defined(__SSE2__)
+/******************************************************************************
+ * gst_h264_find_start_code_sse2
+ *  SSE2 start code search: tests 16 candidate positions per iteration by
+ *  comparing three overlapping loads against 00, 00 and 01.
+ *****************************************************************************/
+gint gst_h264_find_start_code_sse2 (const guint8 *data, gint size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one  = _mm_set1_epi8(1);
+    __m128i       match;
+    gint          offset = 0, mask;
+
+    while (offset + 18 <= size) {
+        match = _mm_and_si128(
+                    _mm_and_si128(
+                        _mm_cmpeq_epi8(_mm_loadu_si128(
+                            (const __m128i*)(data + offset)), zero),
+                        _mm_cmpeq_epi8(_mm_loadu_si128(
+                            (const __m128i*)(data + offset + 1)), zero)),
+                    _mm_cmpeq_epi8(_mm_loadu_si128(
+                        (const __m128i*)(data + offset + 2)), one));
+
+        mask = _mm_movemask_epi8(match);
+        if (mask) {
+            return offset + __builtin_ctz(mask);
+        }
+        offset += 16;
+    }
+
+    return offset + gst_h264_find_start_code_scalar(data + offset,
+                        size - offset);
+}
+#endif
+
+/******************************************************************************
+ * gst_h264_find_start_code_init
+ *  Pick the fastest start code search this CPU supports, then run it.
+ *****************************************************************************/
+static gint gst_h264_find_start_code_init (const guint8 *data, gint size)
+{
+    gint (*fxn) (const guint8 *data, gint size);
+
+    fxn = gst_h264_find_start_code_scalar;
+
+#if defined(__ARM_NEON__)
+    if (gst_ti_cpu_has_neon()) {
+        fxn = gst_h264_find_start_code_neon;
+    }
+#elif defined(__SSE2__)
+    fxn = gst_h264_find_start_code_sse2;
+#endif
+
+    GST_LOG("using %s start code search\n",
+        fxn == gst_h264_find_start_code_scalar ? "scalar" : "SIMD");
+
+    gst_h264_find_start_code_fxn = fxn;
+
+    return fxn(data, size);
+}
+
+/******************************************************************************
+ * gst_h264_find_start_code
+ *  Find the next 3 or 4 byte NAL start code (00 00 01 or 00 00 00 01) in
+ *  data.  Returns the offset of its first byte, or size if there is none,
+ *  and stores the length of the start code in code_length.
+ *****************************************************************************/
+gint gst_h264_find_start_code (const guint8 *data, gint size,
+    gint *code_length)
+{
+    gint offset;
+
+    offset = gst_h264_find_start_code_fxn(data, size);
+
+    if (offset == size) {
+        GST_LOG ("Cannot find next NAL start code. returning %u\n", size);
+        *code_length = 0;
+        return size;
+    }
+
+    /* A zero byte in front of 00 00 01 makes it a 4 byte start code */
+    if (offset > 0 && data[offset - 1] == 0) {
+        *code_length = 4;
+        return offset - 1;
+    }
+
+    *code_length = 3;
+    return offset;
+}
+
+/******************************************************************************
+ * gst_h264_byte_stream_to_avc
+ *  Convert an access unit in byte-stream format to NAL units prefixed with
+ *  a 4 byte length, as carried in a packetized (avcC) stream.
+ *
+ *  The start codes are walked once.  While every NAL unit starts with a 4
+ *  byte start code and follows the previous one directly, the start code is
+ *  overwritten with the length in place.  Anything else (a 3 byte start
+ *  code, data before the first start code, zero bytes between NAL units)
+ *  makes the rest of the access unit be gathered into a new buffer.
+ *
+ *  Takes the reference to buf, which must be writable, and returns the
+ *  converted buffer, which may be buf itself.
+ *****************************************************************************/
+GstBuffer* gst_h264_byte_stream_to_avc (GstBuffer *buf)
+{
+    GstBuffer *outBuf = NULL;
+    guint8    *data, *out = NULL;
+    gint       size, offset, code_len, start, next, next_code_len, end;
+    gint       avcEnd = 0;
+
+    data = GST_BUFFER_DATA(buf);
+    size = GST_BUFFER_SIZE(buf);
+
+    offset = gst_h264_find_start_code(data, size, &code_len);
+    if (offset == size) {
+        GST_WARNING("no NAL start code in %u byte access unit\n", size);
+        return buf;
+    }
+
+    while (offset < size) {
+        start = offset + code_len;
+        next  = start + gst_h264_find_start_code(data + start, size - start,
+                            &next_code_len);
+
+        /* Leave out trailing zero bytes before the next start code */
+        end = next;
+        while (end > start && data[end - 1] == 0) {
+            end--;
+        }
+
+        if (!outBuf && (offset != avcEnd ||
+            code_len != NAL_START_CODE_LENGTH || end == start)) {
+
+            /* Each NAL unit grows by at most one byte and takes up at least
+             * four, which bounds the size of the gathered copy.
+             */
+            GST_LOG("copying access unit from offset %d\n", offset);
+            outBuf = gst_buffer_new_and_alloc(size + (size - avcEnd) / 4 + 4);
+            if (outBuf == NULL) {
+                GST_ERROR("failed to allocate buffer for AVC conversion\n");
+                gst_buffer_unref(buf);
+                return NULL;
+            }
+
+            out = GST_BUFFER_DATA(outBuf);
+            memcpy(out, data, avcEnd);
+            out += avcEnd;
+        }
+
+        if (!outBuf) {
+            GST_WRITE_UINT32_BE(data + offset, end - start);
+            avcEnd = end;
+        }
+        else if (end > start) {
+            GST_WRITE_UINT32_BE(out, end - start);
+            memcpy(out + NAL_START_CODE_LENGTH, data + start, end - start);
+            out += NAL_START_CODE_LENGTH + end - start;
+        }
+
+        offset   = next;
+        code_len = next_code_len;
+    }
+
+    if (!outBuf) {
+        GST_BUFFER_SIZE(buf) = avcEnd;
+        return buf;
+    }
+
+    GST_BUFFER_SIZE(outBuf) = out - GST_BUFFER_DATA(outBuf);
+    gst_buffer_copy_metadata(outBuf, buf, GST_BUFFER_COPY_ALL);
+    gst_buffer_unref(buf);
+
+    return outBuf;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,63 @@
+/*
+ * gsttih264nal.h
+ *
+ * This file declares the H.264 NAL start code search and the byte-stream to
+ * AVC conversion.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef __GST_TIH264NAL_H__
+#define __GST_TIH264NAL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Length of a 4 byte start code, and of the length prefix replacing it */
+#define NAL_START_CODE_LENGTH 4
+
+/* Function to find the next 3 or 4 byte NAL start code in h264 stream */
+gint gst_h264_find_start_code (const guint8 *data, gint size,
+    gint *code_length);
+
+/* Reference implementation of the start code search, without SIMD */
+gint gst_h264_find_start_code_scalar (const guint8 *data, gint size);
+
+/* The SIMD backend built for this architecture.  The NEON one may only be
+ * called when gst_ti_cpu_has_neon() says so.
+ */
+#if defined(__ARM_NEON__)
+gint gst_h264_find_start_code_neon (const guint8 *data, gint size);
+#elif defined(__SSE2__)
+gint gst_h264_find_start_code_sse2 (const guint8 *data, gint size);
+#endif
+
+/* Function to convert a byte-stream access unit to 4 byte length prefixed
+ * NAL units */
+GstBuffer* gst_h264_byte_stream_to_avc (GstBuffer *buf);
+
+G_END_DECLS
+
+#endif /* __GST_TIH264NAL_H__ */
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
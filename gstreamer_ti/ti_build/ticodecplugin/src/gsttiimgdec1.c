@@ -60,7 +60,8 @@ enum
   PROP_FRAMERATE,       /* frameRate      (int)     */
   PROP_RESOLUTION,      /* resolution     (string)  */
   PROP_DISPLAY_BUFFER,  /* displayBuffer  (boolean) */
-  PROP_GEN_TIMESTAMPS   /* genTimeStamps  (boolean) */
+  PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
+  PROP_CACHE_CODEC      /* cacheCodec     (boolean) */
 };
 
 /* Define sink (input) pad capabilities */
@@ -279,6 +280,13 @@ static void gst_tiimgdec1_class_init(GstTIImgdec1Class *klass)
             "Set timestamps on output buffers",
             TRUE, G_PARAM_WRITABLE));
 
+    g_object_class_install_property(gobject_class, PROP_CACHE_CODEC,
+        g_param_spec_boolean("cacheCodec", "Cache codec instance",
+            "Keep the codec and its engine open in a process-wide cache "
+            "when stopping, so the next element with the same settings can "
+            "reuse them (see GST_TI_CODEC_CACHE_SIZE/TIMEOUT)",
+            FALSE, G_PARAM_READWRITE));
+
     GST_LOG("Finish\n");
 }
 
@@ -319,6 +327,13 @@ static void gst_tiimgdec1_init_env(GstTIImgdec1 *imgdec1)
         GST_LOG("Setting genTimeStamps =%s\n", 
                     imgdec1->genTimeStamps ? "TRUE" : "FALSE");
     }
+
+    if (gst_ti_env_is_defined("GST_TI_TIImgdec1_cacheCodec")) {
+        imgdec1->cacheCodec = 
+                gst_ti_env_get_boolean("GST_TI_TIImgdec1_cacheCodec");
+        GST_LOG("Setting cacheCodec =%s\n", 
+                    imgdec1->cacheCodec ? "TRUE" : "FALSE");
+    }
     
     if (gst_ti_env_is_defined("GST_TI_TIImgdec1_framerate")) {
         imgdec1->framerateNum = gst_ti_env_get_int("GST_TI_TIImgdec1_framerate");
@@ -389,6 +404,7 @@ static void gst_tiimgdec1_init(GstTIImgdec1 *imgdec1, GstTIImgdec1Class *gclass)
     imgdec1->codecName          = NULL;
     imgdec1->displayBuffer      = FALSE;
     imgdec1->genTimeStamps      = FALSE;
+    imgdec1->cacheCodec         = FALSE;
     imgdec1->width              = 0;
     imgdec1->height             = 0;
 
@@ -480,6 +496,11 @@ static void gst_tiimgdec1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"genTimeStamps\" to \"%s\"\n",
                 imgdec1->genTimeStamps ? "TRUE" : "FALSE");
             break;
+        case PROP_CACHE_CODEC:
+            imgdec1->cacheCodec = g_value_get_boolean(value);
+            GST_LOG("setting \"cacheCodec\" to \"%s\"\n",
+                imgdec1->cacheCodec ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -506,6 +527,9 @@ static void gst_tiimgdec1_get_property(GObject *object, guint prop_id,
         case PROP_CODEC_NAME:
             g_value_set_string(value, imgdec1->codecName);
             break;
+        case PROP_CACHE_CODEC:
+            g_value_set_boolean(value, imgdec1->cacheCodec);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -1155,6 +1179,15 @@ static GstStateChangeReturn gst_tiimgdec1_change_state(GstElement *element,
     return ret;
 }
 
+/* Image decoder functions for the codec cache; each image is decoded on its
+ * own, so a cached decoder needs no reset.
+ */
+static const GstTICodecFxns gst_tiimgdec1_codec_fxns = {
+    (GstTICodecCreateFxn) Idec1_create,
+    NULL,
+    (GstTICodecDeleteFxn) Idec1_delete
+};
+
 /******************************************************************************
  * gst_tiimgdec1_codec_stop
  *     Stop codec engine
@@ -1176,20 +1209,20 @@ static gboolean gst_tiimgdec1_codec_stop (GstTIImgdec1  *imgdec1)
 
     if (imgdec1->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(imgdec1->hOutBufTab,
+            GST_OBJECT(imgdec1), "output");
         gst_tidmaibuftab_unref(imgdec1->hOutBufTab);
         imgdec1->hOutBufTab = NULL;
     }
 
+    /* The codec cache deletes the decoder and closes the engine, or keeps
+     * them for the next decoder */
     if (imgdec1->hIe) {
-        GST_LOG("closing image decoder\n");
-        Idec1_delete(imgdec1->hIe);
-        imgdec1->hIe = NULL;
-    }
-
-    if (imgdec1->hEngine) {
-        GST_LOG("closing codec engine\n");
-        Engine_close(imgdec1->hEngine);
+        GST_LOG("releasing image decoder\n");
+        gst_ti_codec_cache_release(imgdec1->hIe);
+        imgdec1->hIe     = NULL;
         imgdec1->hEngine = NULL;
+        gst_ti_codec_cache_post_stats(GST_ELEMENT(imgdec1));
     }
 
     return TRUE;
@@ -1204,32 +1237,27 @@ static gboolean gst_tiimgdec1_codec_start (GstTIImgdec1  *imgdec1)
 {
     BufferGfx_Attrs        gfxAttrs  = BufferGfx_Attrs_DEFAULT;
 
-    /* Open the codec engine */
-    GST_LOG("opening codec engine \"%s\"\n", imgdec1->engineName);
-    imgdec1->hEngine = Engine_open((Char *) imgdec1->engineName, NULL, NULL);
-
-    if (imgdec1->hEngine == NULL) {
-        GST_ELEMENT_ERROR(imgdec1, RESOURCE, FAILED,
-        ("failed to open codec engine \"%s\"\n", imgdec1->engineName), (NULL));
-        return FALSE;
-    }
-    GST_LOG("opened codec engine \"%s\" successfully\n", imgdec1->engineName);
-
     if (!gst_tiimgdec1_set_codec_attrs(imgdec1)) {
         GST_ELEMENT_ERROR(imgdec1, RESOURCE, FAILED,
         ("Error while trying to set the codec attrs\n"), (NULL));
         return FALSE;
     }
 
-    GST_LOG("opening image decoder \"%s\"\n", imgdec1->codecName);
-    imgdec1->hIe = Idec1_create(imgdec1->hEngine, (Char*)imgdec1->codecName,
-                      &imgdec1->params, &imgdec1->dynParams);
+    /* Open the codec engine and create the image decoder, or reuse a
+     * cached one */
+    GST_LOG("opening image decoder \"%s\" on codec engine \"%s\"\n",
+        imgdec1->codecName, imgdec1->engineName);
+    imgdec1->hIe = gst_ti_codec_cache_acquire(&gst_tiimgdec1_codec_fxns,
+                      imgdec1->engineName, imgdec1->codecName,
+                      &imgdec1->params, sizeof(imgdec1->params),
+                      &imgdec1->dynParams, sizeof(imgdec1->dynParams),
+                      imgdec1->cacheCodec, &imgdec1->hEngine);
 
     if (imgdec1->hIe == NULL) {
         GST_ELEMENT_ERROR(imgdec1, STREAM, CODEC_NOT_FOUND,
-        ("failed to create image decoder: %s\n", imgdec1->codecName), (NULL));
+        ("failed to create image decoder \"%s\" on codec engine \"%s\"\n",
+         imgdec1->codecName, imgdec1->engineName), (NULL));
         GST_DEBUG("Verify that the values being used for input and output ColorSpace are supported by your codec.\n");
-        GST_LOG("closing codec engine\n");
         return FALSE;
     }
 
@@ -1453,7 +1481,8 @@ static void* gst_tiimgdec1_decode_thread(void *arg)
         }
 
         /* Release buffers no longer in use by the codec */
-        Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(imgdec1->hOutBufTab, hDstBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
 thread_failure:
@@ -1470,7 +1499,8 @@ thread_exit:
     while (bufIdx-- > 0) {
         Buffer_Handle hBuf = BufTab_getBuf(
             GST_TIDMAIBUFTAB_BUFTAB(imgdec1->hOutBufTab), bufIdx);
-        Buffer_freeUseMask(hBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(imgdec1->hOutBufTab, hBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
     /* Release the last buffer we retrieved from the circular buffer */
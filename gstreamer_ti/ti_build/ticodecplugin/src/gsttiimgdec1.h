@@ -70,6 +70,7 @@ struct _GstTIImgdec1
   const gchar*              codecName;
   gboolean                  displayBuffer;
   gboolean                  genTimeStamps;
+  gboolean                  cacheCodec;
   /* Resolution input */
   gint                      width;
   gint                      height;
@@ -67,9 +67,16 @@ enum
   PROP_ICOLORSPACE,     /* iColorSpace    (string)  */
   PROP_OCOLORSPACE,     /* oColorSpace    (string)  */
   PROP_DISPLAY_BUFFER,  /* displayBuffer  (boolean) */
-  PROP_GEN_TIMESTAMPS   /* genTimeStamps  (boolean) */
+  PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
+  PROP_CACHE_CODEC,     /* cacheCodec     (boolean) */
+  PROP_FRAME_QUEUE      /* frameQueue     (boolean) */
 };
 
+/* Number of whole input frames that may wait for the encode thread when
+ * frameQueue=TRUE.  The circular buffer holds two frames as well.
+ */
+#define FRAME_QUEUE_DEPTH 2
+
 /* Codec Attributes for conversion function */
 enum
 {
@@ -146,6 +153,9 @@ static gboolean
  gst_tiimgenc1_sink_event(GstPad *pad, GstEvent *event);
 static GstFlowReturn
  gst_tiimgenc1_chain(GstPad *pad, GstBuffer *buf);
+static GstFlowReturn
+ gst_tiimgenc1_queue_frame(GstTIImgenc1 *imgenc1, GstPad *pad,
+     GstBuffer *buf);
 static gboolean
  gst_tiimgenc1_init_image(GstTIImgenc1 *imgenc1);
 static gboolean
@@ -337,6 +347,20 @@ static void gst_tiimgenc1_class_init(GstTIImgenc1Class *klass)
             "Set timestamps on output buffers",
             TRUE, G_PARAM_WRITABLE));
 
+    g_object_class_install_property(gobject_class, PROP_CACHE_CODEC,
+        g_param_spec_boolean("cacheCodec", "Cache codec instance",
+            "Keep the codec and its engine open in a process-wide cache "
+            "when stopping, so the next element with the same settings can "
+            "reuse them (see GST_TI_CODEC_CACHE_SIZE/TIMEOUT)",
+            FALSE, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_FRAME_QUEUE,
+        g_param_spec_boolean("frameQueue", "Queue whole frames",
+            "Hand each input buffer to the encoder as one whole image "
+            "instead of copying it through a circular buffer.  Buffers "
+            "from DMAI-aware elements are then encoded without a copy",
+            FALSE, G_PARAM_READWRITE));
+
     GST_LOG("Finish\n");
 }
 
@@ -378,6 +402,20 @@ static void gst_tiimgenc1_init_env(GstTIImgenc1 *imgenc1)
         GST_LOG("Setting genTimeStamps =%s\n", 
                     imgenc1->genTimeStamps ? "TRUE" : "FALSE");
     }
+
+    if (gst_ti_env_is_defined("GST_TI_TIImgenc1_cacheCodec")) {
+        imgenc1->cacheCodec = 
+                gst_ti_env_get_boolean("GST_TI_TIImgenc1_cacheCodec");
+        GST_LOG("Setting cacheCodec =%s\n", 
+                    imgenc1->cacheCodec ? "TRUE" : "FALSE");
+    }
+
+    if (gst_ti_env_is_defined("GST_TI_TIImgenc1_frameQueue")) {
+        imgenc1->frameQueue = 
+                gst_ti_env_get_boolean("GST_TI_TIImgenc1_frameQueue");
+        GST_LOG("Setting frameQueue =%s\n", 
+                    imgenc1->frameQueue ? "TRUE" : "FALSE");
+    }
     
     if (gst_ti_env_is_defined("GST_TI_TIImgenc1_framerate")) {
         imgenc1->framerateNum = gst_ti_env_get_int("GST_TI_TIImgenc1_framerate");
@@ -462,6 +500,8 @@ static void gst_tiimgenc1_init(GstTIImgenc1 *imgenc1, GstTIImgenc1Class *gclass)
     imgenc1->codecName          = NULL;
     imgenc1->displayBuffer      = FALSE;
     imgenc1->genTimeStamps      = FALSE;
+    imgenc1->cacheCodec         = FALSE;
+    imgenc1->frameQueue         = FALSE;
     imgenc1->iColor             = NULL;
     imgenc1->oColor             = NULL;
     imgenc1->qValue             = 0;
@@ -483,6 +523,10 @@ static void gst_tiimgenc1_init(GstTIImgenc1 *imgenc1, GstTIImgenc1Class *gclass)
     imgenc1->numOutputBufs      = 0UL;
     imgenc1->hOutBufTab         = NULL;
     imgenc1->circBuf            = NULL;
+    imgenc1->hInBuf             = NULL;
+    imgenc1->inQueue            = NULL;
+    imgenc1->hInBufTab          = NULL;
+    imgenc1->frameSize          = 0;
 
     gst_tiimgenc1_init_env(imgenc1);
 
@@ -590,6 +634,16 @@ static void gst_tiimgenc1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"genTimeStamps\" to \"%s\"\n",
                 imgenc1->genTimeStamps ? "TRUE" : "FALSE");
             break;
+        case PROP_CACHE_CODEC:
+            imgenc1->cacheCodec = g_value_get_boolean(value);
+            GST_LOG("setting \"cacheCodec\" to \"%s\"\n",
+                imgenc1->cacheCodec ? "TRUE" : "FALSE");
+            break;
+        case PROP_FRAME_QUEUE:
+            imgenc1->frameQueue = g_value_get_boolean(value);
+            GST_LOG("setting \"frameQueue\" to \"%s\"\n",
+                imgenc1->frameQueue ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -625,6 +679,12 @@ static void gst_tiimgenc1_get_property(GObject *object, guint prop_id,
         case PROP_ICOLORSPACE:
             g_value_set_string(value, imgenc1->iColor);
             break;
+        case PROP_CACHE_CODEC:
+            g_value_set_boolean(value, imgenc1->cacheCodec);
+            break;
+        case PROP_FRAME_QUEUE:
+            g_value_set_boolean(value, imgenc1->frameQueue);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -880,7 +940,20 @@ static gboolean gst_tiimgenc1_sink_event(GstPad *pad, GstEvent *event)
             ret = gst_pad_push_event(imgenc1->srcpad, event);
             break;
 
+        case GST_EVENT_FLUSH_START:
+            /* Unblock the encode thread downstream first, then drop the
+             * queued images so a chain call waiting on the queue returns.
+             */
+            ret = gst_pad_event_default(pad, event);
+            if (imgenc1->inQueue) {
+                gst_tibufferqueue_set_flushing(imgenc1->inQueue, TRUE);
+            }
+            break;
+
         case GST_EVENT_FLUSH_STOP:
+            if (imgenc1->inQueue) {
+                gst_tibufferqueue_set_flushing(imgenc1->inQueue, FALSE);
+            }
             ret = gst_pad_push_event(imgenc1->srcpad, event);
             break;
 
@@ -891,7 +964,6 @@ static gboolean gst_tiimgenc1_sink_event(GstPad *pad, GstEvent *event)
         case GST_EVENT_CUSTOM_DOWNSTREAM:
         case GST_EVENT_CUSTOM_DOWNSTREAM_OOB:
         case GST_EVENT_CUSTOM_UPSTREAM:
-        case GST_EVENT_FLUSH_START:
         case GST_EVENT_NAVIGATION:
         case GST_EVENT_QOS:
         case GST_EVENT_SEEK:
@@ -955,9 +1027,17 @@ static GstFlowReturn gst_tiimgenc1_chain(GstPad * pad, GstBuffer * buf)
             goto exit;
         }
 
-        GST_TICIRCBUFFER_TIMESTAMP(imgenc1->circBuf) =
-            GST_CLOCK_TIME_IS_VALID(GST_BUFFER_TIMESTAMP(buf)) ?
-            GST_BUFFER_TIMESTAMP(buf) : 0ULL;
+        if (imgenc1->circBuf) {
+            GST_TICIRCBUFFER_TIMESTAMP(imgenc1->circBuf) =
+                GST_CLOCK_TIME_IS_VALID(GST_BUFFER_TIMESTAMP(buf)) ?
+                GST_BUFFER_TIMESTAMP(buf) : 0ULL;
+        }
+    }
+
+    /* Hand whole frames straight to the encode thread */
+    if (imgenc1->inQueue) {
+        flow = gst_tiimgenc1_queue_frame(imgenc1, pad, buf);
+        goto exit;
     }
 
     /* Queue up the encoded data stream into a circular buffer */
@@ -973,6 +1053,91 @@ exit:
     return flow;
 }
 
+
+/******************************************************************************
+ * gst_tiimgenc1_queue_frame
+ *    Queue a whole input image for the encode thread.  Images that are
+ *    already in DMAI buffers are queued as they are; others are copied into
+ *    a contiguous buffer first, since the codec can't read them otherwise.
+ ******************************************************************************/
+static GstFlowReturn gst_tiimgenc1_queue_frame(GstTIImgenc1 *imgenc1,
+                         GstPad *pad, GstBuffer *buf)
+{
+    BufferGfx_Attrs  gfxAttrs = BufferGfx_Attrs_DEFAULT;
+    Buffer_Handle    hBuf;
+    GstBuffer       *frame;
+
+    if ((gint)GST_BUFFER_SIZE(buf) < imgenc1->frameSize) {
+        GST_ELEMENT_ERROR(imgenc1, STREAM, FORMAT,
+        ("if frameQueue=TRUE each input buffer must hold a whole image "
+         "(%d bytes)\n", imgenc1->frameSize), (NULL));
+        return GST_FLOW_UNEXPECTED;
+    }
+
+    if (GST_IS_TIDMAIBUFFERTRANSPORT(buf)) {
+        frame = gst_buffer_ref(buf);
+    }
+    else {
+        if ((gint)GST_BUFFER_SIZE(buf) > Ienc1_getInBufSize(imgenc1->hIe)) {
+            GST_ELEMENT_ERROR(imgenc1, STREAM, FORMAT,
+            ("input image is larger than the codec input buffer (%ld bytes)"
+             "\n", (long) Ienc1_getInBufSize(imgenc1->hIe)), (NULL));
+            return GST_FLOW_UNEXPECTED;
+        }
+
+        /* One buffer for each queued image, plus the one being encoded */
+        if (imgenc1->hInBufTab == NULL) {
+            GST_LOG("creating input buffer table\n");
+            gfxAttrs.bAttrs.memParams.align = 128;
+            gfxAttrs.bAttrs.useMask = gst_tidmaibuffer_CODEC_FREE;
+
+            imgenc1->hInBufTab = gst_tidmaibuftab_new(FRAME_QUEUE_DEPTH + 1,
+                Ienc1_getInBufSize(imgenc1->hIe),
+                BufferGfx_getBufferAttrs(&gfxAttrs));
+
+            if (imgenc1->hInBufTab == NULL) {
+                GST_ELEMENT_ERROR(imgenc1, RESOURCE, NO_SPACE_LEFT,
+                ("failed to create input buffers\n"), (NULL));
+                return GST_FLOW_UNEXPECTED;
+            }
+        }
+
+        if (!(hBuf = gst_tidmaibuftab_get_buf(imgenc1->hInBufTab))) {
+            GST_ELEMENT_ERROR(imgenc1, RESOURCE, READ,
+                ("failed to get a free contiguous buffer from BufTab\n"), 
+                (NULL));
+            return GST_FLOW_UNEXPECTED;
+        }
+
+        memcpy(Buffer_getUserPtr(hBuf), GST_BUFFER_DATA(buf),
+            GST_BUFFER_SIZE(buf));
+
+        /* Once queued the buffer is only held by the transport buffer */
+        frame = gst_tidmaibuffertransport_new(hBuf, imgenc1->hInBufTab);
+        gst_tidmaibuftab_free_buf(imgenc1->hInBufTab, hBuf,
+            gst_tidmaibuffer_CODEC_FREE);
+
+        if (frame == NULL) {
+            GST_ELEMENT_ERROR(imgenc1, RESOURCE, NO_SPACE_LEFT,
+            ("failed to create input transport buffer\n"), (NULL));
+            return GST_FLOW_UNEXPECTED;
+        }
+
+        gst_buffer_set_data(frame, GST_BUFFER_DATA(frame),
+            GST_BUFFER_SIZE(buf));
+        gst_buffer_copy_metadata(frame, buf, GST_BUFFER_COPY_TIMESTAMPS);
+    }
+
+    /* The queue only refuses the image once the encode thread has failed */
+    if (!gst_tibufferqueue_push(imgenc1->inQueue, frame)) {
+        GST_DEBUG("encode thread is not accepting images\n");
+        return GST_PAD_IS_FLUSHING(pad) ?
+                   GST_FLOW_WRONG_STATE : GST_FLOW_UNEXPECTED;
+    }
+
+    return GST_FLOW_OK;
+}
+
 /*******************************************************************************
  * gst_tiimgenc1_convert_fourcc
  *      This function will take in a fourcc value (as used in the format
@@ -1353,7 +1518,8 @@ static gboolean gst_tiimgenc1_init_image(GstTIImgenc1 *imgenc1)
      */
     Rendezvous_meet(imgenc1->waitOnEncodeThread);
 
-    if (imgenc1->circBuf == NULL || imgenc1->hOutBufTab == NULL) {
+    if ((imgenc1->circBuf == NULL && imgenc1->inQueue == NULL) ||
+        imgenc1->hOutBufTab == NULL) {
         GST_ELEMENT_ERROR(imgenc1, RESOURCE, FAILED,
         ("encode thread failed to create circbuf or display buffer handles\n"),
         (NULL));
@@ -1461,6 +1627,15 @@ static GstStateChangeReturn gst_tiimgenc1_change_state(GstElement *element,
     GST_LOG("Finish change_state\n");
     return ret;
 }
+/* Image encoder functions for the codec cache; each image is encoded on its
+ * own, so a cached encoder needs no reset.
+ */
+static const GstTICodecFxns gst_tiimgenc1_codec_fxns = {
+    (GstTICodecCreateFxn) Ienc1_create,
+    NULL,
+    (GstTICodecDeleteFxn) Ienc1_delete
+};
+
 /******************************************************************************
  * gst_tiimgenc1_codec_stop
  *     Stop codec engine
@@ -1480,22 +1655,43 @@ static gboolean gst_tiimgenc1_codec_stop (GstTIImgenc1  *imgenc1)
         gst_ticircbuffer_unref(circBuf);
     }
 
+    if (imgenc1->inQueue) {
+        GST_LOG("freeing input frame queue\n");
+        gst_tibufferqueue_free(imgenc1->inQueue);
+        imgenc1->inQueue      = NULL;
+        imgenc1->framerateNum = 0;
+        imgenc1->framerateDen = 0;
+    }
+
+    if (imgenc1->hInBufTab) {
+        GST_LOG("freeing input buffers\n");
+        gst_tidmaibuftab_log_stats(imgenc1->hInBufTab,
+            GST_OBJECT(imgenc1), "input");
+        gst_tidmaibuftab_unref(imgenc1->hInBufTab);
+        imgenc1->hInBufTab = NULL;
+    }
+
+    if (imgenc1->hInBuf) {
+        Buffer_delete(imgenc1->hInBuf);
+        imgenc1->hInBuf = NULL;
+    }
+
     if (imgenc1->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(imgenc1->hOutBufTab,
+            GST_OBJECT(imgenc1), "output");
         gst_tidmaibuftab_unref(imgenc1->hOutBufTab);
         imgenc1->hOutBufTab = NULL;
     }
 
+    /* The codec cache deletes the encoder and closes the engine, or keeps
+     * them for the next encoder */
     if (imgenc1->hIe) {
-        GST_LOG("closing image encoder\n");
-        Ienc1_delete(imgenc1->hIe);
-        imgenc1->hIe = NULL;
-    }
-
-    if (imgenc1->hEngine) {
-        GST_LOG("closing codec engine\n");
-        Engine_close(imgenc1->hEngine);
+        GST_LOG("releasing image encoder\n");
+        gst_ti_codec_cache_release(imgenc1->hIe);
+        imgenc1->hIe     = NULL;
         imgenc1->hEngine = NULL;
+        gst_ti_codec_cache_post_stats(GST_ELEMENT(imgenc1));
     }
 
     return TRUE;
@@ -1509,34 +1705,30 @@ static gboolean gst_tiimgenc1_codec_stop (GstTIImgenc1  *imgenc1)
 static gboolean gst_tiimgenc1_codec_start (GstTIImgenc1  *imgenc1)
 {
     BufferGfx_Attrs        gfxAttrs  = BufferGfx_Attrs_DEFAULT;
+    BufferGfx_Attrs        inAttrs   = BufferGfx_Attrs_DEFAULT;
     Int                    inBufSize;
 
-    /* Open the codec engine */
-    GST_LOG("opening codec engine \"%s\"\n", imgenc1->engineName);
-    imgenc1->hEngine = Engine_open((Char *) imgenc1->engineName, NULL, NULL);
-
-    if (imgenc1->hEngine == NULL) {
-        GST_ELEMENT_ERROR(imgenc1, RESOURCE, FAILED,
-        ("failed to open codec engine \"%s\"\n", imgenc1->engineName), (NULL));
-        return FALSE;
-    }
-    GST_LOG("opened codec engine \"%s\" successfully\n", imgenc1->engineName);
-
     if (!gst_tiimgenc1_set_codec_attrs(imgenc1)) {
         GST_ELEMENT_ERROR(imgenc1, RESOURCE, FAILED,
         ("Error while trying to set the codec attrs\n"), (NULL));
         return FALSE;
     }
 
-    GST_LOG("opening image encoder \"%s\"\n", imgenc1->codecName);
-    imgenc1->hIe = Ienc1_create(imgenc1->hEngine, (Char*)imgenc1->codecName,
-                      &imgenc1->params, &imgenc1->dynParams);
+    /* Open the codec engine and create the image encoder, or reuse a
+     * cached one */
+    GST_LOG("opening image encoder \"%s\" on codec engine \"%s\"\n",
+        imgenc1->codecName, imgenc1->engineName);
+    imgenc1->hIe = gst_ti_codec_cache_acquire(&gst_tiimgenc1_codec_fxns,
+                      imgenc1->engineName, imgenc1->codecName,
+                      &imgenc1->params, sizeof(imgenc1->params),
+                      &imgenc1->dynParams, sizeof(imgenc1->dynParams),
+                      imgenc1->cacheCodec, &imgenc1->hEngine);
 
     if (imgenc1->hIe == NULL) {
         GST_ELEMENT_ERROR(imgenc1, STREAM, CODEC_NOT_FOUND,
-        ("failed to create image encoder: %s\n", imgenc1->codecName), (NULL));
+        ("failed to create image encoder \"%s\" on codec engine \"%s\"\n",
+         imgenc1->codecName, imgenc1->engineName), (NULL));
         GST_DEBUG("Verify that the values being used for input and output ColorSpace are supported by your codec.\n");
-        GST_LOG("closing codec engine\n");
         return FALSE;
     }
 
@@ -1544,24 +1736,47 @@ static gboolean gst_tiimgenc1_codec_start (GstTIImgenc1  *imgenc1)
                 gst_tiimgenc1_convert_attrs(VAR_ICOLORSPACE, imgenc1))
                 * imgenc1->height;
 
-    /* Create a circular input buffer */
-    imgenc1->circBuf = gst_ticircbuffer_new(
-                           Ienc1_getInBufSize(imgenc1->hIe), 2, TRUE);
+    imgenc1->frameSize = inBufSize;
+
+    /* The encoder reads each image through this BufferGfx, which is pointed
+     * at the input data before every process call.
+     */
+    inAttrs.bAttrs.reference = TRUE;
+    imgenc1->hInBuf = Buffer_create(Ienc1_getInBufSize(imgenc1->hIe),
+                          BufferGfx_getBufferAttrs(&inAttrs));
 
-    if (imgenc1->circBuf == NULL) {
+    if (imgenc1->hInBuf == NULL) {
         GST_ELEMENT_ERROR(imgenc1, RESOURCE, NO_SPACE_LEFT,
-        ("failed to create circular input buffer\n"), (NULL));
+        ("failed to create input reference buffer\n"), (NULL));
         return FALSE;
     }
 
-    /* Calculate the maximum number of buffers allowed in queue before
-     * blocking upstream.
-     */
-    imgenc1->queueMaxBuffers = (inBufSize / imgenc1->upstreamBufSize) + 3;
-    GST_LOG("setting max queue threadshold to %d\n", imgenc1->queueMaxBuffers);
+    if (imgenc1->frameQueue) {
+        /* Create a queue of whole input images */
+        GST_LOG("queueing whole input images\n");
+        imgenc1->inQueue = gst_tibufferqueue_new(FRAME_QUEUE_DEPTH);
+    }
+    else {
+        /* Create a circular input buffer */
+        imgenc1->circBuf = gst_ticircbuffer_new(
+                               Ienc1_getInBufSize(imgenc1->hIe), 2, TRUE);
 
-    /* Display buffer contents if displayBuffer=TRUE was specified */
-    gst_ticircbuffer_set_display(imgenc1->circBuf, imgenc1->displayBuffer);
+        if (imgenc1->circBuf == NULL) {
+            GST_ELEMENT_ERROR(imgenc1, RESOURCE, NO_SPACE_LEFT,
+            ("failed to create circular input buffer\n"), (NULL));
+            return FALSE;
+        }
+
+        /* Calculate the maximum number of buffers allowed in queue before
+         * blocking upstream.
+         */
+        imgenc1->queueMaxBuffers = (inBufSize / imgenc1->upstreamBufSize) + 3;
+        GST_LOG("setting max queue threadshold to %d\n",
+            imgenc1->queueMaxBuffers);
+
+        /* Display buffer contents if displayBuffer=TRUE was specified */
+        gst_ticircbuffer_set_display(imgenc1->circBuf, imgenc1->displayBuffer);
+    }
 
     /* Define the number of display buffers to allocate.  This number must be
      * at least 1, but should be more if codecs don't return a display buffer
@@ -1609,14 +1824,13 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
     GstBuffer              *encDataWindow  = NULL;
     gboolean               codecFlushed    = FALSE;
     void                   *threadRet      = GstTIThreadSuccess;
-    BufferGfx_Attrs        gfxAttrs        = BufferGfx_Attrs_DEFAULT;
     Buffer_Handle          hDstBuf;
     Int32                  encDataConsumed;
     GstClockTime           encDataTime;
     GstClockTime           frameDuration;
-    Buffer_Handle          hEncDataWindow;
     BufferGfx_Dimensions   dim;
     GstBuffer              *outBuf;
+    GstFlowReturn          flowRet;
     Int                    bufIdx;
     Int                    ret;
 
@@ -1641,17 +1855,22 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
     /* Main thread loop */
     while (TRUE) {
 
-        /* Obtain an encoded data frame */
-        encDataWindow  = gst_ticircbuffer_get_data(imgenc1->circBuf);
-        encDataTime    = GST_BUFFER_TIMESTAMP(encDataWindow);
-        hEncDataWindow = GST_TIDMAIBUFFERTRANSPORT_DMAIBUF(encDataWindow);
+        /* Obtain a raw image.  The frame queue only comes back empty once
+         * it has been closed for draining or aborted.
+         */
+        if (imgenc1->inQueue) {
+            encDataWindow = gst_tibufferqueue_pop(imgenc1->inQueue);
+        }
+        else {
+            encDataWindow = gst_ticircbuffer_get_data(imgenc1->circBuf);
+        }
 
         /* If we received a data frame of zero size, there is no more data to
          * process -- exit the thread.  If we weren't told that we are
          * draining the pipeline, something is not right, so exit with an
          * error.
          */
-        if (GST_BUFFER_SIZE(encDataWindow) == 0) {
+        if (encDataWindow == NULL || GST_BUFFER_SIZE(encDataWindow) == 0) {
             GST_LOG("no image data remains\n");
             if (!imgenc1->drainingEOS) {
                 goto thread_failure;
@@ -1671,14 +1890,15 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
         /* Make sure the whole buffer is used for output */
         BufferGfx_resetDimensions(hDstBuf);
 
-        /* Create a BufferGfx object that will point to a reference buffer from
-         * The circular buffer.  This is needed for the encoder which requires
-         * that the input buffer be a BufferGfx object.
+        encDataTime    = GST_BUFFER_TIMESTAMP(encDataWindow);
+
+        /* Point the input BufferGfx at the image.  This is needed for the
+         * encoder which requires that the input buffer be a BufferGfx
+         * object.
          */
-        BufferGfx_getBufferAttrs(&gfxAttrs)->reference = TRUE;
-        imgenc1->hInBuf = Buffer_create(Buffer_getSize(hEncDataWindow),
-                                BufferGfx_getBufferAttrs(&gfxAttrs));
-        Buffer_setUserPtr(imgenc1->hInBuf, Buffer_getUserPtr(hEncDataWindow));
+        Buffer_setUserPtr(imgenc1->hInBuf,
+            (Int8 *) GST_BUFFER_DATA(encDataWindow));
+        Buffer_setSize(imgenc1->hInBuf, GST_BUFFER_SIZE(encDataWindow));
         Buffer_setNumBytesUsed(imgenc1->hInBuf, 
                                Buffer_getSize(imgenc1->hInBuf));
 
@@ -1694,10 +1914,7 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
         GST_LOG("invoking the image encoder\n");
         ret             = Ienc1_process(imgenc1->hIe, imgenc1->hInBuf, hDstBuf);
         encDataConsumed = (codecFlushed) ? 0 :
-                          Buffer_getNumBytesUsed(hEncDataWindow);
-
-        /* Delete the temporary Graphics buffer used for the encode process */
-        Buffer_delete(imgenc1->hInBuf);
+                          GST_BUFFER_SIZE(encDataWindow);
 
         if (ret < 0) {
             GST_ELEMENT_ERROR(imgenc1, STREAM, ENCODE, 
@@ -1716,11 +1933,17 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
             GST_LOG("Ienc1_process returned success code %d\n", ret); 
         }
 
-        /* Release the reference buffer, and tell the circular buffer how much
-         * data was consumed.
+        /* Release the input image, or tell the circular buffer how much data
+         * was consumed.
          */
-        ret = gst_ticircbuffer_data_consumed(imgenc1->circBuf, encDataWindow,
-                  encDataConsumed);
+        if (imgenc1->inQueue) {
+            gst_buffer_unref(encDataWindow);
+            ret = TRUE;
+        }
+        else {
+            ret = gst_ticircbuffer_data_consumed(imgenc1->circBuf,
+                      encDataWindow, encDataConsumed);
+        }
         encDataWindow = NULL;
 
         if (!ret) {
@@ -1755,24 +1978,38 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
         }
 
         /* Tell circular buffer how much time we consumed */
-        gst_ticircbuffer_time_consumed(imgenc1->circBuf, frameDuration);
+        if (imgenc1->circBuf) {
+            gst_ticircbuffer_time_consumed(imgenc1->circBuf, frameDuration);
+        }
 
         /* Push the transport buffer to the source pad */
         GST_LOG("pushing display buffer to source pad\n");
 
-        if (gst_pad_push(imgenc1->srcpad, outBuf) != GST_FLOW_OK) {
+        flowRet = gst_pad_push(imgenc1->srcpad, outBuf);
+
+        /* While flushing, drop the image and wait for the next one */
+        if (flowRet == GST_FLOW_WRONG_STATE && imgenc1->inQueue) {
+            GST_DEBUG("source pad is flushing; image dropped\n");
+        }
+        else if (flowRet != GST_FLOW_OK) {
             GST_DEBUG("push to source pad failed\n");
             goto thread_failure;
         }
 
         /* Release buffers no longer in use by the codec */
-        Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
+        gst_tidmaibuftab_free_buf(imgenc1->hOutBufTab, hDstBuf,
+            gst_tidmaibuffer_CODEC_FREE);
     }
 
 thread_failure:
 
     gst_tithread_set_status(imgenc1, TIThread_CODEC_ABORTED);
-    gst_ticircbuffer_consumer_aborted(imgenc1->circBuf);
+    if (imgenc1->inQueue) {
+        gst_tibufferqueue_abort(imgenc1->inQueue);
+    }
+    else {
+        gst_ticircbuffer_consumer_aborted(imgenc1->circBuf);
+    }
     threadRet = GstTIThreadFailure;
 
 thread_exit:
@@ -1785,12 +2022,16 @@ thread_exit:
         while (bufIdx-- > 0) {
             Buffer_Handle hBuf = BufTab_getBuf(
                 GST_TIDMAIBUFTAB_BUFTAB(imgenc1->hOutBufTab), bufIdx);
-            Buffer_freeUseMask(hBuf, gst_tidmaibuffer_CODEC_FREE);
+            gst_tidmaibuftab_free_buf(imgenc1->hOutBufTab, hBuf,
+                gst_tidmaibuffer_CODEC_FREE);
         }
     }
 
     /* Release the last buffer we retrieved from the circular buffer */
-    if (encDataWindow) {
+    if (encDataWindow && imgenc1->inQueue) {
+        gst_buffer_unref(encDataWindow);
+    }
+    else if (encDataWindow) {
         gst_ticircbuffer_data_consumed(imgenc1->circBuf, encDataWindow, 0);
     }
 
@@ -1837,7 +2078,12 @@ static void gst_tiimgenc1_drain_pipeline(GstTIImgenc1 *imgenc1)
     }
 
     imgenc1->drainingEOS = TRUE;
-    gst_ticircbuffer_drain(imgenc1->circBuf, TRUE);
+    if (imgenc1->inQueue) {
+        gst_tibufferqueue_close(imgenc1->inQueue);
+    }
+    else {
+        gst_ticircbuffer_drain(imgenc1->circBuf, TRUE);
+    }
 
     /* Tell the encode thread that it is ok to shut down */
     Rendezvous_force(imgenc1->waitOnEncodeThread);
@@ -27,6 +27,7 @@
 
 #include <gst/gst.h>
 #include "gstticircbuffer.h"
+#include "gsttibufferqueue.h"
 #include "gsttidmaibuftab.h"
 
 #include <xdc/std.h>
@@ -70,6 +71,8 @@ struct _GstTIImgenc1
   const gchar*              codecName;
   gboolean                  displayBuffer;
   gboolean                  genTimeStamps;
+  gboolean                  cacheCodec;
+  gboolean                  frameQueue;
   gchar*                    iColor;
   gchar*                    oColor;
   gint                      qValue;
@@ -87,6 +90,7 @@ struct _GstTIImgenc1
   gboolean                  capsSet;
   gint                      upstreamBufSize;
   gint                      queueMaxBuffers;
+  gint                      frameSize;
 
   /* Codec Parameters */
   IMGENC1_Params            params;
@@ -106,6 +110,13 @@ struct _GstTIImgenc1
   GstTIDmaiBufTab          *hOutBufTab;
   GstTICircBuffer           *circBuf;
   Buffer_Handle             hInBuf;
+
+  /* With frameQueue=TRUE whole input frames wait in inQueue instead of
+   * being copied into circBuf.  Frames that are not in DMAI buffers are
+   * copied into hInBufTab first.
+   */
+  GstTIBufferQueue          *inQueue;
+  GstTIDmaiBufTab          *hInBufTab;
 };
 
 /* _GstTIImgenc1Class object */
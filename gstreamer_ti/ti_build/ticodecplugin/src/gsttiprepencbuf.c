@@ -762,6 +762,8 @@ static gboolean gst_tiprepencbuf_exit(GstTIPrepEncBuf * prepencbuf)
 
     if (prepencbuf->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(prepencbuf->hOutBufTab,
+            GST_OBJECT(prepencbuf), "output");
         gst_tidmaibuftab_unref(prepencbuf->hOutBufTab);
         prepencbuf->hOutBufTab = NULL;
     }
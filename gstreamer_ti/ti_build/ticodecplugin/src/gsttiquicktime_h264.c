@@ -36,11 +36,13 @@
 #include "gstticodecs.h"
 
 /* NAL start code length (in byte) */
-#define NAL_START_CODE_LENGTH 4
 
 /* NAL start code */
 static unsigned int NAL_START_CODE=0x1000000;
 
+/* Segments gathered into one circular buffer queue operation */
+#define NAL_MAX_SEGMENTS 64
+
 /* Local function declaration */
 static int gst_h264_sps_pps_calBufSize(GstBuffer *codec_data);
 static GstBuffer* gst_h264_get_avcc_header (GstBuffer *buf);
@@ -191,52 +193,59 @@ int gst_h264_parse_and_queue (GstTICircBuffer *circBuf, GstBuffer *buf,
     GstBuffer *sps_pps_data, GstBuffer *nal_code_prefix, guint8 nal_length)
 {
     int i, nal_size=0, avail = GST_BUFFER_SIZE(buf);
-    GstBuffer *subBuf;
     guint8 *inBuf = GST_BUFFER_DATA(buf);
-    int offset = 0;
+    struct iovec segs[NAL_MAX_SEGMENTS];
+    int numSegs = 0;
 
     /* Put SPS and PPS data (prefixed with NAL code) in fifo */
-    if (!gst_ticircbuffer_queue_data(circBuf, sps_pps_data)) {
-        GST_ERROR("Failed to put SPS, PPS data in Fifo \n");
-        return FALSE;
-    }
-
-    do {
+    segs[numSegs].iov_base = GST_BUFFER_DATA(sps_pps_data);
+    segs[numSegs].iov_len  = GST_BUFFER_SIZE(sps_pps_data);
+    numSegs++;
+
+    /* Gather the NAL prefix code and payload of every NAL unit and queue
+     * them with a single circular buffer operation.  Only samples with
+     * more NAL units than fit in segs are queued in several pieces.
+     */
+    while (avail > nal_length) {
         nal_size = 0;
         for (i=0; i < nal_length; i++) {
             nal_size = (nal_size << 8) | inBuf[i];
         }
         inBuf += nal_length;
-        offset += nal_length;
-            
-        /* Put NAL prefix code in fifo */
-        if (!gst_ticircbuffer_queue_data(circBuf, nal_code_prefix)) {
-            GST_ERROR("Failed to put NAL code prefix\n");
-            return FALSE;
-        }
+        avail -= nal_length;
 
-        /* Get a child buffer starting with offset and end at nal_size */
-        subBuf = gst_buffer_create_sub(buf, offset, nal_size);
-        if (subBuf == NULL) {
-            GST_ERROR("Failed to get nal_size=%d buffer from adapater\n", 
-                    nal_size);
+        if (nal_size > avail) {
+            GST_ERROR("NAL size %d exceeds the %d bytes left in buffer\n",
+                    nal_size, avail);
             return FALSE;
         }
 
-        /* Put nal_size data from input buffer in fifo */
-        if (!gst_ticircbuffer_queue_data(circBuf, subBuf)) {
-            GST_ERROR("Failed to put NAL code prefix\n");
-            gst_buffer_unref(subBuf);
-            return FALSE;
+        if (numSegs + 2 > NAL_MAX_SEGMENTS) {
+            if (!gst_ticircbuffer_queue_segments(circBuf, NULL, segs,
+                    numSegs)) {
+                GST_ERROR("Failed to put NAL units in fifo\n");
+                return FALSE;
+            }
+            numSegs = 0;
         }
 
-        /* Unref the sub buffer */
-        gst_buffer_unref(subBuf);
+        segs[numSegs].iov_base = GST_BUFFER_DATA(nal_code_prefix);
+        segs[numSegs].iov_len  = GST_BUFFER_SIZE(nal_code_prefix);
+        numSegs++;
+
+        segs[numSegs].iov_base = inBuf;
+        segs[numSegs].iov_len  = nal_size;
+        numSegs++;
 
-        offset += nal_size;
         inBuf += nal_size;
-        avail -= (nal_size + nal_length);
-    }while (avail > 0);
+        avail -= nal_size;
+    }
+
+    /* The last piece carries the duration of the sample */
+    if (!gst_ticircbuffer_queue_segments(circBuf, buf, segs, numSegs)) {
+        GST_ERROR("Failed to put NAL units in fifo\n");
+        return FALSE;
+    }
 
     return TRUE;
 }
@@ -410,42 +419,6 @@ static int gst_h264_sps_pps_calBufSize (GstBuffer *codec_data)
     return sps_pps_size;
 }
 
-/******************************************************************************
- * gst_h264_find_next_nal_code
- *  Use Boyer-Moore string matching algorithm to find NAL start code.
- *****************************************************************************/
-static guint gst_h264_find_next_nal_code (Int8 *data, gint size)
-{
-    guint offset = 3;
-    unsigned int shift;
-    
-    while (offset < size) {
-        if (1 == data[offset]) {
-            shift = offset;
-            if (0 == data[--shift]) {
-                if (0 == data[--shift]) {
-                    if (0 == data[--shift]) {
-                        return shift;
-                    }
-                }
-            } 
-        offset += 4;
-    } 
-    else if (0 == data[offset]) {
-        /* maybe next byte is 1? */
-        offset++;
-    } 
-    else {
-        /* can jump 4 bytes forward */
-        offset += 4;
-    }
-  }
-
-  GST_LOG ("Cannot find next NAL start code. returning %u\n", size);
-
-  return size;
-}
-
 /******************************************************************************
  * gst_h264_create_sps_pps
  *  This function parses H.264 stream and returns sps and pps data.
@@ -455,25 +428,25 @@ static guint gst_h264_find_next_nal_code (Int8 *data, gint size)
 static gboolean gst_h264_create_sps_pps (Buffer_Handle hBuf, GstBuffer **sps, 
     GstBuffer **pps)
 {
-    guint         next, nal_len, size;
-    Int8          *data;
+    gint          next, nal_len, size, code_len, next_code_len;
+    guint8        *data;
     guint8        type, header;
 
-    data = Buffer_getUserPtr(hBuf);
+    data = (guint8*)Buffer_getUserPtr(hBuf);
     size = Buffer_getNumBytesUsed(hBuf);
 
-    next = gst_h264_find_next_nal_code(data, size);
+    next = gst_h264_find_start_code(data, size, &code_len);
     
     data += next;
     size -= next;
 
     GST_LOG("Found first start at %u\n", next);
 
-    while (size > 4) {
-        data += 4;
-        size -= 4;
+    while (size > code_len) {
+        data += code_len;
+        size -= code_len;
 
-        next = gst_h264_find_next_nal_code(data, size);
+        next = gst_h264_find_start_code(data, size, &next_code_len);
         nal_len = next;
 
         GST_LOG("Found next start at %u\n", next);
@@ -503,6 +476,7 @@ static gboolean gst_h264_create_sps_pps (Buffer_Handle hBuf, GstBuffer **sps,
 
         data += nal_len;
         size -= nal_len;
+        code_len = next_code_len;
     }
 
     return TRUE;
@@ -24,6 +24,7 @@
 
 #include <gst/gst.h>
 #include "gstticircbuffer.h"
+#include "gsttih264nal.h"
 
 /* Get version number from avcC atom  */
 #define AVCC_ATOM_GET_VERSION(header,pos) \
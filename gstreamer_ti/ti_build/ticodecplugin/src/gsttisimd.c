@@ -0,0 +1,233 @@
+/*
+ * gsttisimd.c
+ *
+ * This file implements the CPU feature checks and SIMD helpers shared by the
+ * elements.  Nothing in here depends on DMAI, so it can be built and tested
+ * on any host.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <gst/gst.h>
+
+#include "gsttisimd.h"
+
+/* Plane copy selected on first use */
+static void gst_ti_copy_plane_init(guint8 *dst, gint dstStride,
+    const guint8 *src, gint srcStride, gint width, gint lines);
+static void (*gst_ti_copy_plane_fxn)(guint8 *dst, gint dstStride,
+    const guint8 *src, gint srcStride, gint width, gint lines) =
+    gst_ti_copy_plane_init;
+
+/******************************************************************************
+ * gst_ti_cpu_has_neon
+ *    Check the ELF hardware capabilities for NEON; a NEON build can still end
+ *    up on a Cortex-A9 without it (e.g. Tegra 2).  Always FALSE on other
+ *    architectures.
+ *****************************************************************************/
+gboolean gst_ti_cpu_has_neon(void)
+{
+#if defined(__arm__)
+    unsigned long auxv[2];
+    gboolean      result = FALSE;
+    int           fd;
+
+    fd = open("/proc/self/auxv", O_RDONLY);
+    if (fd < 0) {
+        return FALSE;
+    }
+
+    while (read(fd, auxv, sizeof(auxv)) == sizeof(auxv) && auxv[0] != 0) {
+        /* AT_HWCAP, HWCAP_NEON */
+        if (auxv[0] == 16) {
+            result = (auxv[1] & (1 << 12)) != 0;
+            break;
+        }
+    }
+    close(fd);
+
+    return result;
+#else
+    return FALSE;
+#endif
+}
+
+/******************************************************************************
+ * gst_ti_copy_plane_scalar
+ *    Reference plane copy: one memcpy per line, or a single one when neither
+ *    plane has padding.
+ *****************************************************************************/
+void gst_ti_copy_plane_scalar(guint8 *dst, gint dstStride, const guint8 *src,
+         gint srcStride, gint width, gint lines)
+{
+    if (width == dstStride && width == srcStride) {
+        memcpy(dst, src, width * lines);
+        return;
+    }
+
+    while (lines-- > 0) {
+        memcpy(dst, src, width);
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+#if defined(__ARM_NEON__)
+/******************************************************************************
+ * gst_ti_copy_plane_neon
+ *    NEON plane copy: 64 bytes per iteration with the source prefetched a
+ *    few cache lines ahead, then 16 bytes, then the rest of the line.
+ *****************************************************************************/
+void gst_ti_copy_plane_neon(guint8 *dst, gint dstStride,
+                const guint8 *src, gint srcStride, gint width, gint lines)
+{
+    uint8x16_t a, b, c, d;
+    gint       x;
+
+    while (lines-- > 0) {
+        for (x = 0; x + 64 <= width; x += 64) {
+            __builtin_prefetch(src + x + 256);
+            a = vld1q_u8(src + x);
+            b = vld1q_u8(src + x + 16);
+            c = vld1q_u8(src + x + 32);
+            d = vld1q_u8(src + x + 48);
+            vst1q_u8(dst + x, a);
+            vst1q_u8(dst + x + 16, b);
+            vst1q_u8(dst + x + 32, c);
+            vst1q_u8(dst + x + 48, d);
+        }
+        for (; x + 16 <= width; x += 16) {
+            vst1q_u8(dst + x, vld1q_u8(src + x));
+        }
+        if (x < width) {
+            memcpy(dst + x, src + x, width - x);
+        }
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+#elif defined(__SSE2__)
+/******************************************************************************
+ * gst_ti_copy_plane_sse2
+ *    SSE2 plane copy.  Each line is copied with non-temporal stores once the
+ *    destination is 16 byte aligned: the CPU does not read a display buffer
+ *    back, so there is no point in pulling it into the cache.  Lines that
+ *    start at a different alignment each would leave partial write combining
+ *    buffers behind, so those are copied with memcpy.
+ *****************************************************************************/
+void gst_ti_copy_plane_sse2(guint8 *dst, gint dstStride,
+                const guint8 *src, gint srcStride, gint width, gint lines)
+{
+    __m128i a, b, c, d;
+    gint    x, head;
+
+    if (dstStride & 15) {
+        gst_ti_copy_plane_scalar(dst, dstStride, src, srcStride, width, lines);
+        return;
+    }
+
+    while (lines-- > 0) {
+        head = MIN((gint)(-(gintptr)dst & 15), width);
+        memcpy(dst, src, head);
+
+        for (x = head; x + 64 <= width; x += 64) {
+            a = _mm_loadu_si128((const __m128i*)(src + x));
+            b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+            c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+            d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+            _mm_stream_si128((__m128i*)(dst + x), a);
+            _mm_stream_si128((__m128i*)(dst + x + 16), b);
+            _mm_stream_si128((__m128i*)(dst + x + 32), c);
+            _mm_stream_si128((__m128i*)(dst + x + 48), d);
+        }
+        for (; x + 16 <= width; x += 16) {
+            _mm_stream_si128((__m128i*)(dst + x),
+                _mm_loadu_si128((const __m128i*)(src + x)));
+        }
+        if (x < width) {
+            memcpy(dst + x, src + x, width - x);
+        }
+
+        dst += dstStride;
+        src += srcStride;
+    }
+
+    _mm_sfence();
+}
+#endif
+
+/******************************************************************************
+ * gst_ti_copy_plane_init
+ *    Pick the fastest plane copy this CPU supports, then run it.
+ *****************************************************************************/
+static void gst_ti_copy_plane_init(guint8 *dst, gint dstStride,
+                const guint8 *src, gint srcStride, gint width, gint lines)
+{
+    void (*fxn)(guint8 *dst, gint dstStride, const guint8 *src,
+        gint srcStride, gint width, gint lines);
+
+    fxn = gst_ti_copy_plane_scalar;
+
+#if defined(__ARM_NEON__)
+    if (gst_ti_cpu_has_neon()) {
+        fxn = gst_ti_copy_plane_neon;
+    }
+#elif defined(__SSE2__)
+    fxn = gst_ti_copy_plane_sse2;
+#endif
+
+    GST_LOG("using %s plane copy\n",
+        fxn == gst_ti_copy_plane_scalar ? "scalar" : "SIMD");
+
+    gst_ti_copy_plane_fxn = fxn;
+
+    fxn(dst, dstStride, src, srcStride, width, lines);
+}
+
+/******************************************************************************
+ * gst_ti_copy_plane
+ *    Copy width bytes of lines lines from src to dst, stepping each by its
+ *    own stride.
+ *****************************************************************************/
+void gst_ti_copy_plane(guint8 *dst, gint dstStride, const guint8 *src,
+         gint srcStride, gint width, gint lines)
+{
+    if (width <= 0 || lines <= 0) {
+        return;
+    }
+
+    gst_ti_copy_plane_fxn(dst, dstStride, src, srcStride, width, lines);
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
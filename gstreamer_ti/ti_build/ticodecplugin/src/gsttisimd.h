@@ -0,0 +1,56 @@
+/*
+ * gsttisimd.h
+ *
+ * This file declares the CPU feature checks and SIMD helpers shared by the
+ * elements.  Nothing in here depends on DMAI.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef __GST_TISIMD_H__
+#define __GST_TISIMD_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Function to check whether the CPU we run on has NEON */
+gboolean gst_ti_cpu_has_neon(void);
+
+/* Functions to copy lines between planes with different strides */
+void gst_ti_copy_plane(guint8 *dst, gint dstStride, const guint8 *src,
+         gint srcStride, gint width, gint lines);
+void gst_ti_copy_plane_scalar(guint8 *dst, gint dstStride, const guint8 *src,
+         gint srcStride, gint width, gint lines);
+#if defined(__ARM_NEON__)
+void gst_ti_copy_plane_neon(guint8 *dst, gint dstStride, const guint8 *src,
+         gint srcStride, gint width, gint lines);
+#elif defined(__SSE2__)
+void gst_ti_copy_plane_sse2(guint8 *dst, gint dstStride, const guint8 *src,
+         gint srcStride, gint width, gint lines);
+#endif
+
+G_END_DECLS
+
+#endif /* __GST_TISIMD_H__ */
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
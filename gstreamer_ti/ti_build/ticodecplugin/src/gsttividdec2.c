@@ -66,6 +66,9 @@
 #define     DEFAULT_GENTIMESTAMP    TRUE
 #define     DEFAULT_RTCODECTHREAD   TRUE
 #define     DEFAULT_DISPLAY_BUFFER  FALSE
+#define     DEFAULT_MIRROR_BUFFER   FALSE
+#define     DEFAULT_QUEUE_DEPTH     0
+#define     DEFAULT_CACHE_CODEC     FALSE
 #define     DEFAULT_ENGINE_NAME     "unspecified"
 
 /* define platform specific defaults */
@@ -94,7 +97,10 @@ enum
   PROP_DISPLAY_BUFFER,  /* displayBuffer  (boolean) */
   PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
   PROP_RTCODECTHREAD,   /* rtCodecThread (boolean) */
-  PROP_PAD_ALLOC_OUTBUFS /* padAllocOutbufs (boolean) */
+  PROP_PAD_ALLOC_OUTBUFS, /* padAllocOutbufs (boolean) */
+  PROP_MIRROR_BUFFER,   /* mirrorBuffer   (boolean) */
+  PROP_QUEUE_DEPTH,     /* queueDepth     (int)     */
+  PROP_CACHE_CODEC      /* cacheCodec     (boolean) */
 };
 
 /* Define sink (input) pad capabilities.  Currently, MPEG and H264 are 
@@ -185,6 +191,12 @@ static GstStateChangeReturn
  gst_tividdec2_change_state(GstElement *element, GstStateChange transition);
 static void*
  gst_tividdec2_decode_thread(void *arg);
+static void*
+ gst_tividdec2_push_thread(void *arg);
+static gboolean
+ gst_tividdec2_push_buffer(GstTIViddec2 *viddec2, GstBuffer *outBuf);
+static void
+ gst_tividdec2_stop_push_thread(GstTIViddec2 *viddec2, gboolean drain);
 static void
  gst_tividdec2_drain_pipeline(GstTIViddec2 *viddec2);
 static GstClockTime
@@ -350,6 +362,26 @@ static void gst_tividdec2_class_init(GstTIViddec2Class *klass)
         g_param_spec_boolean("padAllocOutbufs", "Use pad allocation",
             "Try to allocate buffers with pad allocation",
             DEFAULT_PADALLOC, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_MIRROR_BUFFER,
+        g_param_spec_boolean("mirrorBuffer", "Mirror circular buffer",
+            "Map the circular input buffer twice so wrapped data does not "
+            "need to be copied back to its start (ARM-side codecs only)",
+            DEFAULT_MIRROR_BUFFER, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_QUEUE_DEPTH,
+        g_param_spec_int("queueDepth", "Output queue depth",
+            "Number of decoded frames queued for a separate thread that "
+            "pushes them downstream, so a blocking sink does not stall the "
+            "codec (0 = push from the decode thread)",
+            0, G_MAXINT32, DEFAULT_QUEUE_DEPTH, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_CACHE_CODEC,
+        g_param_spec_boolean("cacheCodec", "Cache codec instance",
+            "Keep the codec and its engine open in a process-wide cache "
+            "when stopping, so the next element with the same settings can "
+            "reuse them (see GST_TI_CODEC_CACHE_SIZE/TIMEOUT)",
+            DEFAULT_CACHE_CODEC, G_PARAM_READWRITE));
 }
 
 /******************************************************************************
@@ -381,6 +413,13 @@ static void gst_tividdec2_init_env(GstTIViddec2 *viddec2)
         GST_LOG("Setting displayBuffer=%s\n",
                  viddec2->displayBuffer  ? "TRUE" : "FALSE");
     }
+
+    if (gst_ti_env_is_defined("GST_TI_TIViddec2_mirrorBuffer")) {
+        viddec2->mirrorBuffer =
+                gst_ti_env_get_boolean("GST_TI_TIViddec2_mirrorBuffer");
+        GST_LOG("Setting mirrorBuffer=%s\n",
+                 viddec2->mirrorBuffer  ? "TRUE" : "FALSE");
+    }
  
     if (gst_ti_env_is_defined("GST_TI_TIViddec2_genTimeStamps")) {
         viddec2->genTimeStamps = 
@@ -420,6 +459,18 @@ static void gst_tividdec2_init_env(GstTIViddec2 *viddec2)
                     viddec2->padAllocOutbufs ? "TRUE" : "FALSE");
     }
 
+    if (gst_ti_env_is_defined("GST_TI_TIViddec2_queueDepth")) {
+        viddec2->queueDepth = gst_ti_env_get_int("GST_TI_TIViddec2_queueDepth");
+        GST_LOG("Setting queueDepth=%d\n", viddec2->queueDepth);
+    }
+
+    if (gst_ti_env_is_defined("GST_TI_TIViddec2_cacheCodec")) {
+        viddec2->cacheCodec = 
+                gst_ti_env_get_boolean("GST_TI_TIViddec2_cacheCodec");
+        GST_LOG("Setting cacheCodec =%s\n", 
+                    viddec2->cacheCodec ? "TRUE" : "FALSE");
+    }
+
     GST_LOG("gst_tividdec2_init_env - end\n");
 }
 
@@ -468,10 +519,13 @@ static void gst_tividdec2_init(GstTIViddec2 *viddec2, GstTIViddec2Class *gclass)
     viddec2->codecName          = NULL;
     viddec2->engineName         = NULL;
     viddec2->displayBuffer      = DEFAULT_DISPLAY_BUFFER;
+    viddec2->mirrorBuffer       = DEFAULT_MIRROR_BUFFER;
     viddec2->genTimeStamps      = DEFAULT_GENTIMESTAMP;
     viddec2->numOutputBufs      = DEFAULT_NUMOUTPUT_BUFS;
     viddec2->padAllocOutbufs    = DEFAULT_PADALLOC;
     viddec2->rtCodecThread      = DEFAULT_RTCODECTHREAD;
+    viddec2->queueDepth         = DEFAULT_QUEUE_DEPTH;
+    viddec2->cacheCodec         = DEFAULT_CACHE_CODEC;
     
     viddec2->codecName          = NULL;
 
@@ -483,6 +537,7 @@ static void gst_tividdec2_init(GstTIViddec2 *viddec2, GstTIViddec2Class *gclass)
 
     viddec2->waitOnDecodeThread = NULL;
     viddec2->waitOnDecodeDrain  = NULL;
+    viddec2->outQueue           = NULL;
 
     viddec2->hOutBufTab         = NULL;
     viddec2->circBuf            = NULL;
@@ -592,6 +647,21 @@ static void gst_tividdec2_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"padAllocOutbufs\" to \"%s\"\n",
                 viddec2->padAllocOutbufs ? "TRUE" : "FALSE");
             break;
+        case PROP_MIRROR_BUFFER:
+            viddec2->mirrorBuffer = g_value_get_boolean(value);
+            GST_LOG("setting \"mirrorBuffer\" to \"%s\"\n",
+                viddec2->mirrorBuffer ? "TRUE" : "FALSE");
+            break;
+        case PROP_QUEUE_DEPTH:
+            viddec2->queueDepth = g_value_get_int(value);
+            GST_LOG("setting \"queueDepth\" to \"%d\"\n",
+                viddec2->queueDepth);
+            break;
+        case PROP_CACHE_CODEC:
+            viddec2->cacheCodec = g_value_get_boolean(value);
+            GST_LOG("setting \"cacheCodec\" to \"%s\"\n",
+                viddec2->cacheCodec ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -633,6 +703,15 @@ static void gst_tividdec2_get_property(GObject *object, guint prop_id,
         case PROP_DISPLAY_BUFFER:
             g_value_set_boolean(value, viddec2->displayBuffer);
             break;
+        case PROP_MIRROR_BUFFER:
+            g_value_set_boolean(value, viddec2->mirrorBuffer);
+            break;
+        case PROP_QUEUE_DEPTH:
+            g_value_set_int(value, viddec2->queueDepth);
+            break;
+        case PROP_CACHE_CODEC:
+            g_value_set_boolean(value, viddec2->cacheCodec);
+            break;
         case PROP_NUM_OUTPUT_BUFS:
             g_value_set_int(value, viddec2->numOutputBufs);
             break;
@@ -1290,6 +1369,29 @@ static GstStateChangeReturn gst_tividdec2_change_state(GstElement *element,
     return ret;
 }
 
+/******************************************************************************
+ * gst_tividdec2_codec_reset
+ *     Reset a cached video decoder before it decodes a new stream
+ *****************************************************************************/
+static Bool gst_tividdec2_codec_reset (Ptr hCodec)
+{
+    VIDDEC2_DynamicParams  dynParams = Vdec2_DynamicParams_DEFAULT;
+    VIDDEC2_Status         decStatus;
+
+    decStatus.size     = sizeof(VIDDEC2_Status);
+    decStatus.data.buf = NULL;
+
+    return VIDDEC2_control(Vdec2_getVisaHandle((Vdec2_Handle) hCodec),
+               XDM_RESET, &dynParams, &decStatus) == VIDDEC2_EOK;
+}
+
+/* Video decoder functions for the codec cache */
+static const GstTICodecFxns gst_tividdec2_codec_fxns = {
+    (GstTICodecCreateFxn) Vdec2_create,
+    gst_tividdec2_codec_reset,
+    (GstTICodecDeleteFxn) Vdec2_delete
+};
+
 /******************************************************************************
  * gst_tividdec2_codec_stop
  *     free codec engine resources
@@ -1309,21 +1411,21 @@ static gboolean gst_tividdec2_codec_stop (GstTIViddec2  *viddec2)
 
     if (viddec2->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(viddec2->hOutBufTab,
+            GST_OBJECT(viddec2), "output");
         gst_tidmaibuftab_unref(viddec2->hOutBufTab);
         viddec2->hOutBufTab = NULL;
     }
 
-    /* Shut down remaining items */
+    /* Shut down remaining items; the codec cache deletes the decoder and
+     * closes the engine, or keeps them for the next decoder.
+     */
     if (viddec2->hVd) {
-        GST_LOG("closing video decoder\n");
-        Vdec2_delete(viddec2->hVd);
-        viddec2->hVd = NULL;
-    }
-
-    if (viddec2->hEngine) {
-        GST_LOG("closing codec engine\n");
-        Engine_close(viddec2->hEngine);
+        GST_LOG("releasing video decoder\n");
+        gst_ti_codec_cache_release(viddec2->hVd);
+        viddec2->hVd     = NULL;
         viddec2->hEngine = NULL;
+        gst_ti_codec_cache_post_stats(GST_ELEMENT(viddec2));
     }
 
     return TRUE;
@@ -1343,16 +1445,7 @@ static gboolean gst_tividdec2_codec_start (GstTIViddec2  *viddec2,
     Cpu_Device             device;
     ColorSpace_Type        colorSpace;
     Int                    defaultNumBufs;
-
-    /* Open the codec engine */
-    GST_LOG("opening codec engine \"%s\"\n", viddec2->engineName);
-    viddec2->hEngine = Engine_open((Char *) viddec2->engineName, NULL, NULL);
-
-    if (viddec2->hEngine == NULL) {
-        GST_ELEMENT_ERROR(viddec2, RESOURCE, FAILED,
-        ("failed to open codec engine \"%s\"\n", viddec2->engineName), (NULL));
-        return FALSE;
-    }
+    gboolean               mirror;
 
     /* Determine which device the application is running on */
     if (Cpu_getDevice(NULL, &device) < 0) {
@@ -1427,23 +1520,45 @@ static gboolean gst_tividdec2_codec_start (GstTIViddec2  *viddec2,
         params.maxHeight = viddec2->height;
     }
 
-    GST_LOG("opening video decoder \"%s\"\n", viddec2->codecName);
-    viddec2->hVd = Vdec2_create(viddec2->hEngine, (Char*)viddec2->codecName,
-                      &params, &dynParams);
+    /* Open the codec engine and create the video decoder, or reuse a
+     * cached one */
+    GST_LOG("opening video decoder \"%s\" on codec engine \"%s\"\n",
+        viddec2->codecName, viddec2->engineName);
+    viddec2->hVd = gst_ti_codec_cache_acquire(&gst_tividdec2_codec_fxns,
+                      viddec2->engineName, viddec2->codecName,
+                      &params, sizeof(params), &dynParams, sizeof(dynParams),
+                      viddec2->cacheCodec, &viddec2->hEngine);
 
     if (viddec2->hVd == NULL) {
         GST_ELEMENT_ERROR(viddec2, STREAM, CODEC_NOT_FOUND,
-        ("failed to create video decoder: %s\n", viddec2->codecName), (NULL));
-        GST_LOG("closing codec engine\n");
+        ("failed to create video decoder \"%s\" on codec engine \"%s\"\n",
+         viddec2->codecName, viddec2->engineName), (NULL));
         return FALSE;
     }
 
     /* Record that we haven't processed the first frame yet */
     viddec2->firstFrame = TRUE;
 
-    /* Create a circular input buffer */
-    viddec2->circBuf =
-        gst_ticircbuffer_new(Vdec2_getInBufSize(viddec2->hVd), 3, FALSE);
+    /* Create a circular input buffer.  A mirrored window that wraps is only
+     * contiguous in our virtual memory, so a codec running on the DSP would
+     * read past the end of the buffer.
+     */
+    mirror = viddec2->mirrorBuffer;
+    if (mirror &&
+        !gst_ti_codec_is_local(viddec2->engineName, viddec2->codecName)) {
+        GST_WARNING("codec \"%s\" does not run on the ARM, ignoring "
+            "mirrorBuffer\n", viddec2->codecName);
+        mirror = FALSE;
+    }
+
+    if (mirror) {
+        viddec2->circBuf = gst_ticircbuffer_new_mirrored(
+                               Vdec2_getInBufSize(viddec2->hVd), 3, FALSE);
+    }
+    else {
+        viddec2->circBuf =
+            gst_ticircbuffer_new(Vdec2_getInBufSize(viddec2->hVd), 3, FALSE);
+    }
 
     if (viddec2->circBuf == NULL) {
         GST_ELEMENT_ERROR(viddec2, RESOURCE, NO_SPACE_LEFT,
@@ -1593,6 +1708,21 @@ static void* gst_tividdec2_decode_thread(void *arg)
     /* Calculate the duration of a single frame in this stream */
     frameDuration = gst_tividdec2_frame_duration(viddec2);
 
+    /* Hand decoded frames to a separate thread for pushing, so the codec
+     * can work on the next frame while downstream blocks (e.g. on vsync).
+     */
+    if (viddec2->queueDepth > 0) {
+        viddec2->outQueue = gst_tibufferqueue_new(viddec2->queueDepth);
+
+        if (pthread_create(&viddec2->pushThread, NULL,
+                gst_tividdec2_push_thread, (void*)viddec2)) {
+            GST_WARNING("failed to create push thread; pushing from the "
+                "decode thread\n");
+            gst_tibufferqueue_free(viddec2->outQueue);
+            viddec2->outQueue = NULL;
+        }
+    }
+
     /* Main thread loop */
     while (TRUE) {
 
@@ -1682,7 +1812,8 @@ static void* gst_tividdec2_decode_thread(void *arg)
                 encDataConsumed = 1;
             }
 
-            BufTab_freeBuf(hDstBuf);
+            gst_tidmaibuftab_free_buf(viddec2->hOutBufTab, hDstBuf,
+                Buffer_getUseMask(hDstBuf));
             GST_ERROR("failed to decode video buffer\n");
         }
 
@@ -1693,7 +1824,8 @@ static void* gst_tividdec2_decode_thread(void *arg)
              * via the Vdec2_getFreeBuf API, so mark it as unused now.
              */
             if (codecRet == Dmai_EBITERROR) {
-                BufTab_freeBuf(hDstBuf);
+                gst_tidmaibuftab_free_buf(viddec2->hOutBufTab, hDstBuf,
+                    Buffer_getUseMask(hDstBuf));
 
                 /* If no encoded data was used we cannot find the next frame */
                 if (encDataConsumed == 0 && !codecFlushed) {
@@ -1782,7 +1914,7 @@ static void* gst_tividdec2_decode_thread(void *arg)
                     GST_TIME_ARGS (GST_BUFFER_TIMESTAMP(outBuf)),
                     GST_TIME_ARGS (GST_BUFFER_DURATION(outBuf)));
 
-            if (gst_pad_push(viddec2->srcpad, outBuf) != GST_FLOW_OK) {
+            if (!gst_tividdec2_push_buffer(viddec2, outBuf)) {
                 GST_DEBUG("push to source pad failed\n");
                 goto thread_failure;
             }
@@ -1793,7 +1925,8 @@ static void* gst_tividdec2_decode_thread(void *arg)
         /* Release buffers no longer in use by the codec */
         hFreeBuf = Vdec2_getFreeBuf(viddec2->hVd);
         while (hFreeBuf) {
-            Buffer_freeUseMask(hFreeBuf, gst_tidmaibuffer_CODEC_FREE);
+            gst_tidmaibuftab_free_buf(viddec2->hOutBufTab, hFreeBuf,
+                gst_tidmaibuffer_CODEC_FREE);
             hFreeBuf = Vdec2_getFreeBuf(viddec2->hVd);
         }
 
@@ -1807,6 +1940,10 @@ thread_failure:
 
 thread_exit:
 
+    /* Push out the frames still queued, or drop them if we failed */
+    gst_tividdec2_stop_push_thread(viddec2,
+        threadRet != GstTIThreadFailure);
+
     /* Re-claim any buffers owned by the codec */
     if (viddec2->hOutBufTab) {
         bufIdx =
@@ -1815,7 +1952,8 @@ thread_exit:
         while (bufIdx-- > 0) {
             Buffer_Handle hBuf = BufTab_getBuf(
                 GST_TIDMAIBUFTAB_BUFTAB(viddec2->hOutBufTab), bufIdx);
-            Buffer_freeUseMask(hBuf, gst_tidmaibuffer_CODEC_FREE);
+            gst_tidmaibuftab_free_buf(viddec2->hOutBufTab, hBuf,
+                gst_tidmaibuffer_CODEC_FREE);
         }
     }
 
@@ -1852,6 +1990,84 @@ thread_exit:
 }
 
 
+/******************************************************************************
+ * gst_tividdec2_push_thread
+ *     Push decoded frames queued by the decode thread to the source pad.
+ ******************************************************************************/
+static void* gst_tividdec2_push_thread(void *arg)
+{
+    GstTIViddec2  *viddec2   = GST_TIVIDDEC2(gst_object_ref(arg));
+    void          *threadRet = GstTIThreadSuccess;
+    GstBuffer     *outBuf;
+
+    GST_LOG("init video push_thread\n");
+
+    while ((outBuf = gst_tibufferqueue_pop(viddec2->outQueue))) {
+        if (gst_pad_push(viddec2->srcpad, outBuf) != GST_FLOW_OK) {
+            GST_DEBUG("push to source pad failed\n");
+
+            /* Make the decode thread fail on its next push */
+            gst_tibufferqueue_abort(viddec2->outQueue);
+            threadRet = GstTIThreadFailure;
+            break;
+        }
+    }
+
+    gst_object_unref(viddec2);
+
+    GST_LOG("exit video push_thread (%d)\n", (int)threadRet);
+    return threadRet;
+}
+
+
+/******************************************************************************
+ * gst_tividdec2_push_buffer
+ *     Send a decoded frame downstream, through the push thread if there is
+ *     one.  Returns FALSE if downstream refused it.
+ ******************************************************************************/
+static gboolean gst_tividdec2_push_buffer(GstTIViddec2 *viddec2,
+                    GstBuffer *outBuf)
+{
+    if (viddec2->outQueue) {
+        return gst_tibufferqueue_push(viddec2->outQueue, outBuf);
+    }
+
+    return gst_pad_push(viddec2->srcpad, outBuf) == GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * gst_tividdec2_stop_push_thread
+ *     Wait for the push thread to finish.  If drain is TRUE it pushes the
+ *     frames still queued first, otherwise they are dropped.
+ ******************************************************************************/
+static void gst_tividdec2_stop_push_thread(GstTIViddec2 *viddec2,
+                gboolean drain)
+{
+    void *threadRet;
+
+    if (!viddec2->outQueue) {
+        return;
+    }
+
+    if (drain) {
+        gst_tibufferqueue_close(viddec2->outQueue);
+    }
+    else {
+        gst_tibufferqueue_abort(viddec2->outQueue);
+    }
+
+    if (pthread_join(viddec2->pushThread, &threadRet) == 0) {
+        if (threadRet == GstTIThreadFailure) {
+            GST_DEBUG("push thread exited with an error condition\n");
+        }
+    }
+
+    gst_tibufferqueue_free(viddec2->outQueue);
+    viddec2->outQueue = NULL;
+}
+
+
 /******************************************************************************
  * gst_tividdec2_drain_pipeline
  *    Wait for the decode thread to finish processing queued input data.
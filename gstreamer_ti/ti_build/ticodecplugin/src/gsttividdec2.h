@@ -28,6 +28,7 @@
 #include <gst/gst.h>
 #include "gstticircbuffer.h"
 #include "gsttidmaibuftab.h"
+#include "gsttibufferqueue.h"
 
 #include <xdc/std.h>
 #include <ti/sdo/ce/Engine.h>
@@ -68,8 +69,10 @@ struct _GstTIViddec2
   const gchar*   engineName;
   const gchar*   codecName;
   gboolean       displayBuffer;
+  gboolean       mirrorBuffer;
   gboolean       genTimeStamps;
   gboolean       rtCodecThread;
+  gboolean       cacheCodec;
 
   /* Element state */
   Engine_Handle    hEngine;
@@ -85,6 +88,11 @@ struct _GstTIViddec2
   Rendezvous_Handle  waitOnDecodeThread;
   Rendezvous_Handle  waitOnDecodeDrain;
 
+  /* Output push thread; decoded frames wait in outQueue for it */
+  gint               queueDepth;
+  pthread_t          pushThread;
+  GstTIBufferQueue  *outQueue;
+
   /* Framerate */
   GValue             framerate;
 
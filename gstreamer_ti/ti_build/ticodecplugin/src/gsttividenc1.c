@@ -69,6 +69,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_tividenc1_debug);
 #define     DEFAULT_CONTIG_INPUT_BUF    FALSE
 #define     DEFAULT_GENTIMESTAMP        TRUE
 #define     DEFAULT_ENGINE_NAME         "unspecified"
+#define     DEFAULT_CACHE_CODEC         FALSE
+#define     DEFAULT_QUEUE_DEPTH         0
 
 #if defined(Platform_dm365) || defined(Platform_dm368) || defined(Platform_dm6467) \
     || defined(Platform_dm6467t)
@@ -100,7 +102,9 @@ enum
   PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
   PROP_RATE_CTRL_PRESET,/* rateControlPreset  (gint) */
   PROP_ENCODING_PRESET, /* encodingPreset  (gint) */
-  PROP_BYTE_STREAM      /* byteStream      (gboolean) */
+  PROP_BYTE_STREAM,     /* byteStream      (gboolean) */
+  PROP_CACHE_CODEC,     /* cacheCodec      (gboolean) */
+  PROP_QUEUE_DEPTH      /* queueDepth      (int)     */
 
 };
 
@@ -182,6 +186,12 @@ static gboolean
  gst_tividenc1_codec_start (GstTIVidenc1 *videnc1);
 static gboolean
  gst_tividenc1_codec_stop (GstTIVidenc1 *videnc1);
+static void*
+ gst_tividenc1_encode_thread(void *arg);
+static void
+ gst_tividenc1_start_encode_thread(GstTIVidenc1 *videnc1);
+static void
+ gst_tividenc1_stop_encode_thread(GstTIVidenc1 *videnc1, gboolean drain);
 
 /******************************************************************************
  * gst_tividenc1_class_init_trampoline
@@ -333,6 +343,26 @@ static void gst_tividenc1_class_init(GstTIVidenc1Class *klass)
         g_param_spec_boolean("genTimeStamps", "Generate Time Stamps",
             "Set timestamps on output buffers",
             DEFAULT_GENTIMESTAMP, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_CACHE_CODEC,
+        g_param_spec_boolean("cacheCodec", "Cache codec instance",
+            "Keep the codec and its engine open in a process-wide cache "
+            "when stopping, so the next element with the same settings can "
+            "reuse them (see GST_TI_CODEC_CACHE_SIZE/TIMEOUT)",
+            DEFAULT_CACHE_CODEC, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_NUM_OUTPUT_BUFS,
+        g_param_spec_int("numOutputBufs", "Number of output buffers",
+            "Number of buffers the encoder writes into and pushes downstream "
+            "without copying (0 = copy each frame into a new buffer)",
+            0, G_MAXINT32, DEFAULT_NUMOUTPUT_BUFS, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_QUEUE_DEPTH,
+        g_param_spec_int("queueDepth", "Input queue depth",
+            "Number of input frames queued for a separate thread that "
+            "encodes them, so upstream capture and encode overlap "
+            "(0 = encode on the streaming thread)",
+            0, G_MAXINT32, DEFAULT_QUEUE_DEPTH, G_PARAM_READWRITE));
 }
 
 /******************************************************************************
@@ -391,6 +421,7 @@ static void gst_tividenc1_init(GstTIVidenc1 *videnc1, GstTIVidenc1Class *gclass)
 
     videnc1->sinkAdapter            = NULL;
     videnc1->inBufMetadata          = NULL;
+    videnc1->hOutBufTab             = NULL;
     videnc1->hEncOutBuf             = NULL;
     videnc1->hContigInBuf           = DEFAULT_CONTIG_INPUT_BUF;
     videnc1->hInBufRef              = NULL;
@@ -409,7 +440,11 @@ static void gst_tividenc1_init(GstTIVidenc1 *videnc1, GstTIVidenc1Class *gclass)
     videnc1->contiguousInputFrame   = DEFAULT_CONTIG_INPUT_BUF;
     videnc1->encodingPreset         = DEFAULT_ENCODING_PRESET;
     videnc1->byteStream             = DEFAULT_BYTE_STREAM;
+    videnc1->cacheCodec             = DEFAULT_CACHE_CODEC;
     videnc1->codec_data             = NULL;
+    videnc1->numOutputBufs          = DEFAULT_NUMOUTPUT_BUFS;
+    videnc1->queueDepth             = DEFAULT_QUEUE_DEPTH;
+    videnc1->inQueue                = NULL;
 
     /* Initialize GValue members */
     memset(&videnc1->framerate, 0, sizeof(GValue));
@@ -517,11 +552,26 @@ static void gst_tividenc1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"byteStream\" to \"%s\"\n",
                 videnc1->byteStream ? "TRUE" : "FALSE");
             break;
+        case PROP_CACHE_CODEC:
+            videnc1->cacheCodec = g_value_get_boolean(value);
+            GST_LOG("setting \"cacheCodec\" to \"%s\"\n",
+                videnc1->cacheCodec ? "TRUE" : "FALSE");
+            break;
         case PROP_GEN_TIMESTAMPS:
             videnc1->genTimeStamps = g_value_get_boolean(value);
             GST_LOG("setting \"genTimeStamps\" to \"%s\"\n",
                 videnc1->genTimeStamps ? "TRUE" : "FALSE");
             break;
+        case PROP_NUM_OUTPUT_BUFS:
+            videnc1->numOutputBufs = g_value_get_int(value);
+            GST_LOG("setting \"numOutputBufs\" to \"%d\"\n",
+                videnc1->numOutputBufs);
+            break;
+        case PROP_QUEUE_DEPTH:
+            videnc1->queueDepth = g_value_get_int(value);
+            GST_LOG("setting \"queueDepth\" to \"%d\"\n",
+                videnc1->queueDepth);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -563,6 +613,9 @@ static void gst_tividenc1_get_property(GObject *object, guint prop_id,
         case PROP_BYTE_STREAM:
             g_value_set_boolean(value, videnc1->byteStream);
             break;
+        case PROP_CACHE_CODEC:
+            g_value_set_boolean(value, videnc1->cacheCodec);
+            break;
         case PROP_GEN_TIMESTAMPS:
             g_value_set_boolean(value, videnc1->genTimeStamps);
             break;
@@ -575,6 +628,12 @@ static void gst_tividenc1_get_property(GObject *object, guint prop_id,
         case PROP_BITRATE:
             g_value_set_int(value, videnc1->bitRate);
             break;
+        case PROP_NUM_OUTPUT_BUFS:
+            g_value_set_int(value, videnc1->numOutputBufs);
+            break;
+        case PROP_QUEUE_DEPTH:
+            g_value_set_int(value, videnc1->queueDepth);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -603,7 +662,9 @@ static gboolean gst_tividenc1_set_sink_caps(GstPad *pad, GstCaps *caps)
     GST_INFO("requested sink caps:  %s", string);
     g_free(string);
 
-    /* Shut-down any running video encoder */
+    /* Finish the frames queued with the old caps, then shut-down any
+     * running video encoder */
+    gst_tividenc1_stop_encode_thread(videnc1, TRUE);
     if (!gst_tividenc1_exit_video(videnc1)) {
         gst_object_unref(videnc1);
         return FALSE;
@@ -791,7 +852,23 @@ static gboolean gst_tividenc1_sink_event(GstPad *pad, GstEvent *event)
             break;
 
         case GST_EVENT_EOS:
+            /* Encode and push the frames still queued before the EOS */
+            gst_tividenc1_stop_encode_thread(videnc1, TRUE);
+            ret = gst_pad_push_event(videnc1->srcpad, event);
+            break;
+
+        case GST_EVENT_FLUSH_START:
+            /* Unblock the encode thread downstream first, then drop the
+             * queued frames so a chain call waiting on the queue returns.
+             */
+            ret = gst_pad_event_default(pad, event);
+            if (videnc1->inQueue) {
+                gst_tibufferqueue_abort(videnc1->inQueue);
+            }
+            break;
+
         case GST_EVENT_FLUSH_STOP:
+            gst_tividenc1_stop_encode_thread(videnc1, FALSE);
             ret = gst_pad_push_event(videnc1->srcpad, event);
             break;
 
@@ -802,7 +879,6 @@ static gboolean gst_tividenc1_sink_event(GstPad *pad, GstEvent *event)
         case GST_EVENT_CUSTOM_DOWNSTREAM:
         case GST_EVENT_CUSTOM_DOWNSTREAM_OOB:
         case GST_EVENT_CUSTOM_UPSTREAM:
-        case GST_EVENT_FLUSH_START:
         case GST_EVENT_NAVIGATION:
         case GST_EVENT_QOS:
         case GST_EVENT_SEEK:
@@ -942,6 +1018,13 @@ static GstFlowReturn gst_tividenc1_chain(GstPad * pad, GstBuffer * buf)
         }
     }
 
+    /* Start the encode thread if there is none yet, or it was stopped by an
+     * EOS or a flush.
+     */
+    if (videnc1->queueDepth > 0 && !videnc1->inQueue) {
+        gst_tividenc1_start_encode_thread(videnc1);
+    }
+
     /* We can't easily check to make sure a buffer is physically contiguous in
      * memory, but we can make sure it's the right size, which is better than
      * nothing.
@@ -959,22 +1042,42 @@ static GstFlowReturn gst_tividenc1_chain(GstPad * pad, GstBuffer * buf)
            videnc1->upstreamBufSize) {
         GstBuffer     *qBuf;
         GstBuffer     *outBuf;
+        GstFlowReturn  flowRet;
 
         qBuf = gst_adapter_take_buffer(videnc1->sinkAdapter,
                    videnc1->upstreamBufSize);
 
+        /* Hand the frame to the encode thread if there is one.  The queue
+         * only refuses it once the encode thread has failed or we are
+         * flushing.
+         */
+        if (videnc1->inQueue) {
+            if (!gst_tibufferqueue_push(videnc1->inQueue, qBuf)) {
+                GST_DEBUG("encode thread is not accepting frames\n");
+                if (GST_PAD_IS_FLUSHING(pad) ||
+                    videnc1->encodeFlowRet == GST_FLOW_OK) {
+                    return GST_FLOW_WRONG_STATE;
+                }
+                return videnc1->encodeFlowRet;
+            }
+            continue;
+        }
+
         if (gst_tividenc1_encode(videnc1, qBuf, &outBuf) != GST_FLOW_OK) {
             GST_ELEMENT_ERROR(videnc1, RESOURCE, WRITE,
             ("Failed to encode input buffer\n"), (NULL));
             return GST_FLOW_UNEXPECTED;
         }
 
-        /* Parse and Push the transport buffer to the source pad */
+        /* Parse and Push the transport buffer to the source pad.  qBuf was
+         * consumed by the encode.
+         */
         GST_LOG("pushing display buffer to source pad\n");
-        if (gst_tividenc1_parse_and_push(videnc1, outBuf) != GST_FLOW_OK) {
-            GST_DEBUG("push to source pad failed\n");
-            gst_buffer_unref(qBuf);
-            return GST_FLOW_UNEXPECTED;
+        flowRet = gst_tividenc1_parse_and_push(videnc1, outBuf);
+        if (flowRet != GST_FLOW_OK) {
+            GST_DEBUG("push to source pad failed (%s)\n",
+                gst_flow_get_name(flowRet));
+            return flowRet;
         }
     }
 
@@ -1052,6 +1155,9 @@ static gboolean gst_tividenc1_exit_video(GstTIVidenc1 *videnc1)
 {
     GST_LOG("begin exit_video\n");
 
+    /* Drop any frames still waiting to be encoded */
+    gst_tividenc1_stop_encode_thread(videnc1, FALSE);
+
     if (videnc1->sinkAdapter) {
         g_object_unref(videnc1->sinkAdapter);
         videnc1->sinkAdapter = NULL;
@@ -1125,6 +1231,11 @@ static GstStateChangeReturn gst_tividenc1_change_state(GstElement *element,
 
     /* Handle ramp-down state changes */
     switch (transition) {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            /* Streaming has stopped; drop any frames still queued */
+            gst_tividenc1_stop_encode_thread(videnc1, FALSE);
+            break;
+
         case GST_STATE_CHANGE_READY_TO_NULL:
             /* Shut down any running video encoder */
             if (!gst_tividenc1_exit_video(videnc1)) {
@@ -1140,6 +1251,29 @@ static GstStateChangeReturn gst_tividenc1_change_state(GstElement *element,
     return ret;
 }
 
+/******************************************************************************
+ * gst_tividenc1_codec_reset
+ *   reset a cached video encoder before it encodes a new stream
+ *****************************************************************************/
+static Bool gst_tividenc1_codec_reset (Ptr hCodec)
+{
+    VIDENC1_DynamicParams dynParams = Venc1_DynamicParams_DEFAULT;
+    VIDENC1_Status        encStatus;
+
+    encStatus.size     = sizeof(VIDENC1_Status);
+    encStatus.data.buf = NULL;
+
+    return VIDENC1_control(Venc1_getVisaHandle((Venc1_Handle) hCodec),
+               XDM_RESET, &dynParams, &encStatus) == VIDENC1_EOK;
+}
+
+/* Video encoder functions for the codec cache */
+static const GstTICodecFxns gst_tividenc1_codec_fxns = {
+    (GstTICodecCreateFxn) Venc1_create,
+    gst_tividenc1_codec_reset,
+    (GstTICodecDeleteFxn) Venc1_delete
+};
+
 /******************************************************************************
  * gst_tividenc1_codec_stop
  *   stop codec engine
@@ -1163,16 +1297,22 @@ static gboolean gst_tividenc1_codec_stop (GstTIVidenc1 *videnc1)
         videnc1->hEncOutBuf = NULL;
     }
 
-    if (videnc1->hVe1) {
-        GST_LOG("closing video encoder\n");
-        Venc1_delete(videnc1->hVe1);
-        videnc1->hVe1 = NULL;
+    /* Buffers still downstream keep the BufTab alive until they are freed */
+    if (videnc1->hOutBufTab) {
+        gst_tidmaibuftab_log_stats(videnc1->hOutBufTab,
+            GST_OBJECT(videnc1), "output");
+        gst_tidmaibuftab_unref(videnc1->hOutBufTab);
+        videnc1->hOutBufTab = NULL;
     }
 
-    if (videnc1->hEngine) {
-        GST_LOG("closing codec engine\n");
-        Engine_close(videnc1->hEngine);
+    /* The codec cache deletes the encoder and closes the engine, or keeps
+     * them for the next encoder */
+    if (videnc1->hVe1) {
+        GST_LOG("releasing video encoder\n");
+        gst_ti_codec_cache_release(videnc1->hVe1);
+        videnc1->hVe1    = NULL;
         videnc1->hEngine = NULL;
+        gst_ti_codec_cache_post_stats(GST_ELEMENT(videnc1));
     }
 
     return TRUE;
@@ -1190,16 +1330,6 @@ static gboolean gst_tividenc1_codec_start (GstTIVidenc1 *videnc1)
     VIDENC1_Params        params      = Venc1_Params_DEFAULT;
     Int                   inBufSize;
 
-    /* Open the codec engine */
-    GST_LOG("opening codec engine \"%s\"\n", videnc1->engineName);
-    videnc1->hEngine = Engine_open((Char *) videnc1->engineName, NULL, NULL);
-
-    if (videnc1->hEngine == NULL) {
-        GST_ELEMENT_ERROR(videnc1, RESOURCE, FAILED,
-        ("failed to open codec engine \"%s\"\n", videnc1->engineName), (NULL));
-        return FALSE;
-    }
-
     /* setup codec parameters depending on device */
     switch(videnc1->device) {
         case Cpu_Device_OMAP3530:
@@ -1300,14 +1430,19 @@ static gboolean gst_tividenc1_codec_start (GstTIVidenc1 *videnc1)
     GST_LOG("configuring video encode width=%ld, height=%ld, bitrate=%ld\n", 
             params.maxWidth, params.maxHeight, params.maxBitRate);
 
-    GST_LOG("opening video encoder \"%s\"\n", videnc1->codecName);
-    videnc1->hVe1 = Venc1_create(videnc1->hEngine, (Char*)videnc1->codecName,
-                      &params, &dynParams);
+    /* Open the codec engine and create the video encoder, or reuse a
+     * cached one */
+    GST_LOG("opening video encoder \"%s\" on codec engine \"%s\"\n",
+        videnc1->codecName, videnc1->engineName);
+    videnc1->hVe1 = gst_ti_codec_cache_acquire(&gst_tividenc1_codec_fxns,
+                      videnc1->engineName, videnc1->codecName,
+                      &params, sizeof(params), &dynParams, sizeof(dynParams),
+                      videnc1->cacheCodec, &videnc1->hEngine);
 
     if (videnc1->hVe1 == NULL) {
         GST_ELEMENT_ERROR(videnc1, STREAM, CODEC_NOT_FOUND,
-        ("failed to create video encoder: %s\n", videnc1->codecName), (NULL));
-        GST_LOG("closing codec engine\n");
+        ("failed to create video encoder \"%s\" on codec engine \"%s\"\n",
+         videnc1->codecName, videnc1->engineName), (NULL));
         gst_tividenc1_exit_video(videnc1);
         return FALSE;
     }
@@ -1358,6 +1493,32 @@ static gboolean gst_tividenc1_codec_start (GstTIVidenc1 *videnc1)
     videnc1->hEncOutBuf = Buffer_create(Venc1_getOutBufSize(videnc1->hVe1),
         BufferGfx_getBufferAttrs(&gfxAttrsOut));
 
+    if (videnc1->hEncOutBuf == NULL) {
+        gst_tividenc1_exit_video(videnc1);
+        GST_ELEMENT_ERROR(videnc1, RESOURCE, NO_SPACE_LEFT,
+        ("failed to allocate output buffer for encoder\n"), (NULL));
+        return FALSE;
+    }
+
+    /* Create the pool of output buffers pushed downstream without copying.
+     * hEncOutBuf is still used, with a copy, when downstream holds all of
+     * them.
+     */
+    if (videnc1->numOutputBufs > 0) {
+
+        /* By default, new buffers are marked as in-use by the codec */
+        gfxAttrsOut.bAttrs.useMask = gst_tidmaibuffer_CODEC_FREE;
+
+        videnc1->hOutBufTab = gst_tidmaibuftab_new(videnc1->numOutputBufs,
+            Venc1_getOutBufSize(videnc1->hVe1),
+            BufferGfx_getBufferAttrs(&gfxAttrsOut));
+
+        if (videnc1->hOutBufTab == NULL) {
+            GST_WARNING("failed to create output buffer table; copying "
+                "encoded frames\n");
+        }
+    }
+
     return TRUE;
 }
 
@@ -1386,23 +1547,16 @@ gst_tividenc1_populate_codec_header (GstTIVidenc1 *videnc1,
 static GstFlowReturn
 gst_tividenc1_parse_and_push (GstTIVidenc1 *videnc1, GstBuffer *outBuf)
 {
-    guint8 *data;
-    guint   len;
-
     /* perform H.264 specific parsing before pushing the data */
     if (gst_is_h264_encoder(videnc1->codecName)) {
 
-        /* convert byte-stream to packetized */
+        /* convert byte-stream to packetized: prefix every NALU in the
+         * frame with its length */
         if ((!videnc1->byteStream) && (videnc1->codec_data)) {
-
-            /* Prefix the NALU with length field */
-            data = GST_BUFFER_DATA(outBuf);
-            len = GST_BUFFER_SIZE(outBuf)-4;
-           
-            data[3] = len & 0xff;
-            data[2] = (len >> 8) & 0xff;
-            data[1] = (len >> 16) & 0xff;
-            data[0] = (len >> 24) & 0xff;
+            outBuf = gst_h264_byte_stream_to_avc(outBuf);
+            if (outBuf == NULL) {
+                return GST_FLOW_ERROR;
+            }
         }
     }
 
@@ -1418,6 +1572,7 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
     GstBuffer **outBuf)
 {
     Buffer_Handle  hContigInBuf = NULL;
+    Buffer_Handle  hOutBuf      = NULL;
     GstFlowReturn  flowRet      = GST_FLOW_OK;
     Int            ret;
 
@@ -1443,12 +1598,28 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
         goto exit_fail;
     }
 
+    /* Encode straight into a buffer we can push downstream.  If downstream
+     * is holding all of them, encode into hEncOutBuf and copy instead of
+     * waiting, which could stall a pipeline that keeps buffers around.
+     */
+    if (videnc1->hOutBufTab) {
+        hOutBuf = gst_tidmaibuftab_try_get_buf(videnc1->hOutBufTab);
+
+        if (hOutBuf == NULL) {
+            GST_DEBUG("no free output buffer; copying encoded frame\n");
+        }
+    }
+
+    if (hOutBuf == NULL) {
+        hOutBuf = videnc1->hEncOutBuf;
+    }
+
     /* Reset metadata for encoded output buffer */
-    BufferGfx_resetDimensions(videnc1->hEncOutBuf);
+    BufferGfx_resetDimensions(hOutBuf);
 
     /* Invoke the video encoder */
     GST_LOG("invoking the video encoder\n");
-    ret   = Venc1_process(videnc1->hVe1, hContigInBuf, videnc1->hEncOutBuf);
+    ret   = Venc1_process(videnc1->hVe1, hContigInBuf, hOutBuf);
 
     if (ret < 0) {
         GST_ELEMENT_ERROR(videnc1, STREAM, ENCODE,
@@ -1466,22 +1637,31 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
     }
 
     /* Populate codec header */
-    gst_tividenc1_populate_codec_header(videnc1, videnc1->hEncOutBuf);
+    gst_tividenc1_populate_codec_header(videnc1, hOutBuf);
 
     /* Set the source pad capabilities based on the encoded frame properties.
      */
-    gst_tividenc1_set_source_caps(videnc1, videnc1->hEncOutBuf);
+    gst_tividenc1_set_source_caps(videnc1, hOutBuf);
 
-    /* Create a DMAI transport buffer object to carry a DMAI buffer to
-     * the source pad.  The transport buffer knows how to release the
-     * buffer for re-use in this element when the source pad calls
-     * gst_buffer_unref().
-     */
-    *outBuf =
-        gst_buffer_new_and_alloc(Buffer_getNumBytesUsed(videnc1->hEncOutBuf));
+    if (hOutBuf != videnc1->hEncOutBuf) {
+        /* Create a DMAI transport buffer object to carry a DMAI buffer to
+         * the source pad.  The transport buffer knows how to release the
+         * buffer for re-use in this element when the source pad calls
+         * gst_buffer_unref().
+         */
+        *outBuf = gst_tidmaibuffertransport_new(hOutBuf, videnc1->hOutBufTab);
+        gst_buffer_set_data(*outBuf, GST_BUFFER_DATA(*outBuf),
+            Buffer_getNumBytesUsed(hOutBuf));
+        gst_tidmaibuftab_free_buf(videnc1->hOutBufTab, hOutBuf,
+            gst_tidmaibuffer_CODEC_FREE);
+        hOutBuf = NULL;
+    }
+    else {
+        *outBuf = gst_buffer_new_and_alloc(Buffer_getNumBytesUsed(hOutBuf));
 
-    memcpy(GST_BUFFER_DATA(*outBuf), Buffer_getUserPtr(videnc1->hEncOutBuf),
-        Buffer_getNumBytesUsed(videnc1->hEncOutBuf));
+        memcpy(GST_BUFFER_DATA(*outBuf), Buffer_getUserPtr(hOutBuf),
+            Buffer_getNumBytesUsed(hOutBuf));
+    }
 
     gst_buffer_set_caps(*outBuf, GST_PAD_CAPS(videnc1->srcpad));
 
@@ -1494,12 +1674,124 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
 exit_fail:
     flowRet = GST_FLOW_UNEXPECTED;
 
+    /* Give back an output buffer the codec failed to fill */
+    if (hOutBuf && hOutBuf != videnc1->hEncOutBuf) {
+        gst_tidmaibuftab_free_buf(videnc1->hOutBufTab, hOutBuf,
+            gst_tidmaibuffer_CODEC_FREE);
+    }
+
 exit_ok:
     if (inBuf) gst_buffer_unref(inBuf);
     return flowRet;
 }
 
 
+/******************************************************************************
+ * gst_tividenc1_encode_thread
+ *     Encode frames queued by the streaming thread and push them to the
+ *     source pad.
+ ******************************************************************************/
+static void* gst_tividenc1_encode_thread(void *arg)
+{
+    GstTIVidenc1  *videnc1   = GST_TIVIDENC1(gst_object_ref(arg));
+    void          *threadRet = GstTIThreadSuccess;
+    GstBuffer     *inBuf;
+    GstBuffer     *outBuf;
+    GstFlowReturn  flowRet;
+
+    GST_LOG("init video encode_thread\n");
+
+    while ((inBuf = gst_tibufferqueue_pop(videnc1->inQueue))) {
+        flowRet = gst_tividenc1_encode(videnc1, inBuf, &outBuf);
+        if (flowRet != GST_FLOW_OK) {
+            GST_ELEMENT_ERROR(videnc1, RESOURCE, WRITE,
+            ("Failed to encode input buffer\n"), (NULL));
+            goto thread_failure;
+        }
+
+        GST_LOG("pushing display buffer to source pad\n");
+        flowRet = gst_tividenc1_parse_and_push(videnc1, outBuf);
+        if (flowRet != GST_FLOW_OK) {
+            GST_DEBUG("push to source pad failed (%s)\n",
+                gst_flow_get_name(flowRet));
+            goto thread_failure;
+        }
+    }
+
+    goto thread_exit;
+
+thread_failure:
+
+    /* Make the streaming thread fail on its next frame, with the flow
+     * return that stopped us (NOT_LINKED, WRONG_STATE, ...) so upstream
+     * reacts to it as it would to a failed push.  The queue lock orders
+     * this write before the chain function reads it.
+     */
+    videnc1->encodeFlowRet = flowRet;
+    gst_tibufferqueue_abort(videnc1->inQueue);
+    threadRet = GstTIThreadFailure;
+
+thread_exit:
+
+    gst_object_unref(videnc1);
+
+    GST_LOG("exit video encode_thread (%d)\n", (int)threadRet);
+    return threadRet;
+}
+
+
+/******************************************************************************
+ * gst_tividenc1_start_encode_thread
+ *     Create the input queue and the thread that encodes from it.  If the
+ *     thread cannot be created, frames are encoded on the streaming thread.
+ ******************************************************************************/
+static void gst_tividenc1_start_encode_thread(GstTIVidenc1 *videnc1)
+{
+    videnc1->inQueue       = gst_tibufferqueue_new(videnc1->queueDepth);
+    videnc1->encodeFlowRet = GST_FLOW_OK;
+
+    if (pthread_create(&videnc1->encodeThread, NULL,
+            gst_tividenc1_encode_thread, (void*)videnc1)) {
+        GST_WARNING("failed to create encode thread; encoding on the "
+            "streaming thread\n");
+        gst_tibufferqueue_free(videnc1->inQueue);
+        videnc1->inQueue = NULL;
+    }
+}
+
+
+/******************************************************************************
+ * gst_tividenc1_stop_encode_thread
+ *     Wait for the encode thread to finish.  If drain is TRUE it encodes the
+ *     frames still queued first, otherwise they are dropped.
+ ******************************************************************************/
+static void gst_tividenc1_stop_encode_thread(GstTIVidenc1 *videnc1,
+                gboolean drain)
+{
+    void *threadRet;
+
+    if (!videnc1->inQueue) {
+        return;
+    }
+
+    if (drain) {
+        gst_tibufferqueue_close(videnc1->inQueue);
+    }
+    else {
+        gst_tibufferqueue_abort(videnc1->inQueue);
+    }
+
+    if (pthread_join(videnc1->encodeThread, &threadRet) == 0) {
+        if (threadRet == GstTIThreadFailure) {
+            GST_DEBUG("encode thread exited with an error condition\n");
+        }
+    }
+
+    gst_tibufferqueue_free(videnc1->inQueue);
+    videnc1->inQueue = NULL;
+}
+
+
 /******************************************************************************
  * gst_tividenc1_frame_duration
  *    Return the duration of a single frame in nanoseconds.
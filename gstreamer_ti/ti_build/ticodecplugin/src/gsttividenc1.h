@@ -28,6 +28,7 @@
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
 #include "gsttidmaibuftab.h"
+#include "gsttibufferqueue.h"
 
 #include <xdc/std.h>
 #include <ti/sdo/ce/Engine.h>
@@ -77,6 +78,9 @@ struct _GstTIVidenc1
   gint32         bitRate;
   gint           rateControlPreset;
   gint           encodingPreset;
+  gboolean       cacheCodec;
+  gint           queueDepth;
+  gint           numOutputBufs;
 
   /* Element state */
   Engine_Handle    hEngine;
@@ -97,9 +101,16 @@ struct _GstTIVidenc1
   Ccv_Handle     hCcv;
   Framecopy_Handle hFc;
 
+  /* Encode thread; input frames wait in inQueue for it.  encodeFlowRet is
+   * why it stopped, returned by the next chain call. */
+  pthread_t          encodeThread;
+  GstTIBufferQueue  *inQueue;
+  GstFlowReturn      encodeFlowRet;
+
   /* Buffer management */
   GstAdapter      *sinkAdapter;
   GstBuffer       *inBufMetadata;
+  GstTIDmaiBufTab *hOutBufTab;
   Buffer_Handle    hEncOutBuf;
   Buffer_Handle    hContigInBuf;
   Buffer_Handle    hInBufRef;
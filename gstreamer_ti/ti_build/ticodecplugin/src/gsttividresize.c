@@ -62,7 +62,9 @@ enum {
   PROP_HORZ_WINDOW_TYPE,         /*  hWindowType             (gint)      */
   PROP_VERT_WINDOW_TYPE,         /*  vWindowType             (gint)      */
   PROP_HORZ_FILTER_TYPE,         /*  hFilterType             (gint)      */
-  PROP_VERT_FILTER_TYPE          /*  vFilterType             (gint)      */
+  PROP_VERT_FILTER_TYPE,         /*  vFilterType             (gint)      */
+  PROP_STAGING_HITS,             /*  stagingHits             (guint64)   */
+  PROP_STAGING_ALLOCS            /*  stagingAllocs           (guint64)   */
 };
 
 /* Define property default */
@@ -73,6 +75,9 @@ enum {
 #define DEFAULT_NUM_OUTPUT_BUFS         2
 #define DEFAULT_CONTIGUOUS_INPUT_FRAME  FALSE
 
+/* Input frames are staged one at a time, transform is synchronous */
+#define NUM_STAGING_BUFS                1
+
 /* Define sink and src pad capabilities.  Currently, UYVY and Y8C8
  * supported.
  *
@@ -134,6 +139,11 @@ static gboolean gst_tividresize_get_unit_size (GstBaseTransform *trans,
 static ColorSpace_Type gst_tividresize_get_colorSpace (guint32 fourcc);
 static void gst_tividresize_set_property(GObject *object, guint prop_id,
  const GValue *value, GParamSpec *pspec);
+static void gst_tividresize_get_property(GObject *object, guint prop_id,
+ GValue *value, GParamSpec *pspec);
+static Buffer_Handle gst_tividresize_get_staging_buf (GstTIVidresize
+ *vidresize, gint size);
+static void gst_tividresize_free_staging_bufs (GstTIVidresize *vidresize);
 static GstFlowReturn gst_tividresize_prepare_output_buffer (GstBaseTransform
  *trans, GstBuffer *inBuf, gint size, GstCaps *caps, GstBuffer **outBuf);
 static Buffer_Handle gst_tividresize_gfx_buffer_create (gint width, 
@@ -153,6 +163,10 @@ static void gst_tividresize_init (GstTIVidresize *vidresize)
     vidresize->contiguousInputFrame     =  DEFAULT_CONTIGUOUS_INPUT_FRAME;
     vidresize->numOutputBufs            =  DEFAULT_NUM_OUTPUT_BUFS;
     vidresize->hResize                  =  NULL;
+    vidresize->hInBufTab                =  NULL;
+    vidresize->inBufSize                =  0;
+    vidresize->stagingHits              =  0;
+    vidresize->stagingAllocs            =  0;
 }
 
 /******************************************************************************
@@ -227,6 +241,7 @@ static void gst_tividresize_class_init(GstTIVidresizeClass *klass)
     trans_class      = (GstBaseTransformClass *) klass;
 
     gobject_class->set_property = gst_tividresize_set_property;
+    gobject_class->get_property = gst_tividresize_get_property;
 
     gobject_class->finalize = (GObjectFinalizeFunc)gst_tividresize_exit_resize;
 
@@ -291,6 +306,18 @@ static void gst_tividresize_class_init(GstTIVidresizeClass *klass)
             "\t\t\t 2 - LOWPASS \n",
             1, G_MAXINT32, DEFAULT_VERT_FILTER_TYPE, G_PARAM_WRITABLE));
 
+    g_object_class_install_property(gobject_class, PROP_STAGING_HITS,
+        g_param_spec_uint64("stagingHits", "Staging buffer hits",
+            "Number of non-DMAI input frames copied into an already "
+            "allocated contiguous buffer",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+    g_object_class_install_property(gobject_class, PROP_STAGING_ALLOCS,
+        g_param_spec_uint64("stagingAllocs", "Staging buffer allocations",
+            "Number of contiguous buffers allocated for copying non-DMAI "
+            "input frames",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
     GST_LOG("initialized class init\n");
 }
 
@@ -319,6 +346,68 @@ static Buffer_Handle gst_tividresize_gfx_buffer_create (gint width,
     return buf;
 }
 
+/******************************************************************************
+ * gst_tividresize_get_staging_buf
+ *  Get a contiguous buffer to copy a non-DMAI input frame of the given size
+ *  into.  The buffers are kept until the caps or the frame size change.
+ *****************************************************************************/
+static Buffer_Handle gst_tividresize_get_staging_buf (GstTIVidresize
+    *vidresize, gint size)
+{
+    BufferGfx_Attrs gfxAttrs   = BufferGfx_Attrs_DEFAULT;
+    Buffer_Handle   hBuf;
+
+    if (size != vidresize->inBufSize) {
+        GST_DEBUG("input frame size %d does not match caps (%d)\n", size,
+            vidresize->inBufSize);
+        gst_tividresize_free_staging_bufs(vidresize);
+        vidresize->inBufSize = size;
+    }
+
+    /* Only count a hit when the table actually had a buffer for us */
+    if (vidresize->hInBufTab) {
+        hBuf = gst_tidmaibuftab_get_buf(vidresize->hInBufTab);
+        if (hBuf) {
+            vidresize->stagingHits++;
+        }
+        return hBuf;
+    }
+
+    GST_LOG("allocating %d staging buffers of %d bytes\n",
+        NUM_STAGING_BUFS, size);
+
+    gfxAttrs.bAttrs.useMask = gst_tidmaibuffer_CODEC_FREE;
+    gfxAttrs.colorSpace     = vidresize->srcColorSpace;
+    gfxAttrs.dim.width      = vidresize->srcWidth;
+    gfxAttrs.dim.height     = vidresize->srcHeight;
+    gfxAttrs.dim.lineLength = BufferGfx_calcLineLength(gfxAttrs.dim.width, 
+                                gfxAttrs.colorSpace);
+
+    vidresize->hInBufTab = gst_tidmaibuftab_new(NUM_STAGING_BUFS, size,
+                               BufferGfx_getBufferAttrs(&gfxAttrs));
+    if (vidresize->hInBufTab == NULL) {
+        return NULL;
+    }
+
+    vidresize->stagingAllocs += NUM_STAGING_BUFS;
+    return gst_tidmaibuftab_get_buf(vidresize->hInBufTab);
+}
+
+/******************************************************************************
+ * gst_tividresize_free_staging_bufs
+ *  Free the buffers non-DMAI input frames are copied into.
+ *****************************************************************************/
+static void gst_tividresize_free_staging_bufs (GstTIVidresize *vidresize)
+{
+    if (vidresize->hInBufTab) {
+        GST_LOG("freeing staging buffers\n");
+        gst_tidmaibuftab_log_stats(vidresize->hInBufTab,
+            GST_OBJECT(vidresize), "staging");
+        gst_tidmaibuftab_unref(vidresize->hInBufTab);
+        vidresize->hInBufTab = NULL;
+    }
+}
+
 /*****************************************************************************
  * gst_tividresize_prepare_output_buffer
  *    Function is used to allocate output buffer
@@ -398,6 +487,32 @@ static void gst_tividresize_set_property(GObject *object, guint prop_id,
 
     GST_LOG("end set_property\n");
 }
+
+/******************************************************************************
+ * gst_tividresize_get_property
+ *     Return values for requested element property.
+ ******************************************************************************/
+static void gst_tividresize_get_property(GObject *object, guint prop_id,
+                GValue *value, GParamSpec *pspec)
+{
+    GstTIVidresize *vidresize = GST_TIVIDRESIZE(object);
+
+    GST_LOG("begin get_property\n");
+
+    switch (prop_id) {
+        case PROP_STAGING_HITS:
+            g_value_set_uint64(value, vidresize->stagingHits);
+            break;
+        case PROP_STAGING_ALLOCS:
+            g_value_set_uint64(value, vidresize->stagingAllocs);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+
+    GST_LOG("end get_property\n");
+}
        
 /******************************************************************************
  * gst_tividresize_get_unit_size
@@ -438,6 +553,7 @@ static GstFlowReturn gst_tividresize_transform (GstBaseTransform *trans,
     Buffer_Handle       hInBuf      = NULL, hOutBuf = NULL;
     GstFlowReturn       ret         = GST_FLOW_ERROR;
     Resize_Attrs        rszAttrs    = Resize_Attrs_DEFAULT;
+    gboolean            staged      = FALSE;
 
     GST_LOG("begin transform\n");
 
@@ -465,12 +581,12 @@ static GstFlowReturn gst_tividresize_transform (GstBaseTransform *trans,
         Buffer_setNumBytesUsed(hInBuf, GST_BUFFER_SIZE(src));
     }
     else {
-        /* If we are recieving non-contiguous buffer then create dmai 
-         * contiguous input buffer and copy the data in this buffer.
+        /* If we are recieving non-contiguous buffer then copy the data in
+         * a dmai contiguous staging buffer.
          */
-        hInBuf = gst_tividresize_gfx_buffer_create(vidresize->srcWidth,
-                    vidresize->srcHeight, vidresize->srcColorSpace,
-                     GST_BUFFER_SIZE(src), FALSE);
+        hInBuf = gst_tividresize_get_staging_buf(vidresize,
+                     GST_BUFFER_SIZE(src));
+        staged = TRUE;
         if (hInBuf == NULL) {
             GST_ELEMENT_ERROR(vidresize, RESOURCE, NO_SPACE_LEFT,
             ("failed to create input dmai buffer \n"), (NULL));
@@ -528,7 +644,11 @@ static GstFlowReturn gst_tividresize_transform (GstBaseTransform *trans,
     ret = GST_FLOW_OK;
 
 exit:
-    if (hInBuf && !GST_IS_TIDMAIBUFFERTRANSPORT(src)) {
+    if (hInBuf && staged) {
+        gst_tidmaibuftab_free_buf(vidresize->hInBufTab, hInBuf,
+            gst_tidmaibuffer_CODEC_FREE);
+    }
+    else if (hInBuf && !GST_IS_TIDMAIBUFFERTRANSPORT(src)) {
         Buffer_delete(hInBuf);
     }
 
@@ -678,6 +798,12 @@ static gboolean gst_tividresize_set_caps (GstBaseTransform *trans,
     /* map fourcc with its corresponding dmai colorspace type */ 
     vidresize->srcColorSpace = gst_tividresize_get_colorSpace(fourcc);
 
+    /* staging buffers for non-DMAI input are sized for the new caps the
+     * next time one is needed */
+    gst_tividresize_free_staging_bufs(vidresize);
+    vidresize->inBufSize = gst_ti_calc_buffer_size(vidresize->srcWidth,
+        vidresize->srcHeight, 0, vidresize->srcColorSpace);
+
     /* parse output cap */
     if (!gst_tividresize_parse_caps(out, &vidresize->dstWidth,
              &vidresize->dstHeight, &fourcc)) {
@@ -778,10 +904,19 @@ static gboolean gst_tividresize_exit_resize(GstTIVidresize *vidresize)
 
     if (vidresize->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_log_stats(vidresize->hOutBufTab,
+            GST_OBJECT(vidresize), "output");
         gst_tidmaibuftab_unref(vidresize->hOutBufTab);
         vidresize->hOutBufTab = NULL;
     }
 
+    if (vidresize->hInBufTab) {
+        GST_LOG("staging buffers: %" G_GUINT64_FORMAT " hits, %"
+            G_GUINT64_FORMAT " allocated\n", vidresize->stagingHits,
+            vidresize->stagingAllocs);
+    }
+    gst_tividresize_free_staging_bufs(vidresize);
+
     GST_LOG("end exit_video\n");
     return TRUE;
 }
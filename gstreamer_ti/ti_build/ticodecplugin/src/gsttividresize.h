@@ -83,6 +83,12 @@ struct _GstTIVidresize
   ColorSpace_Type   dstColorSpace;
   GstTIDmaiBufTab  *hOutBufTab;
   Cpu_Handle        hCpu;
+
+  /* Contiguous buffers non-DMAI input frames are copied into */
+  GstTIDmaiBufTab  *hInBufTab;
+  gint              inBufSize;
+  guint64           stagingHits;
+  guint64           stagingAllocs;
   Cpu_Device        device;
 };
 
@@ -0,0 +1,524 @@
+/*
+ * gsttiyuv2rgb.c
+ *
+ * This file implements the software YUV to RGB conversion used when a
+ * conversion can't, or shouldn't, run on the DSP.
+ *
+ * The arithmetic is that of the IMGLIB kernel behind C6Accel's
+ * IMG_yuv420pl_to_rgb565: Y is biased by 16 and the chroma by 128, the
+ * coefficients are Q13 and the result is truncated and clamped to 0..255.
+ * Every step is exact in 32 bits, so the NEON and SSE2 backends give
+ * exactly the output of the scalar reference.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <gst/gst.h>
+
+#include "gsttisimd.h"
+#include "gsttiyuv2rgb.h"
+
+/* Declare variable used to categorize GST_LOG output */
+GST_DEBUG_CATEGORY_STATIC(gst_tiyuv2rgb_debug);
+#define GST_CAT_DEFAULT gst_tiyuv2rgb_debug
+
+/* Q13 coefficients: 1.0, 1.3707, -0.3365, -0.6982, 1.7324 */
+const gint16 gst_ti_yuv2rgb_coeff[5] =
+    {0x2000, 0x2BDD, -0x0AC5, -0x1658, 0x3770};
+
+/* Row conversion selected on first use */
+typedef void (*GstTIYuv2RgbRowFxn)(const gint16 *coeff,
+    GstTIYuv2RgbSrcFormat srcFormat, const guint8 *y, const guint8 *u,
+    const guint8 *v, GstTIYuv2RgbDstFormat dstFormat, guint8 *dst,
+    gint width);
+
+static void gst_ti_yuv2rgb_row_init(const gint16 *coeff,
+    GstTIYuv2RgbSrcFormat srcFormat, const guint8 *y, const guint8 *u,
+    const guint8 *v, GstTIYuv2RgbDstFormat dstFormat, guint8 *dst,
+    gint width);
+static GstTIYuv2RgbRowFxn gst_ti_yuv2rgb_row_fxn = gst_ti_yuv2rgb_row_init;
+
+/* Distance between the luma samples and between the chroma samples of
+ * neighbouring pixel pairs, by source format
+ */
+#define YUV2RGB_Y_STEP(fmt)  ((fmt) == GstTIYuv2Rgb_UYVY ? 2 : 1)
+#define YUV2RGB_UV_STEP(fmt) ((fmt) == GstTIYuv2Rgb_I420 ? 1 : \
+                              (fmt) == GstTIYuv2Rgb_NV12 ? 2 : 4)
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_bytes_per_pixel
+ *    Return the bytes per pixel of a destination format.
+ *****************************************************************************/
+gint gst_ti_yuv2rgb_bytes_per_pixel(GstTIYuv2RgbDstFormat format)
+{
+    switch (format) {
+        case GstTIYuv2Rgb_RGB565:
+            return 2;
+        case GstTIYuv2Rgb_RGB24:
+            return 3;
+        case GstTIYuv2Rgb_BGRx:
+        default:
+            return 4;
+    }
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_row_scalar
+ *    Reference row conversion.  Pixel i has luma y[i * ystep] and shares
+ *    the chroma u[(i / 2) * uvstep], v[(i / 2) * uvstep] with its neighbour.
+ *****************************************************************************/
+static void gst_ti_yuv2rgb_row_scalar(const gint16 *coeff,
+                GstTIYuv2RgbSrcFormat srcFormat, const guint8 *y,
+                const guint8 *u, const guint8 *v,
+                GstTIYuv2RgbDstFormat dstFormat, guint8 *dst, gint width)
+{
+    gint    yStep  = YUV2RGB_Y_STEP(srcFormat);
+    gint    uvStep = YUV2RGB_UV_STEP(srcFormat);
+    gint    i, ct, cb, cr, r, g, b;
+    guint16 pixel;
+
+    for (i = 0; i < width; i++) {
+        cb = u[(i >> 1) * uvStep] - 128;
+        cr = v[(i >> 1) * uvStep] - 128;
+        ct = coeff[0] * (y[i * yStep] - 16);
+
+        r = CLAMP((ct + coeff[1] * cr) >> 13, 0, 255);
+        g = CLAMP((ct + coeff[2] * cb + coeff[3] * cr) >> 13, 0, 255);
+        b = CLAMP((ct + coeff[4] * cb) >> 13, 0, 255);
+
+        switch (dstFormat) {
+            case GstTIYuv2Rgb_RGB565:
+                pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+                memcpy(dst + i * 2, &pixel, 2);
+                break;
+            case GstTIYuv2Rgb_RGB24:
+                dst[i * 3]     = r;
+                dst[i * 3 + 1] = g;
+                dst[i * 3 + 2] = b;
+                break;
+            case GstTIYuv2Rgb_BGRx:
+                dst[i * 4]     = b;
+                dst[i * 4 + 1] = g;
+                dst[i * 4 + 2] = r;
+                dst[i * 4 + 3] = 0xff;
+                break;
+        }
+    }
+}
+
+#if defined(__ARM_NEON__)
+/******************************************************************************
+ * gst_ti_yuv2rgb_neon_channel
+ *    One colour channel of eight pixels: (luma * y + k1 * c1 + k2 * c2) >> 13
+ *    clamped to 0..255.  Pass k2 = 0 for R and B.
+ *****************************************************************************/
+static inline uint8x8_t gst_ti_yuv2rgb_neon_channel(int16x8_t y, gint16 luma,
+                            int16x8_t c1, gint16 k1, int16x8_t c2, gint16 k2)
+{
+    int32x4_t lo, hi;
+
+    lo = vmull_n_s16(vget_low_s16(y), luma);
+    lo = vmlal_n_s16(lo, vget_low_s16(c1), k1);
+    lo = vmlal_n_s16(lo, vget_low_s16(c2), k2);
+    hi = vmull_n_s16(vget_high_s16(y), luma);
+    hi = vmlal_n_s16(hi, vget_high_s16(c1), k1);
+    hi = vmlal_n_s16(hi, vget_high_s16(c2), k2);
+
+    return vqmovun_s16(vcombine_s16(vshrn_n_s32(lo, 13),
+                                    vshrn_n_s32(hi, 13)));
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_neon_565
+ *    Pack eight pixels into RGB565.
+ *****************************************************************************/
+static inline uint8x16_t gst_ti_yuv2rgb_neon_565(uint8x8_t r, uint8x8_t g,
+                             uint8x8_t b)
+{
+    uint16x8_t pixel;
+
+    pixel = vshll_n_u8(r, 8);
+    pixel = vsriq_n_u16(pixel, vshll_n_u8(g, 8), 5);
+    pixel = vsriq_n_u16(pixel, vshll_n_u8(b, 8), 11);
+
+    return vreinterpretq_u8_u16(pixel);
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_row_neon
+ *    NEON row conversion: 16 pixels per iteration, loaded as eight even and
+ *    eight odd pixels that share the eight chroma samples, then the rest of
+ *    the row with the scalar reference.
+ *****************************************************************************/
+static void gst_ti_yuv2rgb_row_neon(const gint16 *coeff,
+                GstTIYuv2RgbSrcFormat srcFormat, const guint8 *y,
+                const guint8 *u, const guint8 *v,
+                GstTIYuv2RgbDstFormat dstFormat, guint8 *dst, gint width)
+{
+    const uint8x8_t bias   = vdup_n_u8(16);
+    const uint8x8_t half   = vdup_n_u8(128);
+    const uint8x8_t opaque = vdup_n_u8(0xff);
+    const gint      bpp    = gst_ti_yuv2rgb_bytes_per_pixel(dstFormat);
+    uint8x8x2_t     luma, chroma, r, g, b;
+    uint8x8x4_t     packed;
+    uint8x8x3_t     rgb;
+    uint8x8x4_t     bgrx;
+    uint8x8_t       u8 = half, v8 = half;
+    int16x8_t       ye, yo, cb, cr;
+    gint            x;
+
+    for (x = 0; x + 16 <= width; x += 16) {
+        switch (srcFormat) {
+            case GstTIYuv2Rgb_I420:
+                luma = vld2_u8(y + x);
+                u8   = vld1_u8(u + x / 2);
+                v8   = vld1_u8(v + x / 2);
+                break;
+            case GstTIYuv2Rgb_NV12:
+                luma   = vld2_u8(y + x);
+                chroma = vld2_u8(u + x);
+                u8     = chroma.val[0];
+                v8     = chroma.val[1];
+                break;
+            case GstTIYuv2Rgb_UYVY:
+            default:
+                packed       = vld4_u8(u + x * 2);
+                u8           = packed.val[0];
+                luma.val[0]  = packed.val[1];
+                v8           = packed.val[2];
+                luma.val[1]  = packed.val[3];
+                break;
+        }
+
+        ye = vreinterpretq_s16_u16(vsubl_u8(luma.val[0], bias));
+        yo = vreinterpretq_s16_u16(vsubl_u8(luma.val[1], bias));
+        cb = vreinterpretq_s16_u16(vsubl_u8(u8, half));
+        cr = vreinterpretq_s16_u16(vsubl_u8(v8, half));
+
+        /* Even and odd pixels back in order: val[0] holds pixels 0-7 */
+        r = vzip_u8(
+                gst_ti_yuv2rgb_neon_channel(ye, coeff[0], cr, coeff[1], cb, 0),
+                gst_ti_yuv2rgb_neon_channel(yo, coeff[0], cr, coeff[1], cb, 0));
+        g = vzip_u8(
+                gst_ti_yuv2rgb_neon_channel(ye, coeff[0], cb, coeff[2], cr,
+                    coeff[3]),
+                gst_ti_yuv2rgb_neon_channel(yo, coeff[0], cb, coeff[2], cr,
+                    coeff[3]));
+        b = vzip_u8(
+                gst_ti_yuv2rgb_neon_channel(ye, coeff[0], cb, coeff[4], cr, 0),
+                gst_ti_yuv2rgb_neon_channel(yo, coeff[0], cb, coeff[4], cr, 0));
+
+        switch (dstFormat) {
+            case GstTIYuv2Rgb_RGB565:
+                vst1q_u8(dst + x * 2,
+                    gst_ti_yuv2rgb_neon_565(r.val[0], g.val[0], b.val[0]));
+                vst1q_u8(dst + x * 2 + 16,
+                    gst_ti_yuv2rgb_neon_565(r.val[1], g.val[1], b.val[1]));
+                break;
+            case GstTIYuv2Rgb_RGB24:
+                rgb.val[0] = r.val[0];
+                rgb.val[1] = g.val[0];
+                rgb.val[2] = b.val[0];
+                vst3_u8(dst + x * 3, rgb);
+                rgb.val[0] = r.val[1];
+                rgb.val[1] = g.val[1];
+                rgb.val[2] = b.val[1];
+                vst3_u8(dst + x * 3 + 24, rgb);
+                break;
+            case GstTIYuv2Rgb_BGRx:
+                bgrx.val[0] = b.val[0];
+                bgrx.val[1] = g.val[0];
+                bgrx.val[2] = r.val[0];
+                bgrx.val[3] = opaque;
+                vst4_u8(dst + x * 4, bgrx);
+                bgrx.val[0] = b.val[1];
+                bgrx.val[1] = g.val[1];
+                bgrx.val[2] = r.val[1];
+                vst4_u8(dst + x * 4 + 32, bgrx);
+                break;
+        }
+    }
+
+    gst_ti_yuv2rgb_row_scalar(coeff, srcFormat,
+        y + x * YUV2RGB_Y_STEP(srcFormat),
+        u + (x / 2) * YUV2RGB_UV_STEP(srcFormat),
+        v + (x / 2) * YUV2RGB_UV_STEP(srcFormat),
+        dstFormat, dst + x * bpp, width - x);
+}
+
+#elif defined(__SSE2__)
+/******************************************************************************
+ * gst_ti_yuv2rgb_sse2_channel
+ *    One colour channel of eight pixels: (luma * y + k1 * c1 + k2 * c2) >> 13
+ *    as signed 16 bit values.  k holds the (luma, k1) pairs and k2 the
+ *    (k2, 0) pairs for pmaddwd.
+ *****************************************************************************/
+static inline __m128i gst_ti_yuv2rgb_sse2_channel(__m128i y, __m128i c1,
+                          __m128i k, __m128i c2, __m128i k2)
+{
+    __m128i lo, hi;
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, c1), k),
+                       _mm_madd_epi16(_mm_unpacklo_epi16(c2, c2), k2));
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, c1), k),
+                       _mm_madd_epi16(_mm_unpackhi_epi16(c2, c2), k2));
+
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 13), _mm_srai_epi32(hi, 13));
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_sse2_565
+ *    Pack eight pixels, given as 16 bit values, into RGB565.
+ *****************************************************************************/
+static inline __m128i gst_ti_yuv2rgb_sse2_565(__m128i r, __m128i g,
+                          __m128i b)
+{
+    r = _mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(0xf8)), 8);
+    g = _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xfc)), 3);
+    b = _mm_srli_epi16(b, 3);
+
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_row_sse2
+ *    SSE2 row conversion: 16 pixels per iteration, then the rest of the row
+ *    with the scalar reference.  pmaddwd does two of the Q13 products per
+ *    32 bit lane.
+ *****************************************************************************/
+static void gst_ti_yuv2rgb_row_sse2(const gint16 *coeff,
+                GstTIYuv2RgbSrcFormat srcFormat, const guint8 *y,
+                const guint8 *u, const guint8 *v,
+                GstTIYuv2RgbDstFormat dstFormat, guint8 *dst, gint width)
+{
+    const __m128i zero    = _mm_setzero_si128();
+    const __m128i bias    = _mm_set1_epi16(16);
+    const __m128i half    = _mm_set1_epi16(128);
+    const __m128i lowByte = _mm_set1_epi16(0xff);
+    const __m128i lowWord = _mm_set1_epi32(0xffff);
+    const __m128i opaque  = _mm_set1_epi8((char)0xff);
+    const __m128i kR = _mm_set1_epi32(((guint32)(guint16)coeff[1] << 16) |
+                                      (guint16)coeff[0]);
+    const __m128i kG = _mm_set1_epi32(((guint32)(guint16)coeff[2] << 16) |
+                                      (guint16)coeff[0]);
+    const __m128i kG2 = _mm_set1_epi32((guint16)coeff[3]);
+    const __m128i kB = _mm_set1_epi32(((guint32)(guint16)coeff[4] << 16) |
+                                      (guint16)coeff[0]);
+    const gint    bpp = gst_ti_yuv2rgb_bytes_per_pixel(dstFormat);
+    __m128i       yv = zero, cb = zero, cr = zero, a, b;
+    __m128i       ylo, yhi, cblo, cbhi, crlo, crhi, rv, gv, bv, bg, rx;
+    guint8        rgb[3][16];
+    gint          x, i;
+
+    for (x = 0; x + 16 <= width; x += 16) {
+        switch (srcFormat) {
+            case GstTIYuv2Rgb_I420:
+                yv = _mm_loadu_si128((const __m128i*)(y + x));
+                cb = _mm_unpacklo_epi8(
+                         _mm_loadl_epi64((const __m128i*)(u + x / 2)), zero);
+                cr = _mm_unpacklo_epi8(
+                         _mm_loadl_epi64((const __m128i*)(v + x / 2)), zero);
+                break;
+            case GstTIYuv2Rgb_NV12:
+                yv = _mm_loadu_si128((const __m128i*)(y + x));
+                a  = _mm_loadu_si128((const __m128i*)(u + x));
+                cb = _mm_and_si128(a, lowByte);
+                cr = _mm_srli_epi16(a, 8);
+                break;
+            case GstTIYuv2Rgb_UYVY:
+                a  = _mm_loadu_si128((const __m128i*)(u + x * 2));
+                b  = _mm_loadu_si128((const __m128i*)(u + x * 2 + 16));
+                yv = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                      _mm_srli_epi16(b, 8));
+                a  = _mm_and_si128(a, lowByte);
+                b  = _mm_and_si128(b, lowByte);
+                cb = _mm_packs_epi32(_mm_and_si128(a, lowWord),
+                                     _mm_and_si128(b, lowWord));
+                cr = _mm_packs_epi32(_mm_srli_epi32(a, 16),
+                                     _mm_srli_epi32(b, 16));
+                break;
+        }
+
+        /* Each chroma sample is shared by two pixels */
+        cb   = _mm_sub_epi16(cb, half);
+        cr   = _mm_sub_epi16(cr, half);
+        cblo = _mm_unpacklo_epi16(cb, cb);
+        cbhi = _mm_unpackhi_epi16(cb, cb);
+        crlo = _mm_unpacklo_epi16(cr, cr);
+        crhi = _mm_unpackhi_epi16(cr, cr);
+        ylo  = _mm_sub_epi16(_mm_unpacklo_epi8(yv, zero), bias);
+        yhi  = _mm_sub_epi16(_mm_unpackhi_epi8(yv, zero), bias);
+
+        /* packus does the clamp to 0..255 */
+        rv = _mm_packus_epi16(
+                 gst_ti_yuv2rgb_sse2_channel(ylo, crlo, kR, zero, zero),
+                 gst_ti_yuv2rgb_sse2_channel(yhi, crhi, kR, zero, zero));
+        gv = _mm_packus_epi16(
+                 gst_ti_yuv2rgb_sse2_channel(ylo, cblo, kG, crlo, kG2),
+                 gst_ti_yuv2rgb_sse2_channel(yhi, cbhi, kG, crhi, kG2));
+        bv = _mm_packus_epi16(
+                 gst_ti_yuv2rgb_sse2_channel(ylo, cblo, kB, zero, zero),
+                 gst_ti_yuv2rgb_sse2_channel(yhi, cbhi, kB, zero, zero));
+
+        switch (dstFormat) {
+            case GstTIYuv2Rgb_RGB565:
+                _mm_storeu_si128((__m128i*)(dst + x * 2),
+                    gst_ti_yuv2rgb_sse2_565(_mm_unpacklo_epi8(rv, zero),
+                        _mm_unpacklo_epi8(gv, zero),
+                        _mm_unpacklo_epi8(bv, zero)));
+                _mm_storeu_si128((__m128i*)(dst + x * 2 + 16),
+                    gst_ti_yuv2rgb_sse2_565(_mm_unpackhi_epi8(rv, zero),
+                        _mm_unpackhi_epi8(gv, zero),
+                        _mm_unpackhi_epi8(bv, zero)));
+                break;
+            case GstTIYuv2Rgb_RGB24:
+                /* SSE2 has no byte shuffle; interleave through memory */
+                _mm_storeu_si128((__m128i*)rgb[0], rv);
+                _mm_storeu_si128((__m128i*)rgb[1], gv);
+                _mm_storeu_si128((__m128i*)rgb[2], bv);
+                for (i = 0; i < 16; i++) {
+                    dst[(x + i) * 3]     = rgb[0][i];
+                    dst[(x + i) * 3 + 1] = rgb[1][i];
+                    dst[(x + i) * 3 + 2] = rgb[2][i];
+                }
+                break;
+            case GstTIYuv2Rgb_BGRx:
+                bg = _mm_unpacklo_epi8(bv, gv);
+                rx = _mm_unpacklo_epi8(rv, opaque);
+                _mm_storeu_si128((__m128i*)(dst + x * 4),
+                    _mm_unpacklo_epi16(bg, rx));
+                _mm_storeu_si128((__m128i*)(dst + x * 4 + 16),
+                    _mm_unpackhi_epi16(bg, rx));
+                bg = _mm_unpackhi_epi8(bv, gv);
+                rx = _mm_unpackhi_epi8(rv, opaque);
+                _mm_storeu_si128((__m128i*)(dst + x * 4 + 32),
+                    _mm_unpacklo_epi16(bg, rx));
+                _mm_storeu_si128((__m128i*)(dst + x * 4 + 48),
+                    _mm_unpackhi_epi16(bg, rx));
+                break;
+        }
+    }
+
+    gst_ti_yuv2rgb_row_scalar(coeff, srcFormat,
+        y + x * YUV2RGB_Y_STEP(srcFormat),
+        u + (x / 2) * YUV2RGB_UV_STEP(srcFormat),
+        v + (x / 2) * YUV2RGB_UV_STEP(srcFormat),
+        dstFormat, dst + x * bpp, width - x);
+}
+#endif
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_row_init
+ *    Pick the fastest row conversion this CPU supports, then run it.
+ *****************************************************************************/
+static void gst_ti_yuv2rgb_row_init(const gint16 *coeff,
+                GstTIYuv2RgbSrcFormat srcFormat, const guint8 *y,
+                const guint8 *u, const guint8 *v,
+                GstTIYuv2RgbDstFormat dstFormat, guint8 *dst, gint width)
+{
+    GstTIYuv2RgbRowFxn fxn;
+
+    /* Initialize GST_LOG for this object */
+    GST_DEBUG_CATEGORY_INIT(gst_tiyuv2rgb_debug, "TIYuv2Rgb", 0,
+        "TI software colorspace conversion");
+
+    fxn = gst_ti_yuv2rgb_row_scalar;
+
+#if defined(__ARM_NEON__)
+    if (gst_ti_cpu_has_neon()) {
+        fxn = gst_ti_yuv2rgb_row_neon;
+    }
+#elif defined(__SSE2__)
+    fxn = gst_ti_yuv2rgb_row_sse2;
+#endif
+
+    GST_LOG("using %s colorspace conversion\n",
+        fxn == gst_ti_yuv2rgb_row_scalar ? "scalar" : "SIMD");
+
+    gst_ti_yuv2rgb_row_fxn = fxn;
+
+    fxn(coeff, srcFormat, y, u, v, dstFormat, dst, width);
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_frame
+ *    Convert a frame one row at a time with the given row conversion.
+ *****************************************************************************/
+static void gst_ti_yuv2rgb_frame(GstTIYuv2RgbRowFxn fxn, const gint16 *coeff,
+                const GstTIYuv2RgbFrame *frame)
+{
+    const guint8 *y, *u, *v;
+    gint          line;
+
+    for (line = 0; line < frame->height; line++) {
+        switch (frame->srcFormat) {
+            case GstTIYuv2Rgb_I420:
+                y = frame->src[0] + line * frame->srcStride[0];
+                u = frame->src[1] + (line >> 1) * frame->srcStride[1];
+                v = frame->src[2] + (line >> 1) * frame->srcStride[2];
+                break;
+            case GstTIYuv2Rgb_NV12:
+                y = frame->src[0] + line * frame->srcStride[0];
+                u = frame->src[1] + (line >> 1) * frame->srcStride[1];
+                v = u + 1;
+                break;
+            case GstTIYuv2Rgb_UYVY:
+            default:
+                u = frame->src[0] + line * frame->srcStride[0];
+                y = u + 1;
+                v = u + 2;
+                break;
+        }
+
+        fxn(coeff, frame->srcFormat, y, u, v, frame->dstFormat,
+            frame->dst + line * frame->dstStride, frame->width);
+    }
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb
+ *    Convert a frame with the fastest backend this CPU supports.
+ *****************************************************************************/
+void gst_ti_yuv2rgb(const gint16 *coeff, const GstTIYuv2RgbFrame *frame)
+{
+    gst_ti_yuv2rgb_frame(gst_ti_yuv2rgb_row_fxn, coeff, frame);
+}
+
+/******************************************************************************
+ * gst_ti_yuv2rgb_scalar
+ *    Convert a frame with the scalar reference.
+ *****************************************************************************/
+void gst_ti_yuv2rgb_scalar(const gint16 *coeff,
+         const GstTIYuv2RgbFrame *frame)
+{
+    gst_ti_yuv2rgb_frame(gst_ti_yuv2rgb_row_scalar, coeff, frame);
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,83 @@
+/*
+ * gsttiyuv2rgb.h
+ *
+ * This file declares the software YUV to RGB conversion used when a
+ * conversion can't, or shouldn't, run on the DSP.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef __GST_TIYUV2RGB_H__
+#define __GST_TIYUV2RGB_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Layouts of the frames converted from */
+typedef enum {
+    GstTIYuv2Rgb_I420,          /* Y, U and V planes, 2x2 chroma        */
+    GstTIYuv2Rgb_NV12,          /* Y plane and a UV plane, 2x2 chroma   */
+    GstTIYuv2Rgb_UYVY           /* packed U0 Y0 V0 Y1                   */
+} GstTIYuv2RgbSrcFormat;
+
+/* Layouts of the frames converted to */
+typedef enum {
+    GstTIYuv2Rgb_RGB565,        /* 16 bit words in host byte order      */
+    GstTIYuv2Rgb_RGB24,         /* R, G, B bytes                        */
+    GstTIYuv2Rgb_BGRx           /* B, G, R, 0xff bytes                  */
+} GstTIYuv2RgbDstFormat;
+
+/* A frame to convert.  src and srcStride hold the Y, U and V planes for
+ * I420, the Y and UV planes for NV12 and the packed data for UYVY.
+ */
+typedef struct _GstTIYuv2RgbFrame {
+    gint                    width;
+    gint                    height;
+    GstTIYuv2RgbSrcFormat   srcFormat;
+    const guint8           *src[3];
+    gint                    srcStride[3];
+    GstTIYuv2RgbDstFormat   dstFormat;
+    guint8                 *dst;
+    gint                    dstStride;
+} GstTIYuv2RgbFrame;
+
+/* Fixed-point (Q13) coefficients shared with the C6Accel conversion:
+ * luma, Cr to R, Cb to G, Cr to G and Cb to B.
+ */
+extern const gint16 gst_ti_yuv2rgb_coeff[5];
+
+/* Function to get the bytes per pixel of a destination format */
+gint gst_ti_yuv2rgb_bytes_per_pixel(GstTIYuv2RgbDstFormat format);
+
+/* Functions to convert a frame, with the fastest backend or the scalar
+ * reference.  Both give identical output.
+ */
+void gst_ti_yuv2rgb(const gint16 *coeff, const GstTIYuv2RgbFrame *frame);
+void gst_ti_yuv2rgb_scalar(const gint16 *coeff,
+         const GstTIYuv2RgbFrame *frame);
+
+G_END_DECLS
+
+#endif /* __GST_TIYUV2RGB_H__ */
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
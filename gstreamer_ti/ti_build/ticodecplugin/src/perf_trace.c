@@ -0,0 +1 @@
+../../gst-openmax/util/perf_trace.c
\ No newline at end of file
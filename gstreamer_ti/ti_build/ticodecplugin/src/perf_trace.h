@@ -0,0 +1 @@
+../../gst-openmax/util/perf_trace.h
\ No newline at end of file
@@ -0,0 +1,272 @@
+/*
+ * bench_circbuffer.c
+ *
+ * Microbenchmark for converting packetized (AVC) H.264 samples to byte
+ * stream while they are queued in a GstTICircBuffer.  A synthetic sample of
+ * a given number of slices is queued over and over, once with
+ * gst_h264_parse_and_queue, which queues a whole sample as one list of
+ * segments, and once the way the plugin used to: a gst_ticircbuffer_queue_data
+ * call for the start code and another for the payload of every NAL unit.
+ * A consumer thread reads full windows like the decoder and checks every
+ * byte it gets.
+ *
+ * Usage: bench_circbuffer [slices [slice bytes [samples]]]
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <gst/gst.h>
+
+#include <xdc/std.h>
+#include <ti/sdo/ce/CERuntime.h>
+#include <ti/sdo/dmai/Dmai.h>
+
+#include "gstticircbuffer.h"
+#include "gsttiquicktime_h264.h"
+
+#define WINDOW_SIZE     (512 * 1024)
+#define NAL_LENGTH      4
+
+typedef enum {
+    QUEUE_SEGMENTS,
+    QUEUE_PER_NAL
+} QueueMode;
+
+typedef struct {
+    GstTICircBuffer *circBuf;
+    const guint8    *expected;      /* byte stream of one sample */
+    gint             expectedSize;
+    guint64          received;
+    gboolean         corrupt;
+} Consumer;
+
+/******************************************************************************
+ * consumer_thread
+ *     Read windows until the producer drains the buffer, and check every
+ *     byte against the byte stream the sample should turn into.
+ ******************************************************************************/
+static void *consumer_thread(void *arg)
+{
+    Consumer  *consumer = (Consumer*)arg;
+    GstBuffer *window;
+    gint       size, pos, n;
+
+    for (;;) {
+        window = gst_ticircbuffer_get_data(consumer->circBuf);
+        size   = GST_BUFFER_SIZE(window);
+
+        if (size == 0) {
+            gst_ticircbuffer_data_consumed(consumer->circBuf, window, 0);
+            break;
+        }
+
+        for (pos = 0; pos < size; pos += n) {
+            gint offset = (consumer->received + pos) % consumer->expectedSize;
+
+            n = MIN(size - pos, consumer->expectedSize - offset);
+            if (memcmp(GST_BUFFER_DATA(window) + pos,
+                    consumer->expected + offset, n)) {
+                consumer->corrupt = TRUE;
+            }
+        }
+
+        consumer->received += size;
+        gst_ticircbuffer_data_consumed(consumer->circBuf, window, size);
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * queue_per_nal
+ *     Queue sample the way gst_h264_parse_and_queue did before it gathered
+ *     segments: one queue operation per start code and per NAL payload.
+ ******************************************************************************/
+static gboolean queue_per_nal(GstTICircBuffer *circBuf, GstBuffer *buf,
+    GstBuffer *sps_pps_data, GstBuffer *nal_code_prefix)
+{
+    guint8    *data   = GST_BUFFER_DATA(buf);
+    gint       offset = 0;
+    gint       nal_size, i;
+    GstBuffer *subBuf;
+    gboolean   ok;
+
+    if (!gst_ticircbuffer_queue_data(circBuf, sps_pps_data)) {
+        return FALSE;
+    }
+
+    while (offset < GST_BUFFER_SIZE(buf)) {
+        nal_size = 0;
+        for (i = 0; i < NAL_LENGTH; i++) {
+            nal_size = (nal_size << 8) | data[offset + i];
+        }
+        offset += NAL_LENGTH;
+
+        if (!gst_ticircbuffer_queue_data(circBuf, nal_code_prefix)) {
+            return FALSE;
+        }
+
+        subBuf = gst_buffer_create_sub(buf, offset, nal_size);
+        ok     = gst_ticircbuffer_queue_data(circBuf, subBuf);
+        gst_buffer_unref(subBuf);
+
+        if (!ok) {
+            return FALSE;
+        }
+
+        offset += nal_size;
+    }
+
+    return TRUE;
+}
+
+/******************************************************************************
+ * run
+ *     Queue samples copies of sample in a fresh circular buffer and return
+ *     the average time spent queueing one sample, in microseconds, or a
+ *     negative value when the consumer saw the wrong data.
+ ******************************************************************************/
+static gdouble run(QueueMode mode, GstBuffer *sample, GstBuffer *sps_pps_data,
+    GstBuffer *nal_code_prefix, const guint8 *expected, gint expectedSize,
+    gint samples)
+{
+    Consumer      consumer;
+    pthread_t     thread;
+    GstClockTime  start, elapsed = 0;
+    gboolean      ok = TRUE;
+    gint          i;
+
+    memset(&consumer, 0, sizeof(consumer));
+    consumer.circBuf      = gst_ticircbuffer_new(WINDOW_SIZE, 3, FALSE);
+    consumer.expected     = expected;
+    consumer.expectedSize = expectedSize;
+
+    if (consumer.circBuf == NULL) {
+        fprintf(stderr, "failed to create circular buffer\n");
+        return -1.0;
+    }
+
+    pthread_create(&thread, NULL, consumer_thread, &consumer);
+
+    for (i = 0; ok && i < samples; i++) {
+        GST_BUFFER_DURATION(sample) = GST_SECOND / 30;
+
+        start = gst_util_get_timestamp();
+        if (mode == QUEUE_SEGMENTS) {
+            ok = gst_h264_parse_and_queue(consumer.circBuf, sample,
+                     sps_pps_data, nal_code_prefix, NAL_LENGTH);
+        }
+        else {
+            ok = queue_per_nal(consumer.circBuf, sample, sps_pps_data,
+                     nal_code_prefix);
+        }
+        elapsed += gst_util_get_timestamp() - start;
+    }
+
+    gst_ticircbuffer_drain(consumer.circBuf, TRUE);
+    pthread_join(thread, NULL);
+    gst_ticircbuffer_unref(consumer.circBuf);
+
+    if (!ok || consumer.corrupt ||
+        consumer.received != (guint64)expectedSize * samples) {
+        fprintf(stderr, "consumer got the wrong data\n");
+        return -1.0;
+    }
+
+    return (gdouble)elapsed / GST_USECOND / samples;
+}
+
+int main(int argc, char *argv[])
+{
+    gint       slices    = argc > 1 ? atoi(argv[1]) : 32;
+    gint       sliceSize = argc > 2 ? atoi(argv[2]) : 1500;
+    gint       samples   = argc > 3 ? atoi(argv[3]) : 2000;
+    GstBuffer *sample, *sps_pps_data, *nal_code_prefix;
+    guint8    *data, *expected;
+    gint       expectedSize, i, j;
+    gdouble    perNal, segments;
+
+    gst_init(&argc, &argv);
+    CERuntime_init();
+    Dmai_init();
+
+    /* SPS and PPS as gst_h264_get_sps_pps_data lays them out */
+    sps_pps_data = gst_buffer_new_and_alloc(20);
+    memset(GST_BUFFER_DATA(sps_pps_data), 0, 20);
+    GST_BUFFER_DATA(sps_pps_data)[3]  = 0x01;
+    GST_BUFFER_DATA(sps_pps_data)[4]  = 0x67;
+    GST_BUFFER_DATA(sps_pps_data)[13] = 0x01;
+    GST_BUFFER_DATA(sps_pps_data)[14] = 0x68;
+
+    nal_code_prefix = gst_buffer_new_and_alloc(4);
+    memcpy(GST_BUFFER_DATA(nal_code_prefix), "\0\0\0\1", 4);
+
+    /* slices NAL units of sliceSize random bytes, each behind its length */
+    sample = gst_buffer_new_and_alloc(slices * (NAL_LENGTH + sliceSize));
+    expectedSize = 20 + slices * (4 + sliceSize);
+    expected     = g_malloc(expectedSize);
+
+    memcpy(expected, GST_BUFFER_DATA(sps_pps_data), 20);
+    data = GST_BUFFER_DATA(sample);
+
+    for (i = 0; i < slices; i++) {
+        guint8 *nal = data + i * (NAL_LENGTH + sliceSize);
+        guint8 *out = expected + 20 + i * (4 + sliceSize);
+
+        GST_WRITE_UINT32_BE(nal, sliceSize);
+        for (j = 0; j < sliceSize; j++) {
+            nal[NAL_LENGTH + j] = g_random_int();
+        }
+
+        memcpy(out, "\0\0\0\1", 4);
+        memcpy(out + 4, nal + NAL_LENGTH, sliceSize);
+    }
+
+    perNal   = run(QUEUE_PER_NAL, sample, sps_pps_data, nal_code_prefix,
+                   expected, expectedSize, samples);
+    segments = run(QUEUE_SEGMENTS, sample, sps_pps_data, nal_code_prefix,
+                   expected, expectedSize, samples);
+
+    if (perNal < 0 || segments < 0) {
+        return 1;
+    }
+
+    printf("%d samples of %d slices x %d bytes, usec to queue a sample:\n",
+        samples, slices, sliceSize);
+    printf("  queue_data per NAL unit  %8.1f\n", perNal);
+    printf("  parse_and_queue          %8.1f  (%.2fx)\n", segments,
+        perNal / segments);
+
+    gst_buffer_unref(sample);
+    gst_buffer_unref(sps_pps_data);
+    gst_buffer_unref(nal_code_prefix);
+    g_free(expected);
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,209 @@
+/*
+ * bench_copy_frame.c
+ *
+ * Compares the ways the video sinks can get a decoded frame in system
+ * memory into a display buffer: a single memcpy of the whole frame (the
+ * lower bound, it only works when the line lengths match), one memcpy per
+ * line, gst_ti_copy_frame, and Framecopy with and without acceleration.
+ * The display buffer is a contiguous BufferGfx as the sinks allocate them;
+ * the frame is wrapped in a reference BufferGfx for Framecopy.
+ *
+ * Usage: bench_copy_frame [width [height [frames]]]
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include <xdc/std.h>
+#include <ti/sdo/ce/CERuntime.h>
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufferGfx.h>
+#include <ti/sdo/dmai/Framecopy.h>
+
+#include "gstticommonutils.h"
+
+typedef enum {
+    COPY_MEMCPY,
+    COPY_PER_LINE,
+    COPY_FRAME,
+    COPY_FRAMECOPY,
+    COPY_FRAMECOPY_ACCEL
+} CopyMethod;
+
+static const gchar *methodNames[] = {
+    "memcpy (whole frame)",
+    "memcpy per line",
+    "gst_ti_copy_frame",
+    "Framecopy",
+    "Framecopy (accel)"
+};
+
+/******************************************************************************
+ * run
+ *     Copy frames frames from hSrcBuf to hDstBuf and return the average time
+ *     per frame in microseconds, or a negative value when the method is not
+ *     available.
+ ******************************************************************************/
+static gdouble run(CopyMethod method, Buffer_Handle hSrcBuf,
+    Buffer_Handle hDstBuf, ColorSpace_Type colorSpace, gint frames)
+{
+    BufferGfx_Dimensions srcDim, dstDim;
+    Framecopy_Attrs      fcAttrs = Framecopy_Attrs_DEFAULT;
+    Framecopy_Handle     hFc = NULL;
+    const guint8        *src = (const guint8 *)Buffer_getUserPtr(hSrcBuf);
+    guint8              *dst = (guint8 *)Buffer_getUserPtr(hDstBuf);
+    GstClockTime         start;
+    gint                 size, i, line, lines;
+
+    BufferGfx_getDimensions(hSrcBuf, &srcDim);
+    BufferGfx_getDimensions(hDstBuf, &dstDim);
+    size = gst_ti_calc_buffer_size(srcDim.width, srcDim.height,
+               srcDim.lineLength, colorSpace);
+
+    if (method == COPY_FRAMECOPY || method == COPY_FRAMECOPY_ACCEL) {
+        fcAttrs.accel = method == COPY_FRAMECOPY_ACCEL;
+        hFc = Framecopy_create(&fcAttrs);
+
+        if (hFc == NULL || Framecopy_config(hFc, hSrcBuf, hDstBuf) < 0) {
+            if (hFc) {
+                Framecopy_delete(hFc);
+            }
+            return -1.0;
+        }
+    }
+
+    start = gst_util_get_timestamp();
+
+    for (i = 0; i < frames; i++) {
+        switch (method) {
+            case COPY_MEMCPY:
+                memcpy(dst, src, size);
+                break;
+            case COPY_PER_LINE:
+                lines = size / srcDim.lineLength;
+                for (line = 0; line < lines; line++) {
+                    memcpy(dst + line * dstDim.lineLength,
+                        src + line * srcDim.lineLength,
+                        BufferGfx_calcLineLength(srcDim.width, colorSpace));
+                }
+                break;
+            case COPY_FRAME:
+                gst_ti_copy_frame(hDstBuf, src, colorSpace,
+                    srcDim.lineLength, srcDim.height, 0, 0, srcDim.width,
+                    srcDim.height);
+                break;
+            case COPY_FRAMECOPY:
+            case COPY_FRAMECOPY_ACCEL:
+                Framecopy_execute(hFc, hSrcBuf, hDstBuf);
+                break;
+        }
+    }
+
+    if (hFc) {
+        Framecopy_delete(hFc);
+    }
+
+    return (gdouble)(gst_util_get_timestamp() - start) / GST_USECOND /
+               frames;
+}
+
+/******************************************************************************
+ * bench_colorspace
+ *     Time every method for frames of one colorspace.
+ ******************************************************************************/
+static void bench_colorspace(ColorSpace_Type colorSpace, const gchar *name,
+    gint width, gint height, gint frames)
+{
+    BufferGfx_Attrs gfxAttrs = BufferGfx_Attrs_DEFAULT;
+    Buffer_Handle   hSrcBuf, hDstBuf;
+    guint8         *frame;
+    gint            lineLength, size, method;
+    gdouble         usec;
+
+    lineLength = BufferGfx_calcLineLength(width, colorSpace);
+    size       = gst_ti_calc_buffer_size(width, height, lineLength,
+                     colorSpace);
+
+    gfxAttrs.colorSpace     = colorSpace;
+    gfxAttrs.dim.width      = width;
+    gfxAttrs.dim.height     = height;
+    gfxAttrs.dim.lineLength = lineLength;
+
+    /* The display buffer, contiguous like the ones the sinks allocate */
+    hDstBuf = Buffer_create(size, BufferGfx_getBufferAttrs(&gfxAttrs));
+
+    /* The decoded frame, in system memory like a GstBuffer from upstream */
+    frame = g_malloc(size);
+    memset(frame, 0x80, size);
+    gfxAttrs.bAttrs.reference = TRUE;
+    hSrcBuf = Buffer_create(size, BufferGfx_getBufferAttrs(&gfxAttrs));
+
+    if (hDstBuf == NULL || hSrcBuf == NULL) {
+        fprintf(stderr, "failed to create buffers\n");
+        exit(1);
+    }
+    Buffer_setUserPtr(hSrcBuf, (Int8 *)frame);
+    Buffer_setNumBytesUsed(hSrcBuf, size);
+
+    printf("%s %dx%d, %d frames, usec per frame:\n", name, width, height,
+        frames);
+
+    for (method = COPY_MEMCPY; method <= COPY_FRAMECOPY_ACCEL; method++) {
+        usec = run(method, hSrcBuf, hDstBuf, colorSpace, frames);
+
+        if (usec < 0) {
+            printf("  %-24s   not available\n", methodNames[method]);
+        }
+        else {
+            printf("  %-24s %8.1f  (%.0f MB/s)\n", methodNames[method], usec,
+                size / usec);
+        }
+    }
+
+    Buffer_delete(hSrcBuf);
+    Buffer_delete(hDstBuf);
+    g_free(frame);
+}
+
+int main(int argc, char *argv[])
+{
+    gint width  = argc > 1 ? atoi(argv[1]) : 720;
+    gint height = argc > 2 ? atoi(argv[2]) : 480;
+    gint frames = argc > 3 ? atoi(argv[3]) : 200;
+
+    gst_init(&argc, &argv);
+    CERuntime_init();
+    Dmai_init();
+
+    bench_colorspace(ColorSpace_UYVY, "UYVY", width, height, frames);
+    bench_colorspace(ColorSpace_YUV420PSEMI, "NV12", width, height, frames);
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
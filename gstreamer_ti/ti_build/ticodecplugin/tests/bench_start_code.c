@@ -0,0 +1,132 @@
+/*
+ * bench_start_code.c
+ *
+ * Throughput of the H.264 start code search over a multi-megabyte stream:
+ * every start code is walked once with the scalar reference and once with
+ * gst_h264_find_start_code, which uses NEON or SSE2 where it can.  The
+ * stream is random slice data without zero bytes, which is close to what
+ * an encoder produces, with start codes a few KB to 64 KB apart.
+ *
+ * Usage: bench_start_code [megabytes]
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gst/gst.h>
+
+#include "gsttih264nal.h"
+
+#define RUNS    5
+
+/******************************************************************************
+ * walk
+ *     Find every start code in data and return how many there are.
+ ******************************************************************************/
+static gint walk(const guint8 *data, gint size, gboolean scalar)
+{
+    gint offset = 0, found, codeLength = 3, codes = 0;
+
+    while (offset < size) {
+        if (scalar) {
+            found = offset + gst_h264_find_start_code_scalar(data + offset,
+                                 size - offset);
+        }
+        else {
+            found = offset + gst_h264_find_start_code(data + offset,
+                                 size - offset, &codeLength);
+        }
+
+        if (found == size) {
+            break;
+        }
+
+        offset = found + codeLength;
+        codes++;
+    }
+
+    return codes;
+}
+
+/******************************************************************************
+ * measure
+ *     Best of RUNS walks over data, in MB/s.
+ ******************************************************************************/
+static gdouble measure(const guint8 *data, gint size, gboolean scalar,
+    gint expected)
+{
+    GstClockTime start, elapsed, best = GST_CLOCK_TIME_NONE;
+    gint         run;
+
+    for (run = 0; run < RUNS; run++) {
+        start = gst_util_get_timestamp();
+        if (walk(data, size, scalar) != expected) {
+            fprintf(stderr, "%s search missed start codes\n",
+                scalar ? "scalar" : "SIMD");
+            exit(1);
+        }
+        elapsed = gst_util_get_timestamp() - start;
+
+        best = MIN(best, elapsed);
+    }
+
+    return (gdouble)size / (1 << 20) / ((gdouble)best / GST_SECOND);
+}
+
+int main(int argc, char *argv[])
+{
+    gint     megabytes = argc > 1 ? atoi(argv[1]) : 64;
+    gint     size, i, codes = 0;
+    guint8  *data;
+    gdouble  scalar, simd;
+
+    gst_init(&argc, &argv);
+
+    size = megabytes << 20;
+    data = g_malloc(size);
+
+    for (i = 0; i < size; i++) {
+        data[i] = g_random_int_range(1, 256);
+    }
+
+    for (i = 0; i + 4 <= size; i += g_random_int_range(4096, 65536)) {
+        data[i] = data[i + 1] = data[i + 2] = 0;
+        data[i + 3] = 1;
+        codes++;
+    }
+
+    scalar = measure(data, size, TRUE, codes);
+    simd   = measure(data, size, FALSE, codes);
+
+    printf("%d MB, %d start codes, MB/s:\n", megabytes, codes);
+    printf("  scalar                     %8.0f\n", scalar);
+    printf("  gst_h264_find_start_code   %8.0f  (%.1fx)\n", simd,
+        simd / scalar);
+
+    g_free(data);
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
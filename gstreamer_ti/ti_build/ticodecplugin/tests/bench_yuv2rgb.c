@@ -0,0 +1,148 @@
+/*
+ * bench_yuv2rgb.c
+ *
+ * Time per frame of the software YUV to RGB conversion used by
+ * TIC6xColorspace, for every source and destination format: the scalar
+ * reference against gst_ti_yuv2rgb, which uses NEON or SSE2 where it can.
+ * Compare the I420 to RGB565 numbers with the C6Accel conversion to choose
+ * the softwareMaxPixels threshold of the element.
+ *
+ * Usage: bench_yuv2rgb [width [height [frames]]]
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include "gsttiyuv2rgb.h"
+
+#define RUNS    3
+
+static const gchar *srcNames[] = { "I420", "NV12", "UYVY" };
+static const gchar *dstNames[] = { "RGB565", "RGB24", "BGRx" };
+
+/******************************************************************************
+ * measure
+ *     Best of RUNS conversions of frames frames, in microseconds per frame.
+ ******************************************************************************/
+static gdouble measure(const GstTIYuv2RgbFrame *frame, gboolean scalar,
+    gint frames)
+{
+    GstClockTime start, elapsed, best = GST_CLOCK_TIME_NONE;
+    gint         run, i;
+
+    for (run = 0; run < RUNS; run++) {
+        start = gst_util_get_timestamp();
+        for (i = 0; i < frames; i++) {
+            if (scalar) {
+                gst_ti_yuv2rgb_scalar(gst_ti_yuv2rgb_coeff, frame);
+            }
+            else {
+                gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, frame);
+            }
+        }
+        elapsed = gst_util_get_timestamp() - start;
+
+        best = MIN(best, elapsed);
+    }
+
+    return (gdouble)best / GST_USECOND / frames;
+}
+
+int main(int argc, char *argv[])
+{
+    gint              width  = argc > 1 ? atoi(argv[1]) : 1280;
+    gint              height = argc > 2 ? atoi(argv[2]) : 720;
+    gint              frames = argc > 3 ? atoi(argv[3]) : 50;
+    GstTIYuv2RgbFrame frame;
+    guint8           *src, *dst;
+    gint              format, chromaWidth, chromaHeight, i;
+    gdouble           scalar, simd;
+
+    gst_init(&argc, &argv);
+
+    chromaWidth  = (width + 1) / 2;
+    chromaHeight = (height + 1) / 2;
+
+    /* Large enough for any of the source and destination formats */
+    src = g_malloc(chromaWidth * 4 * height);
+    dst = g_malloc(width * 4 * height);
+
+    for (i = 0; i < chromaWidth * 4 * height; i++) {
+        src[i] = g_random_int_range(0, 256);
+    }
+
+    printf("%dx%d, %d frames, usec per frame:\n", width, height, frames);
+    printf("                      scalar      SIMD\n");
+
+    for (format = 0; format < G_N_ELEMENTS(srcNames) *
+            G_N_ELEMENTS(dstNames); format++) {
+        memset(&frame, 0, sizeof(frame));
+        frame.width     = width;
+        frame.height    = height;
+        frame.srcFormat = format / G_N_ELEMENTS(dstNames);
+        frame.dstFormat = format % G_N_ELEMENTS(dstNames);
+        frame.dst       = dst;
+        frame.dstStride = width *
+                              gst_ti_yuv2rgb_bytes_per_pixel(frame.dstFormat);
+
+        switch (frame.srcFormat) {
+            case GstTIYuv2Rgb_I420:
+                frame.srcStride[0] = width;
+                frame.srcStride[1] = chromaWidth;
+                frame.srcStride[2] = chromaWidth;
+                frame.src[0] = src;
+                frame.src[1] = src + width * height;
+                frame.src[2] = frame.src[1] + chromaWidth * chromaHeight;
+                break;
+            case GstTIYuv2Rgb_NV12:
+                frame.srcStride[0] = width;
+                frame.srcStride[1] = chromaWidth * 2;
+                frame.src[0] = src;
+                frame.src[1] = src + width * height;
+                break;
+            case GstTIYuv2Rgb_UYVY:
+            default:
+                frame.srcStride[0] = chromaWidth * 4;
+                frame.src[0] = src;
+                break;
+        }
+
+        scalar = measure(&frame, TRUE, frames);
+        simd   = measure(&frame, FALSE, frames);
+
+        printf("  %s -> %-8s  %8.0f  %8.0f  (%.1fx)\n",
+            srcNames[frame.srcFormat], dstNames[frame.dstFormat], scalar,
+            simd, scalar / simd);
+    }
+
+    g_free(src);
+    g_free(dst);
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
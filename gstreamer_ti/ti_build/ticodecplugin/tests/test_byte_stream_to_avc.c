@@ -0,0 +1,330 @@
+/*
+ * test_byte_stream_to_avc.c
+ *
+ * Checks gst_h264_byte_stream_to_avc against a naive conversion that splits
+ * the access unit on every 00 00 01 and length prefixes the pieces.  Covers
+ * multi-slice access units with SPS, PPS and SEI, converted in place when
+ * every start code is 4 bytes, mixed 3 and 4 byte start codes and other
+ * layouts that force the gathered copy, and random byte strings.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include "gsttih264nal.h"
+
+#define MAX_NALS        80
+#define MAX_AU_SIZE     (64 * 1024)
+#define RANDOM_STREAMS  100000
+#define TIMESTAMP       (42 * GST_MSECOND)
+
+/* How a NAL unit is written into a test access unit */
+typedef struct {
+    guint8  type;       /* nal_unit_type, goes into the header byte */
+    gint    size;       /* payload bytes after the header byte */
+    gint    codeLen;    /* 3 or 4 byte start code in front of it */
+    gint    zeros;      /* trailing zero bytes after it */
+} TestNal;
+
+typedef enum {
+    EXPECT_ANY,
+    EXPECT_IN_PLACE,
+    EXPECT_COPY
+} Expect;
+
+static gint failures;
+
+/******************************************************************************
+ * naive_convert
+ *     Split data on every 00 00 01, drop the zero bytes in front of each
+ *     one, and write the non-empty pieces after the first start code to out
+ *     with a 4 byte big endian length.  Returns the size written, or -1 if
+ *     there is no start code and the access unit should be left alone.
+ ******************************************************************************/
+static gint naive_convert(const guint8 *data, gint size, guint8 *out)
+{
+    gint codes[MAX_AU_SIZE / 3 + 2];
+    gint nCodes = 0, outSize = 0, i, start, end;
+
+    for (i = 0; i + 2 < size; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            codes[nCodes++] = i;
+            i += 2;
+        }
+    }
+
+    if (nCodes == 0) {
+        return -1;
+    }
+    codes[nCodes] = size;
+
+    for (i = 0; i < nCodes; i++) {
+        start = codes[i] + 3;
+        end   = codes[i + 1];
+
+        while (end > start && data[end - 1] == 0) {
+            end--;
+        }
+
+        if (end > start) {
+            GST_WRITE_UINT32_BE(out + outSize, end - start);
+            memcpy(out + outSize + 4, data + start, end - start);
+            outSize += 4 + end - start;
+        }
+    }
+
+    return outSize;
+}
+
+/******************************************************************************
+ * check_convert
+ *     Convert a copy of data and compare it with naive_convert.  expect says
+ *     whether the buffer has to be converted in place or copied.
+ ******************************************************************************/
+static void check_convert(const gchar *name, const guint8 *data, gint size,
+    Expect expect)
+{
+    static guint8  expected[MAX_AU_SIZE * 2];
+    GstBuffer     *buf, *outBuf;
+    gint           expectedSize;
+
+    buf = gst_buffer_new_and_alloc(size);
+    memcpy(GST_BUFFER_DATA(buf), data, size);
+    GST_BUFFER_TIMESTAMP(buf) = TIMESTAMP;
+
+    expectedSize = naive_convert(data, size, expected);
+    if (expectedSize < 0) {
+        memcpy(expected, data, size);
+        expectedSize = size;
+    }
+
+    outBuf = gst_h264_byte_stream_to_avc(buf);
+
+    if (outBuf == NULL) {
+        printf("FAIL %s: conversion failed\n", name);
+        failures++;
+        return;
+    }
+
+    if (GST_BUFFER_SIZE(outBuf) != expectedSize ||
+        memcmp(GST_BUFFER_DATA(outBuf), expected, expectedSize) != 0) {
+        printf("FAIL %s: %u bytes out, expected %d\n", name,
+            GST_BUFFER_SIZE(outBuf), expectedSize);
+        failures++;
+    }
+    else if (expect == EXPECT_IN_PLACE && outBuf != buf) {
+        printf("FAIL %s: copied, expected conversion in place\n", name);
+        failures++;
+    }
+    else if (expect == EXPECT_COPY && outBuf == buf) {
+        printf("FAIL %s: converted in place, expected a copy\n", name);
+        failures++;
+    }
+    else if (GST_BUFFER_TIMESTAMP(outBuf) != TIMESTAMP) {
+        printf("FAIL %s: timestamp lost\n", name);
+        failures++;
+    }
+
+    gst_buffer_unref(outBuf);
+}
+
+/******************************************************************************
+ * build_au
+ *     Write the NAL units in nals into au, each behind its start code and
+ *     followed by its trailing zeros.  The payload never contains 00 00, as
+ *     emulation prevention guarantees.  Returns the size of the access unit.
+ ******************************************************************************/
+static gint build_au(guint8 *au, const TestNal *nals, gint nNals)
+{
+    gint size = 0, i, j;
+
+    for (i = 0; i < nNals; i++) {
+        if (nals[i].codeLen == 4) {
+            au[size++] = 0;
+        }
+        au[size++] = 0;
+        au[size++] = 0;
+        au[size++] = 1;
+        au[size++] = 0x60 | nals[i].type;
+
+        for (j = 0; j < nals[i].size; j++) {
+            au[size++] = ((i * 31 + j * 7) & 0xfe) + 1;
+        }
+
+        for (j = 0; j < nals[i].zeros; j++) {
+            au[size++] = 0;
+        }
+    }
+
+    return size;
+}
+
+/******************************************************************************
+ * test_multi_slice
+ *     SPS, PPS, SEI and several slices, as the encoders put out for one
+ *     frame, with every start code 4 bytes, with 3 byte slice start codes,
+ *     with only some of them 3 bytes, and with trailing zeros.
+ ******************************************************************************/
+static void test_multi_slice(void)
+{
+    static guint8 au[MAX_AU_SIZE];
+    TestNal nals[MAX_NALS];
+    gint    nNals, size, i, slices, pattern;
+
+    for (slices = 1; slices <= 32; slices *= 2) {
+        for (pattern = 0; pattern < 6; pattern++) {
+            nNals = 0;
+
+            /* SPS, PPS, SEI */
+            nals[nNals].type = 7; nals[nNals].size = 10; nNals++;
+            nals[nNals].type = 8; nals[nNals].size = 3;  nNals++;
+            nals[nNals].type = 6; nals[nNals].size = 20; nNals++;
+
+            for (i = 0; i < slices; i++) {
+                nals[nNals].type = i == 0 ? 5 : 1;
+                nals[nNals].size = 100 + i * 37;
+                nNals++;
+            }
+
+            for (i = 0; i < nNals; i++) {
+                nals[i].codeLen = 4;
+                nals[i].zeros   = 0;
+
+                switch (pattern) {
+                    case 1: /* x264 style: 3 byte start codes on slices */
+                        if (nals[i].type == 1 || nals[i].type == 5) {
+                            nals[i].codeLen = 3;
+                        }
+                        break;
+                    case 2: /* only the last start code is 3 bytes */
+                        if (i == nNals - 1) {
+                            nals[i].codeLen = 3;
+                        }
+                        break;
+                    case 3: /* every start code is 3 bytes */
+                        nals[i].codeLen = 3;
+                        break;
+                    case 4: /* trailing zeros after the last NAL unit */
+                        if (i == nNals - 1) {
+                            nals[i].zeros = 5;
+                        }
+                        break;
+                    case 5: /* trailing zeros between NAL units */
+                        if (i == 1) {
+                            nals[i].zeros = 2;
+                        }
+                        break;
+                }
+            }
+
+            size = build_au(au, nals, nNals);
+
+            switch (pattern) {
+                case 0:
+                case 4:
+                    check_convert("4 byte start codes", au, size,
+                        EXPECT_IN_PLACE);
+                    break;
+                case 2:
+                    check_convert("last start code 3 bytes", au, size,
+                        EXPECT_COPY);
+                    break;
+                default:
+                    check_convert("mixed start codes", au, size,
+                        EXPECT_COPY);
+                    break;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * test_edge_cases
+ *     Single NAL units, empty ones, data in front of the first start code
+ *     and access units without any start code.
+ ******************************************************************************/
+static void test_edge_cases(void)
+{
+    static const guint8 single4[] = { 0, 0, 0, 1, 0x65, 0x88, 0x84 };
+    static const guint8 single3[] = { 0, 0, 1, 0x65, 0x88, 0x84 };
+    static const guint8 empty[]   = { 0, 0, 0, 1, 0, 0, 0, 1, 0x41, 0x9a };
+    static const guint8 junk[]    = { 0x12, 0x34, 0, 0, 0, 1, 0x41, 0x9a };
+    static const guint8 none[]    = { 0x12, 0x34, 0x56, 0, 0, 2, 0x9a };
+    static const guint8 onlyCode[] = { 0, 0, 0, 1 };
+    static const guint8 cutCode[] = { 0, 0, 0, 1, 0x41, 0x9a, 0, 0 };
+
+    check_convert("single NAL unit", single4, sizeof(single4),
+        EXPECT_IN_PLACE);
+    check_convert("single NAL unit, 3 byte code", single3, sizeof(single3),
+        EXPECT_COPY);
+    check_convert("empty NAL unit", empty, sizeof(empty), EXPECT_COPY);
+    check_convert("leading junk", junk, sizeof(junk), EXPECT_COPY);
+    check_convert("no start code", none, sizeof(none), EXPECT_IN_PLACE);
+    check_convert("start code only", onlyCode, sizeof(onlyCode), EXPECT_ANY);
+    check_convert("zeros at the end", cutCode, sizeof(cutCode),
+        EXPECT_IN_PLACE);
+}
+
+/******************************************************************************
+ * test_random
+ *     Random byte strings made mostly of 0, 1 and a few other values, so
+ *     that start codes of both lengths, empty NAL units and zero runs are
+ *     common.
+ ******************************************************************************/
+static void test_random(void)
+{
+    static const guint8 alphabet[] = { 0, 0, 0, 0, 1, 1, 0x41, 0x65, 0xff };
+    guint8 au[256];
+    gint   stream, size, i;
+
+    for (stream = 0; stream < RANDOM_STREAMS; stream++) {
+        size = g_random_int_range(0, sizeof(au));
+
+        for (i = 0; i < size; i++) {
+            au[i] = alphabet[g_random_int_range(0, sizeof(alphabet))];
+        }
+
+        check_convert("random", au, size, EXPECT_ANY);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    test_multi_slice();
+    test_edge_cases();
+    test_random();
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,245 @@
+/*
+ * test_codec_cache.c
+ *
+ * Checks the codec cache shared by the TI codec elements: an instance is
+ * reused, after a reset, by the next user asking for the same engine, codec
+ * and parameters; concurrent users get instances of their own; idle
+ * entries are evicted when there are too many or they time out; uncached
+ * instances are deleted on release; and the counters, also posted as a
+ * "ti-codec-cache" element message, say what happened.
+ *
+ * The cache opens engines itself, so the test uses the engine of the first
+ * codec of the platform, but the codecs are mocks and nothing is created
+ * on the engine.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include <xdc/std.h>
+#include <ti/sdo/ce/CERuntime.h>
+#include <ti/sdo/dmai/Dmai.h>
+
+#include "gstticodecs.h"
+#include "gstticommonutils.h"
+
+/* Cache limits for the test, in entries and msec */
+#define CACHE_SIZE      "2"
+#define CACHE_TIMEOUT   "200"
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("FAIL line %d: %s\n", __LINE__, #cond);              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+extern GstTICodec gst_ticodec_codecs[];
+
+typedef struct _MockParams {
+    gint width;
+    gint height;
+} MockParams;
+
+static gint failures;
+static gint created, deleted, resets;
+static gboolean failReset;
+
+/******************************************************************************
+ * Mock codec functions
+ *     Instances are plain allocations; "nocodec" can not be created.
+ ******************************************************************************/
+static Ptr mock_create(Engine_Handle hEngine, Char *codecName, Ptr params,
+    Ptr dynParams)
+{
+    if (!strcmp(codecName, "nocodec")) {
+        return NULL;
+    }
+
+    created++;
+    return g_malloc(1);
+}
+
+static Bool mock_reset(Ptr hCodec)
+{
+    resets++;
+    return !failReset;
+}
+
+static Int mock_delete(Ptr hCodec)
+{
+    deleted++;
+    g_free(hCodec);
+    return 0;
+}
+
+static const GstTICodecFxns mockFxns = {
+    mock_create,
+    mock_reset,
+    mock_delete
+};
+
+/******************************************************************************
+ * acquire
+ *     Get a cached instance of codecName on engineName with params.
+ ******************************************************************************/
+static Ptr acquire(const gchar *engineName, const gchar *codecName,
+    MockParams *params, gboolean cache, Engine_Handle *hEngine)
+{
+    MockParams dynParams = { 0, 0 };
+
+    return gst_ti_codec_cache_acquire(&mockFxns, engineName, codecName,
+               params, sizeof(*params), &dynParams, sizeof(dynParams), cache,
+               hEngine);
+}
+
+/******************************************************************************
+ * check_message
+ *     Whether the cache counters posted on element's bus match stats.
+ ******************************************************************************/
+static void check_message(GstElement *element, GstTICodecCacheStats *stats)
+{
+    GstBus             *bus = gst_element_get_bus(element);
+    GstMessage         *message;
+    const GstStructure *structure;
+    guint64             hits = 0, misses = 0, evictions = 0;
+    guint               idle = G_MAXUINT;
+
+    gst_ti_codec_cache_post_stats(element);
+
+    message = gst_bus_pop(bus);
+    CHECK(message && GST_MESSAGE_TYPE(message) == GST_MESSAGE_ELEMENT);
+
+    if (message) {
+        structure = gst_message_get_structure(message);
+        CHECK(gst_structure_has_name(structure, "ti-codec-cache"));
+        gst_structure_get_uint64(structure, "hits", &hits);
+        gst_structure_get_uint64(structure, "misses", &misses);
+        gst_structure_get_uint64(structure, "evictions", &evictions);
+        gst_structure_get_uint(structure, "idle", &idle);
+        gst_message_unref(message);
+    }
+
+    CHECK(hits == stats->hits);
+    CHECK(misses == stats->misses);
+    CHECK(evictions == stats->evictions);
+    CHECK(idle == stats->idle);
+
+    gst_object_unref(bus);
+}
+
+int main(int argc, char *argv[])
+{
+    gchar               *engineName;
+    GstElement          *pipeline;
+    GstTICodecCacheStats stats;
+    MockParams           params = { 64, 32 }, other = { 32, 16 };
+    Engine_Handle        hEngine, hEngine2;
+    Ptr                  hCodec, hCodec2;
+    gint                 count;
+
+    /* Read once, by the first acquire */
+    setenv("GST_TI_CODEC_CACHE_SIZE", CACHE_SIZE, 1);
+    setenv("GST_TI_CODEC_CACHE_TIMEOUT", CACHE_TIMEOUT, 1);
+
+    gst_init(&argc, &argv);
+    CERuntime_init();
+    Dmai_init();
+
+    engineName = gst_ticodec_codecs[0].CE_EngineName;
+    pipeline   = gst_pipeline_new("test");
+
+    /* A released instance is reset and handed to the next user */
+    hCodec = acquire(engineName, "mock", &params, TRUE, &hEngine);
+    CHECK(hCodec != NULL && hEngine != NULL);
+    gst_ti_codec_cache_release(hCodec);
+
+    hCodec2 = acquire(engineName, "mock", &params, TRUE, &hEngine2);
+    CHECK(hCodec2 == hCodec && hEngine2 == hEngine);
+    CHECK(created == 1 && resets == 1);
+
+    /* A concurrent user gets an instance and engine of its own */
+    hCodec = acquire(engineName, "mock", &params, TRUE, &hEngine);
+    CHECK(hCodec != NULL && hCodec != hCodec2 && hEngine != hEngine2);
+    gst_ti_codec_cache_release(hCodec);
+    gst_ti_codec_cache_release(hCodec2);
+
+    gst_ti_codec_cache_get_stats(&stats);
+    CHECK(stats.hits == 1 && stats.misses == 2);
+    CHECK(stats.engineMisses == 2 && stats.idle == 2);
+    check_message(pipeline, &stats);
+
+    /* Other parameters do not match; parking a third entry evicts one */
+    hCodec = acquire(engineName, "mock", &other, TRUE, &hEngine);
+    CHECK(hCodec != NULL && created == 3);
+    gst_ti_codec_cache_release(hCodec);
+
+    gst_ti_codec_cache_get_stats(&stats);
+    CHECK(stats.idle == 2 && stats.evictions == 1 && deleted == 1);
+
+    /* An instance that fails to reset is replaced on the same engine */
+    failReset = TRUE;
+    count     = deleted;
+    hCodec = acquire(engineName, "mock", &other, TRUE, &hEngine);
+    CHECK(hCodec != NULL && deleted == count + 1);
+    gst_ti_codec_cache_release(hCodec);
+    failReset = FALSE;
+
+    gst_ti_codec_cache_get_stats(&stats);
+    CHECK(stats.engineHits == 1);
+
+    /* A codec that can not be created leaves its engine idle */
+    hCodec = acquire(engineName, "nocodec", &params, TRUE, &hEngine);
+    CHECK(hCodec == NULL && hEngine == NULL);
+
+    /* Uncached instances are deleted on release */
+    count  = deleted;
+    hCodec = acquire(engineName, "mock", &params, FALSE, &hEngine);
+    CHECK(hCodec != NULL);
+    gst_ti_codec_cache_release(hCodec);
+    CHECK(deleted == count + 1);
+
+    /* Everything idle times out */
+    g_usleep(atoi(CACHE_TIMEOUT) * 3 * 1000);
+
+    gst_ti_codec_cache_get_stats(&stats);
+    CHECK(stats.idle == 0);
+    CHECK(created == deleted);
+    check_message(pipeline, &stats);
+
+    gst_object_unref(pipeline);
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,269 @@
+/*
+ * test_copy_frame.c
+ *
+ * Checks gst_ti_copy_frame for every colorspace it supports: crops out of a
+ * source frame, copied to dimensions at an offset in the destination
+ * buffer, including crops and dimensions that run past the end of the
+ * buffer's lines or rows and have to be clipped.  Every byte of the
+ * destination allocation is compared against a byte by byte copy.
+ *
+ * The destination is a reference BufferGfx on system memory, so this does
+ * not need CMEM.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include <xdc/std.h>
+#include <ti/sdo/ce/CERuntime.h>
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufferGfx.h>
+
+#include "gstticommonutils.h"
+
+/* Source frame and destination buffer sizes, in pixels */
+#define SRC_WIDTH       70
+#define SRC_HEIGHT      20
+#define DST_WIDTH       64
+#define DST_HEIGHT      16
+#define GUARD_SIZE      64
+#define GUARD           0xa5
+
+static gint failures;
+
+/******************************************************************************
+ * bytes_per_pixel
+ *     Bytes per pixel of the first plane of colorSpace.
+ ******************************************************************************/
+static gint bytes_per_pixel(ColorSpace_Type colorSpace)
+{
+    return BufferGfx_calcLineLength(1, colorSpace);
+}
+
+/******************************************************************************
+ * reference_copy
+ *     What gst_ti_copy_frame should do, one byte at a time: copy the crop at
+ *     (x, y) to the dimensions of the destination, clipped to them and to
+ *     the buffer.
+ ******************************************************************************/
+static void reference_copy(guint8 *dst, gint dstSize,
+    const BufferGfx_Dimensions *dim, const guint8 *src,
+    ColorSpace_Type colorSpace, gint srcLineLength, gint x, gint y,
+    gint width, gint height)
+{
+    gint     bpp       = bytes_per_pixel(colorSpace);
+    gint     dstX      = dim->x;
+    gboolean semi      = colorSpace == ColorSpace_YUV420PSEMI ||
+                         colorSpace == ColorSpace_YUV422PSEMI;
+    gint     lumaSize  = dstSize;
+    gint     row, lines;
+
+    if (semi) {
+        x    &= ~1;
+        dstX &= ~1;
+        lumaSize = colorSpace == ColorSpace_YUV420PSEMI ?
+                       dstSize * 2 / 3 : dstSize / 2;
+    }
+
+    lines  = lumaSize / dim->lineLength;
+    width  = MIN(MIN(width, dim->width), dim->lineLength / bpp - dstX);
+    height = MIN(MIN(height, dim->height), lines - dim->y);
+
+    for (row = 0; row < height; row++) {
+        memcpy(dst + (dim->y + row) * dim->lineLength + dstX * bpp,
+            src + (y + row) * srcLineLength + x * bpp, width * bpp);
+    }
+
+    if (!semi) {
+        return;
+    }
+
+    src += srcLineLength * SRC_HEIGHT;
+    dst += lumaSize;
+
+    if (colorSpace == ColorSpace_YUV420PSEMI) {
+        for (row = 0; row < height / 2; row++) {
+            memcpy(dst + (dim->y / 2 + row) * dim->lineLength + dstX,
+                src + (y / 2 + row) * srcLineLength + x, width);
+        }
+    }
+    else {
+        for (row = 0; row < height; row++) {
+            memcpy(dst + (dim->y + row) * dim->lineLength + dstX,
+                src + (y + row) * srcLineLength + x, width);
+        }
+    }
+}
+
+/******************************************************************************
+ * check_copy
+ *     Copy the crop at (x, y) of size width x height to the dimensions at
+ *     (dimX, dimY) of size dimWidth x dimHeight, and compare the whole
+ *     destination allocation, guard bytes included, with reference_copy.
+ ******************************************************************************/
+static void check_copy(ColorSpace_Type colorSpace, const guint8 *src,
+    gint srcLineLength, gint x, gint y, gint width, gint height, gint dimX,
+    gint dimY, gint dimWidth, gint dimHeight)
+{
+    BufferGfx_Attrs      gfxAttrs = BufferGfx_Attrs_DEFAULT;
+    BufferGfx_Dimensions dim;
+    Buffer_Handle        hDstBuf;
+    guint8              *actual, *expected;
+    gint                 lineLength, dstSize, i;
+
+    lineLength = BufferGfx_calcLineLength(DST_WIDTH, colorSpace);
+    dstSize    = gst_ti_calc_buffer_size(DST_WIDTH, DST_HEIGHT, lineLength,
+                     colorSpace);
+
+    actual   = g_malloc(dstSize + 2 * GUARD_SIZE);
+    expected = g_malloc(dstSize + 2 * GUARD_SIZE);
+    memset(actual, GUARD, dstSize + 2 * GUARD_SIZE);
+    memset(expected, GUARD, dstSize + 2 * GUARD_SIZE);
+
+    gfxAttrs.colorSpace     = colorSpace;
+    gfxAttrs.dim.width      = DST_WIDTH;
+    gfxAttrs.dim.height     = DST_HEIGHT;
+    gfxAttrs.dim.lineLength = lineLength;
+    gfxAttrs.bAttrs.reference = TRUE;
+
+    hDstBuf = Buffer_create(dstSize, BufferGfx_getBufferAttrs(&gfxAttrs));
+    if (hDstBuf == NULL) {
+        printf("FAIL: cannot create reference buffer\n");
+        failures++;
+        goto cleanup;
+    }
+    Buffer_setUserPtr(hDstBuf, (Int8 *)actual + GUARD_SIZE);
+
+    BufferGfx_getDimensions(hDstBuf, &dim);
+    dim.x      = dimX;
+    dim.y      = dimY;
+    dim.width  = dimWidth;
+    dim.height = dimHeight;
+    BufferGfx_setDimensions(hDstBuf, &dim);
+
+    gst_ti_copy_frame(hDstBuf, src, colorSpace, srcLineLength, SRC_HEIGHT,
+        x, y, width, height);
+    reference_copy(expected + GUARD_SIZE, dstSize, &dim, src, colorSpace,
+        srcLineLength, x, y, width, height);
+
+    for (i = 0; i < dstSize + 2 * GUARD_SIZE; i++) {
+        if (actual[i] != expected[i]) {
+            printf("FAIL colorspace %d: crop %dx%d at %d,%d to %dx%d at "
+                "%d,%d: byte %d is 0x%02x, expected 0x%02x\n", colorSpace,
+                width, height, x, y, dimWidth, dimHeight, dimX, dimY,
+                i - GUARD_SIZE, actual[i], expected[i]);
+            failures++;
+            break;
+        }
+    }
+
+    Buffer_delete(hDstBuf);
+
+cleanup:
+    g_free(actual);
+    g_free(expected);
+}
+
+/******************************************************************************
+ * test_colorspace
+ *     Whole frames, crops, partial lines, and dimensions that reach past
+ *     the right or bottom edge of the buffer.
+ ******************************************************************************/
+static void test_colorspace(ColorSpace_Type colorSpace)
+{
+    static const gint offsets[] = { 0, 1, 2, 5, 8 };
+    static const gint sizes[]   = { 1, 2, 7, 16, 33, DST_WIDTH, SRC_WIDTH };
+    gint    srcLineLength, srcSize, i;
+    gint    x, y, dx, dy, w, h;
+    guint8 *src;
+
+    /* Padded source lines, like a frame with a rounded up line length */
+    srcLineLength = BufferGfx_calcLineLength(SRC_WIDTH, colorSpace) + 12;
+    srcSize       = srcLineLength * SRC_HEIGHT * 2;
+    src           = g_malloc(srcSize);
+
+    for (i = 0; i < srcSize; i++) {
+        src[i] = (i * 13 + 7) & 0xff;
+        if (src[i] == GUARD) {
+            src[i] = 0;
+        }
+    }
+
+    for (x = 0; x < G_N_ELEMENTS(offsets); x++) {
+        for (y = 0; y < G_N_ELEMENTS(offsets); y++) {
+            for (dx = 0; dx < G_N_ELEMENTS(offsets); dx++) {
+                for (dy = 0; dy < G_N_ELEMENTS(offsets); dy++) {
+                    for (w = 0; w < G_N_ELEMENTS(sizes); w++) {
+                        h = MIN(sizes[w % 4] + 4, SRC_HEIGHT - offsets[y]);
+
+                        /* The crop must stay inside the source frame */
+                        if (offsets[x] + sizes[w] > SRC_WIDTH) {
+                            continue;
+                        }
+
+                        /* Dimensions the size of the crop, as the video
+                         * sinks set them to center a frame */
+                        check_copy(colorSpace, src, srcLineLength,
+                            offsets[x], offsets[y], sizes[w], h,
+                            offsets[dx], offsets[dy], sizes[w], h);
+
+                        /* Dimensions the size of the buffer, moved by an
+                         * offset, so the copy has to be clipped */
+                        check_copy(colorSpace, src, srcLineLength,
+                            offsets[x], offsets[y], sizes[w],
+                            SRC_HEIGHT - offsets[y], offsets[dx],
+                            offsets[dy], DST_WIDTH, DST_HEIGHT);
+                    }
+                }
+            }
+        }
+    }
+
+    g_free(src);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    CERuntime_init();
+    Dmai_init();
+
+    test_colorspace(ColorSpace_UYVY);
+    test_colorspace(ColorSpace_RGB565);
+    test_colorspace(ColorSpace_RGB888);
+    test_colorspace(ColorSpace_YUV420PSEMI);
+    test_colorspace(ColorSpace_YUV422PSEMI);
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
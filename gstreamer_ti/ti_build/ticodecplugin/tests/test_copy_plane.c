@@ -0,0 +1,151 @@
+/*
+ * test_copy_plane.c
+ *
+ * Checks the plane copy used for frame copies: the scalar reference, the
+ * SIMD backend built for this architecture and the dispatching
+ * gst_ti_copy_plane.  Partial lines of every width up to a few SIMD blocks
+ * are copied between every pair of alignments, with and without padding
+ * between the lines, and everything around the copied rectangle has to be
+ * left alone.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include "gsttisimd.h"
+
+/* Widths up to a few 64 byte SIMD iterations plus a partial block */
+#define MAX_WIDTH       200
+#define MAX_MISALIGN    16
+#define LINES           3
+#define GUARD           0xa5
+
+typedef void (*CopyPlaneFxn)(guint8 *dst, gint dstStride, const guint8 *src,
+    gint srcStride, gint width, gint lines);
+
+static gint failures;
+
+/******************************************************************************
+ * check_copy
+ *     Copy a LINES x width rectangle with fxn and check every byte of the
+ *     destination allocation: the rectangle must hold the source, and the
+ *     padding, the bytes in front and the bytes behind the guard value.
+ ******************************************************************************/
+static void check_copy(CopyPlaneFxn fxn, const gchar *name, gint width,
+    gint srcMisalign, gint dstMisalign, gint srcPad, gint dstPad)
+{
+    gint    srcStride = width + srcPad;
+    gint    dstStride = width + dstPad;
+    gint    dstSize   = dstMisalign + dstStride * LINES + MAX_MISALIGN;
+    guint8 *srcMem, *dstMem, *src, *dst;
+    gint    i, line, col, expected;
+
+    srcMem = g_malloc(srcMisalign + srcStride * LINES + 1);
+    dstMem = g_malloc(dstSize);
+    src    = srcMem + srcMisalign;
+    dst    = dstMem + dstMisalign;
+
+    for (i = 0; i < srcStride * LINES; i++) {
+        src[i] = (i * 7 + 1) & 0xff;
+        if (src[i] == GUARD) {
+            src[i] = 0;
+        }
+    }
+    memset(dstMem, GUARD, dstSize);
+
+    fxn(dst, dstStride, src, srcStride, width, LINES);
+
+    for (i = 0; i < dstSize; i++) {
+        line = (i - dstMisalign) / dstStride;
+        col  = (i - dstMisalign) % dstStride;
+
+        if (i >= dstMisalign && line < LINES && col < width) {
+            expected = src[line * srcStride + col];
+        }
+        else {
+            expected = GUARD;
+        }
+
+        if (dstMem[i] != expected) {
+            printf("FAIL %s: width %d, src misalign %d pad %d, dst misalign "
+                "%d pad %d: byte %d is 0x%02x, expected 0x%02x\n", name,
+                width, srcMisalign, srcPad, dstMisalign, dstPad,
+                i - dstMisalign, dstMem[i], expected);
+            failures++;
+            break;
+        }
+    }
+
+    g_free(srcMem);
+    g_free(dstMem);
+}
+
+/******************************************************************************
+ * test_fxn
+ *     Every width, alignment and padding combination for one plane copy.
+ ******************************************************************************/
+static void test_fxn(CopyPlaneFxn fxn, const gchar *name)
+{
+    static const gint pads[] = { 0, 1, 16, 37 };
+    gint width, srcMisalign, dstMisalign, srcPad, dstPad;
+
+    for (width = 1; width <= MAX_WIDTH; width++) {
+        for (srcMisalign = 0; srcMisalign < MAX_MISALIGN; srcMisalign += 3) {
+            for (dstMisalign = 0; dstMisalign < MAX_MISALIGN; dstMisalign++) {
+                for (srcPad = 0; srcPad < G_N_ELEMENTS(pads); srcPad++) {
+                    for (dstPad = 0; dstPad < G_N_ELEMENTS(pads); dstPad++) {
+                        check_copy(fxn, name, width, srcMisalign,
+                            dstMisalign, pads[srcPad], pads[dstPad]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    test_fxn(gst_ti_copy_plane_scalar, "scalar");
+#if defined(__ARM_NEON__)
+    if (gst_ti_cpu_has_neon()) {
+        test_fxn(gst_ti_copy_plane_neon, "NEON");
+    }
+#elif defined(__SSE2__)
+    test_fxn(gst_ti_copy_plane_sse2, "SSE2");
+#endif
+    test_fxn(gst_ti_copy_plane, "gst_ti_copy_plane");
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
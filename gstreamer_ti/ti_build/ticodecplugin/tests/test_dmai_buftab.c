@@ -0,0 +1,190 @@
+/*
+ * test_dmai_buftab.c
+ *
+ * Checks the free list and waiting of GstTIDmaiBufTab: buffers are handed
+ * out in BufTab order, only come back once every useMask bit is freed, are
+ * found by a scan when freed without gst_tidmaibuftab_free_buf, are not
+ * handed out twice when taken behind the object's back or freed twice,
+ * and a waiting get either times out or is woken by a free from another
+ * thread.  The counters have to match.
+ *
+ * The BufTab holds reference buffers, so this does not need CMEM.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include <gst/gst.h>
+
+#include <xdc/std.h>
+#include <ti/sdo/ce/CERuntime.h>
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufTab.h>
+
+#include "gsttidmaibuftab.h"
+
+#define NUM_BUFS        3
+#define BUF_SIZE        64
+#define USE_MASK        0x3
+#define WAIT_TIMEOUT    (20 * GST_MSECOND)
+#define FREE_DELAY      50000   /* usec */
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("FAIL line %d: %s\n", __LINE__, #cond);              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static gint failures;
+
+/******************************************************************************
+ * new_buftab
+ *     A GstTIDmaiBufTab of num_bufs reference buffers.
+ ******************************************************************************/
+static GstTIDmaiBufTab *new_buftab(gint num_bufs)
+{
+    Buffer_Attrs attrs = Buffer_Attrs_DEFAULT;
+
+    attrs.reference = TRUE;
+    attrs.useMask   = USE_MASK;
+
+    return gst_tidmaibuftab_new(num_bufs, BUF_SIZE, &attrs);
+}
+
+/******************************************************************************
+ * delayed_free
+ *     Free the buffer with index 1 of a BufTab after FREE_DELAY.
+ ******************************************************************************/
+static void *delayed_free(void *arg)
+{
+    GstTIDmaiBufTab *buftab = arg;
+
+    g_usleep(FREE_DELAY);
+    gst_tidmaibuftab_free_buf(buftab,
+        BufTab_getBuf(GST_TIDMAIBUFTAB_BUFTAB(buftab), 1), USE_MASK);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    GstTIDmaiBufTab     *buftab, *other;
+    GstTIDmaiBufTabStats stats;
+    Buffer_Handle        hBufs[NUM_BUFS], hBuf, hForeign;
+    GstClockTime         start;
+    pthread_t            thread;
+    gint                 i;
+
+    gst_init(&argc, &argv);
+    CERuntime_init();
+    Dmai_init();
+
+    buftab = new_buftab(NUM_BUFS);
+    CHECK(buftab != NULL);
+    if (!buftab) {
+        return 1;
+    }
+
+    /* Handed out in BufTab order, until there are none */
+    for (i = 0; i < NUM_BUFS; i++) {
+        hBufs[i] = gst_tidmaibuftab_try_get_buf(buftab);
+        CHECK(hBufs[i] != NULL && Buffer_getId(hBufs[i]) == i);
+        CHECK(hBufs[i] && Buffer_getUseMask(hBufs[i]) == USE_MASK);
+    }
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == NULL);
+
+    /* Free only once every bit is cleared */
+    gst_tidmaibuftab_free_buf(buftab, hBufs[2], 0x1);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == NULL);
+    gst_tidmaibuftab_free_buf(buftab, hBufs[2], 0x2);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == hBufs[2]);
+
+    /* Freed without telling the object: found by the scan */
+    Buffer_freeUseMask(hBufs[0], USE_MASK);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == hBufs[0]);
+
+    /* Taken with BufTab_getFreeBuf after being freed: not handed out */
+    gst_tidmaibuftab_free_buf(buftab, hBufs[0], USE_MASK);
+    CHECK(BufTab_getFreeBuf(GST_TIDMAIBUFTAB_BUFTAB(buftab)) == hBufs[0]);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == NULL);
+
+    /* Waiting with nothing freed times out */
+    start = gst_util_get_timestamp();
+    CHECK(gst_tidmaibuftab_get_buf_timed(buftab, WAIT_TIMEOUT) == NULL);
+    CHECK(gst_util_get_timestamp() - start >= WAIT_TIMEOUT);
+
+    gst_tidmaibuftab_get_stats(buftab, &stats);
+    CHECK(stats.starvations == 4 && stats.timeouts == 1);
+    CHECK(stats.waitTime >= WAIT_TIMEOUT);
+
+    /* A free from another thread wakes a waiting get, timed or blocking */
+    pthread_create(&thread, NULL, delayed_free, buftab);
+    hBuf = gst_tidmaibuftab_get_buf_timed(buftab, GST_CLOCK_TIME_NONE);
+    CHECK(hBuf == hBufs[1]);
+    pthread_join(thread, NULL);
+
+    gst_tidmaibuftab_set_blocking(buftab, TRUE);
+    pthread_create(&thread, NULL, delayed_free, buftab);
+    hBuf = gst_tidmaibuftab_get_buf(buftab);
+    CHECK(hBuf == hBufs[1]);
+    pthread_join(thread, NULL);
+
+    gst_tidmaibuftab_get_stats(buftab, &stats);
+    CHECK(stats.gets == NUM_BUFS + 4 && stats.timeouts == 1);
+
+    /* Buffers of other BufTabs, or without an object, are only cleared */
+    other    = new_buftab(1);
+    hForeign = gst_tidmaibuftab_try_get_buf(other);
+    gst_tidmaibuftab_free_buf(buftab, hForeign, USE_MASK);
+    CHECK(Buffer_getUseMask(hForeign) == 0);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == NULL);
+    gst_tidmaibuftab_unref(other);
+
+    gst_tidmaibuftab_free_buf(NULL, hBufs[2], USE_MASK);
+    CHECK(Buffer_getUseMask(hBufs[2]) == 0);
+
+    /* Freeing twice puts a buffer on the free list once; the scan still
+     * finds the one cleared without the object
+     */
+    gst_tidmaibuftab_free_buf(buftab, hBufs[1], USE_MASK);
+    gst_tidmaibuftab_free_buf(buftab, hBufs[1], USE_MASK);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == hBufs[1]);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == hBufs[2]);
+    CHECK(gst_tidmaibuftab_try_get_buf(buftab) == NULL);
+
+    gst_tidmaibuftab_log_stats(buftab, NULL, "test");
+    gst_tidmaibuftab_unref(buftab);
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
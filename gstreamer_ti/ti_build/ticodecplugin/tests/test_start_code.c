@@ -0,0 +1,248 @@
+/*
+ * test_start_code.c
+ *
+ * Checks the H.264 start code search: the scalar reference, the SIMD
+ * backend built for this architecture and the dispatching
+ * gst_h264_find_start_code against a naive search.  Every start code
+ * position in buffers of every length up to a few SIMD blocks is tried at
+ * every alignment, with 3 and 4 byte start codes, including codes cut off
+ * by the end of the buffer, followed by random streams.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include "gsttisimd.h"
+#include "gsttih264nal.h"
+
+/* Lengths up to a few 16 byte SIMD blocks plus their 2 byte overlap */
+#define MAX_SIZE        80
+#define MAX_MISALIGN    16
+#define RANDOM_STREAMS  20000
+
+static gint failures;
+
+/******************************************************************************
+ * naive_search
+ *     Offset of the first 00 00 01 in data, or size.
+ ******************************************************************************/
+static gint naive_search(const guint8 *data, gint size)
+{
+    gint i;
+
+    for (i = 0; i + 2 < size; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+/******************************************************************************
+ * check
+ *     Compare every search against the naive one on data.  Returns the
+ *     expected result of gst_h264_find_start_code.
+ ******************************************************************************/
+static gint check(const guint8 *data, gint size, const gchar *what)
+{
+    gint expected, expectedLength, found, codeLength;
+
+    expected       = naive_search(data, size);
+    expectedLength = expected == size ? 0 : 3;
+
+    found = gst_h264_find_start_code_scalar(data, size);
+    if (found != expected) {
+        printf("FAIL %s, size %d: scalar found %d, expected %d\n", what,
+            size, found, expected);
+        failures++;
+    }
+
+#if defined(__ARM_NEON__)
+    if (gst_ti_cpu_has_neon()) {
+        found = gst_h264_find_start_code_neon(data, size);
+        if (found != expected) {
+            printf("FAIL %s, size %d: NEON found %d, expected %d\n", what,
+                size, found, expected);
+            failures++;
+        }
+    }
+#elif defined(__SSE2__)
+    found = gst_h264_find_start_code_sse2(data, size);
+    if (found != expected) {
+        printf("FAIL %s, size %d: SSE2 found %d, expected %d\n", what,
+            size, found, expected);
+        failures++;
+    }
+#endif
+
+    /* A zero byte in front of 00 00 01 makes it a 4 byte start code */
+    if (expected > 0 && expected < size && data[expected - 1] == 0) {
+        expected--;
+        expectedLength = 4;
+    }
+
+    found = gst_h264_find_start_code(data, size, &codeLength);
+    if (found != expected || codeLength != expectedLength) {
+        printf("FAIL %s, size %d: found %d (%d bytes), expected %d "
+            "(%d bytes)\n", what, size, found, codeLength, expected,
+            expectedLength);
+        failures++;
+    }
+
+    return expected;
+}
+
+/******************************************************************************
+ * fill
+ *     Fill data with a background that has no start code in it, but plenty
+ *     of near misses for the kinds of background that have them.
+ ******************************************************************************/
+static void fill(guint8 *data, gint size, gint kind)
+{
+    static const guint8 nearMiss[] = { 0x00, 0x00, 0x02, 0x00, 0x01, 0x01 };
+    gint i;
+
+    for (i = 0; i < size; i++) {
+        switch (kind) {
+            case 0:
+                data[i] = 0xff;
+                break;
+            case 1:
+                data[i] = nearMiss[i % sizeof(nearMiss)];
+                break;
+            default:
+                data[i] = g_random_int_range(2, 256);
+                break;
+        }
+    }
+}
+
+/******************************************************************************
+ * test_positions
+ *     A single 3 or 4 byte start code at every position of every buffer,
+ *     at every alignment.  The buffer ends where its allocation does, so
+ *     reading past it shows up under valgrind or ASan.
+ ******************************************************************************/
+static void test_positions(void)
+{
+    static const guint8 code[] = { 0x00, 0x00, 0x00, 0x01 };
+    guint8 *mem, *data;
+    gint    misalign, size, codeLength, pos, kind;
+    gchar   what[64];
+
+    for (misalign = 0; misalign < MAX_MISALIGN; misalign++) {
+        for (size = 0; size <= MAX_SIZE; size++) {
+            mem  = g_malloc(misalign + MAX(size, 1));
+            data = mem + misalign;
+
+            for (kind = 0; kind < 3; kind++) {
+                /* No start code, or only the start of one at the end */
+                fill(data, size, kind);
+                check(data, size, "no start code");
+
+                if (size >= 2) {
+                    data[size - 2] = data[size - 1] = 0;
+                    check(data, size, "cut off start code");
+                }
+
+                for (codeLength = 3; codeLength <= 4; codeLength++) {
+                    for (pos = 0; pos + codeLength <= size; pos++) {
+                        fill(data, size, kind);
+                        memcpy(data + pos, code + 4 - codeLength, codeLength);
+
+                        g_snprintf(what, sizeof(what),
+                            "%d byte code at %d, misalign %d, background %d",
+                            codeLength, pos, misalign, kind);
+                        check(data, size, what);
+                    }
+                }
+            }
+
+            g_free(mem);
+        }
+    }
+}
+
+/******************************************************************************
+ * test_random
+ *     Walk every start code of random streams made mostly of 0 and 1 bytes,
+ *     the way the elements walk access units.
+ ******************************************************************************/
+static void test_random(void)
+{
+    guint8 *data;
+    gint    stream, size, i, offset, found;
+
+    for (stream = 0; stream < RANDOM_STREAMS; stream++) {
+        size = g_random_int_range(0, 4 * MAX_SIZE);
+        data = g_malloc(MAX(size, 1));
+
+        for (i = 0; i < size; i++) {
+            switch (g_random_int_range(0, 8)) {
+                case 0: case 1: case 2: case 3:
+                    data[i] = 0;
+                    break;
+                case 4: case 5:
+                    data[i] = 1;
+                    break;
+                default:
+                    data[i] = g_random_int_range(0, 256);
+                    break;
+            }
+        }
+
+        for (offset = 0; offset < size; offset = found + 3) {
+            found = offset + check(data + offset, size - offset, "random");
+            if (found == size) {
+                break;
+            }
+            /* skip the extra zero of a 4 byte start code too */
+            if (data[found + 2] == 0) {
+                found++;
+            }
+        }
+
+        g_free(data);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    test_positions();
+    test_random();
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,412 @@
+/*
+ * test_yuv2rgb.c
+ *
+ * Checks the software YUV to RGB conversion used by TIC6xColorspace: a few
+ * colours through the scalar reference, the same picture in I420, NV12 and
+ * UYVY converting identically, gst_ti_yuv2rgb against the scalar reference
+ * for every source and destination format at every width up to a few SIMD
+ * blocks, with padded lines and extreme values, and every Y, U and V
+ * combination.  Output has to be bit-exact, and nothing past the end of a
+ * destination line may be written.
+ *
+ * Copyright (C) 2008-2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include "gsttiyuv2rgb.h"
+
+#define MAX_WIDTH       80
+#define GUARD           0x5a
+
+static const GstTIYuv2RgbSrcFormat srcFormats[] = {
+    GstTIYuv2Rgb_I420, GstTIYuv2Rgb_NV12, GstTIYuv2Rgb_UYVY
+};
+
+static const GstTIYuv2RgbDstFormat dstFormats[] = {
+    GstTIYuv2Rgb_RGB565, GstTIYuv2Rgb_RGB24, GstTIYuv2Rgb_BGRx
+};
+
+static gint failures;
+
+/******************************************************************************
+ * make_src
+ *     Allocate a source frame of the given format with pad bytes at the end
+ *     of each line, fill it with random data and set up the planes in
+ *     frame.  A quarter of the bytes are 0 or 255 so that clamping is
+ *     exercised.  Returns the allocation.
+ ******************************************************************************/
+static guint8 *make_src(GstTIYuv2RgbFrame *frame,
+    GstTIYuv2RgbSrcFormat format, gint width, gint height, gint pad)
+{
+    gint    chromaWidth  = (width + 1) / 2;
+    gint    chromaHeight = (height + 1) / 2;
+    gint    size, i;
+    guint8 *data;
+
+    memset(frame, 0, sizeof(*frame));
+    frame->width     = width;
+    frame->height    = height;
+    frame->srcFormat = format;
+
+    switch (format) {
+        case GstTIYuv2Rgb_I420:
+            frame->srcStride[0] = width + pad;
+            frame->srcStride[1] = chromaWidth + pad;
+            frame->srcStride[2] = chromaWidth + pad;
+            size = frame->srcStride[0] * height +
+                   2 * frame->srcStride[1] * chromaHeight;
+            data = g_malloc(size);
+            frame->src[0] = data;
+            frame->src[1] = frame->src[0] + frame->srcStride[0] * height;
+            frame->src[2] = frame->src[1] +
+                                frame->srcStride[1] * chromaHeight;
+            break;
+        case GstTIYuv2Rgb_NV12:
+            frame->srcStride[0] = width + pad;
+            frame->srcStride[1] = chromaWidth * 2 + pad;
+            size = frame->srcStride[0] * height +
+                   frame->srcStride[1] * chromaHeight;
+            data = g_malloc(size);
+            frame->src[0] = data;
+            frame->src[1] = frame->src[0] + frame->srcStride[0] * height;
+            break;
+        case GstTIYuv2Rgb_UYVY:
+        default:
+            frame->srcStride[0] = chromaWidth * 4 + pad;
+            size = frame->srcStride[0] * height;
+            data = g_malloc(size);
+            frame->src[0] = data;
+            break;
+    }
+
+    for (i = 0; i < size; i++) {
+        switch (g_random_int_range(0, 8)) {
+            case 0:
+                data[i] = 0;
+                break;
+            case 1:
+                data[i] = 255;
+                break;
+            default:
+                data[i] = g_random_int_range(0, 256);
+                break;
+        }
+    }
+
+    return data;
+}
+
+/******************************************************************************
+ * check_frame
+ *     Convert a random frame with the scalar reference and with
+ *     gst_ti_yuv2rgb into destinations with pad bytes after every line, and
+ *     compare them.  The pad bytes have to keep the guard value.
+ ******************************************************************************/
+static void check_frame(GstTIYuv2RgbSrcFormat srcFormat,
+    GstTIYuv2RgbDstFormat dstFormat, gint width, gint height, gint pad)
+{
+    GstTIYuv2RgbFrame frame;
+    guint8           *src, *expected, *actual;
+    gint              bpp, size, i;
+
+    src = make_src(&frame, srcFormat, width, height, pad);
+
+    bpp             = gst_ti_yuv2rgb_bytes_per_pixel(dstFormat);
+    frame.dstFormat = dstFormat;
+    frame.dstStride = width * bpp + pad + 7;
+    size            = frame.dstStride * height;
+
+    expected = g_malloc(size);
+    actual   = g_malloc(size);
+    memset(expected, GUARD, size);
+    memset(actual, GUARD, size);
+
+    frame.dst = expected;
+    gst_ti_yuv2rgb_scalar(gst_ti_yuv2rgb_coeff, &frame);
+    frame.dst = actual;
+    gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, &frame);
+
+    for (i = 0; i < size; i++) {
+        if (i % frame.dstStride >= width * bpp && actual[i] != GUARD) {
+            printf("FAIL src %d dst %d %dx%d pad %d: wrote past line %d\n",
+                srcFormat, dstFormat, width, height, pad,
+                i / frame.dstStride);
+            failures++;
+            break;
+        }
+
+        if (actual[i] != expected[i]) {
+            printf("FAIL src %d dst %d %dx%d pad %d: pixel %d,%d byte %d is "
+                "0x%02x, expected 0x%02x\n", srcFormat, dstFormat, width,
+                height, pad, (i % frame.dstStride) / bpp,
+                i / frame.dstStride, i % bpp, actual[i], expected[i]);
+            failures++;
+            break;
+        }
+    }
+
+    g_free(src);
+    g_free(expected);
+    g_free(actual);
+}
+
+/******************************************************************************
+ * convert_pixel
+ *     Convert one pixel to RGB24 with the scalar reference.
+ ******************************************************************************/
+static void convert_pixel(guint8 y, guint8 u, guint8 v, guint8 *rgb)
+{
+    GstTIYuv2RgbFrame frame;
+    guint8            uyvy[4] = { u, y, v, y };
+    guint8            out[6];
+
+    memset(&frame, 0, sizeof(frame));
+    frame.width        = 2;
+    frame.height       = 1;
+    frame.srcFormat    = GstTIYuv2Rgb_UYVY;
+    frame.src[0]       = uyvy;
+    frame.srcStride[0] = sizeof(uyvy);
+    frame.dstFormat    = GstTIYuv2Rgb_RGB24;
+    frame.dst          = out;
+    frame.dstStride    = sizeof(out);
+
+    gst_ti_yuv2rgb_scalar(gst_ti_yuv2rgb_coeff, &frame);
+    memcpy(rgb, out, 3);
+}
+
+/******************************************************************************
+ * test_reference
+ *     Video black and white, and a colour worked out by hand from the
+ *     coefficients: R = 84 + 1.3707 * 72, G = 84 + 0.3365 * 68 - 0.6982 * 72
+ *     and B = 84 - 1.7324 * 68, clamped.
+ ******************************************************************************/
+static void test_reference(void)
+{
+    static const struct {
+        guint8 y, u, v;
+        guint8 rgb[3];
+    } pixels[] = {
+        {  16, 128, 128, {   0,   0,   0 } },
+        { 235, 128, 128, { 219, 219, 219 } },
+        { 100,  60, 200, { 182,  56,   0 } }
+    };
+    guint8 rgb[3];
+    gint   i;
+
+    for (i = 0; i < G_N_ELEMENTS(pixels); i++) {
+        convert_pixel(pixels[i].y, pixels[i].u, pixels[i].v, rgb);
+
+        if (memcmp(rgb, pixels[i].rgb, 3) != 0) {
+            printf("FAIL YUV %d,%d,%d is RGB %d,%d,%d, expected %d,%d,%d\n",
+                pixels[i].y, pixels[i].u, pixels[i].v, rgb[0], rgb[1],
+                rgb[2], pixels[i].rgb[0], pixels[i].rgb[1], pixels[i].rgb[2]);
+            failures++;
+        }
+    }
+}
+
+/******************************************************************************
+ * test_layouts
+ *     Write one picture in I420, NV12 and UYVY and check that all three
+ *     convert to the same RGB.  UYVY has 2x1 chroma, so the chroma of the
+ *     odd lines is copied from the even ones.
+ ******************************************************************************/
+static void test_layouts(void)
+{
+    GstTIYuv2RgbFrame i420, nv12, uyvy;
+    guint8           *i420Data, *nv12Data, *uyvyData;
+    guint8           *i420Out, *nv12Out, *uyvyOut;
+    guint8           *nv12Y, *nv12UV, *packed;
+    guint8            y, u, v;
+    gint              width = 37, height = 6, x, row, dst, lineSize;
+
+    i420Data = make_src(&i420, GstTIYuv2Rgb_I420, width, height, 3);
+    nv12Data = make_src(&nv12, GstTIYuv2Rgb_NV12, width, height, 5);
+    uyvyData = make_src(&uyvy, GstTIYuv2Rgb_UYVY, width, height, 1);
+
+    nv12Y  = (guint8 *)nv12.src[0];
+    nv12UV = (guint8 *)nv12.src[1];
+    packed = (guint8 *)uyvy.src[0];
+
+    for (row = 0; row < height; row++) {
+        for (x = 0; x < width; x++) {
+            y = i420.src[0][row * i420.srcStride[0] + x];
+            u = i420.src[1][row / 2 * i420.srcStride[1] + x / 2];
+            v = i420.src[2][row / 2 * i420.srcStride[2] + x / 2];
+
+            nv12Y[row * nv12.srcStride[0] + x] = y;
+            nv12UV[row / 2 * nv12.srcStride[1] + x / 2 * 2]     = u;
+            nv12UV[row / 2 * nv12.srcStride[1] + x / 2 * 2 + 1] = v;
+
+            packed[row * uyvy.srcStride[0] + x / 2 * 4]               = u;
+            packed[row * uyvy.srcStride[0] + x / 2 * 4 + 1 + x % 2 * 2] = y;
+            packed[row * uyvy.srcStride[0] + x / 2 * 4 + 2]           = v;
+        }
+    }
+
+    i420Out = g_malloc(width * height * 4);
+    nv12Out = g_malloc(width * height * 4);
+    uyvyOut = g_malloc(width * height * 4);
+
+    for (dst = 0; dst < G_N_ELEMENTS(dstFormats); dst++) {
+        i420.dstFormat = nv12.dstFormat = uyvy.dstFormat = dstFormats[dst];
+        i420.dstStride = nv12.dstStride = uyvy.dstStride = width * 4;
+        i420.dst = i420Out;
+        nv12.dst = nv12Out;
+        uyvy.dst = uyvyOut;
+
+        gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, &i420);
+        gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, &nv12);
+        gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, &uyvy);
+
+        lineSize = width * gst_ti_yuv2rgb_bytes_per_pixel(dstFormats[dst]);
+
+        for (row = 0; row < height; row++) {
+            if (memcmp(i420Out + row * width * 4, nv12Out + row * width * 4,
+                    lineSize) != 0) {
+                printf("FAIL dst %d: NV12 line %d differs from I420\n",
+                    dstFormats[dst], row);
+                failures++;
+                break;
+            }
+            if (memcmp(i420Out + row * width * 4, uyvyOut + row * width * 4,
+                    lineSize) != 0) {
+                printf("FAIL dst %d: UYVY line %d differs from I420\n",
+                    dstFormats[dst], row);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    g_free(i420Data);
+    g_free(nv12Data);
+    g_free(uyvyData);
+    g_free(i420Out);
+    g_free(nv12Out);
+    g_free(uyvyOut);
+}
+
+/******************************************************************************
+ * test_bit_exact
+ *     gst_ti_yuv2rgb against the scalar reference: every width up to a few
+ *     SIMD blocks plus a partial one, odd heights, padded lines, and two
+ *     full size frames.
+ ******************************************************************************/
+static void test_bit_exact(void)
+{
+    gint src, dst, width, height;
+
+    for (src = 0; src < G_N_ELEMENTS(srcFormats); src++) {
+        for (dst = 0; dst < G_N_ELEMENTS(dstFormats); dst++) {
+            for (width = 1; width <= MAX_WIDTH; width++) {
+                for (height = 1; height <= 5; height += 2) {
+                    check_frame(srcFormats[src], dstFormats[dst], width,
+                        height, width % 5);
+                }
+            }
+
+            check_frame(srcFormats[src], dstFormats[dst], 1280, 720, 0);
+            check_frame(srcFormats[src], dstFormats[dst], 641, 481, 13);
+        }
+    }
+}
+
+/******************************************************************************
+ * test_all_values
+ *     Every Y, U and V combination, one U value per UYVY frame: each line
+ *     holds every Y for one V.  gst_ti_yuv2rgb has to match the scalar
+ *     reference everywhere.
+ ******************************************************************************/
+static void test_all_values(void)
+{
+    GstTIYuv2RgbFrame frame;
+    guint8           *src, *expected, *actual, *pixel;
+    gint              width = 512, height = 256, dst, bpp, u, v, x;
+
+    src      = g_malloc(width * 2 * height);
+    expected = g_malloc(width * 4 * height);
+    actual   = g_malloc(width * 4 * height);
+
+    memset(&frame, 0, sizeof(frame));
+    frame.width        = width;
+    frame.height       = height;
+    frame.srcFormat    = GstTIYuv2Rgb_UYVY;
+    frame.src[0]       = src;
+    frame.srcStride[0] = width * 2;
+
+    for (u = 0; u < 256; u++) {
+        for (v = 0; v < height; v++) {
+            for (x = 0; x < width / 2; x++) {
+                pixel    = src + v * width * 2 + x * 4;
+                pixel[0] = u;
+                pixel[1] = x;
+                pixel[2] = v;
+                pixel[3] = x;
+            }
+        }
+
+        for (dst = 0; dst < G_N_ELEMENTS(dstFormats); dst++) {
+            bpp             = gst_ti_yuv2rgb_bytes_per_pixel(dstFormats[dst]);
+            frame.dstFormat = dstFormats[dst];
+            frame.dstStride = width * bpp;
+
+            frame.dst = expected;
+            gst_ti_yuv2rgb_scalar(gst_ti_yuv2rgb_coeff, &frame);
+            frame.dst = actual;
+            gst_ti_yuv2rgb(gst_ti_yuv2rgb_coeff, &frame);
+
+            if (memcmp(expected, actual, width * bpp * height) != 0) {
+                printf("FAIL dst %d: U %d differs from the scalar "
+                    "reference\n", dstFormats[dst], u);
+                failures++;
+            }
+        }
+    }
+
+    g_free(src);
+    g_free(expected);
+    g_free(actual);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    test_reference();
+    test_layouts();
+    test_bit_exact();
+    test_all_values();
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif